@@ -6,7 +6,7 @@ TARGET = e01hasher
 TEMPLATE = app
 
 # Qt modules
-QT += core gui widgets
+QT += core gui widgets network sql
 
 # C++ standard (Qt 6 requires C++17 minimum)
 CONFIG += c++17
@@ -55,13 +55,79 @@ SOURCES += \
     src/main.cpp \
     src/mainwindow.cpp \
     src/ewfhandler.cpp \
-    src/hashengine.cpp
+    src/hashengine.cpp \
+    src/sparsemap.cpp \
+    src/quickverifier.cpp \
+    src/clirunner.cpp \
+    src/prefetchreader.cpp \
+    src/blockstage.cpp \
+    src/knownblockindex.cpp \
+    src/knownblockstage.cpp \
+    src/similaritydigest.cpp \
+    src/similaritystage.cpp \
+    src/entropystage.cpp \
+    src/ewfwriter.cpp \
+    src/teewriter.cpp \
+    src/streamreader.cpp \
+    src/segmenthasher.cpp \
+    src/jobtelemetry.cpp \
+    src/hashkernel.cpp \
+    src/hashdigest.cpp \
+    src/watchservice.cpp \
+    src/jobserver.cpp \
+    src/evidencecatalog.cpp \
+    src/catalogbuilder.cpp \
+    src/badrangemap.cpp \
+    src/pipelinetuner.cpp \
+    src/jobcontrol.cpp \
+    src/handlebudget.cpp \
+    src/pipelinetrace.cpp \
+    src/rangeverifier.cpp \
+    src/rangecoordinator.cpp \
+    src/rangeworker.cpp \
+    src/imagecomparator.cpp \
+    src/evidencecopier.cpp \
+    src/loadtester.cpp \
+    src/multibufferhasher.cpp
 
 # Header files
 HEADERS += \
     src/mainwindow.h \
     src/ewfhandler.h \
-    src/hashengine.h
+    src/hashengine.h \
+    src/sparsemap.h \
+    src/quickverifier.h \
+    src/clirunner.h \
+    src/prefetchreader.h \
+    src/blockstage.h \
+    src/knownblockindex.h \
+    src/knownblockstage.h \
+    src/similaritydigest.h \
+    src/similaritystage.h \
+    src/entropystage.h \
+    src/ewfwriter.h \
+    src/teewriter.h \
+    src/streamreader.h \
+    src/segmenthasher.h \
+    src/jobtelemetry.h \
+    src/hashkernel.h \
+    src/hashdigest.h \
+    src/watchservice.h \
+    src/jobserver.h \
+    src/evidencecatalog.h \
+    src/catalogbuilder.h \
+    src/badrangemap.h \
+    src/pipelinetuner.h \
+    src/jobcontrol.h \
+    src/handlebudget.h \
+    src/pipelinetrace.h \
+    src/rangeverifier.h \
+    src/rangecoordinator.h \
+    src/rangeworker.h \
+    src/imagecomparator.h \
+    src/evidencecopier.h \
+    src/loadtester.h \
+    src/multibufferhasher.h
 
 # UI files
 FORMS +=
@@ -77,6 +143,15 @@ win32 {
 # libewf library
 LIBS += -lewf
 
+# Memory-mapped segment I/O (custom libbfio handles; POSIX only). Opt in
+# with "qmake CONFIG+=mmap_io"; needs the libbfio headers and library
+unix:mmap_io {
+    DEFINES += E01HASHER_MMAP_IO
+    SOURCES += src/mmapfileio.cpp
+    HEADERS += src/mmapfileio.h
+    LIBS += -lbfio
+}
+
 # Platform-specific crypto libraries
 win32 {
     # Windows CryptoAPI
@@ -93,6 +168,7 @@ win32 {
     LIBS += -lwinmm
     LIBS += -lversion
     LIBS += -luserenv
+    LIBS += -lpsapi
 }
 
 unix {
@@ -0,0 +1,75 @@
+/*
+ * E01 Hash Verification Tool
+ * BadRangeMap Implementation
+ */
+
+#include "badrangemap.h"
+
+BadRangeMap::BadRangeMap()
+    : badBytes(0)
+{
+}
+
+void BadRangeMap::addRange(qint64 offset, qint64 length, Reason reason)
+{
+    if (length <= 0) {
+        return;
+    }
+
+    badBytes += length;
+
+    // Ranges normally arrive in media order; within one read block a
+    // checksum range can precede a read-error range found earlier
+    int index = ranges.size();
+    while (index > 0 && ranges.at(index - 1).offset > offset) {
+        index--;
+    }
+
+    ranges.insert(index, Range{offset, length, reason});
+
+    // Coalesce with the following range, then with the preceding one
+    if (index + 1 < ranges.size()) {
+        Range &next = ranges[index + 1];
+        if (next.reason == reason && offset + length == next.offset) {
+            ranges[index].length += next.length;
+            ranges.removeAt(index + 1);
+        }
+    }
+    if (index > 0) {
+        Range &previous = ranges[index - 1];
+        if (previous.reason == reason && previous.offset + previous.length == offset) {
+            previous.length += ranges.at(index).length;
+            ranges.removeAt(index);
+        }
+    }
+}
+
+void BadRangeMap::clear()
+{
+    ranges.clear();
+    badBytes = 0;
+}
+
+QList<BadRangeMap::Range> BadRangeMap::getRanges() const
+{
+    return ranges;
+}
+
+qint64 BadRangeMap::getBadBytes() const
+{
+    return badBytes;
+}
+
+bool BadRangeMap::isEmpty() const
+{
+    return ranges.isEmpty();
+}
+
+QString BadRangeMap::reasonName(Reason reason)
+{
+    switch (reason) {
+    case READ_ERROR:     return "read error";
+    case CHECKSUM_ERROR: return "checksum error";
+    }
+    return "unknown";
+}
@@ -0,0 +1,49 @@
+/*
+ * E01 Hash Verification Tool
+ * BadRangeMap - Map of unreadable or checksum-failing regions in the media
+ */
+
+#ifndef BADRANGEMAP_H
+#define BADRANGEMAP_H
+
+#include <QList>
+#include <QString>
+#include <QMetaType>
+
+class BadRangeMap
+{
+public:
+    enum Reason {
+        READ_ERROR,       // libewf could not read or inflate the chunk
+        CHECKSUM_ERROR    // Chunk read, but its stored checksum did not match
+    };
+
+    // A contiguous run of damaged bytes, replaced by the fill byte when hashed
+    struct Range {
+        qint64 offset;
+        qint64 length;
+        Reason reason;
+    };
+
+    BadRangeMap();
+
+    // Record a damaged range (ranges must not overlap); ranges are kept in
+    // offset order and adjacent ranges with the same reason are coalesced
+    void addRange(qint64 offset, qint64 length, Reason reason);
+    void clear();
+
+    // Results
+    QList<Range> getRanges() const;
+    qint64 getBadBytes() const;
+    bool isEmpty() const;
+
+    static QString reasonName(Reason reason);
+
+private:
+    QList<Range> ranges;
+    qint64 badBytes;
+};
+
+Q_DECLARE_METATYPE(BadRangeMap)
+
+#endif // BADRANGEMAP_H
@@ -0,0 +1,170 @@
+/*
+ * E01 Hash Verification Tool
+ * BlockStage Implementation
+ */
+
+#include "blockstage.h"
+#include "jobtelemetry.h"
+#include "pipelinetrace.h"
+#include <QDebug>
+#include <QMutexLocker>
+
+BlockStage::BlockStage(QObject *parent)
+    : QThread(parent)
+    , queueDepth(DEFAULT_QUEUE_DEPTH)
+    , telemetry(nullptr)
+    , trace(nullptr)
+    , traceThreadName("stage")
+    , endOfData(false)
+    , aborted(false)
+    , failed(false)
+{
+}
+
+BlockStage::~BlockStage()
+{
+    if (isRunning()) {
+        abort();
+    }
+}
+
+void BlockStage::setQueueDepth(int depth)
+{
+    queueDepth = qMax(1, depth);
+}
+
+void BlockStage::setTelemetry(JobTelemetry *telemetry)
+{
+    this->telemetry = telemetry;
+}
+
+void BlockStage::setTrace(PipelineTrace *trace, const char *threadName)
+{
+    this->trace = trace;
+    traceThreadName = threadName;
+}
+
+bool BlockStage::startStage()
+{
+    endOfData = false;
+    aborted = false;
+    failed = false;
+    queue.clear();
+
+    if (!prepare()) {
+        return false;
+    }
+
+    start();
+    return true;
+}
+
+void BlockStage::submit(const QByteArray &block, qint64 offset)
+{
+    QMutexLocker locker(&mutex);
+
+    if (queue.size() >= queueDepth && !aborted && !failed) {
+        PipelineTrace::Span span(PipelineTrace::EVENT_WAIT_STAGE_FULL, offset);
+        while (queue.size() >= queueDepth && !aborted && !failed) {
+            notFull.wait(&mutex);
+        }
+    }
+
+    // A failed stage stops consuming; its error is reported by finish()
+    if (aborted || failed) {
+        return;
+    }
+
+    queue.enqueue(Item{block, offset});
+    notEmpty.wakeOne();
+}
+
+bool BlockStage::finish()
+{
+    {
+        QMutexLocker locker(&mutex);
+        endOfData = true;
+        notEmpty.wakeOne();
+    }
+
+    wait();
+    return !hasError();
+}
+
+void BlockStage::abort()
+{
+    {
+        QMutexLocker locker(&mutex);
+        aborted = true;
+        queue.clear();
+        notEmpty.wakeOne();
+        notFull.wakeAll();
+    }
+
+    wait();
+}
+
+bool BlockStage::hasError() const
+{
+    QMutexLocker locker(&mutex);
+    return failed;
+}
+
+QString BlockStage::getLastError() const
+{
+    QMutexLocker locker(&mutex);
+    return lastError;
+}
+
+void BlockStage::setError(const QString &errorMsg)
+{
+    QMutexLocker locker(&mutex);
+    failed = true;
+    lastError = errorMsg;
+    queue.clear();
+    notFull.wakeAll();
+    qDebug() << "BlockStage Error:" << errorMsg;
+}
+
+void BlockStage::run()
+{
+    PipelineTrace::ThreadScope traceScope(trace, traceThreadName);
+
+    while (true) {
+        Item item;
+        {
+            QMutexLocker locker(&mutex);
+
+            if (queue.isEmpty() && !endOfData && !aborted && !failed) {
+                PipelineTrace::Span span(PipelineTrace::EVENT_WAIT_STAGE_EMPTY);
+                while (queue.isEmpty() && !endOfData && !aborted && !failed) {
+                    notEmpty.wait(&mutex);
+                }
+            }
+
+            if (aborted || failed) {
+                return;
+            }
+
+            if (queue.isEmpty()) {
+                // End of data and nothing left to process
+                break;
+            }
+
+            item = queue.dequeue();
+            notFull.wakeOne();
+        }
+
+        {
+            PipelineTrace::Span span(PipelineTrace::EVENT_STAGE_BLOCK, item.offset, item.block.size());
+            processBlock(item.block.constData(), item.block.size(), item.offset);
+        }
+        if (telemetry) {
+            telemetry->addToCounter(JobTelemetry::COUNTER_STAGE_PROCESSED, 1);
+        }
+    }
+
+    if (!complete() && !hasError()) {
+        setError("Stage failed to complete");
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ * E01 Hash Verification Tool
+ * BlockStage - Base class for optional analysis stages fed by HashEngine
+ */
+
+#ifndef BLOCKSTAGE_H
+#define BLOCKSTAGE_H
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+
+class JobTelemetry;
+class PipelineTrace;
+
+// Each stage runs on its own thread and receives the same decompressed
+// buffers the hash loop reads. Buffers are implicitly shared QByteArrays,
+// so handing one to a stage does not copy it. The queue is bounded: a stage
+// that falls behind holds back the reader rather than growing without limit.
+class BlockStage : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit BlockStage(QObject *parent = nullptr);
+    ~BlockStage();
+
+    // Buffers the stage may fall behind by before submit() blocks
+    void setQueueDepth(int depth);
+
+    // Count processed blocks in the job's telemetry (optional)
+    void setTelemetry(JobTelemetry *telemetry);
+
+    // Record the worker's blocks and waits on the job's timeline (optional)
+    void setTrace(PipelineTrace *trace, const char *threadName);
+
+    // Prepare on the caller's thread, then start the worker
+    bool startStage();
+
+    // Queue a buffer; blocks while the queue is full
+    void submit(const QByteArray &block, qint64 offset);
+
+    // Drain the queue and wait for the worker (normal completion)
+    bool finish();
+
+    // Drop queued buffers and stop the worker (cancel / error)
+    void abort();
+
+    // Error handling
+    bool hasError() const;
+    QString getLastError() const;
+
+protected:
+    // Stage hooks
+    virtual bool prepare() { return true; }
+    virtual void processBlock(const char *data, qint64 size, qint64 offset) = 0;
+    virtual bool complete() { return true; }
+
+    void setError(const QString &errorMsg);
+    void run() override;
+
+private:
+    struct Item {
+        QByteArray block;
+        qint64 offset;
+    };
+
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    QQueue<Item> queue;
+    int queueDepth;
+    JobTelemetry *telemetry;
+    PipelineTrace *trace;
+    const char *traceThreadName;
+    bool endOfData;
+    bool aborted;
+    bool failed;
+    QString lastError;
+
+    // Constants
+    static const int DEFAULT_QUEUE_DEPTH = 8;
+};
+
+#endif // BLOCKSTAGE_H
@@ -0,0 +1,186 @@
+/*
+ * E01 Hash Verification Tool
+ * CatalogBuilder Implementation
+ */
+
+#include "catalogbuilder.h"
+#include "ewfhandler.h"
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QThreadPool>
+
+CatalogBuilder::CatalogBuilder(const QString &databasePath, const QStringList &roots, QObject *parent)
+    : QThread(parent)
+    , databasePath(databasePath)
+    , roots(roots)
+    , maxOpenImages(DEFAULT_MAX_OPEN_IMAGES)
+    , catalogedCount(0)
+    , failedCount(0)
+    , cancelled(0)
+{
+}
+
+CatalogBuilder::~CatalogBuilder()
+{
+    // Wait for thread to finish
+    if (isRunning()) {
+        cancel();
+        wait();
+    }
+}
+
+void CatalogBuilder::setMaxOpenImages(int count)
+{
+    maxOpenImages = qMax(1, count);
+}
+
+void CatalogBuilder::cancel()
+{
+    cancelled.storeRelease(1);
+}
+
+void CatalogBuilder::run()
+{
+    catalogedCount = 0;
+    failedCount = 0;
+    finished.clear();
+
+    // The connection belongs to this thread
+    EvidenceCatalog catalog(QString("catalog-%1").arg(reinterpret_cast<quintptr>(this)));
+    if (!catalog.open(databasePath)) {
+        emit error(catalog.getLastError());
+        return;
+    }
+
+    QHash<QString, QPair<qint64, qint64>> known = catalog.getFileStamps();
+    int unchangedCount = 0;
+    int submitted = 0;
+    bool storeFailed = false;
+
+    // The pool's thread limit is the open-image limit
+    QThreadPool pool;
+    pool.setMaxThreadCount(maxOpenImages);
+
+    for (const QString &root : roots) {
+        QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext() && !cancelled.loadAcquire()) {
+            QString path = it.next();
+            if (!isFirstSegment(path)) {
+                continue;
+            }
+
+            QFileInfo info(path);
+            QString imagePath = info.absoluteFilePath();
+            qint64 fileSize = info.size();
+            QDateTime modified = info.lastModified();
+
+            auto stamp = known.constFind(imagePath);
+            if (stamp != known.constEnd() && stamp.value().first == fileSize &&
+                stamp.value().second == modified.toMSecsSinceEpoch()) {
+                unchangedCount++;
+                continue;
+            }
+
+            pool.start([this, imagePath, fileSize, modified]() {
+                catalogImage(imagePath, fileSize, modified);
+            });
+            submitted++;
+
+            // Write as the walk goes so a long scan is queryable early
+            if (submitted % BATCH_SIZE == 0 && !storeFinished(catalog)) {
+                storeFailed = true;
+                cancelled.storeRelease(1);
+            }
+        }
+    }
+
+    while (!pool.waitForDone(DRAIN_INTERVAL_MS)) {
+        if (!storeFailed && !storeFinished(catalog)) {
+            storeFailed = true;
+            cancelled.storeRelease(1);
+        }
+    }
+    if (!storeFailed && !storeFinished(catalog)) {
+        storeFailed = true;
+    }
+    catalog.close();
+
+    if (storeFailed) {
+        emit error(catalog.getLastError());
+        return;
+    }
+    if (cancelled.loadAcquire()) {
+        qDebug() << "CatalogBuilder: Cancelled";
+        return;
+    }
+
+    qDebug() << "CatalogBuilder: Cataloged" << catalogedCount << "images," << unchangedCount
+             << "unchanged," << failedCount << "failed";
+    emit catalogComplete(catalogedCount, unchangedCount, failedCount);
+}
+
+// ===== Private Helper Functions =====
+
+void CatalogBuilder::catalogImage(const QString &imagePath, qint64 fileSize, const QDateTime &modified)
+{
+    if (cancelled.loadAcquire()) {
+        return;
+    }
+
+    CatalogEntry entry;
+    entry.path = imagePath;
+    entry.fileSize = fileSize;
+    entry.modified = modified;
+
+    // Opening reads the section lists, header and hash sections; the
+    // media chunks are never touched
+    EWFHandler handler;
+    if (handler.open(imagePath)) {
+        QMap<QString, QString> metadata = handler.getMetadata();
+        entry.caseNumber = metadata.value("case_number");
+        entry.evidenceNumber = metadata.value("evidence_number");
+        entry.examinerName = metadata.value("examiner_name");
+        entry.description = metadata.value("description");
+        entry.notes = metadata.value("notes");
+        entry.acquiryDate = metadata.value("acquiry_date");
+        entry.mediaSize = handler.getMediaSize();
+        entry.segmentCount = handler.getSegmentFiles().size();
+        entry.storedMD5 = metadata.value("stored_md5");
+        entry.storedSHA1 = metadata.value("stored_sha1");
+        handler.close();
+    } else {
+        // Recorded too, so a damaged image is not retried until it changes
+        entry.error = handler.getLastError();
+        emit imageFailed(imagePath, entry.error);
+    }
+
+    QMutexLocker locker(&finishedMutex);
+    finished.append(entry);
+}
+
+bool CatalogBuilder::storeFinished(EvidenceCatalog &catalog)
+{
+    QList<CatalogEntry> batch;
+    {
+        QMutexLocker locker(&finishedMutex);
+        batch.swap(finished);
+    }
+
+    for (const CatalogEntry &entry : batch) {
+        if (entry.error.isEmpty()) {
+            catalogedCount++;
+        } else {
+            failedCount++;
+        }
+    }
+
+    return catalog.store(batch);
+}
+
+bool CatalogBuilder::isFirstSegment(const QString &fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "e01" || suffix == "ex01";
+}
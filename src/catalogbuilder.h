@@ -0,0 +1,70 @@
+/*
+ * E01 Hash Verification Tool
+ * CatalogBuilder - Parallel metadata scan of an evidence tree
+ */
+
+#ifndef CATALOGBUILDER_H
+#define CATALOGBUILDER_H
+
+#include <QThread>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMutex>
+#include <QAtomicInt>
+#include "evidencecatalog.h"
+
+// Walks directory trees for first segments (.E01 / .Ex01) and records each
+// image's header values and stored hashes in an EvidenceCatalog. Images are
+// opened by a pool of workers, so at most maxOpenImages are open at once;
+// no media data is read. Results are written from this thread in batched
+// transactions, and images whose first segment has the same size and
+// timestamp as in the catalog are skipped.
+class CatalogBuilder : public QThread
+{
+    Q_OBJECT
+
+public:
+    CatalogBuilder(const QString &databasePath, const QStringList &roots, QObject *parent = nullptr);
+    ~CatalogBuilder();
+
+    // Images opened concurrently (each holds its segment files open)
+    void setMaxOpenImages(int count);
+
+    // Control
+    void cancel();
+
+signals:
+    void imageFailed(const QString &imagePath, const QString &reason);
+    void catalogComplete(int cataloged, int unchanged, int failed);
+    void error(const QString &errorMessage);
+
+protected:
+    void run() override;
+
+private:
+    void catalogImage(const QString &imagePath, qint64 fileSize, const QDateTime &modified);
+    bool storeFinished(EvidenceCatalog &catalog);
+    static bool isFirstSegment(const QString &fileName);
+
+    QString databasePath;
+    QStringList roots;
+    int maxOpenImages;
+
+    // Entries finished by workers, not yet written
+    QMutex finishedMutex;
+    QList<CatalogEntry> finished;
+    int catalogedCount;
+    int failedCount;
+
+    // Control flags (set by cancel() and on a store failure, read by the
+    // pool workers; a cancel before run() starts is kept)
+    QAtomicInt cancelled;
+
+    // Constants
+    static const int DEFAULT_MAX_OPEN_IMAGES = 8;
+    static const int BATCH_SIZE = 256;
+    static const int DRAIN_INTERVAL_MS = 500;
+};
+
+#endif // CATALOGBUILDER_H
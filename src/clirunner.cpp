@@ -0,0 +1,1698 @@
+/*
+ * E01 Hash Verification Tool
+ * CliRunner Implementation
+ */
+
+#include "clirunner.h"
+#include "prefetchreader.h"
+#include "knownblockindex.h"
+#include "similaritydigest.h"
+#include "streamreader.h"
+#include "hashkernel.h"
+#include "multibufferhasher.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDebug>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QProcess>
+#include <QThread>
+#include <cstdio>
+
+const char *const CliRunner::RANGE_TOKEN_VARIABLE = "E01HASHER_RANGE_TOKEN";
+
+CliRunner::CliRunner(QObject *parent)
+    : QObject(parent)
+    , out(stdout)
+    , err(stderr)
+    , ewfHandler(nullptr)
+    , hashEngine(nullptr)
+    , quickVerifier(nullptr)
+    , imageComparator(nullptr)
+    , evidenceCopier(nullptr)
+    , watchService(nullptr)
+    , jobServer(nullptr)
+    , catalogBuilder(nullptr)
+    , rangeCoordinator(nullptr)
+    , rangeWorker(nullptr)
+    , loadTester(nullptr)
+    , zeroChunkMap(false)
+    , similarity(false)
+    , segmentHashes(false)
+    , entropyRegionSize(0)
+    , streamInput(false)
+    , expectedStreamSize(0)
+    , passThrough(false)
+    , teeSegmentSize(0)
+    , verifyOutput(false)
+    , outputBytes(0)
+    , continueOnError(false)
+    , fillByte(0)
+    , autoTune(false)
+    , rateLimit(0.0)
+    , background(false)
+    , multiBuffer(false)
+    , rangeSize(0)
+    , pieceSize(0)
+    , spawnWorkers(0)
+    , localRangeWorkers(0)
+    , rangeTimeout(-1)
+    , imageHashed(false)
+    , rangesComplete(false)
+    , hashMD5(false)
+    , hashSHA1(false)
+    , hashSHA256(false)
+    , hashParallelReads(1)
+    , hashReadSize(0)
+{
+    progressTimer.setInterval(PROGRESS_INTERVAL_MS);
+    connect(&progressTimer, &QTimer::timeout, this, &CliRunner::onProgressTimer);
+}
+
+CliRunner::~CliRunner()
+{
+    // Stop any running job before tearing down the handler it reads from
+    if (hashEngine) {
+        hashEngine->cancel();
+        hashEngine->wait();
+        delete hashEngine;
+    }
+
+    if (quickVerifier) {
+        quickVerifier->cancel();
+        quickVerifier->wait();
+        delete quickVerifier;
+    }
+
+    if (imageComparator) {
+        imageComparator->cancel();
+        imageComparator->wait();
+        delete imageComparator;
+    }
+
+    if (evidenceCopier) {
+        evidenceCopier->cancel();
+        evidenceCopier->wait();
+        delete evidenceCopier;
+    }
+
+    if (ewfHandler) {
+        ewfHandler->close();
+        delete ewfHandler;
+    }
+}
+
+int CliRunner::run(const QStringList &arguments)
+{
+    return dispatch(arguments, false);
+}
+
+bool CliRunner::isCommandLine(const QStringList &arguments)
+{
+    CliRunner runner;
+    return runner.dispatch(arguments, true) == EXIT_VERIFIED;
+}
+
+int CliRunner::dispatch(const QStringList &arguments, bool classifyOnly)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Forensic image hash verification utility");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("image", "First segment of the image to verify (e.g. image.E01), "
+                                          "or - to hash a raw stream from stdin");
+
+    QCommandLineOption md5Option("md5", "Calculate MD5.");
+    QCommandLineOption sha1Option("sha1", "Calculate SHA1.");
+    QCommandLineOption sha256Option("sha256", "Calculate SHA256.");
+    QCommandLineOption expectedMD5Option("expected-md5",
+        "Expected MD5 (overrides the hash stored in the image).", "hash");
+    QCommandLineOption expectedSHA1Option("expected-sha1",
+        "Expected SHA1 (overrides the hash stored in the image).", "hash");
+    QCommandLineOption expectedSHA256Option("expected-sha256", "Expected SHA256.", "hash");
+    QCommandLineOption streamOption("stream",
+        "Treat the input as a raw byte stream (named pipe or file) rather than an EWF image; "
+        "implied when the input is -.");
+    QCommandLineOption expectedSizeOption("expected-size",
+        "Expected stream length in bytes, for progress and a size check.", "bytes");
+    QCommandLineOption passThroughOption("pass-through",
+        "Copy the stream to stdout so the tool can sit in a pipeline (the report goes to stderr).");
+    QCommandLineOption quickOption("quick",
+        "Quick triage: read a random sample of chunks instead of hashing the whole image.");
+    QCommandLineOption samplesOption("samples",
+        "Number of chunks to sample in quick mode (default 4096).", "count");
+    QCommandLineOption seedOption("seed",
+        "Random seed for quick mode; reuse a reported seed to repeat a run.", "seed");
+    QCommandLineOption threadsOption("threads",
+        "Number of parallel readers in quick mode.", "count");
+    QCommandLineOption compareImageOption("compare-image",
+        "Compare the image with this one (E01 or raw, either side): hash both in one lockstep "
+        "pass and list the byte ranges that differ.", "image");
+    QCommandLineOption parallelReadsOption("parallel-reads",
+        "Keep this many large reads outstanding (disables tuning; default: chosen by tuning).", "count");
+    QCommandLineOption readSizeOption("read-size",
+        "Size of each parallel read in MB (disables tuning; default 8).", "MB");
+    QCommandLineOption noTuneOption("no-tune",
+        "Skip the start-of-job calibration; use one reader (8 on SMB/NFS) and the cache-blocked kernel.");
+    QCommandLineOption sparseMapOption("sparse-map",
+        "Also map the all-zero chunks of the media (one more scan of every buffer).");
+    QCommandLineOption similarityOption("similarity",
+        "Also compute an ssdeep-compatible similarity digest of the media "
+        "(one per 192 GiB region, ';'-separated, for larger media).");
+    QCommandLineOption segmentHashesOption("segment-hashes",
+        "Also hash each segment file (.E01 ... .Exx) as stored on disk (with --mmap, as libewf "
+        "reads it; otherwise after the media read).");
+    QCommandLineOption compareSimilarityOption("compare-similarity",
+        "Compare the media's similarity digest with this one (implies --similarity).", "digest");
+    QCommandLineOption entropyMapOption("entropy-map",
+        "Write a per-region entropy / zero / 0xFF map of the media as a PPM image.", "file");
+    QCommandLineOption entropyRegionOption("entropy-region",
+        "Region size in KB for --entropy-map (default 1024).", "KB");
+    QCommandLineOption teeOption("tee",
+        "Also write the image contents to this file while hashing: raw, or a new "
+        "E01 if the name ends in .E01.", "output");
+    QCommandLineOption teeSegmentOption("tee-segment-size",
+        "Segment size in MB for an E01 --tee output (default 1536).", "MB");
+    QCommandLineOption verifyOutputOption("verify-output",
+        "Read the --tee output back and check its MD5 against the source.");
+    QCommandLineOption continueOnErrorOption("continue-on-error",
+        "Hash past unreadable or checksum-failing chunks: each is hashed as the fill byte and "
+        "listed in a bad-range map; the digests are then hashes with substitutions.");
+    QCommandLineOption fillByteOption("fill-byte",
+        "Byte substituted for damaged chunks with --continue-on-error, in hex (default 00).", "hex");
+    QCommandLineOption knownBlocksOption("known-blocks",
+        "Look up every block in this known-block index and report the hits.", "index");
+    QCommandLineOption knownBlocksReportOption("known-blocks-report",
+        "Where to write the known-block hit report (default <image>.knownblocks.csv).", "csv");
+    QCommandLineOption buildIndexOption("build-block-index",
+        "Build a known-block index from a list of MD5 block hashes; the positional "
+        "argument is then the index file to write.", "list");
+    QCommandLineOption watchOption("watch",
+        "Watch this directory (repeatable) and verify each acquisition once its segments are complete; "
+        "runs until stopped.", "dir");
+    QCommandLineOption reportDirOption("report-dir",
+        "Directory for --watch verification reports (default: ./reports).", "dir", "reports");
+    QCommandLineOption stableSecondsOption("stable-seconds",
+        "Seconds a segment set must stay unchanged before --watch verifies it (default 120).", "seconds");
+    QCommandLineOption serveOption("serve",
+        "Run as a job server on this local socket name: clients submit, list, cancel and "
+        "follow verification jobs as JSON lines; runs until stopped.", "name");
+    QCommandLineOption workersOption("workers",
+        "Jobs a --serve server hashes at once (default 2).", "count");
+    QCommandLineOption multiBufferOption("multi-buffer",
+        "Hash the SHA-1 / SHA-256 of concurrent --serve and --load-test jobs together, several "
+        "streams per AVX2 instruction, driven by the jobs' own threads (MD5 stays with each job). "
+        "Pays off with more jobs than cores on CPUs without the SHA extensions.");
+    QCommandLineOption loadTestOption("load-test",
+        "Load-test the job server in-process at these concurrencies (comma separated, e.g. 1,8,32) "
+        "with synthetic E01 fixtures; reports latency and throughput percentiles, CPU and RSS.", "levels");
+    QCommandLineOption loadJobsOption("load-jobs",
+        "Jobs per --load-test level (default: twice the concurrency, at least 8).", "count");
+    QCommandLineOption submitRateOption("submit-rate",
+        "Jobs submitted per second in --load-test (default: all at once).", "jobs/s");
+    QCommandLineOption fixtureSizeOption("fixture-size",
+        "Media size of each --load-test fixture in MB (default 256).", "MB");
+    QCommandLineOption fixtureDirOption("fixture-dir",
+        "Keep --load-test fixtures here and reuse them on later runs (default: a temporary directory).", "dir");
+    QCommandLineOption loadReportOption("load-report",
+        "Write the --load-test results as JSON, for comparison between runs.", "file");
+    QCommandLineOption catalogOption("catalog",
+        "Metadata catalog database. With directories as arguments, scan them for images and add "
+        "their headers and stored hashes; without, list catalog entries matching the filters below.",
+        "db");
+    QCommandLineOption maxOpenOption("max-open",
+        "Images a --catalog scan opens at once (default 8).", "count");
+    QCommandLineOption caseOption("case", "--catalog filter: case number.", "number");
+    QCommandLineOption evidenceOption("evidence", "--catalog filter: evidence number.", "number");
+    QCommandLineOption examinerOption("examiner", "--catalog filter: examiner name contains.", "name");
+    QCommandLineOption storedHashOption("stored-hash", "--catalog filter: stored MD5 or SHA1.", "hash");
+    QCommandLineOption minSizeOption("min-size", "--catalog filter: minimum media size in bytes.", "bytes");
+    QCommandLineOption maxSizeOption("max-size", "--catalog filter: maximum media size in bytes.", "bytes");
+    QCommandLineOption rateLimitOption("rate-limit",
+        "Limit each job's reads to this many MB/s (for --watch and --serve, the per-job default).",
+        "MB/s");
+    QCommandLineOption totalRateLimitOption("total-rate-limit",
+        "Limit the reads of all jobs in this process together to this many MB/s.", "MB/s");
+    QCommandLineOption backgroundOption("background",
+        "Run jobs in the idle I/O class and at the lowest CPU priority, so acquisitions on the "
+        "same storage come first.");
+    QCommandLineOption segmentHandlesOption("segment-handles",
+        "Segment files kept open per image (default 0: sized from the segment count and the "
+        "process descriptor budget shared by all jobs; -1: keep every segment open).", "count");
+    QCommandLineOption mmapOption("mmap",
+        "Read segment files through memory maps instead of read() calls (local storage only; "
+        "network shares always use normal reads; needs a build with CONFIG+=mmap_io).");
+    QCommandLineOption traceOption("trace",
+        "Record every read, hash update and queue wait on each pipeline thread and write the "
+        "timeline as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev) when the job ends.",
+        "file");
+    QCommandLineOption copyToOption("copy-to",
+        "Copy the segment files to this directory, read the copies back past the page cache "
+        "and check them against the source, then hash the media from the copy.", "dir");
+    QCommandLineOption coordinateOption("coordinate",
+        "Spread chunk checksum validation, piecewise hashes and --known-blocks lookups over "
+        "--range-worker processes that connect on this address (local socket name or tcp:HOST:PORT); "
+        "the image MD5/SHA is still hashed here as one stream.", "address");
+    QCommandLineOption rangeWorkerOption("range-worker",
+        "Verify ranges for the --coordinate process at this address until it has none left.", "address");
+    QCommandLineOption rangeSizeOption("range-size",
+        "MB of media handed to a --range-worker at a time (default 1024).", "MB");
+    QCommandLineOption pieceSizeOption("piece-size",
+        "Piecewise hash size in MB for --coordinate (default: one piece per range).", "MB");
+    QCommandLineOption spawnWorkersOption("spawn-workers",
+        "Start this many local --range-worker processes for --coordinate.", "count");
+    QCommandLineOption rangeTokenOption("range-token",
+        "Shared token between --coordinate and --range-worker (default: the "
+        "E01HASHER_RANGE_TOKEN environment variable; a TCP coordinator generates one if unset).", "token");
+    QCommandLineOption rangeTimeoutOption("range-timeout",
+        "Seconds a --range-worker may spend on one range before the range is handed out "
+        "again (default 1800, 0 = no limit).", "seconds");
+    QCommandLineOption benchKernelsOption("bench-kernels",
+        "Benchmark the hash update kernels (one pass per algorithm vs cache-blocked) and the "
+        "multi-buffer SHA lanes (vs one context per job), and exit.");
+    QCommandLineOption blockSizeOption("block-size",
+        "Block size in bytes for --build-block-index (power of two, default 4096).", "bytes");
+
+    parser.addOptions({md5Option, sha1Option, sha256Option,
+                       expectedMD5Option, expectedSHA1Option, expectedSHA256Option,
+                       streamOption, expectedSizeOption, passThroughOption,
+                       quickOption, samplesOption, seedOption, threadsOption, compareImageOption,
+                       parallelReadsOption, readSizeOption, noTuneOption,
+                       rateLimitOption, totalRateLimitOption, backgroundOption, segmentHandlesOption, mmapOption,
+                       traceOption,
+                       sparseMapOption, similarityOption, compareSimilarityOption, segmentHashesOption,
+                       continueOnErrorOption, fillByteOption,
+                       entropyMapOption, entropyRegionOption,
+                       teeOption, teeSegmentOption, verifyOutputOption,
+                       knownBlocksOption, knownBlocksReportOption,
+                       buildIndexOption, blockSizeOption, benchKernelsOption,
+                       watchOption, reportDirOption, stableSecondsOption,
+                       serveOption, workersOption, multiBufferOption,
+                       loadTestOption, loadJobsOption, submitRateOption, fixtureSizeOption, fixtureDirOption,
+                       loadReportOption,
+                       copyToOption, coordinateOption, rangeWorkerOption, rangeSizeOption, pieceSizeOption, spawnWorkersOption,
+                       rangeTokenOption, rangeTimeoutOption,
+                       catalogOption, maxOpenOption, caseOption, evidenceOption, examinerOption,
+                       storedHashOption, minSizeOption, maxSizeOption});
+
+    // Only say whether one of the options above (or - for stdin) was given;
+    // single-dash words are read whole, so Qt's -reverse is not -v
+    if (classifyOnly) {
+        parser.setSingleDashWordOptionMode(QCommandLineParser::ParseAsLongOptions);
+        parser.parse(arguments);
+        bool commandLine = !parser.optionNames().isEmpty() || parser.positionalArguments().contains("-");
+        return commandLine ? EXIT_VERIFIED : EXIT_ERROR;
+    }
+
+    parser.process(arguments);
+
+    if (parser.isSet(benchKernelsOption)) {
+        return benchmarkKernels();
+    }
+
+    // Apply to every kind of job below
+    rateLimit = qMax(0.0, parser.value(rateLimitOption).toDouble());
+    background = parser.isSet(backgroundOption);
+    multiBuffer = parser.isSet(multiBufferOption);
+    if (multiBuffer && !MultiBufferHasher::isSupported()) {
+        err << "--multi-buffer needs AVX2 and lanes that pass their self-test (see --bench-kernels); "
+               "SHA is hashed within each job\n";
+        err.flush();
+    } else if (multiBuffer && MultiBufferHasher::hasShaExtensions()) {
+        err << "--multi-buffer: this CPU has the SHA extensions, which usually hash faster per job\n";
+        err.flush();
+    }
+    if (parser.isSet(totalRateLimitOption)) {
+        JobControl::setGlobalRateLimit(parser.value(totalRateLimitOption).toDouble());
+    }
+    EWFHandler::setMaximumOpenHandles(parser.value(segmentHandlesOption).toInt());
+    EWFHandler::setMemoryMappedIO(parser.isSet(mmapOption));
+    if (parser.isSet(mmapOption) && !EWFHandler::isMemoryMappedIOAvailable()) {
+        err << "Warning: this build has no memory-mapped I/O (qmake CONFIG+=mmap_io); using normal reads\n";
+        err.flush();
+    }
+    rangeToken = parser.isSet(rangeTokenOption) ? parser.value(rangeTokenOption)
+                                                : qEnvironmentVariable(RANGE_TOKEN_VARIABLE);
+
+    if (parser.isSet(watchOption)) {
+        bool md5 = parser.isSet(md5Option);
+        bool sha1 = parser.isSet(sha1Option);
+        bool sha256 = parser.isSet(sha256Option);
+        if (!md5 && !sha1 && !sha256) {
+            md5 = true;
+            sha1 = true;
+        }
+        return runWatchService(parser.values(watchOption), parser.value(reportDirOption),
+                               parser.value(stableSecondsOption).toInt(), md5, sha1, sha256);
+    }
+
+    if (parser.isSet(serveOption)) {
+        return runJobServer(parser.value(serveOption), parser.value(workersOption).toInt());
+    }
+
+    if (parser.isSet(rangeWorkerOption)) {
+        return runRangeWorker(parser.value(rangeWorkerOption));
+    }
+
+    if (parser.isSet(loadTestOption)) {
+        return runLoadTest(parser.value(loadTestOption), parser.value(loadJobsOption).toInt(),
+                           parser.value(submitRateOption).toDouble(),
+                           parser.value(fixtureSizeOption).toLongLong() * 1024 * 1024,
+                           parser.value(fixtureDirOption), parser.value(loadReportOption),
+                           parser.isSet(md5Option), parser.isSet(sha1Option), parser.isSet(sha256Option));
+    }
+
+    const QStringList positional = parser.positionalArguments();
+
+    if (parser.isSet(catalogOption)) {
+        if (!positional.isEmpty()) {
+            return buildCatalog(parser.value(catalogOption), positional, parser.value(maxOpenOption).toInt());
+        }
+
+        CatalogQuery filter;
+        filter.caseNumber = parser.value(caseOption);
+        filter.evidenceNumber = parser.value(evidenceOption);
+        filter.examinerName = parser.value(examinerOption);
+        filter.storedHash = parser.value(storedHashOption);
+        if (parser.isSet(minSizeOption)) {
+            filter.minSize = parser.value(minSizeOption).toLongLong();
+        }
+        if (parser.isSet(maxSizeOption)) {
+            filter.maxSize = parser.value(maxSizeOption).toLongLong();
+        }
+        return queryCatalog(parser.value(catalogOption), filter);
+    }
+
+    if (positional.size() != 1) {
+        err << "Error: exactly one image file must be given\n\n" << parser.helpText();
+        err.flush();
+        return EXIT_ERROR;
+    }
+
+    if (parser.isSet(buildIndexOption)) {
+        qint64 blockSize = parser.isSet(blockSizeOption)
+            ? parser.value(blockSizeOption).toLongLong() : DEFAULT_INDEX_BLOCK_SIZE;
+        return buildBlockIndex(parser.value(buildIndexOption), positional.first(), blockSize);
+    }
+
+    if (parser.isSet(compareImageOption)) {
+        bool md5 = parser.isSet(md5Option);
+        bool sha1 = parser.isSet(sha1Option);
+        bool sha256 = parser.isSet(sha256Option);
+        if (!md5 && !sha1 && !sha256) {
+            md5 = true;
+            sha1 = true;
+        }
+        if (!startImageCompare(positional.first(), parser.value(compareImageOption), md5, sha1, sha256,
+                               parser.value(parallelReadsOption).toInt(),
+                               parser.value(readSizeOption).toLongLong() * 1024 * 1024)) {
+            return EXIT_ERROR;
+        }
+        return QCoreApplication::exec();
+    }
+
+    streamInput = parser.isSet(streamOption) || StreamReader::isStdin(positional.first());
+    expectedStreamSize = parser.value(expectedSizeOption).toLongLong();
+    passThrough = streamInput && parser.isSet(passThroughOption);
+
+    // stdout carries the data; keep it clean
+    if (passThrough) {
+        reportFile.open(stderr, QIODevice::WriteOnly);
+        out.setDevice(&reportFile);
+    }
+
+    // Hashes given on the command line take precedence over stored ones
+    if (parser.isSet(expectedMD5Option)) {
+        expected["MD5"] = parser.value(expectedMD5Option).toLower();
+    }
+    if (parser.isSet(expectedSHA1Option)) {
+        expected["SHA1"] = parser.value(expectedSHA1Option).toLower();
+    }
+    if (parser.isSet(expectedSHA256Option)) {
+        expected["SHA256"] = parser.value(expectedSHA256Option).toLower();
+    }
+
+    if (parser.isSet(knownBlocksOption)) {
+        knownBlockIndexPath = parser.value(knownBlocksOption);
+        knownBlockReportPath = parser.isSet(knownBlocksReportOption)
+            ? parser.value(knownBlocksReportOption)
+            : positional.first() + ".knownblocks.csv";
+    }
+
+    compareDigest = parser.value(compareSimilarityOption);
+    zeroChunkMap = parser.isSet(sparseMapOption);
+    similarity = parser.isSet(similarityOption) || !compareDigest.isEmpty();
+    segmentHashes = parser.isSet(segmentHashesOption);
+    continueOnError = parser.isSet(continueOnErrorOption);
+    if (parser.isSet(fillByteOption)) {
+        bool ok = false;
+        uint value = parser.value(fillByteOption).toUInt(&ok, 16);
+        if (!ok || value > 0xFF) {
+            err << "Error: --fill-byte must be a hex byte (00 - ff)\n";
+            err.flush();
+            return EXIT_ERROR;
+        }
+        fillByte = static_cast<quint8>(value);
+    }
+    entropyMapPath = parser.value(entropyMapOption);
+    entropyRegionSize = parser.value(entropyRegionOption).toLongLong() * 1024;
+    teeOutputPath = parser.value(teeOption);
+    teeSegmentSize = parser.value(teeSegmentOption).toLongLong() * 1024 * 1024;
+    verifyOutput = parser.isSet(verifyOutputOption) && !teeOutputPath.isEmpty();
+    tracePath = parser.value(traceOption);
+    coordinateAddress = parser.value(coordinateOption);
+    rangeSize = parser.value(rangeSizeOption).toLongLong() * 1024 * 1024;
+    pieceSize = parser.value(pieceSizeOption).toLongLong() * 1024 * 1024;
+    spawnWorkers = parser.value(spawnWorkersOption).toInt();
+    rangeTimeout = parser.isSet(rangeTimeoutOption) ? parser.value(rangeTimeoutOption).toInt() : -1;
+    if (!coordinateAddress.isEmpty() && (streamInput || parser.isSet(quickOption))) {
+        err << "Error: --coordinate needs an EWF image and a full verification\n";
+        err.flush();
+        return EXIT_ERROR;
+    }
+    copyDestination = parser.value(copyToOption);
+    if (!copyDestination.isEmpty() && (streamInput || parser.isSet(quickOption))) {
+        err << "Error: --copy-to needs an EWF image and a full verification\n";
+        err.flush();
+        return EXIT_ERROR;
+    }
+
+    bool started;
+    if (parser.isSet(quickOption) && !streamInput) {
+        started = startQuickVerify(positional.first(),
+                                   parser.value(samplesOption).toInt(),
+                                   parser.value(seedOption),
+                                   parser.value(threadsOption).toInt());
+    } else {
+        // Default to the same algorithms the GUI pre-selects
+        bool md5 = parser.isSet(md5Option);
+        bool sha1 = parser.isSet(sha1Option);
+        bool sha256 = parser.isSet(sha256Option);
+        if (!md5 && !sha1 && !sha256) {
+            md5 = true;
+            sha1 = true;
+        }
+
+        // Output verification compares MD5s
+        if (verifyOutput) {
+            md5 = true;
+        }
+
+        // Calibrate per job unless the reader setup was given explicitly
+        autoTune = !parser.isSet(noTuneOption) && !parser.isSet(parallelReadsOption) &&
+                   !parser.isSet(readSizeOption) && !streamInput;
+
+        // With --copy-to the media is hashed from the copy once it has been
+        // read back, so only the copier reads the source
+        QString imagePath = positional.first();
+        if (!copyDestination.isEmpty()) {
+            imagePath = QDir(copyDestination).filePath(QFileInfo(imagePath).fileName());
+        }
+
+        // Network shares default to several outstanding reads
+        int parallelReads = parser.value(parallelReadsOption).toInt();
+        if (!autoTune && !parser.isSet(parallelReadsOption) && !streamInput &&
+            PrefetchReader::isNetworkPath(imagePath)) {
+            parallelReads = NETWORK_PARALLEL_READS;
+        }
+
+        hashMD5 = md5;
+        hashSHA1 = sha1;
+        hashSHA256 = sha256;
+        hashParallelReads = parallelReads;
+        hashReadSize = parser.value(readSizeOption).toLongLong() * 1024 * 1024;
+
+        if (!copyDestination.isEmpty()) {
+            started = startCopy(positional.first());
+        } else {
+            started = startHashing(imagePath);
+        }
+    }
+
+    if (!started) {
+        return EXIT_ERROR;
+    }
+
+    return QCoreApplication::exec();
+}
+
+bool CliRunner::startVerification(const QString &path, bool md5, bool sha1, bool sha256,
+                                  int parallelReads, qint64 readSize)
+{
+    if (streamInput) {
+        out << "Input:      " << (StreamReader::isStdin(path) ? QString("stdin") : path) << " (raw stream)\n";
+        if (expectedStreamSize > 0) {
+            out << "Expected:   " << expectedStreamSize << " bytes\n";
+            expected["Size"] = QString::number(expectedStreamSize);
+        }
+        out.flush();
+    } else {
+        ewfHandler = new EWFHandler();
+        if (!ewfHandler->open(path)) {
+            err << "Error: failed to open file: " << ewfHandler->getLastError() << "\n";
+            err.flush();
+            return false;
+        }
+
+        QMap<QString, QString> metadata = ewfHandler->getMetadata();
+        if (!expected.contains("MD5")) {
+            expected["MD5"] = metadata.value("stored_md5");
+        }
+        if (!expected.contains("SHA1")) {
+            expected["SHA1"] = metadata.value("stored_sha1");
+        }
+
+        out << "File:       " << path << "\n";
+        out << "Media size: " << ewfHandler->getMediaSize() << " bytes\n";
+        if (ewfHandler->isMemoryMapped()) {
+            out << "Segment I/O: memory-mapped\n";
+        }
+        if (ewfHandler->getSegmentFiles().size() > 1) {
+            int handleLimit = ewfHandler->getOpenHandleLimit();
+            out << "Segments:   " << ewfHandler->getSegmentFiles().size() << " files, "
+                << (handleLimit > 0 ? QString("at most %1 open").arg(handleLimit) : QString("all open")) << "\n";
+        }
+        out.flush();
+    }
+
+    // In stream mode the engine reads the stream and has no EWF handler
+    hashEngine = new HashEngine(ewfHandler);
+    if (streamInput) {
+        hashEngine->setInputStream(path, expectedStreamSize, passThrough);
+    }
+
+    connect(hashEngine, &HashEngine::md5Calculated, this, &CliRunner::onMD5Calculated);
+    connect(hashEngine, &HashEngine::sha1Calculated, this, &CliRunner::onSHA1Calculated);
+    connect(hashEngine, &HashEngine::sha256Calculated, this, &CliRunner::onSHA256Calculated);
+    connect(hashEngine, &HashEngine::sparseMapCalculated, this, &CliRunner::onSparseMapCalculated);
+    connect(hashEngine, &HashEngine::knownBlocksMatched, this, &CliRunner::onKnownBlocksMatched);
+    connect(hashEngine, &HashEngine::similarityDigestCalculated, this, &CliRunner::onSimilarityDigestCalculated);
+    connect(hashEngine, &HashEngine::similarityDigestSkipped, this, &CliRunner::onSimilarityDigestSkipped);
+    connect(hashEngine, &HashEngine::segmentHashesCalculated, this, &CliRunner::onSegmentHashesCalculated);
+    connect(hashEngine, &HashEngine::badRangesFound, this, &CliRunner::onBadRangesFound);
+    connect(hashEngine, &HashEngine::pipelineTuned, this, &CliRunner::onPipelineTuned);
+    connect(hashEngine, &HashEngine::entropyMapWritten, this, &CliRunner::onEntropyMapWritten);
+    connect(hashEngine, &HashEngine::teeOutputWritten, this, &CliRunner::onTeeOutputWritten);
+    connect(hashEngine, &HashEngine::verificationComplete, this, &CliRunner::onVerificationComplete);
+    connect(hashEngine, &HashEngine::error, this, &CliRunner::onError);
+
+    hashEngine->enableMD5(md5);
+    hashEngine->enableSHA1(sha1);
+    hashEngine->enableSHA256(sha256);
+    hashEngine->enableSparseMap(zeroChunkMap);
+    hashEngine->enableSimilarityDigest(similarity);
+    hashEngine->enableSegmentHashes(segmentHashes);
+    if (continueOnError && !streamInput) {
+        hashEngine->enableContinueOnError(true, fillByte);
+        out << QString("Damaged chunks: hashed as 0x%1 and mapped\n").arg(fillByte, 2, 16, QChar('0'));
+        out.flush();
+    }
+    if (!entropyMapPath.isEmpty()) {
+        hashEngine->setEntropyMap(entropyMapPath, entropyRegionSize);
+    }
+
+    if (rateLimit > 0.0) {
+        hashEngine->getControl().setRateLimit(rateLimit);
+        out << "Rate limit: " << rateLimit << " MB/s\n";
+        out.flush();
+    }
+    if (background) {
+        hashEngine->getControl().setPriority(JobControl::PRIORITY_BACKGROUND);
+        out << "Priority:   background (idle I/O, lowest CPU)\n";
+        out.flush();
+    }
+
+    hashEngine->enableAutoTune(autoTune);
+    if (parallelReads > 1) {
+        hashEngine->setParallelReads(parallelReads, readSize);
+        out << "Reads:      " << parallelReads << " outstanding requests\n";
+        out.flush();
+    }
+
+    if (!teeOutputPath.isEmpty()) {
+        hashEngine->setTeeOutput(teeOutputPath, teeSegmentSize, verifyOutput);
+        out << "Output:     " << teeOutputPath << "\n";
+        out.flush();
+    }
+
+    if (!tracePath.isEmpty()) {
+        hashEngine->setTraceOutput(tracePath);
+        out << "Trace:      " << tracePath << " (written when the job ends)\n";
+        out.flush();
+    }
+
+    // With --coordinate the range workers do the lookups
+    if (!knownBlockIndexPath.isEmpty() && coordinateAddress.isEmpty()) {
+        hashEngine->setKnownBlockIndex(knownBlockIndexPath, knownBlockReportPath);
+        out << "Known blocks: " << knownBlockIndexPath << "\n";
+        out.flush();
+    }
+
+    if (!expected.value("MD5").isEmpty()) {
+        hashEngine->setExpectedMD5(expected.value("MD5"));
+    }
+    if (!expected.value("SHA1").isEmpty()) {
+        hashEngine->setExpectedSHA1(expected.value("SHA1"));
+    }
+    if (!expected.value("SHA256").isEmpty()) {
+        hashEngine->setExpectedSHA256(expected.value("SHA256"));
+    }
+
+    hashEngine->start();
+    progressTimer.start();
+    return true;
+}
+
+bool CliRunner::startQuickVerify(const QString &path, int samples, const QString &seed, int threads)
+{
+    quickVerifier = new QuickVerifier(path);
+
+    if (samples > 0) {
+        quickVerifier->setSampleCount(samples);
+    }
+    if (!seed.isEmpty()) {
+        bool ok = false;
+        quint32 value = seed.toUInt(&ok);
+        if (!ok) {
+            err << "Error: invalid seed: " << seed << "\n";
+            err.flush();
+            return false;
+        }
+        quickVerifier->setSeed(value);
+    }
+    if (threads > 0) {
+        quickVerifier->setThreadCount(threads);
+    }
+
+    connect(quickVerifier, &QuickVerifier::progressUpdate, this, &CliRunner::onQuickProgressUpdate);
+    connect(quickVerifier, &QuickVerifier::quickVerifyComplete, this, &CliRunner::onQuickVerifyComplete);
+    connect(quickVerifier, &QuickVerifier::error, this, &CliRunner::onError);
+
+    out << "File:       " << path << "\n";
+    out << "Mode:       quick verification (random chunk sample)\n";
+    out.flush();
+
+    quickVerifier->start();
+    return true;
+}
+
+bool CliRunner::startImageCompare(const QString &pathA, const QString &pathB, bool md5, bool sha1, bool sha256,
+                                  int parallelReads, qint64 blockSize)
+{
+    if (StreamReader::isStdin(pathA) || StreamReader::isStdin(pathB)) {
+        err << "Error: --compare-image needs two image files\n";
+        err.flush();
+        return false;
+    }
+
+    imageComparator = new ImageComparator(pathA, pathB);
+    imageComparator->setAlgorithms(md5, sha1, sha256);
+    imageComparator->setParallelReads(parallelReads);
+    if (blockSize > 0) {
+        imageComparator->setBlockSize(blockSize);
+    }
+
+    connect(imageComparator, &ImageComparator::compareComplete, this, &CliRunner::onCompareComplete);
+    connect(imageComparator, &ImageComparator::error, this, &CliRunner::onError);
+
+    out << "File A:     " << pathA << (EWFHandler::isEwfImage(pathA) ? "" : " (raw)") << "\n";
+    out << "File B:     " << pathB << (EWFHandler::isEwfImage(pathB) ? "" : " (raw)") << "\n";
+    out << "Mode:       lockstep comparison\n";
+    if (rateLimit > 0.0) {
+        imageComparator->getControl().setRateLimit(rateLimit);
+        out << "Rate limit: " << rateLimit << " MB/s\n";
+    }
+    if (background) {
+        imageComparator->getControl().setPriority(JobControl::PRIORITY_BACKGROUND);
+        out << "Priority:   background (idle I/O, lowest CPU)\n";
+    }
+    out.flush();
+
+    imageComparator->start();
+    progressTimer.start();
+    return true;
+}
+
+int CliRunner::buildBlockIndex(const QString &listPath, const QString &indexPath, qint64 blockSize)
+{
+    // Blocks must tile the read buffers exactly
+    bool powerOfTwo = blockSize > 0 && (blockSize & (blockSize - 1)) == 0;
+    if (!powerOfTwo || blockSize < 512 || blockSize > 1024 * 1024) {
+        err << "Error: block size must be a power of two between 512 and 1048576\n";
+        err.flush();
+        return EXIT_ERROR;
+    }
+
+    QString errorMessage;
+    if (!KnownBlockIndex::build(listPath, indexPath, static_cast<quint32>(blockSize), &errorMessage)) {
+        err << "Error: " << errorMessage << "\n";
+        err.flush();
+        return EXIT_ERROR;
+    }
+
+    KnownBlockIndex index;
+    if (!index.open(indexPath)) {
+        err << "Error: " << index.getLastError() << "\n";
+        err.flush();
+        return EXIT_ERROR;
+    }
+
+    out << "Index:      " << indexPath << "\n";
+    out << "Hashes:     " << index.getEntryCount() << "\n";
+    out << "Block size: " << index.getBlockSize() << " bytes\n";
+    out.flush();
+    return EXIT_VERIFIED;
+}
+
+int CliRunner::benchmarkKernels()
+{
+    // Timings of a kernel that gets the wrong answer are worthless
+    QString failure;
+    if (!HashKernel::verifyEquivalence(&failure)) {
+        err << "Error: blocked kernel digests differ from one pass per algorithm for " << failure << "\n";
+        err.flush();
+        return EXIT_ERROR;
+    }
+    out << "Equivalence: blocked kernels match one pass per algorithm for all 7 algorithm sets\n";
+
+    out << QString("Hashing %1 MB in %2 KB read blocks; blocked kernels use %3 KB sub-blocks\n")
+        .arg(HashKernel::DEFAULT_BENCH_POOL_SIZE / (1024*1024))
+        .arg(HashKernel::BENCH_BLOCK_SIZE / 1024)
+        .arg(HashKernel::SUB_BLOCK_SIZE / 1024);
+    out.flush();
+
+    const QList<KernelBenchResult> results = HashKernel::benchmark();
+
+    out << QString("%1 %2 %3 %4\n")
+        .arg("Algorithms", -16).arg("Passes", 8).arg("Sequential", 14).arg("Blocked", 14);
+    for (const KernelBenchResult &result : results) {
+        // Each read block crosses the cache hierarchy once per pass
+        out << QString("%1 %2 %3 %4\n")
+            .arg(result.algorithms, -16)
+            .arg(QString("%1 -> 1").arg(result.algorithmCount), 8)
+            .arg(QString("%1 MB/s").arg(result.sequentialMBps, 0, 'f', 0), 14)
+            .arg(QString("%1 MB/s").arg(result.blockedMBps, 0, 'f', 0), 14);
+    }
+    out.flush();
+
+    // The shared lanes are only timed (or given a job) once they reproduce
+    // the reference digests
+    if (!MultiBufferHasher::selfTest(&failure)) {
+        err << "Error: multi-buffer SHA lanes give a wrong digest for " << failure << "\n";
+        err.flush();
+        return EXIT_ERROR;
+    }
+    out << "Multi-buffer: FIPS 180 vectors and " << MultiBufferHasher::LANE_COUNT + 3
+        << " uneven concurrent streams match the platform implementation\n";
+    out << QString("Multi-buffer: each thread hashes %1 MB of the same pool in %2 KB reads; "
+                   "one lane set per core (%3), %4 lanes per set\n")
+        .arg(MultiBufferHasher::DEFAULT_BENCH_STREAM_SIZE / (1024*1024))
+        .arg(HashKernel::BENCH_BLOCK_SIZE / 1024)
+        .arg(QThread::idealThreadCount())
+        .arg(MultiBufferHasher::LANE_COUNT);
+    out.flush();
+
+    const QList<MultiBufferBenchResult> laneResults = MultiBufferHasher::benchmark();
+
+    out << QString("%1 %2 %3 %4 %5\n")
+        .arg("Algorithm", -10).arg("Threads", 8).arg("Lane sets", 10).arg("Lanes", 12).arg("Per job", 12);
+    for (const MultiBufferBenchResult &result : laneResults) {
+        out << QString("%1 %2 %3 %4 %5\n")
+            .arg(result.algorithm, -10)
+            .arg(result.streams, 8)
+            .arg(result.laneSets, 10)
+            .arg(QString("%1 MB/s").arg(result.lanesMBps, 0, 'f', 0), 12)
+            .arg(QString("%1 MB/s").arg(result.perJobMBps, 0, 'f', 0), 12);
+    }
+    out.flush();
+    return EXIT_VERIFIED;
+}
+
+int CliRunner::runWatchService(const QStringList &directories, const QString &reportDirectory,
+                               int stableSeconds, bool md5, bool sha1, bool sha256)
+{
+    watchService = new WatchService(this);
+    connect(watchService, &WatchService::acquisitionQueued, this, &CliRunner::onAcquisitionQueued);
+    connect(watchService, &WatchService::verificationStarted, this, &CliRunner::onWatchVerificationStarted);
+    connect(watchService, &WatchService::verificationFinished, this, &CliRunner::onWatchVerificationFinished);
+    connect(watchService, &WatchService::error, this, &CliRunner::onWatchError);
+
+    for (const QString &directory : directories) {
+        if (!watchService->addDirectory(directory)) {
+            err << "Error: not a directory: " << directory << "\n";
+            err.flush();
+            return EXIT_ERROR;
+        }
+    }
+    watchService->setReportDirectory(reportDirectory);
+    if (stableSeconds > 0) {
+        watchService->setStableSeconds(stableSeconds);
+    }
+    watchService->setAlgorithms(md5, sha1, sha256);
+    watchService->setRateLimit(rateLimit);
+    watchService->setBackground(background);
+
+    if (!watchService->start()) {
+        return EXIT_ERROR;
+    }
+
+    out << "Watching:   " << directories.join(", ") << "\n";
+    out << "Reports:    " << reportDirectory << "\n";
+    out.flush();
+
+    return QCoreApplication::exec();
+}
+
+int CliRunner::runJobServer(const QString &name, int workers)
+{
+    jobServer = new JobServer(this);
+    connect(jobServer, &JobServer::jobStarted, this, &CliRunner::onServerJobStarted);
+    connect(jobServer, &JobServer::jobFinished, this, &CliRunner::onServerJobFinished);
+    connect(jobServer, &JobServer::error, this, &CliRunner::onWatchError);
+
+    if (workers > 0) {
+        jobServer->setWorkerCount(workers);
+    }
+    jobServer->setDefaultRateLimit(rateLimit);
+    jobServer->setDefaultBackground(background);
+    jobServer->setMultiBufferHashing(multiBuffer);
+
+    if (!jobServer->listen(name)) {
+        return EXIT_ERROR;
+    }
+
+    out << "Serving:    " << jobServer->serverName() << "\n";
+    out.flush();
+
+    return QCoreApplication::exec();
+}
+
+int CliRunner::runLoadTest(const QString &levels, int jobs, double submitRate, qint64 fixtureSize,
+                           const QString &fixtureDir, const QString &reportPath, bool md5, bool sha1, bool sha256)
+{
+    QList<int> concurrency;
+    for (const QString &level : levels.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        int value = level.trimmed().toInt(&ok);
+        if (!ok || value < 1) {
+            err << "Error: --load-test takes concurrency levels such as 1,8,32\n";
+            err.flush();
+            return EXIT_ERROR;
+        }
+        concurrency.append(value);
+    }
+
+    QStringList algorithms;
+    if (md5) {
+        algorithms << "md5";
+    }
+    if (sha1) {
+        algorithms << "sha1";
+    }
+    if (sha256) {
+        algorithms << "sha256";
+    }
+
+    loadTester = new LoadTester(this);
+    connect(loadTester, &LoadTester::fixtureReady, this, &CliRunner::onLoadFixtureReady);
+    connect(loadTester, &LoadTester::levelStarted, this, &CliRunner::onLoadLevelStarted);
+    connect(loadTester, &LoadTester::levelComplete, this, &CliRunner::onLoadLevelComplete);
+    connect(loadTester, &LoadTester::loadTestComplete, this, &CliRunner::onLoadTestComplete);
+    connect(loadTester, &LoadTester::error, this, &CliRunner::onError);
+
+    loadTester->setConcurrencyLevels(concurrency);
+    loadTester->setJobsPerLevel(jobs);
+    loadTester->setSubmitRate(submitRate);
+    loadTester->setFixtures(fixtureSize, 0, fixtureDir);
+    loadTester->setAlgorithms(algorithms);
+    loadTester->setReportPath(reportPath);
+    loadTester->setMultiBufferHashing(multiBuffer);
+
+    out << "Load test:  concurrency " << levels << ", "
+        << (submitRate > 0.0 ? QString("%1 jobs/s").arg(submitRate) : QString("all jobs at once")) << "\n";
+    out.flush();
+
+    if (!loadTester->start()) {
+        return EXIT_ERROR;
+    }
+
+    return QCoreApplication::exec();
+}
+
+bool CliRunner::startDistribution(const QString &path)
+{
+    rangeCoordinator = new RangeCoordinator(this);
+    connect(rangeCoordinator, &RangeCoordinator::workerJoined, this, &CliRunner::onRangeWorkerJoined);
+    connect(rangeCoordinator, &RangeCoordinator::workerLost, this, &CliRunner::onRangeWorkerLost);
+    connect(rangeCoordinator, &RangeCoordinator::rangeVerified, this, &CliRunner::onRangeVerified);
+    connect(rangeCoordinator, &RangeCoordinator::distributionComplete, this, &CliRunner::onDistributionComplete);
+    connect(rangeCoordinator, &RangeCoordinator::error, this, &CliRunner::onError);
+
+    rangeCoordinator->setImage(path, ewfHandler->getMediaSize());
+    rangeCoordinator->setRangeSize(rangeSize);
+    rangeCoordinator->setPieceSize(pieceSize);
+    rangeCoordinator->setFillByte(fillByte);
+    if (rangeTimeout >= 0) {
+        rangeCoordinator->setTaskTimeout(rangeTimeout);
+    }
+    rangeCoordinator->setToken(rangeToken);
+    if (!knownBlockIndexPath.isEmpty()) {
+        rangeCoordinator->setKnownBlockIndex(knownBlockIndexPath, knownBlockReportPath);
+    }
+
+    if (!rangeCoordinator->listen(coordinateAddress)) {
+        return false;
+    }
+    rangeCoordinator->start();
+
+    out << "Coordinator: " << rangeCoordinator->serverAddress() << " (" << rangeCoordinator->getRangeCount()
+        << " ranges)\n";
+    if (rangeToken.isEmpty() && !rangeCoordinator->getToken().isEmpty()) {
+        out << "Worker token: " << rangeCoordinator->getToken() << " (give remote workers --range-token or "
+            << RANGE_TOKEN_VARIABLE << ")\n";
+    }
+    out.flush();
+
+    // Local workers, mainly for a single host with many cores; remote ones
+    // connect by themselves. The token goes through the environment, where
+    // other users cannot read it off the command line.
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(RANGE_TOKEN_VARIABLE, rangeCoordinator->getToken());
+
+    for (int i = 0; i < spawnWorkers; ++i) {
+        QProcess *process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        process->setProcessEnvironment(environment);
+
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this](int exitCode, QProcess::ExitStatus status) {
+            onLocalRangeWorkerExited(status == QProcess::CrashExit ? QString("crashed")
+                                     : exitCode != 0 ? QString("exited with code %1").arg(exitCode)
+                                     : QString());
+        });
+        connect(process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError processError) {
+            // Every other error is followed by finished()
+            if (processError == QProcess::FailedToStart) {
+                onLocalRangeWorkerExited("could not be started");
+            }
+        });
+
+        ++localRangeWorkers;
+        process->start(QCoreApplication::applicationFilePath(),
+                       QStringList() << "--range-worker" << rangeCoordinator->serverAddress());
+    }
+    return true;
+}
+
+bool CliRunner::startHashing(const QString &path)
+{
+    if (!startVerification(path, hashMD5, hashSHA1, hashSHA256, hashParallelReads, hashReadSize)) {
+        return false;
+    }
+    if (!coordinateAddress.isEmpty()) {
+        return startDistribution(path);
+    }
+    return true;
+}
+
+bool CliRunner::startCopy(const QString &path)
+{
+    // Only the segment list is needed here; the copier is the one reader
+    // of the source, and onCopyComplete hashes the media from the copy
+    EWFHandler source;
+    if (!source.open(path)) {
+        err << "Error: failed to open file: " << source.getLastError() << "\n";
+        err.flush();
+        return false;
+    }
+    QStringList segments = source.getSegmentFiles();
+    source.close();
+
+    evidenceCopier = new EvidenceCopier(segments, copyDestination);
+    evidenceCopier->getControl().setRateLimit(rateLimit);
+    if (background) {
+        evidenceCopier->getControl().setPriority(JobControl::PRIORITY_BACKGROUND);
+    }
+    connect(evidenceCopier, &EvidenceCopier::copyComplete, this, &CliRunner::onCopyComplete);
+    connect(evidenceCopier, &EvidenceCopier::error, this, &CliRunner::onError);
+
+    out << "Source:     " << path << "\n";
+    out << "Copy to:    " << copyDestination << " (" << segments.size()
+        << " segment files, read back when written; the media is then hashed from the copy)\n";
+    out.flush();
+
+    evidenceCopier->start();
+    progressTimer.start();
+    return true;
+}
+
+int CliRunner::runRangeWorker(const QString &address)
+{
+    rangeWorker = new RangeWorker(this);
+    connect(rangeWorker, &RangeWorker::finished, this, &CliRunner::onRangeWorkerFinished);
+    connect(rangeWorker, &RangeWorker::error, this, &CliRunner::onError);
+
+    if (!rangeWorker->connectTo(address, rangeToken)) {
+        return EXIT_ERROR;
+    }
+
+    out << "Worker:     connected to " << address << "\n";
+    out.flush();
+
+    return QCoreApplication::exec();
+}
+
+int CliRunner::buildCatalog(const QString &databasePath, const QStringList &roots, int maxOpenImages)
+{
+    for (const QString &root : roots) {
+        if (!QFileInfo(root).isDir()) {
+            err << "Error: not a directory: " << root << "\n";
+            err.flush();
+            return EXIT_ERROR;
+        }
+    }
+
+    catalogBuilder = new CatalogBuilder(databasePath, roots, this);
+    connect(catalogBuilder, &CatalogBuilder::imageFailed, this, &CliRunner::onCatalogImageFailed);
+    connect(catalogBuilder, &CatalogBuilder::catalogComplete, this, &CliRunner::onCatalogComplete);
+    connect(catalogBuilder, &CatalogBuilder::error, this, &CliRunner::onError);
+    if (maxOpenImages > 0) {
+        catalogBuilder->setMaxOpenImages(maxOpenImages);
+    }
+
+    out << "Cataloging: " << roots.join(", ") << "\n";
+    out << "Catalog:    " << databasePath << "\n";
+    out.flush();
+
+    catalogBuilder->start();
+    return QCoreApplication::exec();
+}
+
+int CliRunner::queryCatalog(const QString &databasePath, const CatalogQuery &filter)
+{
+    if (!QFileInfo::exists(databasePath)) {
+        err << "Error: catalog not found: " << databasePath << "\n";
+        err.flush();
+        return EXIT_ERROR;
+    }
+
+    QList<CatalogEntry> entries;
+    {
+        EvidenceCatalog catalog("catalog-query");
+        if (!catalog.open(databasePath)) {
+            err << "Error: " << catalog.getLastError() << "\n";
+            err.flush();
+            return EXIT_ERROR;
+        }
+        entries = catalog.find(filter);
+        if (!catalog.getLastError().isEmpty()) {
+            err << "Error: " << catalog.getLastError() << "\n";
+            err.flush();
+            return EXIT_ERROR;
+        }
+    }
+
+    // Tab-separated, one image per line, for grep / spreadsheets
+    out << "path\tcase\tevidence\texaminer\tmedia_size\tsegments\tstored_md5\tstored_sha1\tacquired\n";
+    for (const CatalogEntry &entry : entries) {
+        out << entry.path << "\t" << entry.caseNumber << "\t" << entry.evidenceNumber << "\t"
+            << entry.examinerName << "\t" << entry.mediaSize << "\t" << entry.segmentCount << "\t"
+            << entry.storedMD5 << "\t" << entry.storedSHA1 << "\t"
+            << (entry.error.isEmpty() ? entry.acquiryDate : "ERROR: " + entry.error) << "\n";
+    }
+    out.flush();
+
+    err << entries.size() << " image(s)\n";
+    err.flush();
+    return EXIT_VERIFIED;
+}
+
+// ===== Slot Implementations =====
+
+void CliRunner::onProgressTimer()
+{
+    const JobTelemetry *telemetry = nullptr;
+    QString activity;
+    if (hashEngine && !imageHashed) {
+        telemetry = &hashEngine->getTelemetry();
+        activity = "Processing";
+    } else if (evidenceCopier) {
+        telemetry = &evidenceCopier->getTelemetry();
+        activity = evidenceCopier->isReadingBack() ? "Reading back" : "Copying";
+    } else if (imageComparator) {
+        telemetry = &imageComparator->getTelemetry();
+        activity = "Comparing";
+    } else {
+        return;
+    }
+
+    TelemetrySnapshot progress = telemetry->snapshot();
+    QString rate = QString("%1 MB/s").arg(progress.bytesPerSecond() / (1024*1024), 0, 'f', 1);
+
+    // A stream of unknown length has no percentage
+    if (progress.totalBytes <= 0) {
+        err << QString("\r%1: %2 MB, %3")
+            .arg(activity)
+            .arg(progress.bytesProcessed / (1024*1024))
+            .arg(rate);
+    } else {
+        err << QString("\r%1: %2 / %3 MB (%4%), %5")
+            .arg(activity)
+            .arg(progress.bytesProcessed / (1024*1024))
+            .arg(progress.totalBytes / (1024*1024))
+            .arg(progress.percentage())
+            .arg(rate);
+        if (progress.remainingMs() >= 0) {
+            err << ", " << JobTelemetry::formatDuration(progress.remainingMs()) << " left";
+        }
+    }
+    // Trailing spaces clear what a longer previous line left behind
+    err << "    ";
+    err.flush();
+}
+
+void CliRunner::onMD5Calculated(const QString &hash)
+{
+    calculated["MD5"] = hash;
+}
+
+void CliRunner::onSHA1Calculated(const QString &hash)
+{
+    calculated["SHA1"] = hash;
+}
+
+void CliRunner::onSHA256Calculated(const QString &hash)
+{
+    calculated["SHA256"] = hash;
+}
+
+void CliRunner::onSparseMapCalculated(const SparseMap &map)
+{
+    sparseMap = map;
+}
+
+void CliRunner::onKnownBlocksMatched(qint64 knownGood, qint64 knownBad, const QString &reportPath)
+{
+    knownBlockSummary = QString("Known blocks: %1 known-good, %2 known-bad (report: %3)\n")
+        .arg(knownGood)
+        .arg(knownBad)
+        .arg(reportPath);
+}
+
+void CliRunner::onSimilarityDigestCalculated(const QString &digest)
+{
+    similarityDigest = digest;
+}
+
+void CliRunner::onSimilarityDigestSkipped(const QString &reason)
+{
+    similarityWarning = reason;
+}
+
+void CliRunner::onSegmentHashesCalculated(const SegmentHashList &hashes)
+{
+    segmentHashList = hashes;
+}
+
+void CliRunner::onPipelineTuned(const QStringList &reasons)
+{
+    for (const QString &reason : reasons) {
+        out << "Tuning:     " << reason << "\n";
+    }
+    out.flush();
+}
+
+void CliRunner::onBadRangesFound(const BadRangeMap &map)
+{
+    badRangeMap = map;
+}
+
+void CliRunner::onTeeOutputWritten(const QString &outputPath, qint64 bytesWritten, const QString &md5)
+{
+    Q_UNUSED(outputPath);
+    outputBytes = bytesWritten;
+    outputMD5 = md5;
+}
+
+void CliRunner::onEntropyMapWritten(const QString &mapPath, qint64 regions, qint64 highEntropyRegions,
+                                    qint64 wipedRegions)
+{
+    entropySummary = QString("Entropy map: %1 regions, %2 high-entropy, %3 wiped (map: %4)\n")
+        .arg(regions)
+        .arg(highEntropyRegions)
+        .arg(wipedRegions)
+        .arg(mapPath);
+}
+
+void CliRunner::onVerificationComplete(const QMap<QString, bool> &results)
+{
+    // One last sample so the progress line ends on the final figures
+    if (progressTimer.isActive()) {
+        progressTimer.stop();
+        onProgressTimer();
+        err << "\n";
+        err.flush();
+    }
+
+    // With range workers the report waits for the last range
+    if (rangeCoordinator && !rangesComplete) {
+        imageResults = results;
+        imageHashed = true;
+        return;
+    }
+
+    if (results.contains("Size")) {
+        calculated["Size"] = QString::number(hashEngine->getTelemetry().snapshot().bytesProcessed);
+    }
+
+    // Digests over substituted data are never a verification
+    bool substituted = !badRangeMap.isEmpty();
+
+    bool allPassed = !substituted;
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        QString label = (substituted && it.key() != "Size") ? it.key() + " (with substitutions)" : it.key();
+        printResult(label, calculated.value(it.key()), expected.value(it.key()), it.value());
+        if (!it.value()) {
+            allPassed = false;
+        }
+    }
+
+    if (substituted) {
+        out << QString("Damaged:    %1 bytes in %2 ranges, hashed as 0x%3\n")
+            .arg(badRangeMap.getBadBytes())
+            .arg(badRangeMap.getRanges().size())
+            .arg(fillByte, 2, 16, QChar('0'));
+        for (const BadRangeMap::Range &range : badRangeMap.getRanges()) {
+            out << QString("  %1 - %2 (%3 bytes) %4\n")
+                .arg(range.offset)
+                .arg(range.offset + range.length - 1)
+                .arg(range.length)
+                .arg(BadRangeMap::reasonName(range.reason));
+        }
+    } else if (continueOnError && !streamInput) {
+        out << "Damaged:    none\n";
+    }
+
+    if (sparseMap.getTotalBytes() > 0) {
+        out << QString("Zero-filled regions: %1 MB in %2 ranges\n")
+            .arg(sparseMap.getZeroBytes() / (1024*1024))
+            .arg(sparseMap.getRanges().size());
+    }
+    if (!teeOutputPath.isEmpty()) {
+        out << "Output:     " << outputBytes << " bytes written to " << teeOutputPath << "\n";
+        if (verifyOutput) {
+            bool outputVerified = !outputMD5.isEmpty() && outputMD5 == calculated.value("MD5");
+            printResult("Output MD5", outputMD5, calculated.value("MD5"), outputVerified);
+            if (!outputVerified) {
+                allPassed = false;
+            }
+        }
+    }
+
+    // Range workers' results: chunk checksums, then the piecewise hashes
+    if (rangeCoordinator) {
+        BadRangeMap damaged = rangeCoordinator->getBadRanges();
+        out << QString("Ranges:     %1 verified by %2 workers\n")
+            .arg(rangeCoordinator->getRangeCount())
+            .arg(rangeCoordinator->getWorkersSeen());
+        if (damaged.isEmpty()) {
+            out << "Chunks:     all checksums valid\n";
+        } else {
+            out << QString("Chunks:     %1 damaged bytes in %2 ranges\n")
+                .arg(damaged.getBadBytes())
+                .arg(damaged.getRanges().size());
+            for (const BadRangeMap::Range &range : damaged.getRanges()) {
+                out << QString("  %1 - %2 (%3 bytes) %4\n")
+                    .arg(range.offset)
+                    .arg(range.offset + range.length - 1)
+                    .arg(range.length)
+                    .arg(BadRangeMap::reasonName(range.reason));
+            }
+            allPassed = false;
+        }
+
+        const PieceHashList pieces = rangeCoordinator->getPieces();
+        out << "Pieces:     " << pieces.size() << " (MD5 SHA1, damaged chunks hashed as zeros)\n";
+        for (const PieceHash &piece : pieces) {
+            out << QString("  %1 - %2 %3 %4%5\n")
+                .arg(piece.offset)
+                .arg(piece.offset + piece.length - 1)
+                .arg(piece.md5)
+                .arg(piece.sha1)
+                .arg(piece.damaged ? " (damaged)" : "");
+        }
+    }
+
+    // Copies read back from the destination against the source hashes
+    if (evidenceCopier) {
+        out << "Copied:     " << copiedSegments.size() << " segment files to " << copyDestination << "\n";
+        for (const CopiedSegment &segment : copiedSegments) {
+            out << QString("  %1  %2 %3 %4\n")
+                .arg(QFileInfo(segment.destinationPath).fileName())
+                .arg(segment.md5)
+                .arg(segment.sha1)
+                .arg(segment.verified ? "[READ BACK OK]" : "[READ BACK FAILED]");
+            if (!segment.error.isEmpty()) {
+                out << "    " << segment.error << "\n";
+            }
+            if (!segment.verified) {
+                allPassed = false;
+            }
+        }
+    }
+
+    out << knownBlockSummary;
+    out << entropySummary;
+
+    // Container files, for chain-of-custody records
+    if (!segmentHashList.isEmpty()) {
+        out << "Segments:   " << segmentHashList.size() << " files\n";
+        for (const SegmentHash &segment : segmentHashList) {
+            QString name = QFileInfo(segment.path).fileName();
+            if (!segment.error.isEmpty()) {
+                out << "  " << name << ": unreadable - " << segment.error << "\n";
+                allPassed = false;
+                continue;
+            }
+            out << "  " << name << " (" << segment.size << " bytes)\n";
+            out << "    MD5:  " << segment.md5 << "\n";
+            out << "    SHA1: " << segment.sha1 << "\n";
+        }
+    }
+
+    if (!similarityDigest.isEmpty()) {
+        out << "ssdeep:     " << similarityDigest << "\n";
+        if (!compareDigest.isEmpty()) {
+            out << "Similarity: " << SimilarityDigest::compare(similarityDigest, compareDigest)
+                << " / 100\n";
+        }
+    } else if (!similarityWarning.isEmpty()) {
+        out << "ssdeep:     not computed (" << similarityWarning << ")\n";
+    }
+    out.flush();
+
+    finish(allPassed ? EXIT_VERIFIED : EXIT_MISMATCH);
+}
+
+void CliRunner::onQuickProgressUpdate(int percentage, int samplesChecked, int totalSamples)
+{
+    err << QString("\rSampling: %1 / %2 chunks (%3%)")
+        .arg(samplesChecked)
+        .arg(totalSamples)
+        .arg(percentage);
+    err.flush();
+}
+
+void CliRunner::onQuickVerifyComplete(const QuickVerifyResult &result)
+{
+    err << "\n";
+    err.flush();
+
+    out << "Seed:       " << result.seed << "\n";
+    out << QString("Sampled:    %1 of %2 chunks (%3 bytes each)\n")
+        .arg(result.samplesChecked)
+        .arg(result.totalChunks)
+        .arg(result.chunkSize);
+    out << "Failures:   " << result.failures << "\n";
+    for (qint64 offset : result.failedOffsets) {
+        out << "  Damaged chunk at offset " << offset << "\n";
+    }
+
+    if (result.failures == 0) {
+        out << QString("Result:     PLAUSIBLY INTACT - 95% confidence that at most %1% of chunks are damaged\n")
+            .arg(result.damageUpperBound * 100.0, 0, 'f', 3);
+    } else {
+        out << QString("Result:     DAMAGED - an estimated %1% to %2% of chunks are damaged\n")
+            .arg(100.0 * result.failures / result.samplesChecked, 0, 'f', 3)
+            .arg(result.damageUpperBound * 100.0, 0, 'f', 3);
+    }
+    out << QString("Elapsed:    %1 s\n").arg(result.elapsedMs / 1000.0, 0, 'f', 1);
+    out.flush();
+
+    finish(result.failures == 0 ? EXIT_VERIFIED : EXIT_MISMATCH);
+}
+
+void CliRunner::onCompareComplete(const ImageCompareResult &result)
+{
+    // One last sample so the progress line ends on the final figures
+    progressTimer.stop();
+    onProgressTimer();
+    err << "\n";
+    err.flush();
+
+    out << QString("Size:       A %1 bytes, B %2 bytes%3\n")
+        .arg(result.sizeA)
+        .arg(result.sizeB)
+        .arg(result.sizeA == result.sizeB ? "" : " (DIFFERENT)");
+    for (auto it = result.hashesA.constBegin(); it != result.hashesA.constEnd(); ++it) {
+        QString hashB = result.hashesB.value(it.key());
+        out << QString(it.key() + " A:").leftJustified(12) << it.value() << "\n";
+        out << QString(it.key() + " B:").leftJustified(12) << hashB
+            << (hashB == it.value() ? " [MATCH]" : " [DIFFERENT]") << "\n";
+    }
+
+    if (result.differingBytes > 0) {
+        out << QString("Differs:    %1 bytes in %2 ranges%3\n")
+            .arg(result.differingBytes)
+            .arg(result.differingRanges.size())
+            .arg(result.rangesTruncated ? " (list truncated)" : "");
+        for (const QPair<qint64, qint64> &range : result.differingRanges) {
+            out << QString("  %1 - %2 (%3 bytes)\n")
+                .arg(range.first)
+                .arg(range.first + range.second - 1)
+                .arg(range.second);
+        }
+    }
+
+    out << "Result:     " << (result.identical() ? "IDENTICAL" : "DIFFERENT") << "\n";
+    out << QString("Elapsed:    %1 s\n").arg(result.elapsedMs / 1000.0, 0, 'f', 1);
+    out.flush();
+
+    finish(result.identical() ? EXIT_VERIFIED : EXIT_MISMATCH);
+}
+
+void CliRunner::onCopyComplete(const CopiedSegmentList &segments)
+{
+    // End the copy's progress line before the hash starts its own
+    progressTimer.stop();
+    onProgressTimer();
+    err << "\n";
+    err.flush();
+
+    copiedSegments = segments;
+
+    // The copy holds the same bytes and was just read back uncached, so
+    // hashing it leaves the source with a single read
+    if (!startHashing(copiedSegments.first().destinationPath)) {
+        finish(EXIT_ERROR);
+    }
+}
+
+void CliRunner::onError(const QString &message)
+{
+    progressTimer.stop();
+    err << "\nError: " << message << "\n";
+    err.flush();
+    finish(EXIT_ERROR);
+}
+
+void CliRunner::onAcquisitionQueued(const QString &imagePath)
+{
+    out << QDateTime::currentDateTime().toString(Qt::ISODate) << "  Queued    " << imagePath << "\n";
+    out.flush();
+}
+
+void CliRunner::onWatchVerificationStarted(const QString &imagePath)
+{
+    out << QDateTime::currentDateTime().toString(Qt::ISODate) << "  Verifying " << imagePath << "\n";
+    out.flush();
+}
+
+void CliRunner::onWatchVerificationFinished(const QString &imagePath, WatchService::Verdict verdict,
+                                            const QString &reportPath)
+{
+    const char *label = "FAILED    ";
+    if (verdict == WatchService::VERDICT_VERIFIED) {
+        label = "Verified  ";
+    } else if (verdict == WatchService::VERDICT_COMPUTED) {
+        label = "Computed  ";
+    } else if (verdict == WatchService::VERDICT_MISMATCH) {
+        label = "MISMATCH  ";
+    }
+
+    out << QDateTime::currentDateTime().toString(Qt::ISODate) << "  "
+        << label << imagePath << " (report: " << reportPath << ")\n";
+    out.flush();
+}
+
+void CliRunner::onWatchError(const QString &message)
+{
+    // The service keeps running; only startup errors end it
+    err << QDateTime::currentDateTime().toString(Qt::ISODate) << "  Error: " << message << "\n";
+    err.flush();
+}
+
+void CliRunner::onServerJobStarted(int jobId, const QString &imagePath)
+{
+    out << QDateTime::currentDateTime().toString(Qt::ISODate) << "  Job " << jobId << " verifying "
+        << imagePath << "\n";
+    out.flush();
+}
+
+void CliRunner::onServerJobFinished(int jobId, const QString &imagePath, const QString &state)
+{
+    out << QDateTime::currentDateTime().toString(Qt::ISODate) << "  Job " << jobId << " " << state
+        << " " << imagePath << "\n";
+    out.flush();
+}
+
+void CliRunner::onLoadFixtureReady(const QString &path)
+{
+    out << "Fixture:    " << path << "\n";
+    out.flush();
+}
+
+void CliRunner::onLoadLevelStarted(int concurrency, int jobs)
+{
+    err << QString("Running %1 jobs at concurrency %2...\n").arg(jobs).arg(concurrency);
+    err.flush();
+
+    // Header once, before the first row
+    if (loadTester->getResults().isEmpty()) {
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+            .arg("Jobs", 6).arg("Conc.", 6)
+            .arg("Latency p50/p90/p99 ms", 24)
+            .arg("1st progress p50 ms", 20)
+            .arg("Job MB/s p10/p50", 18)
+            .arg("Total MB/s", 11)
+            .arg("CPU %", 7)
+            .arg("Peak RSS MB", 12)
+            .arg("Failed", 7)
+            .arg("SHA lanes", 10);
+        out.flush();
+    }
+}
+
+void CliRunner::onLoadLevelComplete(const LoadLevelResult &result)
+{
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10\n")
+        .arg(result.jobs, 6)
+        .arg(result.concurrency, 6)
+        .arg(QString("%1/%2/%3").arg(result.latencyP50, 0, 'f', 0)
+                                .arg(result.latencyP90, 0, 'f', 0)
+                                .arg(result.latencyP99, 0, 'f', 0), 24)
+        .arg(QString::number(result.firstProgressP50, 'f', 0), 20)
+        .arg(QString("%1/%2").arg(result.jobMBpsP10, 0, 'f', 0).arg(result.jobMBpsP50, 0, 'f', 0), 18)
+        .arg(QString::number(result.aggregateMBps, 'f', 0), 11)
+        .arg(QString::number(result.cpuPercent, 'f', 0), 7)
+        .arg(result.peakRssBytes / (1024*1024), 12)
+        .arg(result.failed, 7)
+        .arg(result.lanesFilled > 0.0 ? QString::number(result.lanesFilled, 'f', 1) : QString("-"), 10);
+    out.flush();
+}
+
+void CliRunner::onLoadTestComplete()
+{
+    int failed = 0;
+    for (const LoadLevelResult &result : loadTester->getResults()) {
+        failed += result.failed;
+    }
+    finish(failed == 0 ? EXIT_VERIFIED : EXIT_MISMATCH);
+}
+
+void CliRunner::onCatalogImageFailed(const QString &imagePath, const QString &reason)
+{
+    err << "Cannot open " << imagePath << ": " << reason << "\n";
+    err.flush();
+}
+
+void CliRunner::onRangeWorkerJoined(const QString &name)
+{
+    out << "Worker joined: " << name << "\n";
+    out.flush();
+}
+
+void CliRunner::onRangeWorkerLost(const QString &name)
+{
+    out << "Worker lost:   " << name << " (a range it held is handed out again)\n";
+    out.flush();
+}
+
+void CliRunner::onLocalRangeWorkerExited(const QString &problem)
+{
+    --localRangeWorkers;
+    if (rangesComplete || !rangeCoordinator) {
+        return;
+    }
+
+    if (!problem.isEmpty()) {
+        err << "\nWarning: a local range worker " << problem << "\n";
+        err.flush();
+    }
+
+    // Nobody left to take the remaining ranges
+    if (localRangeWorkers == 0 && rangeCoordinator->getConnectedWorkers() == 0) {
+        onError("Every local range worker exited before the ranges were verified");
+    }
+}
+
+void CliRunner::onRangeVerified(int rangesDone, int rangeCount)
+{
+    // The hash progress line owns stderr until the image hash is done
+    if (imageHashed) {
+        err << QString("\rRanges: %1 / %2 verified").arg(rangesDone).arg(rangeCount);
+        err.flush();
+    }
+}
+
+void CliRunner::onDistributionComplete()
+{
+    rangesComplete = true;
+
+    if (!knownBlockIndexPath.isEmpty()) {
+        onKnownBlocksMatched(rangeCoordinator->getKnownGood(), rangeCoordinator->getKnownBad(),
+                             knownBlockReportPath);
+    }
+
+    if (imageHashed) {
+        err << "\n";
+        err.flush();
+        onVerificationComplete(imageResults);
+    }
+}
+
+void CliRunner::onRangeWorkerFinished(int rangesVerified)
+{
+    out << "Verified:   " << rangesVerified << " ranges\n";
+    out.flush();
+    finish(EXIT_VERIFIED);
+}
+
+void CliRunner::onCatalogComplete(int cataloged, int unchanged, int failed)
+{
+    out << "Cataloged:  " << cataloged << " image(s), " << unchanged << " unchanged, "
+        << failed << " could not be opened\n";
+    out.flush();
+    finish(failed > 0 ? EXIT_MISMATCH : EXIT_VERIFIED);
+}
+
+// ===== Private Helper Functions =====
+
+void CliRunner::printResult(const QString &algorithm, const QString &calculatedHash,
+                            const QString &expectedHash, bool verified)
+{
+    if (expectedHash.isEmpty()) {
+        out << algorithm << ": " << calculatedHash << " (no stored hash to compare)\n";
+    } else if (verified) {
+        out << algorithm << ": " << calculatedHash << " VERIFIED\n";
+    } else {
+        out << algorithm << ": " << calculatedHash << " NOT VERIFIED (expected " << expectedHash << ")\n";
+    }
+}
+
+void CliRunner::finish(int exitCode)
+{
+    QCoreApplication::exit(exitCode);
+}
@@ -0,0 +1,246 @@
+/*
+ * E01 Hash Verification Tool
+ * CliRunner - Command-line (headless) front end
+ */
+
+#ifndef CLIRUNNER_H
+#define CLIRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QTextStream>
+#include <QFile>
+#include <QTimer>
+#include "ewfhandler.h"
+#include "hashengine.h"
+#include "quickverifier.h"
+#include "imagecomparator.h"
+#include "evidencecopier.h"
+#include "watchservice.h"
+#include "jobserver.h"
+#include "catalogbuilder.h"
+#include "rangecoordinator.h"
+#include "rangeworker.h"
+#include "loadtester.h"
+
+class CliRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CliRunner(QObject *parent = nullptr);
+    ~CliRunner();
+
+    // Parse arguments, run the requested job and return the process exit code
+    int run(const QStringList &arguments);
+
+    // True when the arguments name at least one command-line option (or -
+    // for stdin); a bare image path from a file association and Qt's own
+    // GUI flags (-platform, -style, ...) start the GUI instead
+    static bool isCommandLine(const QStringList &arguments);
+
+    // Exit codes
+    enum ExitCode {
+        EXIT_VERIFIED = 0,     // All hashes match (or nothing to compare)
+        EXIT_MISMATCH = 1,     // Hash mismatch or damaged chunks found
+        EXIT_ERROR = 2         // Could not complete the job
+    };
+
+private slots:
+    // Progress sampled from the hash engine's telemetry
+    void onProgressTimer();
+
+    // Hash engine signals
+    void onMD5Calculated(const QString &hash);
+    void onSHA1Calculated(const QString &hash);
+    void onSHA256Calculated(const QString &hash);
+    void onSparseMapCalculated(const SparseMap &map);
+    void onKnownBlocksMatched(qint64 knownGood, qint64 knownBad, const QString &reportPath);
+    void onSimilarityDigestCalculated(const QString &digest);
+    void onSimilarityDigestSkipped(const QString &reason);
+    void onSegmentHashesCalculated(const SegmentHashList &hashes);
+    void onBadRangesFound(const BadRangeMap &map);
+    void onPipelineTuned(const QStringList &reasons);
+    void onTeeOutputWritten(const QString &outputPath, qint64 bytesWritten, const QString &outputMD5);
+    void onEntropyMapWritten(const QString &mapPath, qint64 regions, qint64 highEntropyRegions,
+                             qint64 wipedRegions);
+    void onVerificationComplete(const QMap<QString, bool> &results);
+
+    // Quick verifier signals
+    void onQuickProgressUpdate(int percentage, int samplesChecked, int totalSamples);
+    void onQuickVerifyComplete(const QuickVerifyResult &result);
+
+    // Two-image comparison signals
+    void onCompareComplete(const ImageCompareResult &result);
+
+    // Copy-and-verify signals
+    void onCopyComplete(const CopiedSegmentList &segments);
+
+    void onError(const QString &message);
+
+    // Watch service signals
+    void onAcquisitionQueued(const QString &imagePath);
+    void onWatchVerificationStarted(const QString &imagePath);
+    void onWatchVerificationFinished(const QString &imagePath, WatchService::Verdict verdict,
+                                     const QString &reportPath);
+    void onWatchError(const QString &message);
+
+    // Job server signals
+    void onServerJobStarted(int jobId, const QString &imagePath);
+    void onServerJobFinished(int jobId, const QString &imagePath, const QString &state);
+
+    // Catalog builder signals
+    void onCatalogImageFailed(const QString &imagePath, const QString &reason);
+    void onCatalogComplete(int cataloged, int unchanged, int failed);
+
+    // Range-parallel verification signals
+    void onRangeWorkerJoined(const QString &name);
+    void onRangeWorkerLost(const QString &name);
+    void onRangeVerified(int rangesDone, int rangeCount);
+    void onDistributionComplete();
+    void onRangeWorkerFinished(int rangesVerified);
+
+    // Load test signals
+    void onLoadFixtureReady(const QString &path);
+    void onLoadLevelStarted(int concurrency, int jobs);
+    void onLoadLevelComplete(const LoadLevelResult &result);
+    void onLoadTestComplete();
+
+private:
+    // run(), or with classifyOnly only the isCommandLine() answer
+    // (EXIT_VERIFIED for yes) from the same option set
+    int dispatch(const QStringList &arguments, bool classifyOnly);
+
+    bool startVerification(const QString &path, bool md5, bool sha1, bool sha256,
+                           int parallelReads, qint64 readSize);
+    bool startQuickVerify(const QString &path, int samples, const QString &seed, int threads);
+    bool startImageCompare(const QString &pathA, const QString &pathB, bool md5, bool sha1, bool sha256,
+                           int parallelReads, qint64 blockSize);
+    int buildBlockIndex(const QString &listPath, const QString &indexPath, qint64 blockSize);
+    int benchmarkKernels();
+    int runWatchService(const QStringList &directories, const QString &reportDirectory,
+                        int stableSeconds, bool md5, bool sha1, bool sha256);
+    int runJobServer(const QString &name, int workers);
+    bool startDistribution(const QString &path);
+    void onLocalRangeWorkerExited(const QString &problem);
+    bool startHashing(const QString &path);
+    bool startCopy(const QString &path);
+    int runRangeWorker(const QString &address);
+    int runLoadTest(const QString &levels, int jobs, double submitRate, qint64 fixtureSize,
+                    const QString &fixtureDir, const QString &reportPath, bool md5, bool sha1, bool sha256);
+    int buildCatalog(const QString &databasePath, const QStringList &roots, int maxOpenImages);
+    int queryCatalog(const QString &databasePath, const CatalogQuery &filter);
+    void printResult(const QString &algorithm, const QString &calculatedHash,
+                     const QString &expectedHash, bool verified);
+    void finish(int exitCode);
+
+    // Output streams (the report moves to stderr when stdout carries data)
+    QTextStream out;
+    QTextStream err;
+    QFile reportFile;
+    QTimer progressTimer;
+
+    // Core components
+    EWFHandler *ewfHandler;
+    HashEngine *hashEngine;
+    QuickVerifier *quickVerifier;
+    ImageComparator *imageComparator;
+    EvidenceCopier *evidenceCopier;
+    WatchService *watchService;
+    JobServer *jobServer;
+    CatalogBuilder *catalogBuilder;
+    RangeCoordinator *rangeCoordinator;
+    RangeWorker *rangeWorker;
+    LoadTester *loadTester;
+
+    // Calculated and expected hashes
+    QMap<QString, QString> calculated;
+    QMap<QString, QString> expected;
+    bool zeroChunkMap;
+    SparseMap sparseMap;
+
+    // Known-block lookup
+    QString knownBlockIndexPath;
+    QString knownBlockReportPath;
+    QString knownBlockSummary;
+
+    // Similarity digest and the digest to compare it against
+    bool similarity;
+    QString similarityDigest;
+    QString similarityWarning;
+    QString compareDigest;
+
+    // Container-file hashes of each segment
+    bool segmentHashes;
+    SegmentHashList segmentHashList;
+
+    // Entropy map
+    QString entropyMapPath;
+    qint64 entropyRegionSize;
+    QString entropySummary;
+
+    // Stream input
+    bool streamInput;
+    qint64 expectedStreamSize;
+    bool passThrough;
+
+    // Convert-while-hashing output
+    QString teeOutputPath;
+    qint64 teeSegmentSize;
+    bool verifyOutput;
+    QString outputMD5;
+    qint64 outputBytes;
+
+    // Continue past damaged chunks
+    bool continueOnError;
+    quint8 fillByte;
+    BadRangeMap badRangeMap;
+
+    // Start-of-job calibration
+    bool autoTune;
+
+    // Pipeline timeline (Chrome trace JSON)
+    QString tracePath;
+
+    // Bandwidth and priority of each job
+    double rateLimit;
+    bool background;
+
+    // SHA of concurrent server jobs on the shared multi-buffer service
+    bool multiBuffer;
+
+    // Range-parallel work spread over worker processes; the report waits
+    // for both the image hash and the last range
+    QString coordinateAddress;
+    qint64 rangeSize;
+    qint64 pieceSize;
+    int spawnWorkers;
+    int localRangeWorkers;
+    int rangeTimeout;
+    QString rangeToken;
+    bool imageHashed;
+    bool rangesComplete;
+    QMap<QString, bool> imageResults;
+
+    // Segment set copied and read back before the media is hashed; the
+    // media hash then reads the copy, so the source is read only once
+    QString copyDestination;
+    CopiedSegmentList copiedSegments;
+
+    // Full-verification settings, kept for a hash started after the copy
+    bool hashMD5;
+    bool hashSHA1;
+    bool hashSHA256;
+    int hashParallelReads;
+    qint64 hashReadSize;
+
+    // Constants
+    static const int NETWORK_PARALLEL_READS = 8;
+    static const int PROGRESS_INTERVAL_MS = 250;
+    static const qint64 DEFAULT_INDEX_BLOCK_SIZE = 4096;
+    static const char *const RANGE_TOKEN_VARIABLE;
+};
+
+#endif // CLIRUNNER_H
@@ -0,0 +1,210 @@
+/*
+ * E01 Hash Verification Tool
+ * EntropyStage Implementation
+ */
+
+#include "entropystage.h"
+#include "sparsemap.h"
+#include <QDebug>
+#include <QFile>
+#include <QtMath>
+#include <cstring>
+
+const double EntropyStage::HIGH_ENTROPY_BITS = 7.9;
+
+EntropyStage::EntropyStage(const QString &mapPath, qint64 regionSize, qint64 mediaSize, QObject *parent)
+    : BlockStage(parent)
+    , mapPath(mapPath)
+    , regionSize(regionSize)
+    , mediaSize(mediaSize)
+    , regionFill(0)
+    , highEntropyRegions(0)
+    , wipedRegions(0)
+{
+    memset(histogram, 0, sizeof(histogram));
+}
+
+QString EntropyStage::getMapPath() const
+{
+    return mapPath;
+}
+
+qint64 EntropyStage::getRegionCount() const
+{
+    return pixels.size() / 3;
+}
+
+qint64 EntropyStage::getHighEntropyRegions() const
+{
+    return highEntropyRegions;
+}
+
+qint64 EntropyStage::getWipedRegions() const
+{
+    return wipedRegions;
+}
+
+bool EntropyStage::prepare()
+{
+    if (regionSize <= 0) {
+        setError("Entropy region size must be positive");
+        return false;
+    }
+
+    // Coarsen the regions if the map would not fit in memory (or in one
+    // QByteArray); the header records the size actually used
+    qint64 minimumRegionSize = (mediaSize + MAX_MAP_PIXELS - 1) / MAX_MAP_PIXELS;
+    if (regionSize < minimumRegionSize) {
+        qDebug() << "EntropyStage: Region size" << regionSize << "raised to" << minimumRegionSize
+                 << "for" << mediaSize << "byte media";
+        regionSize = minimumRegionSize;
+    }
+
+    memset(histogram, 0, sizeof(histogram));
+    regionFill = 0;
+    highEntropyRegions = 0;
+    wipedRegions = 0;
+
+    pixels.clear();
+    qsizetype regions = static_cast<qsizetype>((mediaSize + regionSize - 1) / regionSize);
+    pixels.reserve(regions * 3);
+
+    qDebug() << "EntropyStage: Mapping" << regionSize << "byte regions to" << mapPath;
+    return true;
+}
+
+void EntropyStage::processBlock(const char *data, qint64 size, qint64 offset)
+{
+    Q_UNUSED(offset);
+
+    const quint8 *bytes = reinterpret_cast<const quint8*>(data);
+    qint64 pos = 0;
+
+    // Buffers and regions need not line up; a region may span buffers
+    while (pos < size) {
+        qint64 length = qMin(regionSize - regionFill, size - pos);
+        countBytes(bytes + pos, length);
+
+        pos += length;
+        regionFill += length;
+
+        if (regionFill == regionSize) {
+            finishRegion();
+        }
+    }
+}
+
+bool EntropyStage::complete()
+{
+    // Partial region at the end of the media
+    if (regionFill > 0) {
+        finishRegion();
+    }
+
+    qint64 regions = pixels.size() / 3;
+    qint64 height = (regions + MAP_WIDTH - 1) / MAP_WIDTH;
+
+    QFile file(mapPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        setError(QString("Failed to create entropy map: %1").arg(file.errorString()));
+        return false;
+    }
+
+    // PPM header; the comments let tools map pixels back to offsets
+    QByteArray header;
+    header += "P6\n";
+    header += "# e01hasher entropy map: one pixel per region, left to right, top to bottom\n";
+    header += "# R = entropy (0-8 bits/byte), G = fraction of 0x00 bytes, B = fraction of 0xFF bytes\n";
+    header += "# region_size " + QByteArray::number(regionSize) + "\n";
+    header += "# media_size " + QByteArray::number(mediaSize) + "\n";
+    header += QByteArray::number(MAP_WIDTH) + " " + QByteArray::number(qMax<qint64>(1, height)) + "\n255\n";
+
+    // Pad the last row with black
+    QByteArray padding(static_cast<qsizetype>((qMax<qint64>(1, height) * MAP_WIDTH - regions) * 3), '\0');
+
+    bool written = file.write(header) == header.size() &&
+                   file.write(pixels) == pixels.size() &&
+                   file.write(padding) == padding.size();
+    file.close();
+
+    if (!written) {
+        setError(QString("Failed to write entropy map: %1").arg(file.errorString()));
+        return false;
+    }
+
+    qDebug() << "EntropyStage:" << regions << "regions," << highEntropyRegions << "high entropy,"
+             << wipedRegions << "wiped";
+    return true;
+}
+
+// ===== Private Helper Functions =====
+
+void EntropyStage::countBytes(const quint8 *data, qint64 size)
+{
+    // Unallocated space is common; skip the histogram for all-zero runs
+    if (SparseMap::isAllZero(reinterpret_cast<const char*>(data), size)) {
+        histogram[0][0] += static_cast<quint64>(size);
+        return;
+    }
+
+    // Four interleaved tables: consecutive equal bytes update different
+    // counters, so increments do not stall on each other. Bytes are
+    // fetched eight at a time.
+    qint64 i = 0;
+    for (; i + 8 <= size; i += 8) {
+        quint64 word;
+        memcpy(&word, data + i, sizeof(word));
+
+        ++histogram[0][word & 0xFF];
+        ++histogram[1][(word >> 8) & 0xFF];
+        ++histogram[2][(word >> 16) & 0xFF];
+        ++histogram[3][(word >> 24) & 0xFF];
+        ++histogram[0][(word >> 32) & 0xFF];
+        ++histogram[1][(word >> 40) & 0xFF];
+        ++histogram[2][(word >> 48) & 0xFF];
+        ++histogram[3][word >> 56];
+    }
+
+    for (; i < size; ++i) {
+        ++histogram[0][data[i]];
+    }
+}
+
+void EntropyStage::finishRegion()
+{
+    double entropy = 0.0;
+    quint64 zeroBytes = 0;
+    quint64 ffBytes = 0;
+    const double total = static_cast<double>(regionFill);
+
+    for (int value = 0; value < 256; ++value) {
+        quint64 count = histogram[0][value] + histogram[1][value] +
+                        histogram[2][value] + histogram[3][value];
+        if (count == 0) {
+            continue;
+        }
+
+        double p = count / total;
+        entropy -= p * qLn(p) / M_LN2;
+
+        if (value == 0x00) {
+            zeroBytes = count;
+        } else if (value == 0xFF) {
+            ffBytes = count;
+        }
+    }
+
+    if (entropy >= HIGH_ENTROPY_BITS) {
+        ++highEntropyRegions;
+    }
+    if (zeroBytes == static_cast<quint64>(regionFill) || ffBytes == static_cast<quint64>(regionFill)) {
+        ++wipedRegions;
+    }
+
+    pixels.append(static_cast<char>(qBound(0, qRound(entropy * 255.0 / 8.0), 255)));
+    pixels.append(static_cast<char>(qRound(zeroBytes * 255.0 / total)));
+    pixels.append(static_cast<char>(qRound(ffBytes * 255.0 / total)));
+
+    memset(histogram, 0, sizeof(histogram));
+    regionFill = 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * E01 Hash Verification Tool
+ * EntropyStage - Per-region byte statistics and entropy map
+ */
+
+#ifndef ENTROPYSTAGE_H
+#define ENTROPYSTAGE_H
+
+#include "blockstage.h"
+#include <QByteArray>
+
+// Computes Shannon entropy and the zero / 0xFF byte fractions of every
+// fixed-size region and writes them as a binary PPM image, one pixel per
+// region in media order (red = entropy, green = zero bytes, blue = 0xFF
+// bytes). Encrypted or compressed data shows up red, wiped areas green or
+// blue, and any image viewer can display the result.
+class EntropyStage : public BlockStage
+{
+    Q_OBJECT
+
+public:
+    EntropyStage(const QString &mapPath, qint64 regionSize, qint64 mediaSize, QObject *parent = nullptr);
+
+    // Results (valid after finish())
+    QString getMapPath() const;
+    qint64 getRegionCount() const;
+    qint64 getHighEntropyRegions() const;
+    qint64 getWipedRegions() const;
+
+protected:
+    bool prepare() override;
+    void processBlock(const char *data, qint64 size, qint64 offset) override;
+    bool complete() override;
+
+private:
+    void countBytes(const quint8 *data, qint64 size);
+    void finishRegion();
+
+    QString mapPath;
+    qint64 regionSize;
+    qint64 mediaSize;
+
+    // Current region (64-bit counts: a region may exceed 4GB)
+    quint64 histogram[4][256];
+    qint64 regionFill;
+
+    // One RGB pixel per finished region
+    QByteArray pixels;
+    qint64 highEntropyRegions;
+    qint64 wipedRegions;
+
+    // Constants
+    static const int MAP_WIDTH = 1024;
+    static const qint64 MAX_MAP_PIXELS = 64 * 1024 * 1024;     // 192MB of RGB data
+    static const double HIGH_ENTROPY_BITS;
+};
+
+#endif // ENTROPYSTAGE_H
@@ -0,0 +1,240 @@
+/*
+ * E01 Hash Verification Tool
+ * EvidenceCatalog Implementation
+ */
+
+#include "evidencecatalog.h"
+#include <QDebug>
+#include <QStringList>
+#include <QVariant>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+
+EvidenceCatalog::EvidenceCatalog(const QString &connectionName)
+    : connectionName(connectionName)
+{
+}
+
+EvidenceCatalog::~EvidenceCatalog()
+{
+    close();
+}
+
+bool EvidenceCatalog::open(const QString &databasePath)
+{
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(databasePath);
+        if (!db.open()) {
+            setError("Cannot open catalog " + databasePath + ": " + db.lastError().text());
+            return false;
+        }
+    }
+
+    return createSchema();
+}
+
+void EvidenceCatalog::close()
+{
+    if (!QSqlDatabase::contains(connectionName)) {
+        return;
+    }
+
+    // Every QSqlDatabase copy must be gone before the connection is removed
+    {
+        QSqlDatabase db = QSqlDatabase::database(connectionName, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+QHash<QString, QPair<qint64, qint64>> EvidenceCatalog::getFileStamps()
+{
+    QHash<QString, QPair<qint64, qint64>> stamps;
+
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    if (!query.exec("SELECT path, file_size, modified FROM images")) {
+        setError("Catalog read failed: " + query.lastError().text());
+        return stamps;
+    }
+
+    while (query.next()) {
+        stamps.insert(query.value(0).toString(),
+                      qMakePair(query.value(1).toLongLong(), query.value(2).toLongLong()));
+    }
+
+    return stamps;
+}
+
+bool EvidenceCatalog::store(const QList<CatalogEntry> &entries)
+{
+    if (entries.isEmpty()) {
+        return true;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(connectionName);
+
+    // One transaction per batch: SQLite syncs once per commit, not per row
+    if (!db.transaction()) {
+        setError("Catalog transaction failed: " + db.lastError().text());
+        return false;
+    }
+
+    QSqlQuery query(db);
+    query.prepare("INSERT OR REPLACE INTO images "
+                  "(path, file_size, modified, case_number, evidence_number, examiner_name, "
+                  "description, notes, acquiry_date, media_size, segment_count, stored_md5, "
+                  "stored_sha1, error, cataloged_at) "
+                  "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+    qint64 now = QDateTime::currentDateTime().toMSecsSinceEpoch();
+    for (const CatalogEntry &entry : entries) {
+        query.addBindValue(entry.path);
+        query.addBindValue(entry.fileSize);
+        query.addBindValue(entry.modified.toMSecsSinceEpoch());
+        query.addBindValue(entry.caseNumber);
+        query.addBindValue(entry.evidenceNumber);
+        query.addBindValue(entry.examinerName);
+        query.addBindValue(entry.description);
+        query.addBindValue(entry.notes);
+        query.addBindValue(entry.acquiryDate);
+        query.addBindValue(entry.mediaSize);
+        query.addBindValue(entry.segmentCount);
+        query.addBindValue(entry.storedMD5);
+        query.addBindValue(entry.storedSHA1);
+        query.addBindValue(entry.error);
+        query.addBindValue(now);
+
+        if (!query.exec()) {
+            setError("Catalog insert failed for " + entry.path + ": " + query.lastError().text());
+            db.rollback();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        setError("Catalog commit failed: " + db.lastError().text());
+        db.rollback();
+        return false;
+    }
+
+    return true;
+}
+
+QList<CatalogEntry> EvidenceCatalog::find(const CatalogQuery &filter)
+{
+    QStringList conditions;
+    QList<QVariant> values;
+
+    if (!filter.caseNumber.isEmpty()) {
+        conditions << "case_number = ? COLLATE NOCASE";
+        values << filter.caseNumber;
+    }
+    if (!filter.evidenceNumber.isEmpty()) {
+        conditions << "evidence_number = ? COLLATE NOCASE";
+        values << filter.evidenceNumber;
+    }
+    if (!filter.examinerName.isEmpty()) {
+        conditions << "examiner_name LIKE ?";
+        values << "%" + filter.examinerName + "%";
+    }
+    if (!filter.storedHash.isEmpty()) {
+        conditions << "(stored_md5 = ? OR stored_sha1 = ?)";
+        values << filter.storedHash.trimmed().toLower() << filter.storedHash.trimmed().toLower();
+    }
+    if (filter.minSize >= 0) {
+        conditions << "media_size >= ?";
+        values << filter.minSize;
+    }
+    if (filter.maxSize >= 0) {
+        conditions << "media_size <= ?";
+        values << filter.maxSize;
+    }
+
+    QString sql = "SELECT path, file_size, modified, case_number, evidence_number, examiner_name, "
+                  "description, notes, acquiry_date, media_size, segment_count, stored_md5, "
+                  "stored_sha1, error FROM images";
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+    sql += " ORDER BY path";
+
+    QList<CatalogEntry> entries;
+
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    query.prepare(sql);
+    for (const QVariant &value : values) {
+        query.addBindValue(value);
+    }
+    if (!query.exec()) {
+        setError("Catalog query failed: " + query.lastError().text());
+        return entries;
+    }
+
+    while (query.next()) {
+        CatalogEntry entry;
+        entry.path = query.value(0).toString();
+        entry.fileSize = query.value(1).toLongLong();
+        entry.modified = QDateTime::fromMSecsSinceEpoch(query.value(2).toLongLong());
+        entry.caseNumber = query.value(3).toString();
+        entry.evidenceNumber = query.value(4).toString();
+        entry.examinerName = query.value(5).toString();
+        entry.description = query.value(6).toString();
+        entry.notes = query.value(7).toString();
+        entry.acquiryDate = query.value(8).toString();
+        entry.mediaSize = query.value(9).toLongLong();
+        entry.segmentCount = query.value(10).toInt();
+        entry.storedMD5 = query.value(11).toString();
+        entry.storedSHA1 = query.value(12).toString();
+        entry.error = query.value(13).toString();
+        entries.append(entry);
+    }
+
+    return entries;
+}
+
+QString EvidenceCatalog::getLastError() const
+{
+    return lastError;
+}
+
+// ===== Private Helper Functions =====
+
+bool EvidenceCatalog::createSchema()
+{
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+
+    // Rows are only ever replaced whole, so a crash mid-run costs at most
+    // the last uncommitted batch
+    const QStringList statements = {
+        "PRAGMA journal_mode = WAL",
+        "CREATE TABLE IF NOT EXISTS images ("
+        "path TEXT PRIMARY KEY, file_size INTEGER, modified INTEGER, "
+        "case_number TEXT, evidence_number TEXT, examiner_name TEXT, "
+        "description TEXT, notes TEXT, acquiry_date TEXT, "
+        "media_size INTEGER, segment_count INTEGER, "
+        "stored_md5 TEXT, stored_sha1 TEXT, error TEXT, cataloged_at INTEGER)",
+        "CREATE INDEX IF NOT EXISTS images_case ON images (case_number COLLATE NOCASE)",
+        "CREATE INDEX IF NOT EXISTS images_evidence ON images (evidence_number COLLATE NOCASE)",
+        "CREATE INDEX IF NOT EXISTS images_examiner ON images (examiner_name)",
+        "CREATE INDEX IF NOT EXISTS images_size ON images (media_size)",
+        "CREATE INDEX IF NOT EXISTS images_md5 ON images (stored_md5)",
+        "CREATE INDEX IF NOT EXISTS images_sha1 ON images (stored_sha1)"
+    };
+
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            setError("Catalog schema setup failed: " + query.lastError().text());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void EvidenceCatalog::setError(const QString &errorMsg)
+{
+    lastError = errorMsg;
+    qDebug() << "EvidenceCatalog Error:" << errorMsg;
+}
@@ -0,0 +1,77 @@
+/*
+ * E01 Hash Verification Tool
+ * EvidenceCatalog - SQLite index of image metadata
+ */
+
+#ifndef EVIDENCECATALOG_H
+#define EVIDENCECATALOG_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QPair>
+#include <QDateTime>
+
+// One cataloged image (the fields of EWFHandler::getMetadata)
+struct CatalogEntry
+{
+    QString path;             // First segment
+    qint64 fileSize = 0;      // First segment, for change detection
+    QDateTime modified;
+    QString caseNumber;
+    QString evidenceNumber;
+    QString examinerName;
+    QString description;
+    QString notes;
+    QString acquiryDate;
+    qint64 mediaSize = 0;
+    int segmentCount = 0;
+    QString storedMD5;
+    QString storedSHA1;
+    QString error;            // Empty unless the image could not be opened
+};
+
+// Filters for EvidenceCatalog::find(); empty / negative fields match all
+struct CatalogQuery
+{
+    QString caseNumber;       // Exact, case-insensitive
+    QString evidenceNumber;   // Exact, case-insensitive
+    QString examinerName;     // Substring, case-insensitive
+    QString storedHash;       // Stored MD5 or SHA1
+    qint64 minSize = -1;
+    qint64 maxSize = -1;
+};
+
+// Wraps one SQLite connection (QSQLITE). Each instance has its own
+// connection name, and, like every QSqlDatabase connection, is only used
+// from the thread that opened it.
+class EvidenceCatalog
+{
+public:
+    explicit EvidenceCatalog(const QString &connectionName);
+    ~EvidenceCatalog();
+
+    // Open or create the database and its schema
+    bool open(const QString &databasePath);
+    void close();
+
+    // Size and modification time (ms since epoch) of every cataloged path,
+    // so an incremental run can skip unchanged images without a query each
+    QHash<QString, QPair<qint64, qint64>> getFileStamps();
+
+    // Insert or replace entries in a single transaction
+    bool store(const QList<CatalogEntry> &entries);
+
+    QList<CatalogEntry> find(const CatalogQuery &filter);
+
+    QString getLastError() const;
+
+private:
+    bool createSchema();
+    void setError(const QString &errorMsg);
+
+    QString connectionName;
+    QString lastError;
+};
+
+#endif // EVIDENCECATALOG_H
@@ -0,0 +1,375 @@
+/*
+ * E01 Hash Verification Tool
+ * EvidenceCopier Implementation
+ */
+
+#include "evidencecopier.h"
+#include "hashdigest.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QMutexLocker>
+#include <QThreadPool>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #include <cstdlib>
+    #include <cstring>
+#endif
+
+EvidenceCopier::EvidenceCopier(const QStringList &segmentFiles, const QString &destinationDir, QObject *parent)
+    : QThread(parent)
+    , segmentFiles(segmentFiles)
+    , destinationDir(destinationDir)
+    , totalBytes(0)
+    , bytesDone(0)
+    , readerDone(false)
+    , writeFailed(false)
+    , readingBack(0)
+{
+}
+
+EvidenceCopier::~EvidenceCopier()
+{
+    // Wait for thread to finish
+    if (isRunning()) {
+        cancel();
+        wait();
+    }
+}
+
+CopiedSegmentList EvidenceCopier::getResults() const
+{
+    return results;
+}
+
+qint64 EvidenceCopier::getTotalBytes() const
+{
+    return totalBytes;
+}
+
+const JobTelemetry &EvidenceCopier::getTelemetry() const
+{
+    return telemetry;
+}
+
+bool EvidenceCopier::isReadingBack() const
+{
+    return readingBack.loadAcquire() != 0;
+}
+
+JobControl &EvidenceCopier::getControl()
+{
+    return control;
+}
+
+void EvidenceCopier::cancel()
+{
+    control.cancel();
+}
+
+void EvidenceCopier::run()
+{
+    qDebug() << "EvidenceCopier: Copying" << segmentFiles.size() << "segment files to" << destinationDir;
+
+    control.applyPriority();
+    telemetry.begin(0);
+    readingBack.storeRelease(0);
+    results.clear();
+    totalBytes = 0;
+
+    if (!QDir().mkpath(destinationDir)) {
+        telemetry.end(JobTelemetry::STATE_FAILED);
+        emit error("Cannot create " + destinationDir);
+        return;
+    }
+
+    // Evidence already at the destination is never overwritten
+    for (const QString &path : segmentFiles) {
+        CopiedSegment segment;
+        segment.sourcePath = path;
+        segment.destinationPath = QDir(destinationDir).filePath(QFileInfo(path).fileName());
+        if (QFileInfo::exists(segment.destinationPath)) {
+            telemetry.end(JobTelemetry::STATE_FAILED);
+            emit error("Destination already exists: " + segment.destinationPath);
+            return;
+        }
+        totalBytes += QFileInfo(path).size();
+        results.append(segment);
+    }
+
+    telemetry.setTotalBytes(totalBytes);
+    bytesDone = 0;
+    for (int i = 0; i < results.size(); ++i) {
+        if (!copySegment(results[i])) {
+            if (control.isCancelled()) {
+                qDebug() << "EvidenceCopier: Cancelled";
+                telemetry.end(JobTelemetry::STATE_CANCELLED);
+            } else {
+                telemetry.end(JobTelemetry::STATE_FAILED);
+                emit error(results[i].error);
+            }
+            return;
+        }
+    }
+
+    // Every copy is on disk before the first is read back
+    telemetry.begin(totalBytes);
+    readingBack.storeRelease(1);
+    bytesDone = 0;
+    for (int i = 0; i < results.size() && !control.isCancelled(); ++i) {
+        readBack(results[i]);
+    }
+
+    if (control.isCancelled()) {
+        qDebug() << "EvidenceCopier: Cancelled";
+        telemetry.end(JobTelemetry::STATE_CANCELLED);
+        return;
+    }
+
+    telemetry.end(JobTelemetry::STATE_FINISHED);
+    emit copyComplete(results);
+
+    qDebug() << "EvidenceCopier: Copied and read back" << totalBytes << "bytes";
+}
+
+// ===== Private Helper Functions =====
+
+bool EvidenceCopier::copySegment(CopiedSegment &segment)
+{
+    QFile input(segment.sourcePath);
+    if (!input.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        segment.error = "Cannot read " + segment.sourcePath + ": " + input.errorString();
+        return false;
+    }
+#ifndef _WIN32
+    // The whole file is read once, front to back
+    posix_fadvise(input.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // Written under a temporary name; renamed only once flushed to disk
+    QSaveFile output(segment.destinationPath);
+    if (!output.open(QIODevice::WriteOnly)) {
+        segment.error = "Cannot write " + segment.destinationPath + ": " + output.errorString();
+        return false;
+    }
+
+    HashDigest digest(true, true, false);
+    if (!digest.isValid()) {
+        segment.error = "Failed to initialize segment hash";
+        return false;
+    }
+
+    writeQueue.clear();
+    readerDone = false;
+    writeFailed = false;
+    writeError.clear();
+
+    QThreadPool writerPool;
+    writerPool.setMaxThreadCount(1);
+    writerPool.start([this, &output]() {
+        control.applyPriority();
+        writerLoop(&output);
+    });
+
+    while (control.checkpoint()) {
+        QByteArray block(static_cast<int>(BLOCK_SIZE), Qt::Uninitialized);
+        qint64 bytesRead = input.read(block.data(), BLOCK_SIZE);
+        if (bytesRead < 0) {
+            segment.error = "Cannot read " + segment.sourcePath + ": " + input.errorString();
+            break;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        block.resize(static_cast<int>(bytesRead));
+
+        {
+            QMutexLocker locker(&mutex);
+            while (writeQueue.size() >= QUEUE_DEPTH && !writeFailed) {
+                blockWritten.wait(&mutex);
+            }
+            if (writeFailed) {
+                break;
+            }
+            writeQueue.enqueue(block);
+            blockQueued.wakeAll();
+        }
+
+        // Hashed while the writer stores the same (shared) block
+        digest.update(block.constData(), bytesRead);
+        segment.size += bytesRead;
+        bytesDone += bytesRead;
+        telemetry.setBytesProcessed(bytesDone);
+
+        if (!control.throttle(bytesRead)) {
+            break;
+        }
+    }
+
+    {
+        QMutexLocker locker(&mutex);
+        readerDone = true;
+        blockQueued.wakeAll();
+    }
+    writerPool.waitForDone();
+
+    if (writeFailed) {
+        segment.error = "Cannot write " + segment.destinationPath + ": " + writeError;
+    }
+    if (control.isCancelled() || !segment.error.isEmpty()) {
+        output.cancelWriting();
+        return false;
+    }
+
+    if (!output.commit()) {
+        segment.error = "Cannot write " + segment.destinationPath + ": " + output.errorString();
+        return false;
+    }
+
+    QMap<QString, QString> hashes = digest.finish();
+    segment.md5 = hashes.value("MD5");
+    segment.sha1 = hashes.value("SHA1");
+    qDebug() << "EvidenceCopier:" << QFileInfo(segment.sourcePath).fileName() << segment.md5;
+    return true;
+}
+
+void EvidenceCopier::writerLoop(QIODevice *output)
+{
+    while (true) {
+        QByteArray block;
+        {
+            QMutexLocker locker(&mutex);
+            while (writeQueue.isEmpty() && !readerDone) {
+                blockQueued.wait(&mutex);
+            }
+            if (writeQueue.isEmpty()) {
+                return;
+            }
+            block = writeQueue.dequeue();
+            blockWritten.wakeAll();
+        }
+
+        if (output->write(block) != block.size()) {
+            QMutexLocker locker(&mutex);
+            writeFailed = true;
+            writeError = output->errorString();
+            blockWritten.wakeAll();
+            return;
+        }
+    }
+}
+
+bool EvidenceCopier::readBack(CopiedSegment &segment)
+{
+    HashDigest digest(true, true, false);
+    if (!digest.isValid()) {
+        segment.error = "Failed to initialize segment hash";
+        return false;
+    }
+
+    qint64 total = 0;
+
+#ifdef _WIN32
+    // Unbuffered reads need sector-aligned buffers; VirtualAlloc gives pages
+    std::wstring wPath = QDir::toNativeSeparators(segment.destinationPath).toStdWString();
+    HANDLE file = CreateFileW(wPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        segment.error = "Cannot read back " + segment.destinationPath;
+        return false;
+    }
+    char *buffer = static_cast<char*>(VirtualAlloc(NULL, BLOCK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+
+    while (buffer && control.checkpoint()) {
+        DWORD bytesRead = 0;
+        if (!ReadFile(file, buffer, static_cast<DWORD>(BLOCK_SIZE), &bytesRead, NULL)) {
+            segment.error = "Cannot read back " + segment.destinationPath;
+            break;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        digest.update(buffer, bytesRead);
+        total += bytesRead;
+        bytesDone += bytesRead;
+        telemetry.setBytesProcessed(bytesDone);
+        control.throttle(bytesRead);
+    }
+
+    if (buffer) {
+        VirtualFree(buffer, 0, MEM_RELEASE);
+    } else {
+        segment.error = "Failed to allocate read-back buffer";
+    }
+    CloseHandle(file);
+#else
+    QByteArray path = QFile::encodeName(segment.destinationPath);
+    int fd = -1;
+#ifdef O_DIRECT
+    fd = ::open(path.constData(), O_RDONLY | O_DIRECT);
+#endif
+    if (fd < 0) {
+        fd = ::open(path.constData(), O_RDONLY);
+        if (fd < 0) {
+            segment.error = "Cannot read back " + segment.destinationPath + ": " + QString::fromLocal8Bit(strerror(errno));
+            return false;
+        }
+#ifdef F_NOCACHE
+        fcntl(fd, F_NOCACHE, 1);
+#endif
+    }
+
+    // The copy was synced by the commit, so its cached pages are clean and
+    // can be dropped: without direct I/O (tmpfs, some FUSE mounts) they
+    // would serve this read, and the media hash reads the copy next
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+    void *buffer = nullptr;
+    if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, BLOCK_SIZE) != 0) {
+        ::close(fd);
+        segment.error = "Failed to allocate read-back buffer";
+        return false;
+    }
+
+    while (control.checkpoint()) {
+        ssize_t bytesRead = ::read(fd, buffer, BLOCK_SIZE);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            segment.error = "Cannot read back " + segment.destinationPath + ": " + QString::fromLocal8Bit(strerror(errno));
+            break;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+        digest.update(static_cast<const char*>(buffer), bytesRead);
+        total += bytesRead;
+        bytesDone += bytesRead;
+        telemetry.setBytesProcessed(bytesDone);
+        control.throttle(bytesRead);
+    }
+
+    free(buffer);
+    ::close(fd);
+#endif
+
+    if (control.isCancelled() || !segment.error.isEmpty()) {
+        return false;
+    }
+
+    QMap<QString, QString> hashes = digest.finish();
+    segment.verified = total == segment.size && hashes.value("MD5") == segment.md5 &&
+                       hashes.value("SHA1") == segment.sha1;
+
+    qDebug() << "EvidenceCopier: Read back" << QFileInfo(segment.destinationPath).fileName()
+             << (segment.verified ? "matches" : "DIFFERS");
+    return segment.verified;
+}
@@ -0,0 +1,112 @@
+/*
+ * E01 Hash Verification Tool
+ * EvidenceCopier - Copy a segment set and verify the copy from disk
+ */
+
+#ifndef EVIDENCECOPIER_H
+#define EVIDENCECOPIER_H
+
+#include <QThread>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QQueue>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMetaType>
+#include <QAtomicInteger>
+#include "jobtelemetry.h"
+#include "jobcontrol.h"
+
+// One segment file, its hashes as read from the source and the outcome of
+// reading the written copy back
+struct CopiedSegment
+{
+    QString sourcePath;
+    QString destinationPath;
+    qint64 size = 0;
+    QString md5;              // Of the source, hashed while copying
+    QString sha1;
+    bool verified = false;    // The copy read back from disk has the same hashes
+    QString error;            // Empty unless the copy or the read-back failed
+};
+
+typedef QList<CopiedSegment> CopiedSegmentList;
+
+Q_DECLARE_METATYPE(CopiedSegmentList)
+
+// Copies each segment file to a destination directory. The reader on this
+// thread hands large blocks to a writer thread through a short queue and
+// hashes each block while the writer stores it, so reading, hashing and
+// writing overlap and the copy runs at the speed of the slower device.
+// This is the only read of the source: callers that also want the media
+// hash take it from the copy once copyComplete() is emitted (the decoded
+// media needs libewf, which reads files, not the copier's blocks).
+// Each copy is written under a temporary name and renamed once it is on
+// disk. When every segment is copied, the copies are read back past the
+// page cache (O_DIRECT, F_NOCACHE or FILE_FLAG_NO_BUFFERING) and hashed
+// again, so the comparison is against what the destination really holds;
+// their cached pages are dropped too, so a media hash of the copy also
+// reads the destination disk (except on Windows, where it may still be
+// served from the file cache).
+class EvidenceCopier : public QThread
+{
+    Q_OBJECT
+
+public:
+    EvidenceCopier(const QStringList &segmentFiles, const QString &destinationDir, QObject *parent = nullptr);
+    ~EvidenceCopier();
+
+    // Results, in segment order (valid once the thread has finished)
+    CopiedSegmentList getResults() const;
+    qint64 getTotalBytes() const;
+
+    // Bytes copied, then (restarted) bytes read back, read lock-free by the
+    // caller's timer; isReadingBack() tells the two phases apart
+    const JobTelemetry &getTelemetry() const;
+    bool isReadingBack() const;
+
+    // Cancel, pause, rate limit and priority; set up before start()
+    JobControl &getControl();
+    void cancel();
+
+signals:
+    void copyComplete(const CopiedSegmentList &segments);
+    void error(const QString &errorMessage);
+
+protected:
+    void run() override;
+
+private:
+    bool copySegment(CopiedSegment &segment);
+    void writerLoop(QIODevice *output);
+    bool readBack(CopiedSegment &segment);
+
+    QStringList segmentFiles;
+    QString destinationDir;
+    CopiedSegmentList results;
+    qint64 totalBytes;
+    qint64 bytesDone;
+
+    // Reader -> writer hand-off (guarded by mutex)
+    QMutex mutex;
+    QWaitCondition blockQueued;
+    QWaitCondition blockWritten;
+    QQueue<QByteArray> writeQueue;
+    bool readerDone;
+    bool writeFailed;
+    QString writeError;
+
+    // Progress and control
+    JobTelemetry telemetry;
+    JobControl control;
+    QAtomicInteger<int> readingBack;
+
+    // Constants
+    static const qint64 BLOCK_SIZE = 8 * 1024 * 1024;   // Large requests suit both USB and network storage
+    static const int QUEUE_DEPTH = 4;
+    static const qint64 DIRECT_IO_ALIGNMENT = 4096;
+};
+
+#endif // EVIDENCECOPIER_H
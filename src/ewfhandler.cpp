@@ -3,27 +3,109 @@
  * EWFHandler Implementation
  */
 
+// libbfio ahead of libewf, which declares its file-IO pool open only once
+// libbfio's types are known
+#ifdef E01HASHER_MMAP_IO
+    #include <libbfio.h>
+#endif
 #include "ewfhandler.h"
+#include "badrangemap.h"
+#include "handlebudget.h"
+#include "prefetchreader.h"
+#include <QByteArray>
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
 #include <QDebug>
 #include <cstring>
+#include <algorithm>
+
+#ifdef E01HASHER_MMAP_IO
+    #include "mmapfileio.h"
+#endif
 
 EWFHandler::EWFHandler()
     : handle(nullptr)
     , error(nullptr)
     , opened(false)
     , mediaSize(0)
+    , chunkSize(0)
+    , bytesPerSector(0)
+    , openHandleLimit(0)
+    , reservedHandles(0)
+    , mappedSegments(nullptr)
     , metadataCached(false)
+    , headerValuesRead(false)
 {
 }
 
+int EWFHandler::maximumOpenHandles = 0;
+bool EWFHandler::memoryMappedIO = false;
+
 EWFHandler::~EWFHandler()
 {
     close();
 }
 
+void EWFHandler::setMaximumOpenHandles(int count)
+{
+    maximumOpenHandles = qMax(-1, count);
+}
+
+void EWFHandler::setMemoryMappedIO(bool enable)
+{
+    memoryMappedIO = enable;
+}
+
+bool EWFHandler::isMemoryMappedIOAvailable()
+{
+#ifdef E01HASHER_MMAP_IO
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool EWFHandler::isMemoryMapped() const
+{
+    return mappedSegments != nullptr;
+}
+
+bool EWFHandler::setSegmentHashes(bool enable)
+{
+#ifdef E01HASHER_MMAP_IO
+    if (mappedSegments != nullptr) {
+        mappedSegments->setSegmentHashes(enable);
+        return enable;
+    }
+#else
+    Q_UNUSED(enable);
+#endif
+    return false;
+}
+
+SegmentHashList EWFHandler::finishSegmentHashes()
+{
+#ifdef E01HASHER_MMAP_IO
+    if (mappedSegments != nullptr) {
+        return mappedSegments->finishSegmentHashes();
+    }
+#endif
+    return SegmentHashList();
+}
+
+bool EWFHandler::isEwfImage(const QString &filePath)
+{
+#ifdef _WIN32
+    std::wstring wPath = QDir::toNativeSeparators(filePath).toStdWString();
+    int result = libewf_check_file_signature_wide(wPath.c_str(), nullptr);
+#else
+    QByteArray path = QFile::encodeName(filePath);
+    int result = libewf_check_file_signature(path.constData(), nullptr);
+#endif
+    return result == 1;
+}
+
 bool EWFHandler::open(const QString &filePath)
 {
     // Close any previously opened file
@@ -61,6 +143,9 @@ bool EWFHandler::open(const QString &filePath)
         return false;
     }
 
+    // Must be set before the open, which creates the handle pool
+    limitOpenHandles(fileCount);
+
     // Open the file(s) with libewf
     int result;
 #ifdef _WIN32
@@ -78,14 +163,24 @@ bool EWFHandler::open(const QString &filePath)
         libewf_glob_wide_free(reinterpret_cast<wchar_t**>(filenames), fileCount, nullptr);
     }
 #else
-    // Linux: Use standard char open
-    result = libewf_handle_open(
-        handle,
-        filenames,
-        fileCount,
-        LIBEWF_OPEN_READ,
-        &error
-    );
+    result = 0;
+#ifdef E01HASHER_MMAP_IO
+    // Local images can be read through memory maps instead of read() calls
+    if (memoryMappedIO && !PrefetchReader::isNetworkPath(filePath) &&
+        openMemoryMapped(filenames, fileCount)) {
+        result = 1;
+    }
+#endif
+    if (result != 1) {
+        // Linux: Use standard char open
+        result = libewf_handle_open(
+            handle,
+            filenames,
+            fileCount,
+            LIBEWF_OPEN_READ,
+            &error
+        );
+    }
 
     // Free the globbed filenames
     if (filenames != nullptr) {
@@ -105,6 +200,7 @@ bool EWFHandler::open(const QString &filePath)
         setError(errorMsg);
         libewf_handle_free(&handle, nullptr);
         handle = nullptr;
+        releaseOpenHandles();
         return false;
     }
 
@@ -115,10 +211,29 @@ bool EWFHandler::open(const QString &filePath)
         libewf_handle_close(handle, nullptr);
         libewf_handle_free(&handle, nullptr);
         handle = nullptr;
+        releaseMappedSegments();
+        releaseOpenHandles();
         return false;
     }
 
     mediaSize = static_cast<qint64>(size);
+
+    // Get chunk geometry (EWF stores and compresses data per chunk)
+    uint32_t sectorsPerChunk = 0;
+    uint32_t sectorSize = 0;
+    if (libewf_handle_get_sectors_per_chunk(handle, &sectorsPerChunk, &error) == 1 &&
+        libewf_handle_get_bytes_per_sector(handle, &sectorSize, &error) == 1 &&
+        sectorsPerChunk > 0 && sectorSize > 0) {
+        bytesPerSector = sectorSize;
+        chunkSize = static_cast<qint64>(sectorsPerChunk) * sectorSize;
+    } else {
+        if (error != nullptr) {
+            libewf_error_free(&error);
+        }
+        bytesPerSector = DEFAULT_BYTES_PER_SECTOR;
+        chunkSize = DEFAULT_CHUNK_SIZE;
+    }
+
     currentFilePath = filePath;
     opened = true;
     lastError.clear();
@@ -133,12 +248,20 @@ void EWFHandler::close()
         libewf_handle_free(&handle, nullptr);
         handle = nullptr;
     }
+    releaseMappedSegments();
+    releaseOpenHandles();
 
     opened = false;
     currentFilePath.clear();
+    segmentFiles.clear();
     mediaSize = 0;
+    chunkSize = 0;
+    bytesPerSector = 0;
     cachedMetadata.clear();
     metadataCached = false;
+    headerValues.clear();
+    headerValuesRead = false;
+    checksumErrorCache.clear();
 }
 
 bool EWFHandler::isOpen() const
@@ -203,16 +326,105 @@ qint64 EWFHandler::readAt(char *buffer, qint64 maxSize, qint64 offset)
     return static_cast<qint64>(bytesRead);
 }
 
+void EWFHandler::readWithSubstitution(char *buffer, qint64 size, qint64 offset, char fillByte,
+                                      BadRangeMap &badRanges)
+{
+    // Chunks of this block that could not be read at all, in offset order,
+    // so a chunk that failed outright is not also counted as a checksum
+    // failure
+    QList<QPair<qint64, qint64>> filled;
+
+    if (readAt(buffer, size, offset) != size) {
+        // Retry one EWF chunk at a time so only the damaged chunks are lost
+        qint64 step = chunkSize > 0 ? chunkSize : size;
+        qint64 pos = 0;
+        while (pos < size) {
+            qint64 length = qMin(step - ((offset + pos) % step), size - pos);
+            if (readAt(buffer + pos, length, offset + pos) != length) {
+                memset(buffer + pos, fillByte, static_cast<size_t>(length));
+                badRanges.addRange(offset + pos, length, BadRangeMap::READ_ERROR);
+                filled.append(qMakePair(offset + pos, length));
+            }
+            pos += length;
+        }
+    }
+
+    // libewf returns checksum-failing chunks as read and only records them;
+    // substitute the parts not already filled above
+    const QList<QPair<qint64, qint64>> errors = getChecksumErrors(offset, size);
+    for (const QPair<qint64, qint64> &range : errors) {
+        qint64 start = range.first;
+        qint64 end = range.first + range.second;
+
+        for (const QPair<qint64, qint64> &gap : filled) {
+            if (start >= end || gap.first >= end) {
+                break;
+            }
+            if (gap.first + gap.second <= start) {
+                continue;
+            }
+            if (gap.first > start) {
+                memset(buffer + (start - offset), fillByte, static_cast<size_t>(gap.first - start));
+                badRanges.addRange(start, gap.first - start, BadRangeMap::CHECKSUM_ERROR);
+            }
+            start = gap.first + gap.second;
+        }
+
+        if (start < end) {
+            memset(buffer + (start - offset), fillByte, static_cast<size_t>(end - start));
+            badRanges.addRange(start, end - start, BadRangeMap::CHECKSUM_ERROR);
+        }
+    }
+}
+
 qint64 EWFHandler::getMediaSize() const
 {
     return mediaSize;
 }
 
+qint64 EWFHandler::getChunkSize() const
+{
+    return chunkSize;
+}
+
+qint64 EWFHandler::getBytesPerSector() const
+{
+    return bytesPerSector;
+}
+
 QString EWFHandler::getFilePath() const
 {
     return currentFilePath;
 }
 
+QStringList EWFHandler::getSegmentFiles() const
+{
+    return segmentFiles;
+}
+
+int EWFHandler::getOpenHandleLimit() const
+{
+    return openHandleLimit;
+}
+
+int EWFHandler::getCompressionLevel()
+{
+    if (!opened || handle == nullptr) {
+        return -1;
+    }
+
+    int8_t compressionLevel = 0;
+    uint8_t compressionFlags = 0;
+    if (libewf_handle_get_compression_values(handle, &compressionLevel, &compressionFlags, &error) != 1) {
+        if (error != nullptr) {
+            libewf_error_free(&error);
+        }
+        return -1;
+    }
+
+    return compressionLevel;
+}
+
 QMap<QString, QString> EWFHandler::getMetadata()
 {
     if (!opened || handle == nullptr) {
@@ -294,6 +506,112 @@ bool EWFHandler::hasStoredHash(const QString &algorithm)
     return !hash.isEmpty();
 }
 
+bool EWFHandler::segmentFilesCorrupted()
+{
+    if (!opened || handle == nullptr) {
+        return false;
+    }
+
+    int result = libewf_handle_segment_files_corrupted(handle, &error);
+    if (result == -1 && error != nullptr) {
+        libewf_error_free(&error);
+    }
+
+    return result == 1;
+}
+
+QList<QPair<qint64, qint64>> EWFHandler::getChecksumErrors()
+{
+    QList<QPair<qint64, qint64>> ranges;
+
+    if (!opened || handle == nullptr) {
+        return ranges;
+    }
+
+    uint32_t errorCount = 0;
+    if (libewf_handle_get_number_of_checksum_errors(handle, &errorCount, &error) != 1) {
+        if (error != nullptr) {
+            libewf_error_free(&error);
+        }
+        return ranges;
+    }
+
+    for (uint32_t i = 0; i < errorCount; ++i) {
+        QPair<qint64, qint64> range;
+        if (readChecksumError(i, range)) {
+            ranges.append(range);
+        }
+    }
+
+    return ranges;
+}
+
+QList<QPair<qint64, qint64>> EWFHandler::getChecksumErrors(qint64 offset, qint64 size)
+{
+    QList<QPair<qint64, qint64>> overlapping;
+
+    int errorCount = getChecksumErrorCount();
+    if (errorCount == 0) {
+        checksumErrorCache.clear();
+        return overlapping;
+    }
+
+    // Called for every block, so the list is only fetched again when
+    // libewf's count changes. libewf keeps its ranges in offset order and
+    // merges a failed chunk into any range it touches, so with an unchanged
+    // count a read can only have grown ranges touching the chunks it read,
+    // and only those are read again
+    auto firstEndingAtOrAfter = [this](qint64 position) {
+        return std::lower_bound(checksumErrorCache.begin(), checksumErrorCache.end(), position,
+                                [](const QPair<qint64, qint64> &range, qint64 value) {
+                                    return range.first + range.second < value;
+                                });
+    };
+    if (errorCount != checksumErrorCache.size()) {
+        checksumErrorCache = getChecksumErrors();
+    } else {
+        qint64 step = chunkSize > 0 ? chunkSize : 1;
+        qint64 chunksStart = offset - offset % step;
+        qint64 chunksEnd = offset + size + (step - (offset + size) % step) % step;
+        for (auto it = firstEndingAtOrAfter(chunksStart);
+             it != checksumErrorCache.end() && it->first <= chunksEnd; ++it) {
+            uint32_t index = static_cast<uint32_t>(it - checksumErrorCache.begin());
+            if (!readChecksumError(index, *it)) {
+                checksumErrorCache = getChecksumErrors();
+                break;
+            }
+        }
+    }
+
+    for (auto it = firstEndingAtOrAfter(offset);
+         it != checksumErrorCache.end() && it->first < offset + size; ++it) {
+        qint64 start = qMax(offset, it->first);
+        qint64 end = qMin(offset + size, it->first + it->second);
+        if (start < end) {
+            overlapping.append(qMakePair(start, end - start));
+        }
+    }
+
+    return overlapping;
+}
+
+int EWFHandler::getChecksumErrorCount()
+{
+    if (!opened || handle == nullptr) {
+        return 0;
+    }
+
+    uint32_t errorCount = 0;
+    if (libewf_handle_get_number_of_checksum_errors(handle, &errorCount, &error) != 1) {
+        if (error != nullptr) {
+            libewf_error_free(&error);
+        }
+        return 0;
+    }
+
+    return static_cast<int>(errorCount);
+}
+
 QString EWFHandler::getLastError() const
 {
     return lastError;
@@ -301,6 +619,23 @@ QString EWFHandler::getLastError() const
 
 // ===== Private Helper Functions =====
 
+bool EWFHandler::readChecksumError(uint32_t index, QPair<qint64, qint64> &range)
+{
+    // libewf records checksum errors in sectors
+    uint64_t startSector = 0;
+    uint64_t numberOfSectors = 0;
+    if (libewf_handle_get_checksum_error(handle, index, &startSector, &numberOfSectors, &error) != 1) {
+        if (error != nullptr) {
+            libewf_error_free(&error);
+        }
+        return false;
+    }
+
+    range = qMakePair(static_cast<qint64>(startSector) * bytesPerSector,
+                      static_cast<qint64>(numberOfSectors) * bytesPerSector);
+    return true;
+}
+
 bool EWFHandler::detectAndGlobSegments(const QString &filePath, char ***filenames, int *fileCount)
 {
 #ifdef _WIN32
@@ -346,6 +681,11 @@ bool EWFHandler::detectAndGlobSegments(const QString &filePath, char ***filename
         *fileCount = 1;
     }
 
+    segmentFiles.clear();
+    for (int i = 0; i < *fileCount; ++i) {
+        segmentFiles.append(QString::fromWCharArray(wFilenames[i]));
+    }
+
     // Convert wide char array to char array for libewf_handle_open_wide
     // Actually, we'll store the wide char pointers and use open_wide
     *filenames = reinterpret_cast<char**>(wFilenames);
@@ -386,6 +726,11 @@ bool EWFHandler::detectAndGlobSegments(const QString &filePath, char ***filename
 
         *fileCount = 1;
     }
+
+    segmentFiles.clear();
+    for (int i = 0; i < *fileCount; ++i) {
+        segmentFiles.append(QString::fromLocal8Bit((*filenames)[i]));
+    }
 #endif
 
     if (*fileCount == 0) {
@@ -396,60 +741,89 @@ bool EWFHandler::detectAndGlobSegments(const QString &filePath, char ***filename
     return true;
 }
 
-QString EWFHandler::getHeaderValue(const char *identifier)
+QMap<QString, QString> EWFHandler::getHeaderValues()
 {
     if (!opened || handle == nullptr) {
-        return QString();
+        return QMap<QString, QString>();
     }
 
-    size_t valueSize = 0;
-    uint8_t *value = nullptr;
+    if (!headerValuesRead) {
+        readHeaderValues();
+    }
 
-    // Get the size of the value
-    int result = libewf_handle_get_utf8_header_value(
-        handle,
-        reinterpret_cast<const uint8_t*>(identifier),
-        strlen(identifier),
-        nullptr,
-        0,
-        &error
-    );
+    return headerValues;
+}
 
-    if (result != 1) {
+QString EWFHandler::getHeaderValue(const char *identifier)
+{
+    if (!opened || handle == nullptr) {
         return QString();
     }
 
-    // Get the actual size
-    result = libewf_handle_get_utf8_header_value_size(
-        handle,
-        reinterpret_cast<const uint8_t*>(identifier),
-        strlen(identifier),
-        &valueSize,
-        &error
-    );
-
-    if (result != 1 || valueSize == 0) {
-        return QString();
+    if (!headerValuesRead) {
+        readHeaderValues();
     }
 
-    // Allocate buffer and get the value
-    value = new uint8_t[valueSize];
-    result = libewf_handle_get_utf8_header_value(
-        handle,
-        reinterpret_cast<const uint8_t*>(identifier),
-        strlen(identifier),
-        value,
-        valueSize,
-        &error
-    );
+    return headerValues.value(QString::fromLatin1(identifier));
+}
 
-    QString strValue;
-    if (result == 1) {
-        strValue = QString::fromUtf8(reinterpret_cast<const char*>(value));
+void EWFHandler::readHeaderValues()
+{
+    // One pass over the header section's identifiers; each value is
+    // fetched with a single call into a stack buffer, and only values
+    // larger than that pay for a size query
+    headerValues.clear();
+    headerValuesRead = true;
+
+    uint32_t valueCount = 0;
+    if (libewf_handle_get_number_of_header_values(handle, &valueCount, &error) != 1) {
+        libewf_error_free(&error);
+        return;
     }
 
-    delete[] value;
-    return strValue;
+    uint8_t identifier[HEADER_BUFFER_SIZE];
+    uint8_t value[HEADER_BUFFER_SIZE];
+
+    for (uint32_t index = 0; index < valueCount; ++index) {
+        size_t identifierSize = 0;
+        if (libewf_handle_get_header_value_identifier_size(handle, index, &identifierSize, &error) != 1 ||
+            identifierSize == 0 || identifierSize > sizeof(identifier) ||
+            libewf_handle_get_header_value_identifier(handle, index, identifier, identifierSize, &error) != 1) {
+            libewf_error_free(&error);
+            continue;
+        }
+
+        // Sizes include the terminating NUL
+        size_t identifierLength = identifierSize - 1;
+        QString key = QString::fromUtf8(reinterpret_cast<const char*>(identifier),
+                                        static_cast<int>(identifierLength));
+
+        int result = libewf_handle_get_utf8_header_value(handle, identifier, identifierLength,
+                                                         value, sizeof(value), &error);
+        if (result == 1) {
+            headerValues.insert(key, QString::fromUtf8(reinterpret_cast<const char*>(value)));
+            continue;
+        }
+        libewf_error_free(&error);
+
+        // Too large for the stack buffer (long notes fields)
+        size_t valueSize = 0;
+        if (result != -1 ||
+            libewf_handle_get_utf8_header_value_size(handle, identifier, identifierLength,
+                                                     &valueSize, &error) != 1 || valueSize == 0) {
+            libewf_error_free(&error);
+            continue;
+        }
+
+        QByteArray largeValue(static_cast<int>(valueSize), '\0');
+        if (libewf_handle_get_utf8_header_value(handle, identifier, identifierLength,
+                                                reinterpret_cast<uint8_t*>(largeValue.data()),
+                                                valueSize, &error) == 1) {
+            headerValues.insert(key, QString::fromUtf8(largeValue.constData()));
+        } else {
+            libewf_error_free(&error);
+        }
+    }
 }
 
 QString EWFHandler::getHashValue(const char *identifier)
@@ -495,6 +869,72 @@ QString EWFHandler::getHashValue(const char *identifier)
     return hashValue;
 }
 
+void EWFHandler::limitOpenHandles(int segmentCount)
+{
+    // Unlimited: libewf keeps every segment open, so count them all
+    if (maximumOpenHandles < 0) {
+        openHandleLimit = 0;
+        HandleBudget::instance().reserve(segmentCount, segmentCount);
+        reservedHandles = segmentCount;
+        return;
+    }
+
+    // Reads move through the segments front to back, so a handful of open
+    // segments serves sequential, parallel and sampled reads alike
+    int wanted = maximumOpenHandles > 0 ? maximumOpenHandles : AUTO_OPEN_HANDLES;
+    wanted = qMin(wanted, segmentCount);
+    int minimum = qMin(MINIMUM_OPEN_HANDLES, wanted);
+    openHandleLimit = HandleBudget::instance().reserve(wanted, minimum);
+    reservedHandles = openHandleLimit;
+
+    if (libewf_handle_set_maximum_number_of_open_handles(handle, openHandleLimit, &error) != 1) {
+        if (error != nullptr) {
+            libewf_error_free(&error);
+        }
+        qDebug() << "EWFHandler: Cannot limit open segment handles; libewf keeps all" << segmentCount;
+        int remaining = segmentCount - reservedHandles;
+        reservedHandles += HandleBudget::instance().reserve(remaining, remaining);
+        openHandleLimit = 0;
+    }
+}
+
+#ifdef E01HASHER_MMAP_IO
+bool EWFHandler::openMemoryMapped(char * const filenames[], int fileCount)
+{
+    // The pool enforces the open-handle limit itself
+    mappedSegments = MmapFileIO::create(filenames, fileCount, openHandleLimit);
+    if (mappedSegments == nullptr) {
+        return false;
+    }
+
+    if (libewf_handle_open_file_io_pool(handle, mappedSegments->getPool(), LIBEWF_OPEN_READ, &error) != 1) {
+        if (error != nullptr) {
+            libewf_error_free(&error);
+        }
+        qDebug() << "EWFHandler: Memory-mapped open failed, using normal reads";
+        releaseMappedSegments();
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+void EWFHandler::releaseMappedSegments()
+{
+#ifdef E01HASHER_MMAP_IO
+    delete mappedSegments;
+#endif
+    mappedSegments = nullptr;
+}
+
+void EWFHandler::releaseOpenHandles()
+{
+    HandleBudget::instance().release(reservedHandles);
+    reservedHandles = 0;
+    openHandleLimit = 0;
+}
+
 void EWFHandler::setError(const QString &errorMsg)
 {
     lastError = errorMsg;
@@ -8,14 +8,54 @@
 
 #include <QString>
 #include <QMap>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+
 #include <libewf.h>
 
+#include "segmenthasher.h"
+
+class BadRangeMap;
+class MmapFileIO;
+
 class EWFHandler
 {
 public:
     EWFHandler();
     ~EWFHandler();
 
+    // Segment files libewf keeps open per image, for every handler opened
+    // after the call: 0 sizes it from the segment count and the shared
+    // HandleBudget, -1 leaves libewf unlimited (one descriptor per segment)
+    static void setMaximumOpenHandles(int count);
+
+    // Read segment files through memory maps (a libbfio pool of MmapFileIO
+    // handles) instead of read() calls, for handlers opened after the call.
+    // Ignored for images on network filesystems and in builds without
+    // memory-mapped I/O (see isMemoryMappedIOAvailable), and falls back to
+    // the normal open if libewf rejects the pool.
+    static void setMemoryMappedIO(bool enable);
+
+    // Built with CONFIG+=mmap_io (POSIX only)
+    static bool isMemoryMappedIOAvailable();
+
+    // True if this image was opened through memory maps
+    bool isMemoryMapped() const;
+
+    // Hash every segment file (MD5 + SHA1) as this handle's reads pass
+    // through it, so the segments are not read a second time. Only for an
+    // image opened through memory maps; returns whether hashing is on
+    bool setSegmentHashes(bool enable);
+
+    // Hash what the reads did not reach and return the results in segment
+    // order (empty unless setSegmentHashes(true) succeeded)
+    SegmentHashList finishSegmentHashes();
+
+    // True if the file starts with an EWF (E01/Ex01) signature; anything
+    // else is treated as a raw image by the callers that accept both
+    static bool isEwfImage(const QString &filePath);
+
     // File operations
     bool open(const QString &filePath);
     void close();
@@ -25,19 +65,53 @@ public:
     qint64 read(char *buffer, qint64 maxSize);
     qint64 readAt(char *buffer, qint64 maxSize, qint64 offset);
 
+    // Read exactly size bytes at offset, replacing every damaged chunk in
+    // the block with fillByte and recording it in badRanges: chunks libewf
+    // cannot read or inflate, and chunks whose checksum failed, whenever
+    // they were first read
+    void readWithSubstitution(char *buffer, qint64 size, qint64 offset, char fillByte,
+                              BadRangeMap &badRanges);
+
     // File information
     qint64 getMediaSize() const;
+    qint64 getChunkSize() const;
+    qint64 getBytesPerSector() const;
     QString getFilePath() const;
 
+    // Compression the image was written with: 0 none, 1 fast, 2 best
+    // (-1 if libewf cannot tell)
+    int getCompressionLevel();
+
+    // Segment files (.E01 ... .Exx) the image was opened from, in order
+    QStringList getSegmentFiles() const;
+
+    // Segment handles libewf may hold open for this image (0 = unlimited)
+    int getOpenHandleLimit() const;
+
     // Metadata extraction
     QMap<QString, QString> getMetadata();
     QString getMetadataValue(const QString &key);
 
+    // Every header value stored in the image (case number, examiner, ...)
+    QMap<QString, QString> getHeaderValues();
+
     // Stored hash values from E01 file
     QString getStoredMD5();
     QString getStoredSHA1();
     bool hasStoredHash(const QString &algorithm);
 
+    // True if libewf found the segment set damaged or cut short (e.g. the
+    // last segment has no closing "done" section yet)
+    bool segmentFilesCorrupted();
+
+    // Byte ranges (offset, length) whose chunk checksums failed during reads
+    QList<QPair<qint64, qint64>> getChecksumErrors();
+    int getChecksumErrorCount();
+
+    // The checksum-error ranges overlapping [offset, offset + size),
+    // clipped to it and in offset order
+    QList<QPair<qint64, qint64>> getChecksumErrors(qint64 offset, qint64 size);
+
     // Error handling
     QString getLastError() const;
 
@@ -45,8 +119,16 @@ private:
     // Helper functions
     bool detectAndGlobSegments(const QString &filePath, char ***filenames, int *fileCount);
     QString getHeaderValue(const char *identifier);
+    void readHeaderValues();
     QString getHashValue(const char *identifier);
+    void limitOpenHandles(int segmentCount);
+#ifdef E01HASHER_MMAP_IO
+    bool openMemoryMapped(char * const filenames[], int fileCount);
+#endif
+    void releaseMappedSegments();
+    void releaseOpenHandles();
     void setError(const QString &errorMsg);
+    bool readChecksumError(uint32_t index, QPair<qint64, qint64> &range);
 
     // libewf handle
     libewf_handle_t *handle;
@@ -55,12 +137,40 @@ private:
     // State
     bool opened;
     QString currentFilePath;
+    QStringList segmentFiles;
     QString lastError;
     qint64 mediaSize;
+    qint64 chunkSize;
+    qint64 bytesPerSector;
+
+    // Segment handles libewf may keep open, and those reserved for them
+    // in the HandleBudget
+    int openHandleLimit;
+    int reservedHandles;
+    static int maximumOpenHandles;
+
+    // Memory-mapped segment access (owned; freed after the libewf handle)
+    MmapFileIO *mappedSegments;
+    static bool memoryMappedIO;
 
     // Cached metadata
     QMap<QString, QString> cachedMetadata;
     bool metadataCached;
+
+    // Every header value, read in one pass on first use
+    QMap<QString, QString> headerValues;
+    bool headerValuesRead;
+
+    // Checksum-error ranges as libewf last listed them (its index order,
+    // which is offset order); see getChecksumErrors(offset, size)
+    QList<QPair<qint64, qint64>> checksumErrorCache;
+
+    // Constants
+    static const qint64 DEFAULT_BYTES_PER_SECTOR = 512;
+    static const qint64 DEFAULT_CHUNK_SIZE = 64 * DEFAULT_BYTES_PER_SECTOR;
+    static const int HEADER_BUFFER_SIZE = 1024;
+    static const int AUTO_OPEN_HANDLES = 16;     // Ample for sequential and parallel reads
+    static const int MINIMUM_OPEN_HANDLES = 4;   // Granted even when the budget is used up
 };
 
 #endif // EWFHANDLER_H
@@ -0,0 +1,231 @@
+/*
+ * E01 Hash Verification Tool
+ * EWFWriter Implementation
+ */
+
+#include "ewfwriter.h"
+#include <QDir>
+#include <QStringList>
+#include <QDebug>
+#include <cstring>
+
+EWFWriter::EWFWriter()
+    : handle(nullptr)
+    , error(nullptr)
+    , opened(false)
+    , mediaSize(0)
+    , segmentSize(DEFAULT_SEGMENT_SIZE)
+    , compressionLevel(COMPRESSION_FAST)
+    , bytesPerSector(DEFAULT_BYTES_PER_SECTOR)
+{
+}
+
+EWFWriter::~EWFWriter()
+{
+    close();
+}
+
+void EWFWriter::setMediaSize(qint64 size)
+{
+    mediaSize = size;
+}
+
+void EWFWriter::setSegmentSize(qint64 size)
+{
+    if (size > 0) {
+        segmentSize = size;
+    }
+}
+
+void EWFWriter::setCompressionLevel(CompressionLevel level)
+{
+    compressionLevel = level;
+}
+
+void EWFWriter::setBytesPerSector(qint64 size)
+{
+    if (size > 0) {
+        bytesPerSector = size;
+    }
+}
+
+void EWFWriter::setHeaderValue(const QString &identifier, const QString &value)
+{
+    headerValues.insert(identifier, value);
+}
+
+bool EWFWriter::open(const QString &basePath)
+{
+    if (opened) {
+        close();
+    }
+
+    // Output is always EnCase 6; an .Ex01 name would get .E01 segments
+    if (basePath.endsWith(".ex01", Qt::CaseInsensitive)) {
+        setError("Ex01 (EWF2) output is not supported; use an .E01 output name");
+        return false;
+    }
+
+    if (libewf_handle_initialize(&handle, &error) != 1) {
+        setError("Failed to initialize libewf handle");
+        return false;
+    }
+
+    int result;
+#ifdef _WIN32
+    // Windows: Use wide-character open
+    std::wstring wPath = QDir::toNativeSeparators(segmentBasePath(basePath)).toStdWString();
+    wchar_t *filenames[1] = { const_cast<wchar_t*>(wPath.c_str()) };
+    result = libewf_handle_open_wide(handle, filenames, 1, LIBEWF_OPEN_WRITE, &error);
+#else
+    // Linux: Use standard char open
+    QByteArray pathBytes = segmentBasePath(basePath).toLocal8Bit();
+    char *filenames[1] = { pathBytes.data() };
+    result = libewf_handle_open(handle, filenames, 1, LIBEWF_OPEN_WRITE, &error);
+#endif
+
+    if (result != 1) {
+        setError("Failed to create E01 image");
+        libewf_handle_free(&handle, nullptr);
+        handle = nullptr;
+        return false;
+    }
+
+    opened = true;
+
+    // Media values must be set before the first write
+    if (libewf_handle_set_format(handle, LIBEWF_FORMAT_ENCASE6, &error) != 1 ||
+        libewf_handle_set_bytes_per_sector(handle, static_cast<uint32_t>(bytesPerSector), &error) != 1 ||
+        libewf_handle_set_media_size(handle, static_cast<size64_t>(mediaSize), &error) != 1 ||
+        libewf_handle_set_maximum_segment_size(handle, static_cast<size64_t>(segmentSize), &error) != 1 ||
+        libewf_handle_set_compression_values(handle, static_cast<int8_t>(compressionLevel),
+                                             LIBEWF_COMPRESS_FLAG_USE_EMPTY_BLOCK_COMPRESSION,
+                                             &error) != 1) {
+        setError("Failed to set E01 media values");
+        close();
+        return false;
+    }
+
+    for (auto it = headerValues.constBegin(); it != headerValues.constEnd(); ++it) {
+        QByteArray identifier = it.key().toUtf8();
+        QByteArray value = it.value().toUtf8();
+        if (libewf_handle_set_utf8_header_value(handle,
+                reinterpret_cast<const uint8_t*>(identifier.constData()), identifier.size(),
+                reinterpret_cast<const uint8_t*>(value.constData()), value.size(), &error) != 1) {
+            setError("Failed to set header value: " + it.key());
+            close();
+            return false;
+        }
+    }
+
+    qDebug() << "EWFWriter: Creating" << segmentBasePath(basePath) << "with" << mediaSize << "bytes in"
+             << segmentSize / (1024*1024) << "MB segments";
+    return true;
+}
+
+bool EWFWriter::isOpen() const
+{
+    return opened;
+}
+
+qint64 EWFWriter::write(const char *data, qint64 size)
+{
+    if (!opened || handle == nullptr) {
+        setError("Image not open for writing");
+        return -1;
+    }
+
+    qint64 total = 0;
+    while (total < size) {
+        ssize_t written = libewf_handle_write_buffer(handle, data + total,
+                                                     static_cast<size_t>(size - total), &error);
+        if (written <= 0) {
+            setError("Failed to write data to E01 image");
+            return -1;
+        }
+        total += written;
+    }
+
+    return total;
+}
+
+bool EWFWriter::setHashValue(const char *identifier, const QString &hexHash)
+{
+    if (!opened || handle == nullptr || hexHash.isEmpty()) {
+        return false;
+    }
+
+    QByteArray value = hexHash.toLatin1();
+    if (libewf_handle_set_utf8_hash_value(handle,
+            reinterpret_cast<const uint8_t*>(identifier), strlen(identifier),
+            reinterpret_cast<const uint8_t*>(value.constData()), value.size(), &error) != 1) {
+        setError(QString("Failed to store %1 hash").arg(identifier));
+        return false;
+    }
+
+    return true;
+}
+
+bool EWFWriter::finalize()
+{
+    if (!opened || handle == nullptr) {
+        setError("Image not open for writing");
+        return false;
+    }
+
+    if (libewf_handle_write_finalize(handle, &error) < 0) {
+        setError("Failed to finalize E01 image");
+        close();
+        return false;
+    }
+
+    close();
+    return true;
+}
+
+void EWFWriter::close()
+{
+    if (handle != nullptr) {
+        libewf_handle_close(handle, nullptr);
+        libewf_handle_free(&handle, nullptr);
+        handle = nullptr;
+    }
+
+    opened = false;
+}
+
+QString EWFWriter::getLastError() const
+{
+    return lastError;
+}
+
+QString EWFWriter::segmentBasePath(const QString &path)
+{
+    // libewf appends .E01, .E02, ... itself
+    static const QStringList extensions = { ".e01", ".ex01" };
+    for (const QString &extension : extensions) {
+        if (path.endsWith(extension, Qt::CaseInsensitive)) {
+            return path.left(path.length() - extension.length());
+        }
+    }
+
+    return path;
+}
+
+// ===== Private Helper Functions =====
+
+void EWFWriter::setError(const QString &errorMsg)
+{
+    lastError = errorMsg;
+
+    if (error != nullptr) {
+        char errorString[512];
+        if (libewf_error_sprint(error, errorString, 512) > 0) {
+            lastError += QString(" - libewf error: %1").arg(errorString);
+        }
+        libewf_error_free(&error);
+        error = nullptr;
+    }
+
+    qDebug() << "EWFWriter Error:" << lastError;
+}
@@ -0,0 +1,72 @@
+/*
+ * E01 Hash Verification Tool
+ * EWFWriter - libewf write API wrapper
+ */
+
+#ifndef EWFWRITER_H
+#define EWFWRITER_H
+
+#include <QString>
+#include <QMap>
+#include <libewf.h>
+
+class EWFWriter
+{
+public:
+    // libewf compression levels
+    enum CompressionLevel {
+        COMPRESSION_NONE = 0,
+        COMPRESSION_FAST = 1,
+        COMPRESSION_BEST = 2
+    };
+
+    EWFWriter();
+    ~EWFWriter();
+
+    // Settings (must be made before open)
+    void setMediaSize(qint64 size);
+    void setSegmentSize(qint64 size);
+    void setCompressionLevel(CompressionLevel level);
+    void setBytesPerSector(qint64 size);
+    void setHeaderValue(const QString &identifier, const QString &value);
+
+    // Create the image; the .E01 extension is added by libewf and is
+    // stripped from basePath if present
+    bool open(const QString &basePath);
+    bool isOpen() const;
+
+    // Append data in media order
+    qint64 write(const char *data, qint64 size);
+
+    // Stored hashes ("MD5", "SHA1") written into the image on finalize
+    bool setHashValue(const char *identifier, const QString &hexHash);
+
+    // Flush the remaining chunks and the trailing sections, then close
+    bool finalize();
+    void close();
+
+    // Error handling
+    QString getLastError() const;
+
+    static QString segmentBasePath(const QString &path);
+
+private:
+    void setError(const QString &errorMsg);
+
+    libewf_handle_t *handle;
+    libewf_error_t *error;
+
+    bool opened;
+    qint64 mediaSize;
+    qint64 segmentSize;
+    CompressionLevel compressionLevel;
+    qint64 bytesPerSector;
+    QMap<QString, QString> headerValues;
+    QString lastError;
+
+    // Constants
+    static const qint64 DEFAULT_SEGMENT_SIZE = 1536LL * 1024 * 1024;  // 1.5GB, the EnCase default
+    static const qint64 DEFAULT_BYTES_PER_SECTOR = 512;
+};
+
+#endif // EWFWRITER_H
@@ -0,0 +1,73 @@
+/*
+ * E01 Hash Verification Tool
+ * HandleBudget Implementation
+ */
+
+#include "handlebudget.h"
+#include <QDebug>
+#include <QMutexLocker>
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+#endif
+
+HandleBudget::HandleBudget()
+    : limit(MAXIMUM_BUDGET)
+    , inUse(0)
+{
+#ifndef _WIN32
+    // Raise the soft limit to the hard one: thousands of segments across a
+    // few jobs easily pass the usual 1024
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0) {
+        if (files.rlim_cur < files.rlim_max) {
+            struct rlimit raised = files;
+            raised.rlim_cur = files.rlim_max;
+            if (setrlimit(RLIMIT_NOFILE, &raised) == 0) {
+                files = raised;
+            }
+        }
+
+        // RLIM_INFINITY (and other huge limits) are capped like Windows
+        rlim_t available = files.rlim_cur;
+        if (available == RLIM_INFINITY || available > static_cast<rlim_t>(MAXIMUM_BUDGET)) {
+            available = MAXIMUM_BUDGET;
+        }
+        limit = qMax(MINIMUM_BUDGET, static_cast<int>(available) - RESERVED_DESCRIPTORS);
+    }
+#endif
+
+    qDebug() << "HandleBudget:" << limit << "segment handles";
+}
+
+HandleBudget &HandleBudget::instance()
+{
+    static HandleBudget budget;
+    return budget;
+}
+
+int HandleBudget::reserve(int wanted, int minimum)
+{
+    QMutexLocker locker(&mutex);
+    int granted = qMax(minimum, qMin(wanted, limit - inUse));
+    inUse += granted;
+    return granted;
+}
+
+void HandleBudget::release(int count)
+{
+    QMutexLocker locker(&mutex);
+    inUse = qMax(0, inUse - count);
+}
+
+int HandleBudget::getLimit() const
+{
+    QMutexLocker locker(&mutex);
+    return limit;
+}
+
+int HandleBudget::getInUse() const
+{
+    QMutexLocker locker(&mutex);
+    return inUse;
+}
@@ -0,0 +1,43 @@
+/*
+ * E01 Hash Verification Tool
+ * HandleBudget - Process-wide budget of open segment-file handles
+ */
+
+#ifndef HANDLEBUDGET_H
+#define HANDLEBUDGET_H
+
+#include <QMutex>
+
+// Shares the process's file-descriptor limit between every open image.
+// Each EWFHandler reserves the segment handles it lets libewf keep open and
+// returns them on close; libewf closes and reopens segments beyond that
+// (least recently used first). Reservations never block: when the budget
+// is used up a handler still gets a small minimum, so an image can always
+// be opened, and the reserve left for sockets, databases and reports
+// absorbs the difference.
+class HandleBudget
+{
+public:
+    static HandleBudget &instance();
+
+    // Up to `wanted` handles, at least `minimum`
+    int reserve(int wanted, int minimum);
+    void release(int count);
+
+    int getLimit() const;
+    int getInUse() const;
+
+private:
+    HandleBudget();
+
+    mutable QMutex mutex;
+    int limit;
+    int inUse;
+
+    // Constants
+    static const int RESERVED_DESCRIPTORS = 128;   // Sockets, SQLite, reports, stdio
+    static const int MINIMUM_BUDGET = 64;
+    static const int MAXIMUM_BUDGET = 8192;        // Also used on Windows, which has no descriptor limit
+};
+
+#endif // HANDLEBUDGET_H
@@ -0,0 +1,120 @@
+/*
+ * E01 Hash Verification Tool
+ * HashDigest Implementation
+ */
+
+#include "hashdigest.h"
+
+HashDigest::HashDigest(bool md5, bool sha1, bool sha256)
+    : md5(md5)
+    , sha1(sha1)
+    , sha256(sha256)
+    , valid(false)
+    , updateKernel(HashKernel::select(md5, sha1, sha256))
+{
+#ifdef _WIN32
+    hCryptProv = 0;
+    hMD5 = 0;
+    hSHA1 = 0;
+    hSHA256 = 0;
+    valid = CryptAcquireContext(&hCryptProv, NULL, NULL, PROV_RSA_AES, CRYPT_VERIFYCONTEXT) &&
+            (!md5 || CryptCreateHash(hCryptProv, CALG_MD5, 0, 0, &hMD5)) &&
+            (!sha1 || CryptCreateHash(hCryptProv, CALG_SHA1, 0, 0, &hSHA1)) &&
+            (!sha256 || CryptCreateHash(hCryptProv, CALG_SHA_256, 0, 0, &hSHA256));
+    targets.md5 = hMD5;
+    targets.sha1 = hSHA1;
+    targets.sha256 = hSHA256;
+#else
+    MD5_Init(&md5Context);
+    SHA1_Init(&sha1Context);
+    SHA256_Init(&sha256Context);
+    targets.md5 = md5 ? &md5Context : nullptr;
+    targets.sha1 = sha1 ? &sha1Context : nullptr;
+    targets.sha256 = sha256 ? &sha256Context : nullptr;
+    valid = true;
+#endif
+}
+
+HashDigest::~HashDigest()
+{
+#ifdef _WIN32
+    if (hMD5) {
+        CryptDestroyHash(hMD5);
+    }
+    if (hSHA1) {
+        CryptDestroyHash(hSHA1);
+    }
+    if (hSHA256) {
+        CryptDestroyHash(hSHA256);
+    }
+    if (hCryptProv) {
+        CryptReleaseContext(hCryptProv, 0);
+    }
+#endif
+}
+
+bool HashDigest::isValid() const
+{
+    return valid;
+}
+
+void HashDigest::update(const char *data, qint64 size)
+{
+    if (valid && size > 0) {
+        updateKernel(targets, data, size);
+    }
+}
+
+void HashDigest::update(const QByteArray &block)
+{
+    update(block.constData(), block.size());
+}
+
+QMap<QString, QString> HashDigest::finish()
+{
+    QMap<QString, QString> hashes;
+    if (!valid) {
+        return hashes;
+    }
+
+    unsigned char digest[32];
+#ifdef _WIN32
+    DWORD digestSize;
+    if (md5) {
+        digestSize = 16;
+        CryptGetHashParam(hMD5, HP_HASHVAL, digest, &digestSize, 0);
+        hashes["MD5"] = toHex(digest, 16);
+    }
+    if (sha1) {
+        digestSize = 20;
+        CryptGetHashParam(hSHA1, HP_HASHVAL, digest, &digestSize, 0);
+        hashes["SHA1"] = toHex(digest, 20);
+    }
+    if (sha256) {
+        digestSize = 32;
+        CryptGetHashParam(hSHA256, HP_HASHVAL, digest, &digestSize, 0);
+        hashes["SHA256"] = toHex(digest, 32);
+    }
+#else
+    if (md5) {
+        MD5_Final(digest, &md5Context);
+        hashes["MD5"] = toHex(digest, 16);
+    }
+    if (sha1) {
+        SHA1_Final(digest, &sha1Context);
+        hashes["SHA1"] = toHex(digest, 20);
+    }
+    if (sha256) {
+        SHA256_Final(digest, &sha256Context);
+        hashes["SHA256"] = toHex(digest, 32);
+    }
+#endif
+    return hashes;
+}
+
+// ===== Private Helper Functions =====
+
+QString HashDigest::toHex(const unsigned char *digest, int size)
+{
+    return QString::fromLatin1(QByteArray(reinterpret_cast<const char*>(digest), size).toHex());
+}
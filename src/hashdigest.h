@@ -0,0 +1,57 @@
+/*
+ * E01 Hash Verification Tool
+ * HashDigest - MD5 / SHA1 / SHA256 of one stream
+ */
+
+#ifndef HASHDIGEST_H
+#define HASHDIGEST_H
+
+#include "hashkernel.h"
+#include <QString>
+#include <QMap>
+#include <QByteArray>
+
+// Running digests of one stream (an image, a segment file, a piece) on the
+// platform's crypto API, fed through the blocked HashKernel for the chosen
+// algorithm set. finish() returns lowercase hex keyed "MD5", "SHA1" and
+// "SHA256", the keys the rest of the tool reports hashes under.
+class HashDigest
+{
+public:
+    HashDigest(bool md5, bool sha1, bool sha256);
+    ~HashDigest();
+
+    // False when the crypto provider could not be opened (Windows only)
+    bool isValid() const;
+
+    void update(const char *data, qint64 size);
+    void update(const QByteArray &block);
+
+    // Finalize and return the enabled digests; call once
+    QMap<QString, QString> finish();
+
+private:
+    HashDigest(const HashDigest &) = delete;
+    HashDigest &operator=(const HashDigest &) = delete;
+
+    static QString toHex(const unsigned char *digest, int size);
+
+    bool md5;
+    bool sha1;
+    bool sha256;
+    bool valid;
+    HashTargets targets;
+    HashKernel::UpdateFunction updateKernel;
+#ifdef _WIN32
+    HCRYPTPROV hCryptProv;
+    HCRYPTHASH hMD5;
+    HCRYPTHASH hSHA1;
+    HCRYPTHASH hSHA256;
+#else
+    MD5_CTX md5Context;
+    SHA_CTX sha1Context;
+    SHA256_CTX sha256Context;
+#endif
+};
+
+#endif // HASHDIGEST_H
@@ -5,7 +5,15 @@
 
 #include "hashengine.h"
 #include <QDebug>
-#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <cstring>
+#include "prefetchreader.h"
+#include "knownblockstage.h"
+#include "similaritystage.h"
+#include "entropystage.h"
+#include "teewriter.h"
+#include "streamreader.h"
+#include "pipelinetrace.h"
 
 HashEngine::HashEngine(EWFHandler *ewfHandler, QObject *parent)
     : QThread(parent)
@@ -13,13 +21,35 @@ HashEngine::HashEngine(EWFHandler *ewfHandler, QObject *parent)
     , calculateMD5(true)
     , calculateSHA1(true)
     , calculateSHA256(true)
+    , buildSparseMap(false)
+    , chunkSize(0)
+    , calculateSimilarity(false)
+    , calculateSegmentHashes(false)
+    , entropyRegionSize(DEFAULT_ENTROPY_REGION_SIZE)
+    , teeSegmentSize(0)
+    , teeVerifyOutput(false)
+    , knownBlockStage(nullptr)
+    , similarityStage(nullptr)
+    , entropyStage(nullptr)
+    , teeWriter(nullptr)
+    , continueOnError(false)
+    , fillByte(0)
+    , expectedStreamSize(0)
+    , streamPassThrough(false)
+    , parallelReads(1)
+    , parallelReadSize(DEFAULT_PARALLEL_READ_SIZE)
+    , autoTune(false)
+    , blockedKernel(true)
 #ifdef _WIN32
     , hCryptProv(0)
     , hMD5(0)
     , hSHA1(0)
     , hSHA256(0)
 #endif
-    , cancelled(false)
+    , updateKernel(nullptr)
+    , multiBufferHashing(false)
+    , sha1Stream(nullptr)
+    , sha256Stream(nullptr)
 {
 }
 
@@ -30,6 +60,13 @@ HashEngine::~HashEngine()
         cancel();
         wait();
     }
+
+    releaseStages();
+}
+
+void HashEngine::setEWFHandler(EWFHandler *handler)
+{
+    ewfHandler = handler;
 }
 
 void HashEngine::enableMD5(bool enable)
@@ -47,6 +84,93 @@ void HashEngine::enableSHA256(bool enable)
     calculateSHA256 = enable;
 }
 
+void HashEngine::enableSparseMap(bool enable)
+{
+    buildSparseMap = enable;
+}
+
+void HashEngine::setKnownBlockIndex(const QString &indexPath, const QString &reportPath)
+{
+    knownBlockIndexPath = indexPath;
+    knownBlockReportPath = reportPath;
+}
+
+void HashEngine::enableSimilarityDigest(bool enable)
+{
+    calculateSimilarity = enable;
+}
+
+void HashEngine::enableSegmentHashes(bool enable)
+{
+    calculateSegmentHashes = enable;
+}
+
+void HashEngine::setEntropyMap(const QString &mapPath, qint64 regionSize)
+{
+    entropyMapPath = mapPath;
+    if (regionSize > 0) {
+        entropyRegionSize = regionSize;
+    }
+}
+
+void HashEngine::setTeeOutput(const QString &outputPath, qint64 segmentSize, bool verifyOutput)
+{
+    teeOutputPath = outputPath;
+    teeSegmentSize = segmentSize;
+    teeVerifyOutput = verifyOutput;
+}
+
+void HashEngine::setInputStream(const QString &path, qint64 expectedSize, bool passThrough)
+{
+    streamPath = path;
+    expectedStreamSize = expectedSize;
+    streamPassThrough = passThrough;
+}
+
+void HashEngine::enableContinueOnError(bool enable, quint8 fillByte)
+{
+    continueOnError = enable;
+    this->fillByte = static_cast<char>(fillByte);
+}
+
+void HashEngine::enableAutoTune(bool enable)
+{
+    autoTune = enable;
+}
+
+void HashEngine::setPipelineConfig(const PipelineConfig &config)
+{
+    autoTune = false;
+    parallelReads = qMax(1, config.parallelReads);
+    if (config.readSize > 0) {
+        parallelReadSize = config.readSize;
+    }
+    blockedKernel = config.blockedKernel;
+}
+
+PipelineConfig HashEngine::getPipelineConfig() const
+{
+    return tunedConfig;
+}
+
+void HashEngine::enableMultiBufferHashing(bool enable)
+{
+    multiBufferHashing = enable;
+}
+
+void HashEngine::setParallelReads(int readers, qint64 blockSize)
+{
+    parallelReads = qMax(1, readers);
+    if (blockSize > 0) {
+        parallelReadSize = blockSize;
+    }
+}
+
+void HashEngine::setTraceOutput(const QString &tracePath)
+{
+    this->tracePath = tracePath;
+}
+
 void HashEngine::setExpectedMD5(const QString &hash)
 {
     expectedMD5 = hash.toLower().trimmed();
@@ -62,20 +186,72 @@ void HashEngine::setExpectedSHA256(const QString &hash)
     expectedSHA256 = hash.toLower().trimmed();
 }
 
+const JobTelemetry &HashEngine::getTelemetry() const
+{
+    return telemetry;
+}
+
+JobControl &HashEngine::getControl()
+{
+    return control;
+}
+
 void HashEngine::cancel()
 {
-    cancelled = true;
+    control.cancel();
 }
 
 void HashEngine::run()
 {
     qDebug() << "HashEngine: Starting hash calculation";
 
-    cancelled = false;
-
-    // Verify EWF handler is open
-    if (!ewfHandler || !ewfHandler->isOpen()) {
+    control.applyPriority();
+    telemetry.begin(0);
+
+    // Declared before the readers and workers, so the trace is written on
+    // every return only once they have all stopped recording
+    QScopedPointer<PipelineTrace> trace(tracePath.isEmpty() ? nullptr : new PipelineTrace(tracePath));
+    PipelineTrace::ThreadScope traceScope(trace.data(), "hash loop");
+
+    // Stream input replaces the EWF handler
+    QScopedPointer<StreamReader> streamReader;
+    if (!streamPath.isEmpty()) {
+        streamReader.reset(new StreamReader());
+        streamReader->setPassThrough(streamPassThrough);
+        if (!streamReader->open(streamPath)) {
+            emit error(streamReader->getLastError());
+            telemetry.end(JobTelemetry::STATE_FAILED);
+            return;
+        }
+    } else if (!ewfHandler || !ewfHandler->isOpen()) {
+        // Verify EWF handler is open
         emit error("File not open");
+        telemetry.end(JobTelemetry::STATE_FAILED);
+        return;
+    }
+
+    // Pick readers and kernel for this image on this host
+    tunedConfig = PipelineConfig();
+    if (autoTune && !streamReader) {
+        PipelineTuner tuner(ewfHandler);
+        PipelineConfig config = tuner.calibrate(calculateMD5, calculateSHA1, calculateSHA256);
+        tunedConfig = config;
+        parallelReads = config.parallelReads;
+        if (config.readSize > 0) {
+            parallelReadSize = config.readSize;
+        }
+        blockedKernel = config.blockedKernel;
+
+        for (const QString &reason : config.reasons) {
+            qDebug() << "HashEngine: Tuning -" << reason;
+        }
+        emit pipelineTuned(config.reasons);
+    }
+
+    // A cancel during calibration ends the job before any reader starts
+    if (control.isCancelled()) {
+        qDebug() << "HashEngine: Cancelled by user";
+        telemetry.end(JobTelemetry::STATE_CANCELLED);
         return;
     }
 
@@ -83,12 +259,38 @@ void HashEngine::run()
     if (!initializeHashContexts()) {
         emit error("Failed to initialize hash contexts");
         cleanupHashContexts();
+        telemetry.end(JobTelemetry::STATE_FAILED);
         return;
     }
 
-    // Get total file size
-    qint64 totalBytes = ewfHandler->getMediaSize();
+    // Get total file size (a stream's size is only known if given)
+    qint64 totalBytes = streamReader ? expectedStreamSize : ewfHandler->getMediaSize();
     qint64 bytesProcessed = 0;
+    telemetry.setTotalBytes(totalBytes);
+
+    // Zero detection works on EWF chunk boundaries (read blocks for streams)
+    chunkSize = streamReader ? 0 : ewfHandler->getChunkSize();
+    sparseMap.clear();
+    badRanges.clear();
+
+    // Optional per-block analysis runs beside the hash loop
+    if (!startStages(totalBytes, trace.data())) {
+        cleanupHashContexts();
+        telemetry.end(JobTelemetry::STATE_FAILED);
+        return;
+    }
+
+    // Parallel read-ahead for high-latency storage (its readers cannot
+    // substitute damaged chunks, so continue-on-error reads in line)
+    bool prefetch = parallelReads > 1 && !streamReader && !continueOnError;
+
+    // Segment files are hashed as libewf reads them when it reads through
+    // the memory-mapped pool on this handle, so they come off the disk
+    // once. Otherwise SegmentHasher re-reads them after the media read
+    // (below), never competing with it for the disk.
+    bool segmentHashesInFlight = !streamReader &&
+        ewfHandler->setSegmentHashes(calculateSegmentHashes && !prefetch);
+    QScopedPointer<SegmentHasher> segmentHasher;
 
     qDebug() << "HashEngine: Processing" << totalBytes << "bytes";
 
@@ -96,60 +298,144 @@ void HashEngine::run()
     char *buffer = new char[CHUNK_SIZE];
     if (!buffer) {
         emit error("Failed to allocate read buffer");
+        releaseStages();
         cleanupHashContexts();
+        telemetry.end(JobTelemetry::STATE_FAILED);
         return;
     }
 
-    // Timer for progress updates
-    QElapsedTimer timer;
-    timer.start();
-    qint64 lastProgressUpdate = 0;
+    QScopedPointer<PrefetchReader> prefetchReader;
+    if (prefetch) {
+        prefetchReader.reset(new PrefetchReader(ewfHandler->getFilePath(), totalBytes,
+                                                parallelReads, parallelReadSize));
+        prefetchReader->setJobControl(&control);
+        prefetchReader->setTrace(trace.data());
+        prefetchReader->start();
+    }
+    QByteArray block;
 
     // Read and hash data in chunks
-    while (bytesProcessed < totalBytes && !cancelled) {
-        // Calculate how much to read
-        qint64 bytesToRead = qMin(CHUNK_SIZE, totalBytes - bytesProcessed);
-
-        // Read data at specific offset (ensures consistent results)
-        qint64 bytesRead = ewfHandler->readAt(buffer, bytesToRead, bytesProcessed);
+    while (streamReader || bytesProcessed < totalBytes) {
+        const char *data = buffer;
+        qint64 bytesRead;
+
+        if (prefetchReader) {
+            // Blocks arrive in media order from the parallel readers
+            if (prefetchReader->takeNext(block)) {
+                data = block.constData();
+                bytesRead = block.size();
+            } else {
+                bytesRead = prefetchReader->hasError() ? -1 : 0;
+            }
+        } else {
+            // Calculate how much to read
+            qint64 bytesToRead = streamReader ? CHUNK_SIZE : qMin(CHUNK_SIZE, totalBytes - bytesProcessed);
+
+            // Stages keep a reference to the block, so each read needs its own
+            char *target = buffer;
+            if (!stages.isEmpty()) {
+                block = QByteArray(static_cast<int>(bytesToRead), Qt::Uninitialized);
+                target = block.data();
+                data = block.constData();
+            }
+
+            PipelineTrace::Span span(PipelineTrace::EVENT_READ, bytesProcessed, bytesToRead);
+            if (streamReader) {
+                bytesRead = streamReader->read(target, bytesToRead);
+            } else if (continueOnError) {
+                ewfHandler->readWithSubstitution(target, bytesToRead, bytesProcessed, fillByte, badRanges);
+                bytesRead = bytesToRead;
+            } else {
+                // Read data at specific offset (ensures consistent results)
+                bytesRead = ewfHandler->readAt(target, bytesToRead, bytesProcessed);
+            }
+        }
 
         if (bytesRead < 0) {
-            emit error("Failed to read data from file");
+            if (prefetchReader) {
+                emit error(prefetchReader->getLastError());
+            } else if (streamReader) {
+                emit error(streamReader->getLastError());
+            } else {
+                emit error("Failed to read data from file");
+            }
             delete[] buffer;
+            releaseStages();
             cleanupHashContexts();
+            telemetry.end(JobTelemetry::STATE_FAILED);
             return;
         }
 
         if (bytesRead == 0) {
-            // End of file
+            // End of file (or readers stopped by a cancel)
+            break;
+        }
+
+        // Reader stage: prefetch readers are throttled as they read
+        if (prefetchReader ? !control.checkpoint() : !control.throttle(bytesRead)) {
             break;
         }
 
+        // Hand the block to the analysis stages before hashing it here
+        if (!stages.isEmpty()) {
+            if (bytesRead < block.size()) {
+                block.truncate(static_cast<int>(bytesRead));
+            }
+            telemetry.addToCounter(JobTelemetry::COUNTER_STAGE_SUBMITTED, stages.size());
+            for (BlockStage *stage : stages) {
+                stage->submit(block, bytesProcessed);
+            }
+        }
+
+        // Record all-zero chunks
+        if (buildSparseMap) {
+            updateSparseMap(data, bytesRead, bytesProcessed);
+        }
+
         // Update hashes
-        updateHashes(buffer, bytesRead);
+        {
+            PipelineTrace::Span span(PipelineTrace::EVENT_HASH, bytesProcessed, bytesRead);
+            updateHashes(data, bytesRead);
+        }
 
         bytesProcessed += bytesRead;
 
-        // Emit progress update every 100ms
-        qint64 elapsed = timer.elapsed();
-        if (elapsed - lastProgressUpdate >= 100) {
-            calculateProgress(bytesProcessed, totalBytes);
-            lastProgressUpdate = elapsed;
-        }
+        // Publish progress; the GUI / CLI sample it on their own timer
+        telemetry.setBytesProcessed(bytesProcessed);
 
-        // Check for cancellation
-        if (cancelled) {
-            qDebug() << "HashEngine: Cancelled by user";
-            delete[] buffer;
-            cleanupHashContexts();
-            return;
+        // Blocks here while paused
+        if (!control.checkpoint()) {
+            break;
         }
     }
 
     delete[] buffer;
 
-    // Final progress update
-    calculateProgress(totalBytes, totalBytes);
+    // Check for cancellation
+    if (control.isCancelled()) {
+        qDebug() << "HashEngine: Cancelled by user";
+        releaseStages();
+        cleanupHashContexts();
+        telemetry.end(JobTelemetry::STATE_CANCELLED);
+        return;
+    }
+
+    // The scoped pointer cancels and joins the workers on every early
+    // return; they overlap the analysis stages draining
+    if (calculateSegmentHashes && !streamReader && !segmentHashesInFlight) {
+        segmentHasher.reset(new SegmentHasher(ewfHandler->getSegmentFiles()));
+        segmentHasher->setTelemetry(&telemetry);
+        segmentHasher->setJobControl(&control);
+        segmentHasher->setTrace(trace.data());
+        segmentHasher->start();
+    }
+
+    // A stream is complete when it ends
+    if (streamReader) {
+        qDebug() << "HashEngine: Stream ended after" << bytesProcessed << "bytes";
+        totalBytes = bytesProcessed;
+        telemetry.setTotalBytes(totalBytes);
+    }
 
     // Finalize hashes
     finalizeHashes();
@@ -157,6 +443,57 @@ void HashEngine::run()
     // Cleanup
     cleanupHashContexts();
 
+    // A converted E01 carries the source hashes
+    if (teeWriter) {
+        teeWriter->setSourceHashes(calculatedMD5, calculatedSHA1);
+    }
+
+    // Wait for the analysis stages (and any output writer) to drain
+    if (!finishStages()) {
+        releaseStages();
+        telemetry.end(JobTelemetry::STATE_FAILED);
+        return;
+    }
+
+    // Report unallocated (all-zero) regions
+    if (buildSparseMap) {
+        emit sparseMapCalculated(sparseMap);
+    }
+
+    if (knownBlockStage) {
+        emit knownBlocksMatched(knownBlockStage->getKnownGood(), knownBlockStage->getKnownBad(),
+                                knownBlockStage->getReportPath());
+    }
+    if (similarityStage) {
+        if (!similarityStage->getDigest().isEmpty()) {
+            emit similarityDigestCalculated(similarityStage->getDigest());
+        } else if (similarityStage->hasError()) {
+            emit similarityDigestSkipped(similarityStage->getLastError());
+        }
+    }
+    if (teeWriter) {
+        emit teeOutputWritten(teeWriter->getOutputPath(), teeWriter->getBytesWritten(),
+                              teeWriter->getOutputMD5());
+    }
+    if (entropyStage) {
+        emit entropyMapWritten(entropyStage->getMapPath(), entropyStage->getRegionCount(),
+                               entropyStage->getHighEntropyRegions(), entropyStage->getWipedRegions());
+    }
+    releaseStages();
+
+    if (segmentHashesInFlight) {
+        emit segmentHashesCalculated(ewfHandler->finishSegmentHashes());
+    } else if (segmentHasher) {
+        segmentHasher->wait();
+        emit segmentHashesCalculated(segmentHasher->getResults());
+    }
+
+    if (continueOnError && !streamReader) {
+        qDebug() << "HashEngine:" << badRanges.getRanges().size() << "damaged ranges,"
+                 << badRanges.getBadBytes() << "bytes substituted";
+        emit badRangesFound(badRanges);
+    }
+
     // Compare results and emit verification complete
     QMap<QString, bool> verificationResults;
 
@@ -184,6 +521,11 @@ void HashEngine::run()
         }
     }
 
+    if (streamReader && expectedStreamSize > 0) {
+        verificationResults["Size"] = (bytesProcessed == expectedStreamSize);
+    }
+
+    telemetry.end(JobTelemetry::STATE_FINISHED);
     emit verificationComplete(verificationResults);
 
     qDebug() << "HashEngine: Completed successfully";
@@ -191,6 +533,11 @@ void HashEngine::run()
 
 bool HashEngine::initializeHashContexts()
 {
+    // SHA-1 / SHA-256 in the shared lanes need no contexts here
+    bool sharedSHA = multiBufferHashing && MultiBufferHasher::isSupported();
+    bool localSHA1 = calculateSHA1 && !sharedSHA;
+    bool localSHA256 = calculateSHA256 && !sharedSHA;
+
 #ifdef _WIN32
     // Acquire cryptographic provider
     if (!CryptAcquireContext(&hCryptProv, NULL, NULL, PROV_RSA_AES, CRYPT_VERIFYCONTEXT)) {
@@ -206,14 +553,14 @@ bool HashEngine::initializeHashContexts()
         }
     }
 
-    if (calculateSHA1) {
+    if (localSHA1) {
         if (!CryptCreateHash(hCryptProv, CALG_SHA1, 0, 0, &hSHA1)) {
             qDebug() << "HashEngine: Failed to create SHA1 hash";
             return false;
         }
     }
 
-    if (calculateSHA256) {
+    if (localSHA256) {
         if (!CryptCreateHash(hCryptProv, CALG_SHA_256, 0, 0, &hSHA256)) {
             qDebug() << "HashEngine: Failed to create SHA256 hash";
             return false;
@@ -225,50 +572,147 @@ bool HashEngine::initializeHashContexts()
         MD5_Init(&md5Context);
     }
 
-    if (calculateSHA1) {
+    if (localSHA1) {
         SHA1_Init(&sha1Context);
     }
 
-    if (calculateSHA256) {
+    if (localSHA256) {
         SHA256_Init(&sha256Context);
     }
 #endif
 
+    // Pick the kernel once so the per-block path has no flag checks
+    hashTargets = HashTargets();
+#ifdef _WIN32
+    hashTargets.md5 = calculateMD5 ? hMD5 : 0;
+    hashTargets.sha1 = localSHA1 ? hSHA1 : 0;
+    hashTargets.sha256 = localSHA256 ? hSHA256 : 0;
+#else
+    hashTargets.md5 = calculateMD5 ? &md5Context : nullptr;
+    hashTargets.sha1 = localSHA1 ? &sha1Context : nullptr;
+    hashTargets.sha256 = localSHA256 ? &sha256Context : nullptr;
+#endif
+    updateKernel = blockedKernel ? HashKernel::select(calculateMD5, localSHA1, localSHA256)
+                                 : &HashKernel::sequentialUpdate;
+
+    if (sharedSHA) {
+        if (calculateSHA1) {
+            sha1Stream = new MultiBufferHasher::Stream(MultiBufferHasher::SHA1);
+        }
+        if (calculateSHA256) {
+            sha256Stream = new MultiBufferHasher::Stream(MultiBufferHasher::SHA256);
+        }
+    }
+
     return true;
 }
 
 void HashEngine::updateHashes(const char *data, qint64 size)
 {
-#ifdef _WIN32
-    const BYTE *byteData = reinterpret_cast<const BYTE*>(data);
-    DWORD dataSize = static_cast<DWORD>(size);
+    // Queue SHA first: an engine already driving the lane set can take this
+    // buffer in while this thread runs MD5, and wait() hashes the rest here
+    if (sha1Stream) {
+        sha1Stream->submit(data, size);
+    }
+    if (sha256Stream) {
+        sha256Stream->submit(data, size);
+    }
 
-    if (calculateMD5 && hMD5) {
-        CryptHashData(hMD5, byteData, dataSize, 0);
+    updateKernel(hashTargets, data, size);
+
+    if (sha1Stream) {
+        sha1Stream->wait();
+    }
+    if (sha256Stream) {
+        sha256Stream->wait();
     }
+}
 
-    if (calculateSHA1 && hSHA1) {
-        CryptHashData(hSHA1, byteData, dataSize, 0);
+void HashEngine::updateSparseMap(const char *data, qint64 size, qint64 offset)
+{
+    qint64 step = chunkSize > 0 ? chunkSize : size;
+
+    for (qint64 pos = 0; pos < size; pos += step) {
+        qint64 length = qMin(step, size - pos);
+        sparseMap.addChunk(offset + pos, length, SparseMap::isAllZero(data + pos, length));
     }
+}
 
-    if (calculateSHA256 && hSHA256) {
-        CryptHashData(hSHA256, byteData, dataSize, 0);
+bool HashEngine::startStages(qint64 mediaSize, PipelineTrace *trace)
+{
+    releaseStages();
+
+    if (!knownBlockIndexPath.isEmpty()) {
+        knownBlockStage = new KnownBlockStage(knownBlockIndexPath, knownBlockReportPath);
+        knownBlockStage->setTrace(trace, "known-block stage");
+        stages.append(knownBlockStage);
     }
-#else
-    const unsigned char *byteData = reinterpret_cast<const unsigned char*>(data);
 
-    if (calculateMD5) {
-        MD5_Update(&md5Context, byteData, size);
+    if (calculateSimilarity) {
+        similarityStage = new SimilarityStage(mediaSize);
+        similarityStage->setTrace(trace, "similarity stage");
+        stages.append(similarityStage);
     }
 
-    if (calculateSHA1) {
-        SHA1_Update(&sha1Context, byteData, size);
+    if (!entropyMapPath.isEmpty()) {
+        entropyStage = new EntropyStage(entropyMapPath, entropyRegionSize, mediaSize);
+        entropyStage->setTrace(trace, "entropy stage");
+        stages.append(entropyStage);
     }
 
-    if (calculateSHA256) {
-        SHA256_Update(&sha256Context, byteData, size);
+    if (!teeOutputPath.isEmpty()) {
+        teeWriter = new TeeWriter(teeOutputPath, mediaSize);
+        teeWriter->setSegmentSize(teeSegmentSize);
+        teeWriter->setVerifyOutput(teeVerifyOutput);
+        if (streamPath.isEmpty()) {
+            teeWriter->setSourceHeader(ewfHandler->getHeaderValues(), ewfHandler->getBytesPerSector());
+        }
+        teeWriter->setTrace(trace, "tee writer");
+        stages.append(teeWriter);
     }
-#endif
+
+    for (BlockStage *stage : stages) {
+        stage->setTelemetry(&telemetry);
+        if (!stage->startStage()) {
+            emit error(stage->getLastError());
+            releaseStages();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool HashEngine::finishStages()
+{
+    for (BlockStage *stage : stages) {
+        if (!stage->finish()) {
+            // The similarity digest is supplementary; it never fails the hashes
+            if (stage == similarityStage) {
+                qDebug() << "HashEngine: Similarity digest failed -" << stage->getLastError();
+                continue;
+            }
+            emit error(stage->getLastError());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void HashEngine::releaseStages()
+{
+    // abort() is a no-op wait for stages that already finished
+    for (BlockStage *stage : stages) {
+        stage->abort();
+        delete stage;
+    }
+
+    stages.clear();
+    knownBlockStage = nullptr;
+    similarityStage = nullptr;
+    entropyStage = nullptr;
+    teeWriter = nullptr;
 }
 
 void HashEngine::finalizeHashes()
@@ -318,7 +762,7 @@ void HashEngine::finalizeHashes()
     }
 
     // Finalize SHA1
-    if (calculateSHA1) {
+    if (calculateSHA1 && !sha1Stream) {
         SHA1_Final(hashBuffer, &sha1Context);
         calculatedSHA1 = hashToHexString(hashBuffer, SHA_DIGEST_LENGTH);
         emit sha1Calculated(calculatedSHA1);
@@ -326,13 +770,26 @@ void HashEngine::finalizeHashes()
     }
 
     // Finalize SHA256
-    if (calculateSHA256) {
+    if (calculateSHA256 && !sha256Stream) {
         SHA256_Final(hashBuffer, &sha256Context);
         calculatedSHA256 = hashToHexString(hashBuffer, SHA256_DIGEST_LENGTH);
         emit sha256Calculated(calculatedSHA256);
         qDebug() << "SHA256:" << calculatedSHA256;
     }
 #endif
+
+    // Digests from the shared multi-buffer lanes
+    if (sha1Stream) {
+        calculatedSHA1 = QString::fromLatin1(sha1Stream->finish().toHex());
+        emit sha1Calculated(calculatedSHA1);
+        qDebug() << "SHA1:" << calculatedSHA1 << "(multi-buffer)";
+    }
+
+    if (sha256Stream) {
+        calculatedSHA256 = QString::fromLatin1(sha256Stream->finish().toHex());
+        emit sha256Calculated(calculatedSHA256);
+        qDebug() << "SHA256:" << calculatedSHA256 << "(multi-buffer)";
+    }
 }
 
 void HashEngine::cleanupHashContexts()
@@ -360,6 +817,12 @@ void HashEngine::cleanupHashContexts()
 #else
     // OpenSSL contexts are stack-allocated, no cleanup needed
 #endif
+
+    // Waits for any blocks still on the service
+    delete sha1Stream;
+    sha1Stream = nullptr;
+    delete sha256Stream;
+    sha256Stream = nullptr;
 }
 
 #ifdef _WIN32
@@ -377,59 +840,3 @@ QString HashEngine::hashToHexString(const unsigned char *hash, unsigned int hash
 
     return hexString.toLower();
 }
-
-void HashEngine::calculateProgress(qint64 bytesProcessed, qint64 totalBytes)
-{
-    int percentage = 0;
-    if (totalBytes > 0) {
-        percentage = static_cast<int>((bytesProcessed * 100) / totalBytes);
-    }
-
-    emit progressUpdate(percentage, bytesProcessed, totalBytes);
-
-    // Calculate time remaining using exponential smoothing for stability
-    static QElapsedTimer overallTimer;
-    static bool timerStarted = false;
-    static qint64 smoothedRemainingMs = 0;
-    static const double SMOOTHING_FACTOR = 0.2; // Lower = more smoothing
-
-    if (!timerStarted) {
-        overallTimer.start();
-        timerStarted = true;
-        smoothedRemainingMs = 0;
-    }
-
-    if (percentage > 0 && percentage < 100) {
-        qint64 elapsedMs = overallTimer.elapsed();
-        qint64 totalEstimatedMs = (elapsedMs * 100) / percentage;
-        qint64 rawRemainingMs = totalEstimatedMs - elapsedMs;
-
-        // Apply exponential smoothing to reduce jitter
-        if (smoothedRemainingMs == 0) {
-            // First estimate - use raw value
-            smoothedRemainingMs = rawRemainingMs;
-        } else {
-            // Blend new estimate with previous smoothed value
-            smoothedRemainingMs = static_cast<qint64>(
-                SMOOTHING_FACTOR * rawRemainingMs +
-                (1.0 - SMOOTHING_FACTOR) * smoothedRemainingMs
-            );
-        }
-
-        int remainingSeconds = static_cast<int>(smoothedRemainingMs / 1000);
-        int minutes = remainingSeconds / 60;
-        int seconds = remainingSeconds % 60;
-
-        QString timeString;
-        if (minutes > 0) {
-            timeString = QString("%1m %2s").arg(minutes).arg(seconds);
-        } else {
-            timeString = QString("%1s").arg(seconds);
-        }
-
-        emit timeEstimate(timeString);
-    } else if (percentage >= 100) {
-        timerStarted = false;
-        smoothedRemainingMs = 0;
-    }
-}
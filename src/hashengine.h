@@ -8,8 +8,18 @@
 
 #include <QThread>
 #include <QString>
+#include <QStringList>
 #include <QMap>
+#include <QList>
 #include "ewfhandler.h"
+#include "sparsemap.h"
+#include "badrangemap.h"
+#include "segmenthasher.h"
+#include "jobtelemetry.h"
+#include "jobcontrol.h"
+#include "hashkernel.h"
+#include "pipelinetuner.h"
+#include "multibufferhasher.h"
 
 // Platform-specific crypto headers
 #ifdef _WIN32
@@ -20,6 +30,13 @@
     #include <openssl/sha.h>
 #endif
 
+class BlockStage;
+class KnownBlockStage;
+class SimilarityStage;
+class EntropyStage;
+class TeeWriter;
+class PipelineTrace;
+
 class HashEngine : public QThread
 {
     Q_OBJECT
@@ -28,29 +45,130 @@ public:
     explicit HashEngine(EWFHandler *ewfHandler, QObject *parent = nullptr);
     ~HashEngine();
 
+    // Image to read on the next run (lets one engine serve many jobs;
+    // only while the thread is not running)
+    void setEWFHandler(EWFHandler *handler);
+
     // Hash algorithm selection
     void enableMD5(bool enable);
     void enableSHA1(bool enable);
     void enableSHA256(bool enable);
 
+    // Map all-zero chunks for the report (off by default: it scans every
+    // buffer a second time). The map is report-only; the known-block and
+    // entropy stages test their own 4 KB blocks / spans for zeros
+    void enableSparseMap(bool enable);
+
+    // Look up every block against a known-block index and write a CSV
+    // hit report (empty index path disables the lookup)
+    void setKnownBlockIndex(const QString &indexPath, const QString &reportPath);
+
+    // ssdeep-compatible similarity digest of the full media
+    void enableSimilarityDigest(bool enable);
+
+    // Per-region entropy / zero / 0xFF map written as a PPM image
+    // (empty path disables it; region size 0 keeps the default)
+    void setEntropyMap(const QString &mapPath, qint64 regionSize = 0);
+
+    // Hash each segment file (.E01 ... .Exx) as stored, in parallel with
+    // the media hash
+    void enableSegmentHashes(bool enable);
+
+    // Also write the decompressed stream to a raw or E01 output (chosen by
+    // extension); verifyOutput reads the result back and hashes it
+    void setTeeOutput(const QString &outputPath, qint64 segmentSize = 0, bool verifyOutput = false);
+
+    // Hash a raw byte stream ("-" for stdin, or a named pipe) instead of
+    // the EWF handler's image; expectedSize (optional) drives progress and
+    // the size check, passThrough copies the stream to stdout
+    void setInputStream(const QString &path, qint64 expectedSize = 0, bool passThrough = false);
+
+    // Keep hashing past unreadable or checksum-failing chunks: each damaged
+    // chunk is hashed as fillByte and recorded in a bad-range map, and the
+    // digests become "hashes with substitutions" (EWF images only)
+    void enableContinueOnError(bool enable, quint8 fillByte = 0);
+
+    // Calibrate at the start of each run (image compression, storage type,
+    // read and hash speed) and choose the reader count, read size and hash
+    // kernel; overrides setParallelReads() (EWF images only)
+    void enableAutoTune(bool enable);
+
+    // Reuse a configuration from an earlier calibration instead of
+    // calibrating again (turns auto-tuning off)
+    void setPipelineConfig(const PipelineConfig &config);
+
+    // Configuration chosen by the last auto-tuned run (empty reasons if
+    // the run did not calibrate)
+    PipelineConfig getPipelineConfig() const;
+
+    // Reader tuning: more than one reader keeps several large requests
+    // outstanding at once (for SMB/NFS and other high-latency storage)
+    void setParallelReads(int readers, qint64 blockSize = 0);
+
+    // Hash SHA-1 / SHA-256 in the process-wide multi-buffer lanes, AVX2
+    // lanes shared with the other engines hashing at the same time
+    // (ignored without AVX2 or when the lanes failed their self-test)
+    void enableMultiBufferHashing(bool enable);
+
+    // Record a timeline of every read, hash update, stage block and queue
+    // wait on each pipeline thread, written as Chrome trace-event JSON
+    // (chrome://tracing, ui.perfetto.dev) when the run ends, however it
+    // ends (empty path disables it)
+    void setTraceOutput(const QString &tracePath);
+
     // Expected hashes for verification
     void setExpectedMD5(const QString &hash);
     void setExpectedSHA1(const QString &hash);
     void setExpectedSHA256(const QString &hash);
 
+    // Progress, rate and stage counters, sampled by the caller on its own
+    // timer (valid for the engine's lifetime)
+    const JobTelemetry &getTelemetry() const;
+
+    // Pause / resume, rate limit and priority (valid for the engine's
+    // lifetime; a caller that reuses the engine resets it before start(),
+    // so a cancel or pause issued before the run begins is kept)
+    JobControl &getControl();
+
     // Control
     void cancel();
 
 signals:
-    // Progress signals
-    void progressUpdate(int percentage, qint64 bytesProcessed, qint64 totalBytes);
-    void timeEstimate(const QString &remaining);
-
     // Hash results
     void md5Calculated(const QString &hash);
     void sha1Calculated(const QString &hash);
     void sha256Calculated(const QString &hash);
 
+    // Map of all-zero chunks (emitted before verificationComplete)
+    void sparseMapCalculated(const SparseMap &map);
+
+    // Known-block lookup summary (emitted before verificationComplete)
+    void knownBlocksMatched(qint64 knownGood, qint64 knownBad, const QString &reportPath);
+
+    // Similarity digest (emitted before verificationComplete); when it
+    // could not be computed, the reason instead
+    void similarityDigestCalculated(const QString &digest);
+    void similarityDigestSkipped(const QString &reason);
+
+    // Entropy map summary (emitted before verificationComplete)
+    void entropyMapWritten(const QString &mapPath, qint64 regions, qint64 highEntropyRegions,
+                           qint64 wipedRegions);
+
+    // Container-file hashes of every segment (emitted before verificationComplete)
+    void segmentHashesCalculated(const SegmentHashList &hashes);
+
+    // Converted output (emitted before verificationComplete); outputMD5 is
+    // empty unless output verification was requested
+    void teeOutputWritten(const QString &outputPath, qint64 bytesWritten, const QString &outputMD5);
+
+    // Configuration chosen by auto-tuning, one reason per choice (emitted
+    // before hashing starts)
+    void pipelineTuned(const QStringList &reasons);
+
+    // Damaged ranges substituted with the fill byte (emitted before
+    // verificationComplete when continue-on-error is enabled)
+    void badRangesFound(const BadRangeMap &map);
+
     // Verification results
     void verificationComplete(const QMap<QString, bool> &results);
 
@@ -73,7 +191,12 @@ private:
 #else
     QString hashToHexString(const unsigned char *hash, unsigned int hashSize);
 #endif
-    void calculateProgress(qint64 bytesProcessed, qint64 totalBytes);
+    void updateSparseMap(const char *data, qint64 size, qint64 offset);
+
+    // Analysis stages
+    bool startStages(qint64 mediaSize, PipelineTrace *trace);
+    bool finishStages();
+    void releaseStages();
 
     // EWF handler
     EWFHandler *ewfHandler;
@@ -83,6 +206,47 @@ private:
     bool calculateSHA1;
     bool calculateSHA256;
 
+    // Optional analysis
+    bool buildSparseMap;
+    SparseMap sparseMap;
+    qint64 chunkSize;
+    QString knownBlockIndexPath;
+    QString knownBlockReportPath;
+    bool calculateSimilarity;
+    bool calculateSegmentHashes;
+    QString entropyMapPath;
+    qint64 entropyRegionSize;
+    QString teeOutputPath;
+    qint64 teeSegmentSize;
+    bool teeVerifyOutput;
+
+    // Analysis stages fed from the read loop (owned, recreated per run)
+    QList<BlockStage*> stages;
+    KnownBlockStage *knownBlockStage;
+    SimilarityStage *similarityStage;
+    EntropyStage *entropyStage;
+    TeeWriter *teeWriter;
+
+    // Continue past damaged chunks
+    bool continueOnError;
+    char fillByte;
+    BadRangeMap badRanges;
+
+    // Stream input
+    QString streamPath;
+    qint64 expectedStreamSize;
+    bool streamPassThrough;
+
+    // Reader tuning
+    int parallelReads;
+    qint64 parallelReadSize;
+    bool autoTune;
+    bool blockedKernel;
+    PipelineConfig tunedConfig;
+
+    // Pipeline timeline
+    QString tracePath;
+
     // Expected hashes
     QString expectedMD5;
     QString expectedSHA1;
@@ -105,11 +269,25 @@ private:
     SHA256_CTX sha256Context;
 #endif
 
-    // Control flags
-    bool cancelled;
+    // Update kernel for the enabled algorithms (chosen once per run)
+    HashTargets hashTargets;
+    HashKernel::UpdateFunction updateKernel;
+
+    // Streams in the shared multi-buffer lanes (null when hashed here)
+    bool multiBufferHashing;
+    MultiBufferHasher::Stream *sha1Stream;
+    MultiBufferHasher::Stream *sha256Stream;
+
+    // Published progress
+    JobTelemetry telemetry;
+
+    // Cancel, pause, throttling and priority
+    JobControl control;
 
     // Constants
     static const qint64 CHUNK_SIZE = 1024 * 1024;  // 1MB chunks
+    static const qint64 DEFAULT_PARALLEL_READ_SIZE = 8 * 1024 * 1024;  // 8MB per outstanding request
+    static const qint64 DEFAULT_ENTROPY_REGION_SIZE = 1024 * 1024;  // 1MB per map pixel
 };
 
 #endif // HASHENGINE_H
@@ -0,0 +1,323 @@
+/*
+ * E01 Hash Verification Tool
+ * HashKernel Implementation
+ */
+
+#include "hashkernel.h"
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+
+// Per-algorithm update on the platform's crypto API
+#ifdef _WIN32
+inline void feed(HCRYPTHASH hash, const char *data, qint64 size)
+{
+    CryptHashData(hash, reinterpret_cast<const BYTE*>(data), static_cast<DWORD>(size), 0);
+}
+#else
+inline void feed(MD5_CTX *context, const char *data, qint64 size)
+{
+    MD5_Update(context, data, static_cast<size_t>(size));
+}
+
+inline void feed(SHA_CTX *context, const char *data, qint64 size)
+{
+    SHA1_Update(context, data, static_cast<size_t>(size));
+}
+
+inline void feed(SHA256_CTX *context, const char *data, qint64 size)
+{
+    SHA256_Update(context, data, static_cast<size_t>(size));
+}
+#endif
+
+// Contexts for one benchmark run
+class BenchContexts
+{
+public:
+    BenchContexts(bool md5, bool sha1, bool sha256)
+    {
+#ifdef _WIN32
+        hCryptProv = 0;
+        if (CryptAcquireContext(&hCryptProv, NULL, NULL, PROV_RSA_AES, CRYPT_VERIFYCONTEXT)) {
+            if (md5) {
+                CryptCreateHash(hCryptProv, CALG_MD5, 0, 0, &targets.md5);
+            }
+            if (sha1) {
+                CryptCreateHash(hCryptProv, CALG_SHA1, 0, 0, &targets.sha1);
+            }
+            if (sha256) {
+                CryptCreateHash(hCryptProv, CALG_SHA_256, 0, 0, &targets.sha256);
+            }
+        }
+#else
+        if (md5) {
+            MD5_Init(&md5Context);
+            targets.md5 = &md5Context;
+        }
+        if (sha1) {
+            SHA1_Init(&sha1Context);
+            targets.sha1 = &sha1Context;
+        }
+        if (sha256) {
+            SHA256_Init(&sha256Context);
+            targets.sha256 = &sha256Context;
+        }
+#endif
+    }
+
+    ~BenchContexts()
+    {
+        // Finalizing is part of a real run, and keeps the work observable
+        finish();
+    }
+
+    // Digests of the enabled algorithms, concatenated; only the first call
+    // finalizes
+    QByteArray finish()
+    {
+        if (finished) {
+            return digests;
+        }
+        finished = true;
+
+        unsigned char digest[32];
+#ifdef _WIN32
+        DWORD digestSize;
+        HCRYPTHASH hashes[] = {targets.md5, targets.sha1, targets.sha256};
+        for (HCRYPTHASH hash : hashes) {
+            if (hash) {
+                digestSize = sizeof(digest);
+                if (CryptGetHashParam(hash, HP_HASHVAL, digest, &digestSize, 0)) {
+                    digests.append(reinterpret_cast<const char*>(digest), static_cast<int>(digestSize));
+                }
+                CryptDestroyHash(hash);
+            }
+        }
+        if (hCryptProv) {
+            CryptReleaseContext(hCryptProv, 0);
+        }
+#else
+        if (targets.md5) {
+            MD5_Final(digest, &md5Context);
+            digests.append(reinterpret_cast<const char*>(digest), MD5_DIGEST_LENGTH);
+        }
+        if (targets.sha1) {
+            SHA1_Final(digest, &sha1Context);
+            digests.append(reinterpret_cast<const char*>(digest), SHA_DIGEST_LENGTH);
+        }
+        if (targets.sha256) {
+            SHA256_Final(digest, &sha256Context);
+            digests.append(reinterpret_cast<const char*>(digest), SHA256_DIGEST_LENGTH);
+        }
+#endif
+        return digests;
+    }
+
+    HashTargets targets;
+
+private:
+    bool finished = false;
+    QByteArray digests;
+
+#ifdef _WIN32
+    HCRYPTPROV hCryptProv;
+#else
+    MD5_CTX md5Context;
+    SHA_CTX sha1Context;
+    SHA256_CTX sha256Context;
+#endif
+};
+
+double runBench(HashKernel::UpdateFunction update, const HashTargets &targets, const QByteArray &pool)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    for (qint64 offset = 0; offset < pool.size(); offset += HashKernel::BENCH_BLOCK_SIZE) {
+        qint64 length = qMin<qint64>(HashKernel::BENCH_BLOCK_SIZE, pool.size() - offset);
+        update(targets, pool.constData() + offset, length);
+    }
+
+    qint64 elapsedNs = qMax<qint64>(1, timer.nsecsElapsed());
+    return (static_cast<double>(pool.size()) / (1024.0 * 1024.0)) / (elapsedNs / 1e9);
+}
+
+} // namespace
+
+HashKernel::UpdateFunction HashKernel::select(bool md5, bool sha1, bool sha256)
+{
+    static const UpdateFunction kernels[8] = {
+        &HashKernel::blockedUpdate<false, false, false>,
+        &HashKernel::blockedUpdate<false, false, true>,
+        &HashKernel::blockedUpdate<false, true, false>,
+        &HashKernel::blockedUpdate<false, true, true>,
+        &HashKernel::blockedUpdate<true, false, false>,
+        &HashKernel::blockedUpdate<true, false, true>,
+        &HashKernel::blockedUpdate<true, true, false>,
+        &HashKernel::blockedUpdate<true, true, true>
+    };
+
+    return kernels[(md5 ? 4 : 0) | (sha1 ? 2 : 0) | (sha256 ? 1 : 0)];
+}
+
+void HashKernel::sequentialUpdate(const HashTargets &targets, const char *data, qint64 size)
+{
+    if (targets.md5) {
+        feed(targets.md5, data, size);
+    }
+    if (targets.sha1) {
+        feed(targets.sha1, data, size);
+    }
+    if (targets.sha256) {
+        feed(targets.sha256, data, size);
+    }
+}
+
+bool HashKernel::verifyEquivalence(QString *failure)
+{
+    // One byte past an aligned start, so neither the sub-blocks nor the
+    // read pieces line up with cache lines or hash blocks
+    QByteArray storage = makeBenchPool(EQUIVALENCE_BUFFER_SIZE + 8);
+    const char *data = storage.constData() + 1;
+
+    // Read pieces straddle the sub-block size on both sides
+    const qint64 pieceSizes[] = { 1, 63, 64, 65, SUB_BLOCK_SIZE - 1, SUB_BLOCK_SIZE + 1,
+                                  BENCH_BLOCK_SIZE, 3 * SUB_BLOCK_SIZE + 7 };
+    const int pieceCount = sizeof(pieceSizes) / sizeof(pieceSizes[0]);
+
+    for (int set = 1; set < 8; ++set) {
+        bool md5 = set & 4;
+        bool sha1 = set & 2;
+        bool sha256 = set & 1;
+        UpdateFunction blocked = select(md5, sha1, sha256);
+
+        BenchContexts sequentialContexts(md5, sha1, sha256);
+        BenchContexts blockedContexts(md5, sha1, sha256);
+
+        qint64 offset = 0;
+        for (int piece = 0; offset < EQUIVALENCE_BUFFER_SIZE; ++piece) {
+            qint64 length = qMin(pieceSizes[piece % pieceCount], EQUIVALENCE_BUFFER_SIZE - offset);
+            sequentialUpdate(sequentialContexts.targets, data + offset, length);
+            blocked(blockedContexts.targets, data + offset, length);
+            offset += length;
+        }
+
+        QByteArray expected = sequentialContexts.finish();
+        if (expected.isEmpty() || blockedContexts.finish() != expected) {
+            if (failure) {
+                *failure = algorithmNames(md5, sha1, sha256);
+            }
+            qDebug() << "HashKernel: Blocked kernel mismatch for" << algorithmNames(md5, sha1, sha256);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QList<KernelBenchResult> HashKernel::benchmark(qint64 poolSize)
+{
+    QByteArray pool = makeBenchPool(poolSize);
+
+    struct Set {
+        bool md5;
+        bool sha1;
+        bool sha256;
+    };
+    const Set sets[] = {
+        {true, true, false},
+        {true, false, true},
+        {false, true, true},
+        {true, true, true}
+    };
+
+    QList<KernelBenchResult> results;
+    for (const Set &set : sets) {
+        results.append(benchmarkPool(set.md5, set.sha1, set.sha256, pool));
+    }
+
+    return results;
+}
+
+KernelBenchResult HashKernel::benchmarkSet(bool md5, bool sha1, bool sha256, qint64 poolSize)
+{
+    return benchmarkPool(md5, sha1, sha256, makeBenchPool(poolSize));
+}
+
+QByteArray HashKernel::makeBenchPool(qint64 poolSize)
+{
+    // Distinct, incompressible-looking data so nothing is served from a
+    // warm cache line that a real read would not have
+    QByteArray pool(static_cast<int>(poolSize), Qt::Uninitialized);
+    quint64 state = 0x9E3779B97F4A7C15ULL;
+    quint64 *words = reinterpret_cast<quint64*>(pool.data());
+    for (qint64 i = 0; i < poolSize / 8; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        words[i] = state;
+    }
+
+    return pool;
+}
+
+// ===== Private Helper Functions =====
+
+QString HashKernel::algorithmNames(bool md5, bool sha1, bool sha256)
+{
+    QStringList names;
+    if (md5) {
+        names << "MD5";
+    }
+    if (sha1) {
+        names << "SHA1";
+    }
+    if (sha256) {
+        names << "SHA256";
+    }
+
+    return names.join("+");
+}
+
+KernelBenchResult HashKernel::benchmarkPool(bool md5, bool sha1, bool sha256, const QByteArray &pool)
+{
+    KernelBenchResult result;
+    result.algorithms = algorithmNames(md5, sha1, sha256);
+    result.algorithmCount = int(md5) + int(sha1) + int(sha256);
+
+    {
+        BenchContexts contexts(md5, sha1, sha256);
+        result.sequentialMBps = runBench(&HashKernel::sequentialUpdate, contexts.targets, pool);
+    }
+    {
+        BenchContexts contexts(md5, sha1, sha256);
+        result.blockedMBps = runBench(select(md5, sha1, sha256), contexts.targets, pool);
+    }
+
+    qDebug() << "HashKernel:" << result.algorithms << result.sequentialMBps << "->"
+             << result.blockedMBps << "MB/s";
+    return result;
+}
+
+template<bool DoMD5, bool DoSHA1, bool DoSHA256>
+void HashKernel::blockedUpdate(const HashTargets &targets, const char *data, qint64 size)
+{
+    for (qint64 offset = 0; offset < size; offset += SUB_BLOCK_SIZE) {
+        const char *block = data + offset;
+        qint64 length = qMin(SUB_BLOCK_SIZE, size - offset);
+
+        // Disabled algorithms compile away in each instance
+        if (DoMD5) {
+            feed(targets.md5, block, length);
+        }
+        if (DoSHA1) {
+            feed(targets.sha1, block, length);
+        }
+        if (DoSHA256) {
+            feed(targets.sha256, block, length);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * E01 Hash Verification Tool
+ * HashKernel - Cache-blocked multi-algorithm hash update
+ */
+
+#ifndef HASHKERNEL_H
+#define HASHKERNEL_H
+
+#include <QString>
+#include <QList>
+#include <QByteArray>
+
+// Platform-specific crypto headers
+#ifdef _WIN32
+    #include <windows.h>
+    #include <wincrypt.h>
+#else
+    #include <openssl/md5.h>
+    #include <openssl/sha.h>
+#endif
+
+// Hash contexts an update kernel feeds; disabled algorithms are left null
+struct HashTargets
+{
+#ifdef _WIN32
+    HCRYPTHASH md5 = 0;
+    HCRYPTHASH sha1 = 0;
+    HCRYPTHASH sha256 = 0;
+#else
+    MD5_CTX *md5 = nullptr;
+    SHA_CTX *sha1 = nullptr;
+    SHA256_CTX *sha256 = nullptr;
+#endif
+};
+
+// Throughput of one algorithm set, one pass per algorithm vs blocked
+struct KernelBenchResult
+{
+    QString algorithms;
+    int algorithmCount = 0;
+    double sequentialMBps = 0.0;
+    double blockedMBps = 0.0;
+};
+
+// Feeding a 1MB read buffer to MD5, then SHA1, then SHA256 streams it from
+// L2/L3 (or memory) once per algorithm. The blocked kernels walk the buffer
+// in SUB_BLOCK_SIZE pieces and hand each piece to every enabled algorithm
+// while it is still in L1, so the buffer is fetched once. Each combination
+// of algorithms is its own template instance, picked once per run, so the
+// inner loop carries no enable-flag checks.
+class HashKernel
+{
+public:
+    typedef void (*UpdateFunction)(const HashTargets &targets, const char *data, qint64 size);
+
+    // Blocked kernel for the given algorithm set
+    static UpdateFunction select(bool md5, bool sha1, bool sha256);
+
+    // One full pass per algorithm (the previous behaviour; benchmark baseline)
+    static void sequentialUpdate(const HashTargets &targets, const char *data, qint64 size);
+
+    // Check that the blocked kernel of every algorithm set produces the same
+    // digests as one pass per algorithm, over an unaligned buffer fed in
+    // uneven pieces; on a mismatch the failing set is named in failure
+    static bool verifyEquivalence(QString *failure = nullptr);
+
+    // Time both strategies for every multi-algorithm set over a buffer pool
+    // larger than the last-level cache, fed in read-loop sized blocks
+    static QList<KernelBenchResult> benchmark(qint64 poolSize = DEFAULT_BENCH_POOL_SIZE);
+
+    // The same comparison for one algorithm set
+    static KernelBenchResult benchmarkSet(bool md5, bool sha1, bool sha256,
+                                          qint64 poolSize = DEFAULT_BENCH_POOL_SIZE);
+
+    // Fixed-seed pseudo-random data, the same on every run and host
+    static QByteArray makeBenchPool(qint64 poolSize);
+
+    // Constants
+    static const qint64 SUB_BLOCK_SIZE = 16 * 1024;    // Well inside a 32KB L1d with the contexts
+    static const qint64 BENCH_BLOCK_SIZE = 1024 * 1024; // Matches HashEngine::CHUNK_SIZE
+    static const qint64 DEFAULT_BENCH_POOL_SIZE = 256 * 1024 * 1024;
+    static const qint64 EQUIVALENCE_BUFFER_SIZE = 3 * 1024 * 1024 + 4099;
+
+private:
+    static KernelBenchResult benchmarkPool(bool md5, bool sha1, bool sha256, const QByteArray &pool);
+    static QString algorithmNames(bool md5, bool sha1, bool sha256);
+
+    template<bool DoMD5, bool DoSHA1, bool DoSHA256>
+    static void blockedUpdate(const HashTargets &targets, const char *data, qint64 size);
+};
+
+#endif // HASHKERNEL_H
@@ -0,0 +1,242 @@
+/*
+ * E01 Hash Verification Tool
+ * ImageComparator Implementation
+ */
+
+#include "imagecomparator.h"
+#include "ewfhandler.h"
+#include "hashdigest.h"
+#include "prefetchreader.h"
+#include <QDebug>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThreadPool>
+#include <cstring>
+
+ImageComparator::ImageComparator(const QString &pathA, const QString &pathB, QObject *parent)
+    : QThread(parent)
+    , pathA(pathA)
+    , pathB(pathB)
+    , calculateMD5(true)
+    , calculateSHA1(false)
+    , calculateSHA256(false)
+    , parallelReads(0)
+    , blockSize(DEFAULT_BLOCK_SIZE)
+{
+}
+
+ImageComparator::~ImageComparator()
+{
+    // Wait for thread to finish
+    if (isRunning()) {
+        cancel();
+        wait();
+    }
+}
+
+void ImageComparator::setAlgorithms(bool md5, bool sha1, bool sha256)
+{
+    calculateMD5 = md5;
+    calculateSHA1 = sha1;
+    calculateSHA256 = sha256;
+}
+
+void ImageComparator::setParallelReads(int count)
+{
+    parallelReads = qMax(0, count);
+}
+
+void ImageComparator::setBlockSize(qint64 bytes)
+{
+    // Whole sectors, so a block boundary never splits a compared sector
+    if (bytes >= COMPARE_GRANULARITY) {
+        blockSize = bytes - bytes % COMPARE_GRANULARITY;
+    }
+}
+
+const JobTelemetry &ImageComparator::getTelemetry() const
+{
+    return telemetry;
+}
+
+JobControl &ImageComparator::getControl()
+{
+    return control;
+}
+
+void ImageComparator::cancel()
+{
+    control.cancel();
+}
+
+qint64 ImageComparator::findDifferences(const char *a, const char *b, qint64 size, qint64 offset,
+                                        QList<QPair<qint64, qint64>> &ranges, int maxRanges)
+{
+    // memcmp is the vectorised compare of the C library (SSE2/AVX2 in glibc
+    // and the MSVC runtime); identical blocks, the normal case, cost one call
+    if (memcmp(a, b, static_cast<size_t>(size)) == 0) {
+        return 0;
+    }
+
+    qint64 differing = 0;
+    for (qint64 pos = 0; pos < size; pos += COMPARE_GRANULARITY) {
+        qint64 length = qMin(COMPARE_GRANULARITY, size - pos);
+        if (memcmp(a + pos, b + pos, static_cast<size_t>(length)) == 0) {
+            continue;
+        }
+
+        differing += length;
+        if (!ranges.isEmpty() && ranges.last().first + ranges.last().second == offset + pos) {
+            ranges.last().second += length;
+        } else if (ranges.size() < maxRanges) {
+            ranges.append(qMakePair(offset + pos, length));
+        }
+    }
+    return differing;
+}
+
+void ImageComparator::run()
+{
+    qDebug() << "ImageComparator: Comparing" << pathA << "with" << pathB;
+
+    control.applyPriority();
+    telemetry.begin(0);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    ImageCompareResult result;
+    bool rawA = !EWFHandler::isEwfImage(pathA);
+    bool rawB = !EWFHandler::isEwfImage(pathB);
+    if (!mediaSize(pathA, rawA, result.sizeA) || !mediaSize(pathB, rawB, result.sizeB)) {
+        telemetry.end(JobTelemetry::STATE_FAILED);
+        emit error(lastError);
+        return;
+    }
+
+    HashDigest digestA(calculateMD5, calculateSHA1, calculateSHA256);
+    HashDigest digestB(calculateMD5, calculateSHA1, calculateSHA256);
+    if (!digestA.isValid() || !digestB.isValid()) {
+        telemetry.end(JobTelemetry::STATE_FAILED);
+        emit error("Failed to initialize hash contexts");
+        return;
+    }
+
+    // Same block size on both sides keeps block N of A and B at the same offset
+    int readsA = parallelReads > 0 ? parallelReads
+        : (PrefetchReader::isNetworkPath(pathA) ? NETWORK_PARALLEL_READS : LOCAL_PARALLEL_READS);
+    int readsB = parallelReads > 0 ? parallelReads
+        : (PrefetchReader::isNetworkPath(pathB) ? NETWORK_PARALLEL_READS : LOCAL_PARALLEL_READS);
+    PrefetchReader readerA(pathA, result.sizeA, readsA, blockSize);
+    PrefetchReader readerB(pathB, result.sizeB, readsB, blockSize);
+    readerA.setRawInput(rawA);
+    readerB.setRawInput(rawB);
+    readerA.setJobControl(&control);
+    readerB.setJobControl(&control);
+    readerA.start();
+    readerB.start();
+
+    // B is hashed here while this thread hashes and compares A
+    QThreadPool hashPool;
+    hashPool.setMaxThreadCount(1);
+
+    telemetry.setTotalBytes(qMax(result.sizeA, result.sizeB));
+    qint64 positionA = 0;
+    qint64 positionB = 0;
+
+    while (positionA < result.sizeA || positionB < result.sizeB) {
+        if (!control.checkpoint()) {
+            qDebug() << "ImageComparator: Cancelled";
+            telemetry.end(JobTelemetry::STATE_CANCELLED);
+            return;
+        }
+
+        // The readers pause, throttle and stop with the job
+        QByteArray blockA;
+        QByteArray blockB;
+        bool readA = positionA >= result.sizeA || readerA.takeNext(blockA);
+        bool readB = positionB >= result.sizeB || readerB.takeNext(blockB);
+        if (control.isCancelled()) {
+            qDebug() << "ImageComparator: Cancelled";
+            telemetry.end(JobTelemetry::STATE_CANCELLED);
+            return;
+        }
+        if (!readA) {
+            telemetry.end(JobTelemetry::STATE_FAILED);
+            emit error(pathA + ": " + readerA.getLastError());
+            return;
+        }
+        if (!readB) {
+            telemetry.end(JobTelemetry::STATE_FAILED);
+            emit error(pathB + ": " + readerB.getLastError());
+            return;
+        }
+
+        hashPool.start([&digestB, &blockB]() {
+            digestB.update(blockB);
+        });
+        digestA.update(blockA);
+
+        // Past the end of the shorter image only the tail counts, below
+        qint64 common = qMin(blockA.size(), blockB.size());
+        if (common > 0) {
+            result.differingBytes += findDifferences(blockA.constData(), blockB.constData(), common,
+                                                     positionA, result.differingRanges,
+                                                     MAX_REPORTED_RANGES);
+        }
+
+        hashPool.waitForDone();
+        positionA += blockA.size();
+        positionB += blockB.size();
+        telemetry.setBytesProcessed(qMax(positionA, positionB));
+    }
+
+    if (result.sizeA != result.sizeB) {
+        qint64 tail = qAbs(result.sizeA - result.sizeB);
+        result.differingBytes += tail;
+        if (result.differingRanges.size() < MAX_REPORTED_RANGES) {
+            result.differingRanges.append(qMakePair(qMin(result.sizeA, result.sizeB), tail));
+        }
+    }
+
+    // Differences past the range limit are counted but not listed
+    qint64 listedBytes = 0;
+    for (const QPair<qint64, qint64> &range : result.differingRanges) {
+        listedBytes += range.second;
+    }
+    result.rangesTruncated = listedBytes < result.differingBytes;
+
+    result.hashesA = digestA.finish();
+    result.hashesB = digestB.finish();
+    result.elapsedMs = timer.elapsed();
+    telemetry.end(JobTelemetry::STATE_FINISHED);
+
+    qDebug() << "ImageComparator: Done -" << result.differingBytes << "differing bytes in"
+             << result.differingRanges.size() << "ranges," << result.elapsedMs << "ms";
+    emit compareComplete(result);
+}
+
+// ===== Private Helper Functions =====
+
+bool ImageComparator::mediaSize(const QString &path, bool raw, qint64 &size)
+{
+    if (raw) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            lastError = "Cannot open " + path + ": " + file.errorString();
+            return false;
+        }
+        size = file.size();
+        return true;
+    }
+
+    // Probe the image geometry with a short-lived handle
+    EWFHandler handler;
+    if (!handler.open(path)) {
+        lastError = "Cannot open " + path + ": " + handler.getLastError();
+        return false;
+    }
+    size = handler.getMediaSize();
+    return true;
+}
@@ -0,0 +1,100 @@
+/*
+ * E01 Hash Verification Tool
+ * ImageComparator - Lockstep hash and byte comparison of two images
+ */
+
+#ifndef IMAGECOMPARATOR_H
+#define IMAGECOMPARATOR_H
+
+#include <QThread>
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QMetaType>
+#include "jobtelemetry.h"
+#include "jobcontrol.h"
+
+// Outcome of comparing image A with image B
+struct ImageCompareResult
+{
+    qint64 sizeA = 0;
+    qint64 sizeB = 0;
+    qint64 differingBytes = 0;                     // Including the tail of the longer image
+    QList<QPair<qint64, qint64>> differingRanges;  // (offset, length), merged, in media order
+    bool rangesTruncated = false;                  // More ranges than MAX_REPORTED_RANGES
+    QMap<QString, QString> hashesA;                // "MD5" / "SHA1" / "SHA256" -> hex
+    QMap<QString, QString> hashesB;
+    qint64 elapsedMs = 0;
+
+    bool identical() const { return sizeA == sizeB && differingBytes == 0; }
+};
+
+Q_DECLARE_METATYPE(ImageCompareResult)
+
+// Reads two images (E01 or raw, in any combination) through two
+// PrefetchReaders with the same block size, so block N of A and block N of
+// B arrive together. Each pair is compared and both are hashed in the same
+// pass: B on a helper thread while A is hashed and compared here. This
+// replaces a full verification of each image followed by a separate diff.
+class ImageComparator : public QThread
+{
+    Q_OBJECT
+
+public:
+    ImageComparator(const QString &pathA, const QString &pathB, QObject *parent = nullptr);
+    ~ImageComparator();
+
+    // Hash algorithms applied to both images (default MD5)
+    void setAlgorithms(bool md5, bool sha1, bool sha256);
+
+    // Readers per image (0 picks by storage) and their block size
+    void setParallelReads(int count);
+    void setBlockSize(qint64 bytes);
+
+    // Progress, read lock-free by the caller's timer
+    const JobTelemetry &getTelemetry() const;
+
+    // Cancel, pause, rate limit and priority; set up before start()
+    JobControl &getControl();
+    void cancel();
+
+    // Differing bytes of a block pair, merged into ranges at sector
+    // granularity; returns the number of differing bytes
+    static qint64 findDifferences(const char *a, const char *b, qint64 size, qint64 offset,
+                                  QList<QPair<qint64, qint64>> &ranges, int maxRanges);
+
+signals:
+    void compareComplete(const ImageCompareResult &result);
+    void error(const QString &errorMessage);
+
+protected:
+    void run() override;
+
+private:
+    bool mediaSize(const QString &path, bool raw, qint64 &size);
+
+    QString pathA;
+    QString pathB;
+
+    // Configuration
+    bool calculateMD5;
+    bool calculateSHA1;
+    bool calculateSHA256;
+    int parallelReads;
+    qint64 blockSize;
+
+    // Progress and control
+    JobTelemetry telemetry;
+    JobControl control;
+    QString lastError;
+
+    // Constants
+    static const qint64 DEFAULT_BLOCK_SIZE = 8 * 1024 * 1024;
+    static const qint64 COMPARE_GRANULARITY = 512;   // One sector
+    static const int LOCAL_PARALLEL_READS = 2;
+    static const int NETWORK_PARALLEL_READS = 8;
+    static const int MAX_REPORTED_RANGES = 100000;
+};
+
+#endif // IMAGECOMPARATOR_H
@@ -0,0 +1,237 @@
+/*
+ * E01 Hash Verification Tool
+ * JobControl Implementation
+ */
+
+#include "jobcontrol.h"
+#include "pipelinetrace.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <cmath>
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+// <linux/ioprio.h> is not installed everywhere, and glibc has no wrapper
+const int IOPRIO_WHO_PROCESS = 1;
+const int IOPRIO_CLASS_IDLE = 3;
+const int IOPRIO_CLASS_SHIFT = 13;
+const int BACKGROUND_NICE = 19;
+#endif
+
+const double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+
+// Longest single wait, so a lowered or removed limit takes effect promptly
+const qint64 MAX_THROTTLE_WAIT_MS = 250;
+
+}
+
+// ===== TokenBucket =====
+
+TokenBucket::TokenBucket()
+    : rate(0.0)
+    , tokens(0.0)
+    , lastRefillNs(0)
+{
+    clock.start();
+}
+
+void TokenBucket::setRate(double bytesPerSecond)
+{
+    QMutexLocker locker(&mutex);
+    rate = qMax(0.0, bytesPerSecond);
+
+    // Start full so a new limit does not stall the next read
+    tokens = rate;
+    lastRefillNs = clock.nsecsElapsed();
+}
+
+double TokenBucket::getRate() const
+{
+    QMutexLocker locker(&mutex);
+    return rate;
+}
+
+qint64 TokenBucket::take(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    if (rate <= 0.0) {
+        return 0;
+    }
+
+    qint64 now = clock.nsecsElapsed();
+    tokens = qMin(rate, tokens + (now - lastRefillNs) * rate / 1e9);
+    lastRefillNs = now;
+
+    tokens -= bytes;
+    if (tokens >= 0.0) {
+        return 0;
+    }
+    return static_cast<qint64>(std::ceil(-tokens * 1000.0 / rate));
+}
+
+// ===== JobControl =====
+
+JobControl::JobControl()
+    : cancelled(false)
+    , paused(false)
+    , priority(PRIORITY_NORMAL)
+{
+}
+
+void JobControl::cancel()
+{
+    QMutexLocker locker(&mutex);
+    cancelled = true;
+    stateChanged.wakeAll();
+}
+
+void JobControl::pause()
+{
+    QMutexLocker locker(&mutex);
+    paused = true;
+}
+
+void JobControl::resume()
+{
+    QMutexLocker locker(&mutex);
+    paused = false;
+    stateChanged.wakeAll();
+}
+
+bool JobControl::isCancelled() const
+{
+    QMutexLocker locker(&mutex);
+    return cancelled;
+}
+
+bool JobControl::isPaused() const
+{
+    QMutexLocker locker(&mutex);
+    return paused;
+}
+
+void JobControl::setRateLimit(double megabytesPerSecond)
+{
+    bucket.setRate(megabytesPerSecond * BYTES_PER_MEGABYTE);
+
+    // A waiting reader re-reads the limit
+    QMutexLocker locker(&mutex);
+    stateChanged.wakeAll();
+}
+
+double JobControl::getRateLimit() const
+{
+    return bucket.getRate() / BYTES_PER_MEGABYTE;
+}
+
+void JobControl::setPriority(Priority priority)
+{
+    QMutexLocker locker(&mutex);
+    this->priority = priority;
+}
+
+JobControl::Priority JobControl::getPriority() const
+{
+    QMutexLocker locker(&mutex);
+    return priority;
+}
+
+void JobControl::setGlobalRateLimit(double megabytesPerSecond)
+{
+    globalBucket().setRate(megabytesPerSecond * BYTES_PER_MEGABYTE);
+}
+
+double JobControl::getGlobalRateLimit()
+{
+    return globalBucket().getRate() / BYTES_PER_MEGABYTE;
+}
+
+void JobControl::reset()
+{
+    QMutexLocker locker(&mutex);
+    cancelled = false;
+    paused = false;
+}
+
+bool JobControl::checkpoint()
+{
+    QMutexLocker locker(&mutex);
+    if (paused && !cancelled) {
+        PipelineTrace::Span span(PipelineTrace::EVENT_WAIT_PAUSED);
+        while (paused && !cancelled) {
+            stateChanged.wait(&mutex);
+        }
+    }
+    return !cancelled;
+}
+
+bool JobControl::throttle(qint64 bytes)
+{
+    // Both buckets are charged; the longer debt sets the wait
+    qint64 waitMs = qMax(bucket.take(bytes), globalBucket().take(bytes));
+    if (waitMs > 0 && !waitFor(waitMs)) {
+        return false;
+    }
+    return checkpoint();
+}
+
+void JobControl::applyPriority() const
+{
+    if (getPriority() != PRIORITY_BACKGROUND) {
+        return;
+    }
+
+#ifdef _WIN32
+    // Lowers I/O and memory priority as well as CPU priority
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN)) {
+        qDebug() << "JobControl: Failed to enter background mode:" << GetLastError();
+    }
+#elif defined(__linux__)
+    // Both are per thread on Linux (0 / the tid name the calling thread)
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+        qDebug() << "JobControl: Failed to set idle I/O class";
+    }
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), BACKGROUND_NICE) != 0) {
+        qDebug() << "JobControl: Failed to lower CPU priority";
+    }
+#endif
+}
+
+// ===== Private Helper Functions =====
+
+bool JobControl::waitFor(qint64 ms)
+{
+    QElapsedTimer timer;
+    timer.start();
+    PipelineTrace::Span span(PipelineTrace::EVENT_WAIT_THROTTLE);
+
+    QMutexLocker locker(&mutex);
+    while (!cancelled) {
+        qint64 remaining = ms - timer.elapsed();
+        if (remaining <= 0) {
+            break;
+        }
+        stateChanged.wait(&mutex, static_cast<unsigned long>(qMin(remaining, MAX_THROTTLE_WAIT_MS)));
+
+        // Limit removed while waiting
+        if (bucket.getRate() <= 0.0 && globalBucket().getRate() <= 0.0) {
+            break;
+        }
+    }
+    return !cancelled;
+}
+
+TokenBucket &JobControl::globalBucket()
+{
+    static TokenBucket shared;
+    return shared;
+}
@@ -0,0 +1,92 @@
+/*
+ * E01 Hash Verification Tool
+ * JobControl - Cancel, pause, bandwidth and priority channel for a running job
+ */
+
+#ifndef JOBCONTROL_H
+#define JOBCONTROL_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+
+// Token bucket in bytes per second. Consumers take what they have just read
+// and may run the bucket into debt; the returned delay pays it back, so a
+// few large reads are limited as precisely as many small ones. Holds at most
+// one second of burst.
+class TokenBucket
+{
+public:
+    TokenBucket();
+
+    // 0 disables the limit
+    void setRate(double bytesPerSecond);
+    double getRate() const;
+
+    // Milliseconds the caller should wait before reading on (0 = none)
+    qint64 take(qint64 bytes);
+
+private:
+    mutable QMutex mutex;
+    QElapsedTimer clock;
+    double rate;
+    double tokens;
+    qint64 lastRefillNs;
+};
+
+// Shared between a job's threads and whoever controls it (GUI, CLI, job
+// server). The job calls checkpoint() between pipeline stages, where it
+// blocks while paused, and throttle() after each read, where it waits for
+// the job's own and the process-wide token buckets. Both return false once
+// the job is cancelled, including while they wait. Pausing holds every
+// buffer, hash context and open handle, so resume continues mid-image.
+class JobControl
+{
+public:
+    enum Priority {
+        PRIORITY_NORMAL,
+        PRIORITY_BACKGROUND    // Idle I/O class and lowest CPU priority
+    };
+
+    JobControl();
+
+    // Controller side (any thread); reset() clears cancel and pause before
+    // a reused job is started again
+    void reset();
+    void cancel();
+    void pause();
+    void resume();
+    bool isCancelled() const;
+    bool isPaused() const;
+
+    // Per-job limit in MB/s (0 = unlimited); may change while running
+    void setRateLimit(double megabytesPerSecond);
+    double getRateLimit() const;
+
+    // Applied by each of the job's threads when it starts
+    void setPriority(Priority priority);
+    Priority getPriority() const;
+
+    // Limit shared by every job in the process (0 = unlimited)
+    static void setGlobalRateLimit(double megabytesPerSecond);
+    static double getGlobalRateLimit();
+
+    // Job side
+    bool checkpoint();
+    bool throttle(qint64 bytes);
+    void applyPriority() const;   // To the calling thread
+
+private:
+    bool waitFor(qint64 ms);
+
+    static TokenBucket &globalBucket();
+
+    mutable QMutex mutex;
+    QWaitCondition stateChanged;
+    bool cancelled;
+    bool paused;
+    Priority priority;
+    TokenBucket bucket;
+};
+
+#endif // JOBCONTROL_H
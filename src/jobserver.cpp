@@ -0,0 +1,686 @@
+/*
+ * E01 Hash Verification Tool
+ * JobServer Implementation
+ */
+
+#include "jobserver.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+JobServer::JobServer(QObject *parent)
+    : QObject(parent)
+    , workerCount(DEFAULT_WORKER_COUNT)
+    , defaultRateLimit(0.0)
+    , defaultBackground(false)
+    , progressInterval(PROGRESS_INTERVAL_MS)
+    , multiBufferHashing(false)
+    , nextJobId(1)
+{
+    connect(&server, &QLocalServer::newConnection, this, &JobServer::onNewConnection);
+    connect(&progressTimer, &QTimer::timeout, this, &JobServer::onProgressTimer);
+}
+
+JobServer::~JobServer()
+{
+    // Stop running jobs before tearing down the handlers they read from;
+    // every engine is cancelled first so they wind down together
+    for (Worker *worker : workers) {
+        worker->engine->cancel();
+    }
+    for (Worker *worker : workers) {
+        worker->engine->wait();
+        delete worker->engine;
+        delete worker->ewfHandler;
+        delete worker;
+    }
+}
+
+void JobServer::setWorkerCount(int count)
+{
+    workerCount = qMax(1, count);
+}
+
+void JobServer::setDefaultRateLimit(double megabytesPerSecond)
+{
+    defaultRateLimit = qMax(0.0, megabytesPerSecond);
+}
+
+void JobServer::setDefaultBackground(bool background)
+{
+    defaultBackground = background;
+}
+
+void JobServer::setProgressInterval(int milliseconds)
+{
+    progressInterval = qMax(10, milliseconds);
+}
+
+void JobServer::setMultiBufferHashing(bool enable)
+{
+    multiBufferHashing = enable;
+}
+
+bool JobServer::listen(const QString &name)
+{
+    // A server that died without cleaning up leaves its socket file behind;
+    // remove it only when nothing answers, so a second --serve with the
+    // same name cannot take the socket from a running server
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(STALE_SOCKET_PROBE_MS)) {
+        probe.disconnectFromServer();
+        emit error("Cannot listen on " + name + ": another server is already running there");
+        return false;
+    }
+    QLocalServer::removeServer(name);
+
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    if (!server.listen(name)) {
+        emit error("Cannot listen on " + name + ": " + server.errorString());
+        return false;
+    }
+
+    createWorkers();
+
+    qDebug() << "JobServer: Listening on" << server.fullServerName() << "with" << workerCount << "workers";
+    return true;
+}
+
+QString JobServer::serverName() const
+{
+    return server.fullServerName();
+}
+
+// ===== Slot Implementations =====
+
+void JobServer::onNewConnection()
+{
+    while (server.hasPendingConnections()) {
+        QLocalSocket *socket = server.nextPendingConnection();
+        clients.insert(socket, Client());
+
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readClient(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { dropClient(socket); });
+    }
+}
+
+void JobServer::onProgressTimer()
+{
+    for (Worker *worker : workers) {
+        if (worker->jobId == 0) {
+            continue;
+        }
+
+        TelemetrySnapshot progress = worker->engine->getTelemetry().snapshot();
+        if (progress.state != JobTelemetry::STATE_RUNNING) {
+            continue;
+        }
+
+        QJsonObject event;
+        event.insert("event", "progress");
+        event.insert("job", worker->jobId);
+        event.insert("bytes", progress.bytesProcessed);
+        event.insert("total", progress.totalBytes);
+        event.insert("percent", progress.percentage());
+        event.insert("bytesPerSecond", progress.bytesPerSecond());
+        event.insert("remainingMs", progress.remainingMs());
+        event.insert("paused", jobs[worker->jobId].pauseRequested);
+        publish(worker->jobId, event);
+    }
+}
+
+// ===== Private Helper Functions =====
+
+void JobServer::readClient(QLocalSocket *socket)
+{
+    if (!clients.contains(socket)) {
+        return;
+    }
+
+    Client &client = clients[socket];
+    client.buffer.append(socket->readAll());
+
+    int newline;
+    while ((newline = client.buffer.indexOf('\n')) >= 0) {
+        QByteArray line = client.buffer.left(newline).trimmed();
+        client.buffer.remove(0, newline + 1);
+        if (!line.isEmpty()) {
+            handleRequest(socket, line);
+        }
+        if (!clients.contains(socket)) {
+            return;
+        }
+    }
+
+    // A peer that never sends a newline does not get to grow the buffer
+    if (client.buffer.size() > MAX_REQUEST_SIZE) {
+        send(socket, errorReply("Request too large"));
+        socket->disconnectFromServer();
+    }
+}
+
+void JobServer::dropClient(QLocalSocket *socket)
+{
+    clients.remove(socket);
+    socket->deleteLater();
+}
+
+void JobServer::handleRequest(QLocalSocket *socket, const QByteArray &line)
+{
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        send(socket, errorReply("Malformed request: expected one JSON object per line"));
+        return;
+    }
+
+    QJsonObject request = document.object();
+    QString command = request.value("cmd").toString();
+    QJsonObject reply;
+
+    if (command == "submit") {
+        reply = submitJob(request);
+    } else if (command == "list") {
+        QJsonArray list;
+        for (const Job &job : jobs) {
+            list.append(describeJob(job));
+        }
+        reply.insert("ok", true);
+        reply.insert("jobs", list);
+    } else if (command == "cancel") {
+        reply = cancelJob(request);
+    } else if (command == "pause") {
+        reply = pauseJob(request, true);
+    } else if (command == "resume") {
+        reply = pauseJob(request, false);
+    } else if (command == "throttle") {
+        reply = throttleJob(request);
+    } else if (command == "subscribe") {
+        reply = subscribe(socket, request);
+    } else {
+        reply = errorReply("Unknown command: " + command);
+    }
+
+    if (request.contains("id")) {
+        reply.insert("id", request.value("id"));
+    }
+    send(socket, reply);
+
+    // Jobs are started after the reply so the submitter learns its id
+    // before the first event for it
+    startQueuedJobs();
+}
+
+QJsonObject JobServer::submitJob(const QJsonObject &request)
+{
+    QString image = request.value("image").toString();
+    if (image.isEmpty()) {
+        return errorReply("submit requires an image path");
+    }
+
+    QFileInfo info(image);
+    if (!info.isFile()) {
+        return errorReply("Image not found: " + image);
+    }
+
+    Job job;
+    const QJsonArray algorithms = request.value("algorithms").toArray();
+    for (const QJsonValue &value : algorithms) {
+        QString algorithm = value.toString().toLower();
+        if (algorithm == "md5") {
+            job.md5 = true;
+        } else if (algorithm == "sha1") {
+            job.sha1 = true;
+        } else if (algorithm == "sha256") {
+            job.sha256 = true;
+        } else {
+            return errorReply("Unknown algorithm: " + value.toString());
+        }
+    }
+
+    // Same default as the command line
+    if (!job.md5 && !job.sha1 && !job.sha256) {
+        job.md5 = true;
+        job.sha1 = true;
+    }
+
+    job.rateLimit = qMax(0.0, request.value("rateLimit").toDouble(defaultRateLimit));
+    job.background = request.value("background").toBool(defaultBackground);
+
+    job.id = nextJobId++;
+    job.imagePath = info.absoluteFilePath();
+    job.submitted = QDateTime::currentDateTime();
+    jobs.insert(job.id, job);
+    pending.enqueue(job.id);
+
+    qDebug() << "JobServer: Job" << job.id << "submitted for" << job.imagePath;
+    emit jobSubmitted(job.id, job.imagePath);
+
+    QJsonObject reply;
+    reply.insert("ok", true);
+    reply.insert("job", job.id);
+    return reply;
+}
+
+QJsonObject JobServer::cancelJob(const QJsonObject &request)
+{
+    int jobId = request.value("job").toInt();
+    if (!jobs.contains(jobId)) {
+        return errorReply(QString("No such job: %1").arg(jobId));
+    }
+
+    Job &job = jobs[jobId];
+    if (job.state == JOB_QUEUED) {
+        pending.removeAll(jobId);
+        job.state = JOB_CANCELLED;
+        finishJob(job);
+    } else if (job.state == JOB_RUNNING) {
+        // The result event follows once the engine has stopped
+        job.cancelRequested = true;
+        Worker *worker = workerFor(jobId);
+        if (worker) {
+            worker->engine->cancel();
+        }
+    } else {
+        return errorReply(QString("Job %1 has already finished").arg(jobId));
+    }
+
+    QJsonObject reply;
+    reply.insert("ok", true);
+    return reply;
+}
+
+QJsonObject JobServer::pauseJob(const QJsonObject &request, bool pause)
+{
+    int jobId = request.value("job").toInt();
+    if (!jobs.contains(jobId)) {
+        return errorReply(QString("No such job: %1").arg(jobId));
+    }
+
+    // A queued job has nothing to hold; it would only block a worker
+    Job &job = jobs[jobId];
+    if (job.state != JOB_RUNNING) {
+        return errorReply(QString("Job %1 is not running").arg(jobId));
+    }
+
+    job.pauseRequested = pause;
+    Worker *worker = workerFor(jobId);
+    if (worker) {
+        if (pause) {
+            worker->engine->getControl().pause();
+        } else {
+            worker->engine->getControl().resume();
+        }
+    }
+
+    qDebug() << "JobServer: Job" << jobId << (pause ? "paused" : "resumed");
+
+    QJsonObject reply;
+    reply.insert("ok", true);
+    return reply;
+}
+
+QJsonObject JobServer::throttleJob(const QJsonObject &request)
+{
+    if (!request.value("rateLimit").isDouble()) {
+        return errorReply("throttle requires a rateLimit in MB/s (0 = unlimited)");
+    }
+    double rateLimit = qMax(0.0, request.value("rateLimit").toDouble());
+
+    if (!request.contains("job")) {
+        JobControl::setGlobalRateLimit(rateLimit);
+        qDebug() << "JobServer: Server-wide rate limit" << rateLimit << "MB/s";
+    } else {
+        int jobId = request.value("job").toInt();
+        if (!jobs.contains(jobId)) {
+            return errorReply(QString("No such job: %1").arg(jobId));
+        }
+
+        Job &job = jobs[jobId];
+        if (job.state != JOB_QUEUED && job.state != JOB_RUNNING) {
+            return errorReply(QString("Job %1 has already finished").arg(jobId));
+        }
+
+        job.rateLimit = rateLimit;
+        Worker *worker = workerFor(jobId);
+        if (worker) {
+            worker->engine->getControl().setRateLimit(rateLimit);
+        }
+    }
+
+    QJsonObject reply;
+    reply.insert("ok", true);
+    return reply;
+}
+
+QJsonObject JobServer::subscribe(QLocalSocket *socket, const QJsonObject &request)
+{
+    Client &client = clients[socket];
+
+    if (!request.contains("job")) {
+        client.allJobs = true;
+    } else {
+        int jobId = request.value("job").toInt();
+        if (!jobs.contains(jobId)) {
+            return errorReply(QString("No such job: %1").arg(jobId));
+        }
+        client.jobIds.insert(jobId);
+    }
+
+    QJsonObject reply;
+    reply.insert("ok", true);
+    return reply;
+}
+
+void JobServer::createWorkers()
+{
+    for (int i = workers.size(); i < workerCount; ++i) {
+        Worker *worker = new Worker();
+        worker->engine = new HashEngine(nullptr);
+        worker->engine->enableSparseMap(false);
+        worker->engine->enableMultiBufferHashing(multiBufferHashing);
+
+        // Results are collected per signal and reported once the thread has
+        // exited, so the engine is idle again when the job is marked done
+        HashEngine *engine = worker->engine;
+        connect(engine, &HashEngine::md5Calculated, this, [this, worker](const QString &hash) {
+            jobs[worker->jobId].calculated["MD5"] = hash;
+        });
+        connect(engine, &HashEngine::sha1Calculated, this, [this, worker](const QString &hash) {
+            jobs[worker->jobId].calculated["SHA1"] = hash;
+        });
+        connect(engine, &HashEngine::sha256Calculated, this, [this, worker](const QString &hash) {
+            jobs[worker->jobId].calculated["SHA256"] = hash;
+        });
+        connect(engine, &HashEngine::verificationComplete, this, [this, worker](const QMap<QString, bool> &results) {
+            jobs[worker->jobId].results = results;
+        });
+        connect(engine, &HashEngine::error, this, [this, worker](const QString &message) {
+            jobs[worker->jobId].failure = message;
+        });
+        connect(engine, &QThread::finished, this, [this, worker]() { onWorkerFinished(worker); });
+
+        workers.append(worker);
+    }
+}
+
+void JobServer::startQueuedJobs()
+{
+    for (Worker *worker : workers) {
+        // An image that fails to open leaves the worker free for the next
+        while (worker->jobId == 0 && !pending.isEmpty()) {
+            startJob(worker);
+        }
+    }
+
+    if (!progressTimer.isActive()) {
+        for (Worker *worker : workers) {
+            if (worker->jobId != 0) {
+                progressTimer.start(progressInterval);
+                break;
+            }
+        }
+    }
+}
+
+void JobServer::startJob(Worker *worker)
+{
+    Job &job = jobs[pending.dequeue()];
+
+    EWFHandler *handler = new EWFHandler();
+    if (!handler->open(job.imagePath)) {
+        job.failure = "Failed to open image: " + handler->getLastError();
+        job.state = JOB_FAILED;
+        delete handler;
+        finishJob(job);
+        return;
+    }
+
+    job.stored["MD5"] = handler->getStoredMD5();
+    job.stored["SHA1"] = handler->getStoredSHA1();
+    job.state = JOB_RUNNING;
+
+    worker->jobId = job.id;
+    worker->ewfHandler = handler;
+
+    // Every setting is rewritten: the engine still holds the last job's.
+    // Its control is cleared here, before start(), so a cancel or pause
+    // sent while the thread is starting up is not lost
+    HashEngine *engine = worker->engine;
+    engine->getControl().reset();
+    engine->setEWFHandler(handler);
+    engine->enableMD5(job.md5);
+    engine->enableSHA1(job.sha1);
+    engine->enableSHA256(job.sha256);
+    engine->setExpectedMD5(job.stored.value("MD5"));
+    engine->setExpectedSHA1(job.stored.value("SHA1"));
+    engine->setExpectedSHA256(QString());
+    engine->getControl().setRateLimit(job.rateLimit);
+    engine->getControl().setPriority(job.background ? JobControl::PRIORITY_BACKGROUND
+                                                    : JobControl::PRIORITY_NORMAL);
+
+    // Calibration probes the image and times the kernels; one run per
+    // directory and algorithm set is enough for this worker
+    QString tuningKey = tuningKeyFor(job);
+    if (worker->tuning.contains(tuningKey)) {
+        engine->setPipelineConfig(worker->tuning.value(tuningKey));
+        worker->tuningKey.clear();
+    } else {
+        engine->enableAutoTune(true);
+        worker->tuningKey = tuningKey;
+    }
+
+    qDebug() << "JobServer: Job" << job.id << "started";
+    emit jobStarted(job.id, job.imagePath);
+
+    QJsonObject event;
+    event.insert("event", "started");
+    event.insert("job", job.id);
+    event.insert("image", job.imagePath);
+    publish(job.id, event);
+
+    engine->start();
+}
+
+void JobServer::onWorkerFinished(Worker *worker)
+{
+    Job &job = jobs[worker->jobId];
+
+    // The engine reports a cancel only through its telemetry
+    int finalState = worker->engine->getTelemetry().snapshot().state;
+    if (!job.failure.isEmpty() || finalState == JobTelemetry::STATE_FAILED) {
+        if (job.failure.isEmpty()) {
+            job.failure = "Hash calculation failed";
+        }
+        job.state = JOB_FAILED;
+    } else if (finalState == JobTelemetry::STATE_CANCELLED) {
+        job.state = JOB_CANCELLED;
+    } else {
+        // Only hashes with a stored value were verified; the engine counts
+        // the others as passed
+        bool compared = false;
+        job.state = JOB_VERIFIED;
+        for (auto it = job.results.constBegin(); it != job.results.constEnd(); ++it) {
+            if (job.stored.value(it.key()).isEmpty()) {
+                continue;
+            }
+            compared = true;
+            if (!it.value()) {
+                job.state = JOB_MISMATCH;
+            }
+        }
+        if (!compared) {
+            job.state = JOB_COMPUTED;
+        }
+    }
+
+    // Keep a calibration from a run that got through it
+    if (!worker->tuningKey.isEmpty()) {
+        PipelineConfig config = worker->engine->getPipelineConfig();
+        if (!config.reasons.isEmpty()) {
+            worker->tuning.insert(worker->tuningKey, config);
+        }
+        worker->tuningKey.clear();
+    }
+
+    worker->engine->setEWFHandler(nullptr);
+    delete worker->ewfHandler;
+    worker->ewfHandler = nullptr;
+    worker->jobId = 0;
+
+    finishJob(job);
+    startQueuedJobs();
+
+    bool busy = false;
+    for (Worker *other : workers) {
+        if (other->jobId != 0) {
+            busy = true;
+        }
+    }
+    if (!busy) {
+        progressTimer.stop();
+    }
+}
+
+void JobServer::finishJob(Job &job)
+{
+    qDebug() << "JobServer: Job" << job.id << stateName(job.state);
+    emit jobFinished(job.id, job.imagePath, stateName(job.state));
+
+    QJsonObject event = describeJob(job);
+    event.insert("event", "result");
+    publish(job.id, event);
+
+    pruneFinishedJobs();
+}
+
+void JobServer::pruneFinishedJobs()
+{
+    int finished = 0;
+    for (const Job &job : jobs) {
+        if (job.state != JOB_QUEUED && job.state != JOB_RUNNING) {
+            finished++;
+        }
+    }
+
+    // Oldest first (job ids only grow)
+    auto it = jobs.begin();
+    while (finished > MAX_FINISHED_JOBS && it != jobs.end()) {
+        if (it.value().state != JOB_QUEUED && it.value().state != JOB_RUNNING) {
+            for (Client &client : clients) {
+                client.jobIds.remove(it.key());
+            }
+            it = jobs.erase(it);
+            finished--;
+        } else {
+            ++it;
+        }
+    }
+}
+
+JobServer::Worker *JobServer::workerFor(int jobId) const
+{
+    for (Worker *worker : workers) {
+        if (worker->jobId == jobId) {
+            return worker;
+        }
+    }
+    return nullptr;
+}
+
+void JobServer::send(QLocalSocket *socket, const QJsonObject &message)
+{
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    socket->write("\n");
+}
+
+void JobServer::publish(int jobId, const QJsonObject &event)
+{
+    for (auto it = clients.begin(); it != clients.end(); ++it) {
+        if (it.value().allJobs || it.value().jobIds.contains(jobId)) {
+            send(it.key(), event);
+        }
+    }
+}
+
+QJsonObject JobServer::describeJob(const Job &job) const
+{
+    QJsonObject description;
+    description.insert("job", job.id);
+    description.insert("image", job.imagePath);
+    description.insert("state", stateName(job.state));
+    description.insert("submitted", job.submitted.toString(Qt::ISODate));
+
+    QJsonArray algorithms;
+    if (job.md5) {
+        algorithms.append("md5");
+    }
+    if (job.sha1) {
+        algorithms.append("sha1");
+    }
+    if (job.sha256) {
+        algorithms.append("sha256");
+    }
+    description.insert("algorithms", algorithms);
+    description.insert("rateLimit", job.rateLimit);
+    description.insert("background", job.background);
+    if (job.state == JOB_RUNNING) {
+        description.insert("paused", job.pauseRequested);
+    }
+
+    if (!job.calculated.isEmpty()) {
+        QJsonObject hashes;
+        for (auto it = job.calculated.constBegin(); it != job.calculated.constEnd(); ++it) {
+            QJsonObject hash;
+            hash.insert("calculated", it.value());
+            hash.insert("stored", job.stored.value(it.key()));
+            if (job.stored.value(it.key()).isEmpty()) {
+                hash.insert("result", "no stored hash");
+            } else {
+                hash.insert("verified", job.results.value(it.key()));
+                hash.insert("result", job.results.value(it.key()) ? "verified" : "mismatch");
+            }
+            hashes.insert(it.key(), hash);
+        }
+        description.insert("hashes", hashes);
+    }
+
+    if (!job.failure.isEmpty()) {
+        description.insert("error", job.failure);
+    }
+
+    return description;
+}
+
+QString JobServer::stateName(JobState state)
+{
+    switch (state) {
+    case JOB_QUEUED:    return "queued";
+    case JOB_RUNNING:   return "running";
+    case JOB_VERIFIED:  return "verified";
+    case JOB_COMPUTED:  return "computed";
+    case JOB_MISMATCH:  return "mismatch";
+    case JOB_FAILED:    return "failed";
+    case JOB_CANCELLED: return "cancelled";
+    }
+    return "unknown";
+}
+
+QString JobServer::tuningKeyFor(const Job &job)
+{
+    // Images in one directory normally share storage (and often imager
+    // settings), which is what the calibration measures
+    return QString("%1|%2%3%4").arg(QFileInfo(job.imagePath).absolutePath())
+        .arg(job.md5 ? "md5" : "").arg(job.sha1 ? "sha1" : "").arg(job.sha256 ? "sha256" : "");
+}
+
+QJsonObject JobServer::errorReply(const QString &message)
+{
+    QJsonObject reply;
+    reply.insert("ok", false);
+    reply.insert("error", message);
+    return reply;
+}
@@ -0,0 +1,187 @@
+/*
+ * E01 Hash Verification Tool
+ * JobServer - Local socket job-submission service
+ */
+
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QSet>
+#include <QList>
+#include <QQueue>
+#include <QDateTime>
+#include <QTimer>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include "ewfhandler.h"
+#include "hashengine.h"
+
+// Accepts verification jobs over a local socket (a Unix domain socket on
+// Linux, a named pipe on Windows). Requests and replies are one JSON object
+// per line:
+//
+//   {"cmd":"submit","image":"/cases/disk.E01","algorithms":["md5","sha1"]}
+//       -> {"ok":true,"job":7}
+//   {"cmd":"list"}                  -> {"ok":true,"jobs":[{...}, ...]}
+//   {"cmd":"cancel","job":7}        -> {"ok":true}
+//   {"cmd":"pause","job":7}         -> {"ok":true}  (and "resume"; running jobs)
+//   {"cmd":"throttle","job":7,"rateLimit":40}
+//                                   -> {"ok":true}  (MB/s, 0 = unlimited; omit
+//                                                    "job" for the server-wide limit)
+//   {"cmd":"subscribe","job":7}     -> {"ok":true}  (omit "job" for all jobs)
+//
+// submit also takes "rateLimit" (MB/s) and "background" (idle I/O class,
+// lowest CPU priority); both default to the server's settings. A paused
+// job keeps its worker, handles and hash state, and resumes where it was.
+//
+// A request's "id" member, if present, is echoed in its reply. Subscribed
+// clients also receive {"event":"started"|"progress"|"result",...} lines;
+// progress is sampled from each running engine's telemetry on a timer, so
+// a slow client never holds up a read loop.
+//
+// The hash engines are created once, when the server starts, and reused:
+// a job only opens its image and hands the handler to an idle engine.
+// Each worker calibrates its pipeline once per image directory and
+// algorithm set and reuses the result for later jobs there. Jobs beyond
+// the worker count wait in a FIFO queue.
+//
+// A job whose image has no stored hash for any of its algorithms ends
+// "computed", not "verified": there was nothing to verify against.
+class JobServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobServer(QObject *parent = nullptr);
+    ~JobServer();
+
+    // Number of jobs hashed at once (before listen())
+    void setWorkerCount(int count);
+
+    // Defaults for jobs that do not set their own
+    void setDefaultRateLimit(double megabytesPerSecond);
+    void setDefaultBackground(bool background);
+
+    // How often subscribers get progress events (default 500 ms)
+    void setProgressInterval(int milliseconds);
+
+    // Hash the SHA-1 / SHA-256 of concurrent jobs together in the shared
+    // multi-buffer lanes (before listen())
+    void setMultiBufferHashing(bool enable);
+
+    bool listen(const QString &name);
+    QString serverName() const;
+
+signals:
+    void jobSubmitted(int jobId, const QString &imagePath);
+    void jobStarted(int jobId, const QString &imagePath);
+    void jobFinished(int jobId, const QString &imagePath, const QString &state);
+    void error(const QString &errorMessage);
+
+private slots:
+    void onNewConnection();
+    void onProgressTimer();
+
+private:
+    enum JobState {
+        JOB_QUEUED,
+        JOB_RUNNING,
+        JOB_VERIFIED,
+        JOB_COMPUTED,       // Finished, but no stored hash to compare with
+        JOB_MISMATCH,
+        JOB_FAILED,
+        JOB_CANCELLED
+    };
+
+    struct Job {
+        int id = 0;
+        QString imagePath;
+        bool md5 = false;
+        bool sha1 = false;
+        bool sha256 = false;
+        JobState state = JOB_QUEUED;
+        QDateTime submitted;
+        QMap<QString, QString> calculated;
+        QMap<QString, QString> stored;
+        QMap<QString, bool> results;
+        QString failure;
+        bool cancelRequested = false;
+        bool pauseRequested = false;
+        double rateLimit = 0.0;      // MB/s, 0 = unlimited
+        bool background = false;
+    };
+
+    // One pooled engine; jobId is 0 while idle. Calibrations are kept
+    // per image directory and algorithm set; tuningKey is set while a job
+    // is calibrating
+    struct Worker {
+        HashEngine *engine = nullptr;
+        EWFHandler *ewfHandler = nullptr;
+        int jobId = 0;
+        QMap<QString, PipelineConfig> tuning;
+        QString tuningKey;
+    };
+
+    // Per-connection state
+    struct Client {
+        QByteArray buffer;
+        bool allJobs = false;
+        QSet<int> jobIds;
+    };
+
+    // Requests
+    void readClient(QLocalSocket *socket);
+    void dropClient(QLocalSocket *socket);
+    void handleRequest(QLocalSocket *socket, const QByteArray &line);
+    QJsonObject submitJob(const QJsonObject &request);
+    QJsonObject cancelJob(const QJsonObject &request);
+    QJsonObject pauseJob(const QJsonObject &request, bool pause);
+    QJsonObject throttleJob(const QJsonObject &request);
+    QJsonObject subscribe(QLocalSocket *socket, const QJsonObject &request);
+
+    // Scheduling
+    void createWorkers();
+    void startQueuedJobs();
+    void startJob(Worker *worker);
+    void onWorkerFinished(Worker *worker);
+    void finishJob(Job &job);
+    void pruneFinishedJobs();
+    Worker *workerFor(int jobId) const;
+
+    // Output
+    void send(QLocalSocket *socket, const QJsonObject &message);
+    void publish(int jobId, const QJsonObject &event);
+    QJsonObject describeJob(const Job &job) const;
+    static QString stateName(JobState state);
+    static QString tuningKeyFor(const Job &job);
+    static QJsonObject errorReply(const QString &message);
+
+    QLocalServer server;
+    QTimer progressTimer;
+    int workerCount;
+    double defaultRateLimit;
+    bool defaultBackground;
+    int progressInterval;
+    bool multiBufferHashing;
+
+    QList<Worker*> workers;
+    QMap<QLocalSocket*, Client> clients;
+    QMap<int, Job> jobs;
+    QQueue<int> pending;
+    int nextJobId;
+
+    // Constants
+    static const int DEFAULT_WORKER_COUNT = 2;
+    static const int PROGRESS_INTERVAL_MS = 500;
+    static const int MAX_FINISHED_JOBS = 256;
+    static const int MAX_REQUEST_SIZE = 64 * 1024;
+    static const int STALE_SOCKET_PROBE_MS = 1000;    // A live server accepts well within this
+};
+
+#endif // JOBSERVER_H
@@ -0,0 +1,110 @@
+/*
+ * E01 Hash Verification Tool
+ * JobTelemetry Implementation
+ */
+
+#include "jobtelemetry.h"
+
+int TelemetrySnapshot::percentage() const
+{
+    if (totalBytes <= 0) {
+        return 0;
+    }
+    return static_cast<int>(qMin<qint64>(100, (bytesProcessed * 100) / totalBytes));
+}
+
+double TelemetrySnapshot::bytesPerSecond() const
+{
+    if (elapsedMs <= 0) {
+        return 0.0;
+    }
+    return (static_cast<double>(bytesProcessed) * 1000.0) / elapsedMs;
+}
+
+qint64 TelemetrySnapshot::remainingMs() const
+{
+    // The whole-run average rate is steady enough to extrapolate from
+    // without further smoothing
+    if (totalBytes <= 0 || bytesProcessed <= 0 || bytesProcessed >= totalBytes) {
+        return -1;
+    }
+    return static_cast<qint64>((static_cast<double>(totalBytes - bytesProcessed) * elapsedMs) / bytesProcessed);
+}
+
+JobTelemetry::JobTelemetry()
+    : state(STATE_IDLE)
+    , startMs(0)
+    , endMs(0)
+    , bytesProcessed(0)
+    , totalBytes(0)
+{
+    // Started once here so readers never see the timer itself change
+    clock.start();
+}
+
+void JobTelemetry::begin(qint64 totalBytes)
+{
+    bytesProcessed.storeRelaxed(0);
+    this->totalBytes.storeRelaxed(totalBytes);
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        counters[i].storeRelaxed(0);
+    }
+    endMs.storeRelaxed(0);
+    startMs.storeRelaxed(clock.elapsed());
+    state.storeRelease(STATE_RUNNING);
+}
+
+void JobTelemetry::setTotalBytes(qint64 totalBytes)
+{
+    this->totalBytes.storeRelaxed(totalBytes);
+}
+
+void JobTelemetry::setBytesProcessed(qint64 bytesProcessed)
+{
+    this->bytesProcessed.storeRelaxed(bytesProcessed);
+}
+
+void JobTelemetry::addToCounter(Counter counter, qint64 amount)
+{
+    counters[counter].fetchAndAddRelaxed(amount);
+}
+
+void JobTelemetry::end(State finalState)
+{
+    endMs.storeRelaxed(clock.elapsed());
+    state.storeRelease(finalState);
+}
+
+TelemetrySnapshot JobTelemetry::snapshot() const
+{
+    TelemetrySnapshot snapshot;
+    snapshot.state = state.loadAcquire();
+    snapshot.bytesProcessed = bytesProcessed.loadRelaxed();
+    snapshot.totalBytes = totalBytes.loadRelaxed();
+    snapshot.stageBacklog = qMax<qint64>(0, counters[COUNTER_STAGE_SUBMITTED].loadRelaxed() -
+                                            counters[COUNTER_STAGE_PROCESSED].loadRelaxed());
+    snapshot.segmentBytes = counters[COUNTER_SEGMENT_BYTES].loadRelaxed();
+
+    if (snapshot.state != STATE_IDLE) {
+        qint64 stop = (snapshot.state == STATE_RUNNING) ? clock.elapsed() : endMs.loadRelaxed();
+        snapshot.elapsedMs = qMax<qint64>(0, stop - startMs.loadRelaxed());
+    }
+
+    return snapshot;
+}
+
+QString JobTelemetry::formatDuration(qint64 ms)
+{
+    qint64 totalSeconds = qMax<qint64>(0, ms / 1000);
+    qint64 hours = totalSeconds / 3600;
+    qint64 minutes = (totalSeconds / 60) % 60;
+    qint64 seconds = totalSeconds % 60;
+
+    if (hours > 0) {
+        return QString("%1h %2m").arg(hours).arg(minutes, 2, 10, QChar('0'));
+    }
+    if (minutes > 0) {
+        return QString("%1m %2s").arg(minutes).arg(seconds);
+    }
+    return QString("%1s").arg(seconds);
+}
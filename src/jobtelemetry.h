@@ -0,0 +1,76 @@
+/*
+ * E01 Hash Verification Tool
+ * JobTelemetry - Lock-free progress slots published by a running job
+ */
+
+#ifndef JOBTELEMETRY_H
+#define JOBTELEMETRY_H
+
+#include <QString>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+
+// Point-in-time copy of a job's telemetry. Fields are read one at a time,
+// so they are each current but not a single consistent cut.
+struct TelemetrySnapshot
+{
+    int state = 0;                 // JobTelemetry::State
+    qint64 bytesProcessed = 0;
+    qint64 totalBytes = 0;         // 0 while the length is unknown (streams)
+    qint64 elapsedMs = 0;
+    qint64 stageBacklog = 0;       // Blocks queued but not yet analyzed by stages
+    qint64 segmentBytes = 0;       // Bytes read by the segment-file hasher
+
+    int percentage() const;
+    double bytesPerSecond() const;
+    qint64 remainingMs() const;    // -1 until an estimate is possible
+};
+
+// A job's worker thread publishes its progress here with plain atomic
+// stores; the GUI and CLI read it on their own timer. Publishing costs a
+// few relaxed stores per block, never a signal, allocation or string
+// format, so refresh cost does not grow with the number of running jobs.
+class JobTelemetry
+{
+public:
+    enum State {
+        STATE_IDLE,
+        STATE_RUNNING,
+        STATE_FINISHED,
+        STATE_FAILED,
+        STATE_CANCELLED
+    };
+
+    enum Counter {
+        COUNTER_STAGE_SUBMITTED,   // Blocks handed to analysis stages
+        COUNTER_STAGE_PROCESSED,   // Blocks the stages have finished with
+        COUNTER_SEGMENT_BYTES,     // Bytes read by the segment-file hasher
+        COUNTER_COUNT
+    };
+
+    JobTelemetry();
+
+    // Writer side (the job's threads)
+    void begin(qint64 totalBytes);
+    void setTotalBytes(qint64 totalBytes);
+    void setBytesProcessed(qint64 bytesProcessed);
+    void addToCounter(Counter counter, qint64 amount);
+    void end(State finalState);
+
+    // Reader side (any thread, any number of readers)
+    TelemetrySnapshot snapshot() const;
+
+    // "1h 02m", "4m 10s", "12s"
+    static QString formatDuration(qint64 ms);
+
+private:
+    QElapsedTimer clock;
+    QAtomicInteger<int> state;
+    QAtomicInteger<qint64> startMs;
+    QAtomicInteger<qint64> endMs;
+    QAtomicInteger<qint64> bytesProcessed;
+    QAtomicInteger<qint64> totalBytes;
+    QAtomicInteger<qint64> counters[COUNTER_COUNT];
+};
+
+#endif // JOBTELEMETRY_H
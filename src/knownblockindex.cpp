@@ -0,0 +1,482 @@
+/*
+ * E01 Hash Verification Tool
+ * KnownBlockIndex Implementation
+ */
+
+#include "knownblockindex.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define KNOWNBLOCK_PREFETCH(address) __builtin_prefetch(address)
+#else
+    #define KNOWNBLOCK_PREFETCH(address) ((void)0)
+#endif
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'E', '0', '1', 'K', 'B', 'I', 'D', 'X'};
+
+// Lookups are processed in groups small enough to keep on the stack
+const int LOOKUP_GROUP = 64;
+
+struct BuildEntry {
+    KnownBlockIndex::Digest digest;
+    quint8 status;
+};
+
+bool digestLess(const KnownBlockIndex::Digest &a, const KnownBlockIndex::Digest &b)
+{
+    return memcmp(a.bytes, b.bytes, sizeof(a.bytes)) < 0;
+}
+
+bool parseHexDigest(const QByteArray &hex, KnownBlockIndex::Digest &digest)
+{
+    if (hex.size() != 32) {
+        return false;
+    }
+
+    for (int i = 0; i < 32; ++i) {
+        char c = hex.at(i);
+        bool isHex = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+        if (!isHex) {
+            return false;
+        }
+    }
+
+    QByteArray raw = QByteArray::fromHex(hex);
+    memcpy(digest.bytes, raw.constData(), sizeof(digest.bytes));
+    return true;
+}
+
+} // namespace
+
+KnownBlockIndex::KnownBlockIndex()
+    : mapped(nullptr)
+    , blockSize(0)
+    , entryCount(0)
+    , bloomMask(0)
+    , bloomHashes(0)
+    , bloom(nullptr)
+    , buckets(nullptr)
+    , digests(nullptr)
+    , statuses(nullptr)
+{
+}
+
+KnownBlockIndex::~KnownBlockIndex()
+{
+    close();
+}
+
+bool KnownBlockIndex::open(const QString &indexPath)
+{
+    close();
+
+    file.setFileName(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        lastError = QString("Failed to open block index: %1").arg(file.errorString());
+        return false;
+    }
+
+    qint64 fileSize = file.size();
+    if (fileSize < static_cast<qint64>(sizeof(Header))) {
+        lastError = "Block index is truncated";
+        file.close();
+        return false;
+    }
+
+    // The whole index is mapped; the OS pages in only what lookups touch
+    mapped = file.map(0, fileSize);
+    if (!mapped) {
+        lastError = QString("Failed to map block index: %1").arg(file.errorString());
+        file.close();
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, mapped, sizeof(header));
+
+    if (memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        header.version != INDEX_VERSION) {
+        lastError = "Not a block index file (or unsupported version)";
+        close();
+        return false;
+    }
+
+    // Bound the counts by the file size first so the size sum cannot wrap
+    bool powerOfTwo = header.bloomLines > 0 && (header.bloomLines & (header.bloomLines - 1)) == 0;
+    bool countsFit = header.bloomLines <= static_cast<quint64>(fileSize) / (BLOOM_LINE_WORDS * sizeof(quint64)) &&
+                     header.entryCount <= static_cast<quint64>(fileSize) / (sizeof(Digest) + 1);
+    if (!powerOfTwo || !countsFit || header.bloomHashes == 0 || header.bloomHashes > BLOOM_HASHES) {
+        lastError = "Block index is corrupt";
+        close();
+        return false;
+    }
+
+    qint64 expectedSize = static_cast<qint64>(sizeof(Header))
+                        + static_cast<qint64>(header.bloomLines) * BLOOM_LINE_WORDS * sizeof(quint64)
+                        + static_cast<qint64>(BUCKET_COUNT + 1) * sizeof(quint64)
+                        + static_cast<qint64>(header.entryCount) * (sizeof(Digest) + 1);
+
+    if (fileSize != expectedSize) {
+        lastError = "Block index is truncated or corrupt";
+        close();
+        return false;
+    }
+
+    blockSize = header.blockSize;
+    entryCount = static_cast<qint64>(header.entryCount);
+    bloomMask = header.bloomLines - 1;
+    bloomHashes = header.bloomHashes;
+
+    const uchar *section = mapped + sizeof(Header);
+    bloom = reinterpret_cast<const quint64*>(section);
+    section += header.bloomLines * BLOOM_LINE_WORDS * sizeof(quint64);
+    buckets = reinterpret_cast<const quint64*>(section);
+    section += (BUCKET_COUNT + 1) * sizeof(quint64);
+    digests = reinterpret_cast<const Digest*>(section);
+    section += entryCount * sizeof(Digest);
+    statuses = section;
+
+    // searchBucket() trusts the bucket table to stay inside the digests:
+    // it must start at 0, never decrease and end at the entry count
+    if (buckets[0] != 0 || buckets[BUCKET_COUNT] != header.entryCount) {
+        lastError = "Block index bucket table is corrupt";
+        close();
+        return false;
+    }
+    for (quint32 b = 0; b < BUCKET_COUNT; ++b) {
+        if (buckets[b] > buckets[b + 1]) {
+            lastError = "Block index bucket table is corrupt";
+            close();
+            return false;
+        }
+    }
+
+    qDebug() << "KnownBlockIndex: Opened" << indexPath << "with" << entryCount
+             << "hashes of" << blockSize << "byte blocks";
+    return true;
+}
+
+void KnownBlockIndex::close()
+{
+    if (mapped) {
+        file.unmap(const_cast<uchar*>(mapped));
+        mapped = nullptr;
+    }
+
+    if (file.isOpen()) {
+        file.close();
+    }
+
+    blockSize = 0;
+    entryCount = 0;
+    bloomMask = 0;
+    bloomHashes = 0;
+    bloom = nullptr;
+    buckets = nullptr;
+    digests = nullptr;
+    statuses = nullptr;
+}
+
+bool KnownBlockIndex::isOpen() const
+{
+    return mapped != nullptr;
+}
+
+quint32 KnownBlockIndex::getBlockSize() const
+{
+    return blockSize;
+}
+
+qint64 KnownBlockIndex::getEntryCount() const
+{
+    return entryCount;
+}
+
+KnownBlockIndex::Status KnownBlockIndex::lookup(const Digest &digest) const
+{
+    if (!isOpen() || !bloomContains(bloomLine(digest), digest)) {
+        return Unknown;
+    }
+
+    return searchBucket(digest);
+}
+
+void KnownBlockIndex::lookupBatch(const Digest *batch, int count, quint8 *results) const
+{
+    if (!isOpen()) {
+        memset(results, Unknown, count);
+        return;
+    }
+
+    const quint64 *lines[LOOKUP_GROUP];
+    int candidates[LOOKUP_GROUP];
+
+    for (int start = 0; start < count; start += LOOKUP_GROUP) {
+        int groupSize = qMin(LOOKUP_GROUP, count - start);
+
+        // Phase 1: issue every bloom line fetch before testing any of them
+        for (int i = 0; i < groupSize; ++i) {
+            lines[i] = bloomLine(batch[start + i]);
+            KNOWNBLOCK_PREFETCH(lines[i]);
+        }
+
+        // Phase 2: filter, and prefetch bucket bounds for the survivors
+        int candidateCount = 0;
+        for (int i = 0; i < groupSize; ++i) {
+            if (bloomContains(lines[i], batch[start + i])) {
+                candidates[candidateCount++] = i;
+                KNOWNBLOCK_PREFETCH(&buckets[bucketOf(batch[start + i])]);
+            } else {
+                results[start + i] = Unknown;
+            }
+        }
+
+        // Phase 3: search the (few) entries in each candidate's bucket
+        for (int c = 0; c < candidateCount; ++c) {
+            int i = candidates[c];
+            results[start + i] = searchBucket(batch[start + i]);
+        }
+    }
+}
+
+bool KnownBlockIndex::build(const QString &listPath, const QString &indexPath,
+                            quint32 blockSize, QString *errorMessage)
+{
+    auto fail = [errorMessage](const QString &message) {
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        qDebug() << "KnownBlockIndex Error:" << message;
+        return false;
+    };
+
+    QFile listFile(listPath);
+    if (!listFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return fail(QString("Failed to open hash list: %1").arg(listFile.errorString()));
+    }
+
+    // Read the hash list; NSRL-scale sets pass 2^31 bytes, past what Qt 5
+    // containers can hold, so the build uses 64-bit sizes throughout
+    std::vector<BuildEntry> entries;
+    qint64 lineNumber = 0;
+    qint64 skipped = 0;
+
+    while (!listFile.atEnd()) {
+        QByteArray line = listFile.readLine();
+        ++lineNumber;
+
+        int comment = line.indexOf('#');
+        if (comment >= 0) {
+            line.truncate(comment);
+        }
+        line = line.simplified().replace(',', ' ');
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QList<QByteArray> fields = line.split(' ');
+        BuildEntry entry;
+        if (!parseHexDigest(fields.first(), entry.digest)) {
+            ++skipped;
+            continue;
+        }
+
+        entry.status = KnownGood;
+        if (fields.size() > 1) {
+            QByteArray label = fields.at(1).toLower();
+            if (label == "bad" || label == "known-bad") {
+                entry.status = KnownBad;
+            }
+        }
+
+        entries.push_back(entry);
+    }
+
+    if (entries.empty()) {
+        return fail("Hash list contains no valid MD5 hashes");
+    }
+
+    // Sort and merge duplicates; a hash listed as bad anywhere stays bad
+    std::sort(entries.begin(), entries.end(), [](const BuildEntry &a, const BuildEntry &b) {
+        return digestLess(a.digest, b.digest);
+    });
+
+    size_t unique = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (unique > 0 && memcmp(entries[unique - 1].digest.bytes, entries[i].digest.bytes,
+                                 sizeof(Digest)) == 0) {
+            entries[unique - 1].status = qMax(entries[unique - 1].status, entries[i].status);
+        } else {
+            entries[unique++] = entries[i];
+        }
+    }
+    entries.resize(unique);
+
+    // Size the bloom filter to a power-of-two number of cache lines
+    quint64 wantedLines = (static_cast<quint64>(unique) * BLOOM_BITS_PER_ENTRY + 511) / 512;
+    quint64 bloomLines = 1;
+    while (bloomLines < wantedLines) {
+        bloomLines <<= 1;
+    }
+
+    std::vector<quint64> bloomWords(static_cast<size_t>(bloomLines) * BLOOM_LINE_WORDS, 0);
+    std::vector<quint64> bucketStarts(BUCKET_COUNT + 1, 0);
+
+    for (size_t i = 0; i < unique; ++i) {
+        const Digest &digest = entries[i].digest;
+
+        quint64 first, second;
+        digestHalves(digest, first, second);
+        quint64 *line = bloomWords.data() + (second & (bloomLines - 1)) * BLOOM_LINE_WORDS;
+        for (quint32 k = 0; k < BLOOM_HASHES; ++k) {
+            quint32 bit = (first >> (9 * k)) & 511;
+            line[bit >> 6] |= Q_UINT64_C(1) << (bit & 63);
+        }
+
+        ++bucketStarts[bucketOf(digest) + 1];
+    }
+
+    // Convert per-bucket counts into start offsets
+    for (quint32 b = 1; b <= BUCKET_COUNT; ++b) {
+        bucketStarts[b] += bucketStarts[b - 1];
+    }
+
+    // Write the index
+    QFile indexFile(indexPath);
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail(QString("Failed to create block index: %1").arg(indexFile.errorString()));
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.blockSize = blockSize;
+    header.entryCount = static_cast<quint64>(unique);
+    header.bloomLines = bloomLines;
+    header.bloomHashes = BLOOM_HASHES;
+
+    // Large sections go out in bounded pieces rather than one write
+    auto writeAll = [&indexFile](const char *data, qint64 size) {
+        for (qint64 pos = 0; pos < size; pos += WRITE_CHUNK_SIZE) {
+            qint64 length = qMin(WRITE_CHUNK_SIZE, size - pos);
+            if (indexFile.write(data + pos, length) != length) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Digests and statuses are gathered from the entries one piece at a time
+    auto writeEntries = [&](bool digestsSection) {
+        const size_t entrySize = digestsSection ? sizeof(Digest) : 1;
+        const size_t perPiece = static_cast<size_t>(WRITE_CHUNK_SIZE) / entrySize;
+        QByteArray piece(static_cast<int>(perPiece * entrySize), Qt::Uninitialized);
+        for (size_t start = 0; start < unique; start += perPiece) {
+            size_t count = qMin(perPiece, unique - start);
+            for (size_t i = 0; i < count; ++i) {
+                if (digestsSection) {
+                    memcpy(piece.data() + i * sizeof(Digest), entries[start + i].digest.bytes, sizeof(Digest));
+                } else {
+                    piece[static_cast<int>(i)] = static_cast<char>(entries[start + i].status);
+                }
+            }
+            qint64 length = static_cast<qint64>(count * entrySize);
+            if (indexFile.write(piece.constData(), length) != length) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool written =
+        indexFile.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header) &&
+        writeAll(reinterpret_cast<const char*>(bloomWords.data()),
+                 static_cast<qint64>(bloomWords.size() * sizeof(quint64))) &&
+        writeAll(reinterpret_cast<const char*>(bucketStarts.data()),
+                 static_cast<qint64>(bucketStarts.size() * sizeof(quint64))) &&
+        writeEntries(true) &&
+        writeEntries(false);
+
+    indexFile.close();
+
+    if (!written) {
+        indexFile.remove();
+        return fail(QString("Failed to write block index: %1").arg(indexFile.errorString()));
+    }
+
+    qDebug() << "KnownBlockIndex: Built" << indexPath << "with" << static_cast<qint64>(unique) << "hashes,"
+             << skipped << "invalid lines skipped of" << lineNumber;
+    return true;
+}
+
+QString KnownBlockIndex::statusName(quint8 status)
+{
+    switch (status) {
+    case KnownGood:
+        return "known-good";
+    case KnownBad:
+        return "known-bad";
+    default:
+        return "unknown";
+    }
+}
+
+QString KnownBlockIndex::getLastError() const
+{
+    return lastError;
+}
+
+// ===== Private Helper Functions =====
+
+const quint64 *KnownBlockIndex::bloomLine(const Digest &digest) const
+{
+    quint64 first, second;
+    digestHalves(digest, first, second);
+    return bloom + (second & bloomMask) * BLOOM_LINE_WORDS;
+}
+
+bool KnownBlockIndex::bloomContains(const quint64 *line, const Digest &digest) const
+{
+    quint64 first, second;
+    digestHalves(digest, first, second);
+
+    for (quint32 k = 0; k < bloomHashes; ++k) {
+        quint32 bit = (first >> (9 * k)) & 511;
+        if (!(line[bit >> 6] & (Q_UINT64_C(1) << (bit & 63)))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+KnownBlockIndex::Status KnownBlockIndex::searchBucket(const Digest &digest) const
+{
+    quint32 bucket = bucketOf(digest);
+    const Digest *first = digests + buckets[bucket];
+    const Digest *last = digests + buckets[bucket + 1];
+
+    const Digest *found = std::lower_bound(first, last, digest, digestLess);
+    if (found != last && memcmp(found->bytes, digest.bytes, sizeof(Digest)) == 0) {
+        return static_cast<Status>(statuses[found - digests]);
+    }
+
+    return Unknown;
+}
+
+quint32 KnownBlockIndex::bucketOf(const Digest &digest)
+{
+    return (static_cast<quint32>(digest.bytes[0]) << 8) | digest.bytes[1];
+}
+
+void KnownBlockIndex::digestHalves(const Digest &digest, quint64 &first, quint64 &second)
+{
+    memcpy(&first, digest.bytes, sizeof(first));
+    memcpy(&second, digest.bytes + sizeof(first), sizeof(second));
+}
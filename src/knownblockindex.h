@@ -0,0 +1,103 @@
+/*
+ * E01 Hash Verification Tool
+ * KnownBlockIndex - Memory-mapped database of known-good / known-bad block hashes
+ */
+
+#ifndef KNOWNBLOCKINDEX_H
+#define KNOWNBLOCKINDEX_H
+
+#include <QString>
+#include <QFile>
+
+// Index file layout (host byte order, every section 8-byte aligned):
+//
+//   Header        64 bytes (magic, version, block size, counts)
+//   Bloom filter  bloomLines x 64 bytes; all probes for one hash land in a
+//                 single cache line, so a miss costs one memory access
+//   Buckets       (BUCKET_COUNT + 1) x quint64; the first 16 bits of a
+//                 digest select a bucket, narrowing the search to a few
+//                 entries
+//   Digests       entryCount x 16 bytes, sorted
+//   Statuses      entryCount x 1 byte, parallel to the digests
+//
+// Block hashes are MD5, the digest used by the common block hash sets.
+class KnownBlockIndex
+{
+public:
+    enum Status : quint8 {
+        Unknown = 0,
+        KnownGood = 1,
+        KnownBad = 2
+    };
+
+    struct Digest {
+        quint8 bytes[16];
+    };
+
+    KnownBlockIndex();
+    ~KnownBlockIndex();
+
+    // Open / close an index file
+    bool open(const QString &indexPath);
+    void close();
+    bool isOpen() const;
+
+    // Index properties
+    quint32 getBlockSize() const;
+    qint64 getEntryCount() const;
+
+    // Lookups; a batch is probed in phases so memory accesses overlap
+    Status lookup(const Digest &digest) const;
+    void lookupBatch(const Digest *digests, int count, quint8 *results) const;
+
+    // Build an index from a text list: one hex MD5 per line, optionally
+    // followed by "good" or "bad" (default good); '#' starts a comment
+    static bool build(const QString &listPath, const QString &indexPath,
+                      quint32 blockSize, QString *errorMessage = nullptr);
+
+    static QString statusName(quint8 status);
+
+    // Error handling
+    QString getLastError() const;
+
+private:
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 blockSize;
+        quint64 entryCount;
+        quint64 bloomLines;
+        quint32 bloomHashes;
+        quint32 reserved[7];
+    };
+
+    const quint64 *bloomLine(const Digest &digest) const;
+    bool bloomContains(const quint64 *line, const Digest &digest) const;
+    Status searchBucket(const Digest &digest) const;
+
+    static quint32 bucketOf(const Digest &digest);
+    static void digestHalves(const Digest &digest, quint64 &first, quint64 &second);
+
+    QFile file;
+    const uchar *mapped;
+    quint32 blockSize;
+    qint64 entryCount;
+    quint64 bloomMask;
+    quint32 bloomHashes;
+    const quint64 *bloom;
+    const quint64 *buckets;
+    const Digest *digests;
+    const quint8 *statuses;
+    QString lastError;
+
+    // Constants
+    static const quint32 INDEX_VERSION = 1;
+    static const quint32 BUCKET_BITS = 16;
+    static const quint32 BUCKET_COUNT = 1u << BUCKET_BITS;
+    static const quint32 BLOOM_BITS_PER_ENTRY = 12;
+    static const quint32 BLOOM_HASHES = 7;
+    static const int BLOOM_LINE_WORDS = 8;  // 64-byte cache line
+    static const qint64 WRITE_CHUNK_SIZE = 4 * 1024 * 1024;
+};
+
+#endif // KNOWNBLOCKINDEX_H
@@ -0,0 +1,189 @@
+/*
+ * E01 Hash Verification Tool
+ * KnownBlockStage Implementation
+ */
+
+#include "knownblockstage.h"
+#include "sparsemap.h"
+#include <QDebug>
+
+#ifndef _WIN32
+    #include <openssl/md5.h>
+#endif
+
+KnownBlockStage::KnownBlockStage(const QString &indexPath, const QString &reportPath, QObject *parent)
+    : BlockStage(parent)
+    , indexPath(indexPath)
+    , reportPath(reportPath)
+    , blocksChecked(0)
+    , knownGood(0)
+    , knownBad(0)
+#ifdef _WIN32
+    , hCryptProv(0)
+#endif
+{
+}
+
+KnownBlockStage::~KnownBlockStage()
+{
+    if (isRunning()) {
+        abort();
+    }
+    releaseCrypto();
+}
+
+qint64 KnownBlockStage::getBlocksChecked() const
+{
+    return blocksChecked;
+}
+
+qint64 KnownBlockStage::getKnownGood() const
+{
+    return knownGood;
+}
+
+qint64 KnownBlockStage::getKnownBad() const
+{
+    return knownBad;
+}
+
+QString KnownBlockStage::getReportPath() const
+{
+    return reportPath;
+}
+
+bool KnownBlockStage::prepare()
+{
+    blocksChecked = 0;
+    knownGood = 0;
+    knownBad = 0;
+
+    if (!index.open(indexPath)) {
+        setError(index.getLastError());
+        return false;
+    }
+
+    quint32 blockSize = index.getBlockSize();
+    if (blockSize == 0) {
+        setError("Block index has no block size");
+        return false;
+    }
+
+#ifdef _WIN32
+    if (!CryptAcquireContext(&hCryptProv, NULL, NULL, PROV_RSA_AES, CRYPT_VERIFYCONTEXT)) {
+        setError("Failed to acquire CryptoAPI context");
+        return false;
+    }
+#endif
+
+    report.setFileName(reportPath);
+    if (!report.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        setError(QString("Failed to create hit report: %1").arg(report.errorString()));
+        return false;
+    }
+    report.write("offset,md5,status\n");
+
+    qDebug() << "KnownBlockStage: Checking" << blockSize << "byte blocks against" << indexPath;
+    return true;
+}
+
+void KnownBlockStage::processBlock(const char *data, qint64 size, qint64 offset)
+{
+    const qint64 blockSize = index.getBlockSize();
+
+    // Hash every whole block in the buffer first, then look them up as
+    // one batch. A trailing partial block at the end of the media is not
+    // comparable with full-block hashes and is left out.
+    digests.resize(0);
+    offsets.resize(0);
+
+    for (qint64 pos = 0; pos + blockSize <= size; pos += blockSize) {
+        if (SparseMap::isAllZero(data + pos, blockSize)) {
+            continue;
+        }
+
+        KnownBlockIndex::Digest digest;
+        if (!hashBlock(data + pos, blockSize, digest)) {
+            setError(QString("Failed to hash block at offset %1").arg(offset + pos));
+            return;
+        }
+
+        digests.append(digest);
+        offsets.append(offset + pos);
+    }
+
+    blocksChecked += digests.size();
+    if (digests.isEmpty()) {
+        return;
+    }
+
+    results.resize(digests.size());
+    index.lookupBatch(digests.constData(), digests.size(), results.data());
+
+    for (int i = 0; i < results.size(); ++i) {
+        if (results[i] == KnownBlockIndex::Unknown) {
+            continue;
+        }
+
+        if (results[i] == KnownBlockIndex::KnownBad) {
+            ++knownBad;
+        } else {
+            ++knownGood;
+        }
+
+        QByteArray hex = QByteArray(reinterpret_cast<const char*>(digests[i].bytes),
+                                    sizeof(digests[i].bytes)).toHex();
+        report.write(QString("%1,%2,%3\n")
+                     .arg(offsets[i])
+                     .arg(QString::fromLatin1(hex))
+                     .arg(KnownBlockIndex::statusName(results[i]))
+                     .toLatin1());
+    }
+}
+
+bool KnownBlockStage::complete()
+{
+    report.close();
+    index.close();
+    releaseCrypto();
+
+    if (report.error() != QFileDevice::NoError) {
+        setError(QString("Failed to write hit report: %1").arg(report.errorString()));
+        return false;
+    }
+
+    qDebug() << "KnownBlockStage: Checked" << blocksChecked << "blocks," << knownGood
+             << "known-good," << knownBad << "known-bad";
+    return true;
+}
+
+// ===== Private Helper Functions =====
+
+bool KnownBlockStage::hashBlock(const char *data, qint64 size, KnownBlockIndex::Digest &digest)
+{
+#ifdef _WIN32
+    HCRYPTHASH hHash = 0;
+    if (!CryptCreateHash(hCryptProv, CALG_MD5, 0, 0, &hHash)) {
+        return false;
+    }
+
+    DWORD hashSize = sizeof(digest.bytes);
+    bool ok = CryptHashData(hHash, reinterpret_cast<const BYTE*>(data), static_cast<DWORD>(size), 0) &&
+              CryptGetHashParam(hHash, HP_HASHVAL, digest.bytes, &hashSize, 0);
+    CryptDestroyHash(hHash);
+    return ok;
+#else
+    MD5(reinterpret_cast<const unsigned char*>(data), static_cast<size_t>(size), digest.bytes);
+    return true;
+#endif
+}
+
+void KnownBlockStage::releaseCrypto()
+{
+#ifdef _WIN32
+    if (hCryptProv) {
+        CryptReleaseContext(hCryptProv, 0);
+        hCryptProv = 0;
+    }
+#endif
+}
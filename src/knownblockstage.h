@@ -0,0 +1,64 @@
+/*
+ * E01 Hash Verification Tool
+ * KnownBlockStage - Per-block hash lookup against a KnownBlockIndex
+ */
+
+#ifndef KNOWNBLOCKSTAGE_H
+#define KNOWNBLOCKSTAGE_H
+
+#include "blockstage.h"
+#include "knownblockindex.h"
+#include <QFile>
+#include <QVector>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <wincrypt.h>
+#endif
+
+// Hashes every index-sized block of the media and writes a CSV line for
+// each block found in the index. All-zero blocks are skipped; they carry
+// no evidential value and would dominate the report.
+class KnownBlockStage : public BlockStage
+{
+    Q_OBJECT
+
+public:
+    KnownBlockStage(const QString &indexPath, const QString &reportPath, QObject *parent = nullptr);
+    ~KnownBlockStage();
+
+    // Results (valid after finish())
+    qint64 getBlocksChecked() const;
+    qint64 getKnownGood() const;
+    qint64 getKnownBad() const;
+    QString getReportPath() const;
+
+protected:
+    bool prepare() override;
+    void processBlock(const char *data, qint64 size, qint64 offset) override;
+    bool complete() override;
+
+private:
+    bool hashBlock(const char *data, qint64 size, KnownBlockIndex::Digest &digest);
+    void releaseCrypto();
+
+    QString indexPath;
+    QString reportPath;
+    KnownBlockIndex index;
+    QFile report;
+
+    // Per-buffer batch
+    QVector<KnownBlockIndex::Digest> digests;
+    QVector<qint64> offsets;
+    QVector<quint8> results;
+
+    qint64 blocksChecked;
+    qint64 knownGood;
+    qint64 knownBad;
+
+#ifdef _WIN32
+    HCRYPTPROV hCryptProv;
+#endif
+};
+
+#endif // KNOWNBLOCKSTAGE_H
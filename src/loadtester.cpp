@@ -0,0 +1,561 @@
+/*
+ * E01 Hash Verification Tool
+ * LoadTester Implementation
+ */
+
+#include "loadtester.h"
+#include "jobserver.h"
+#include "ewfwriter.h"
+#include "multibufferhasher.h"
+#include <QDebug>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QThread>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+LoadTester::LoadTester(QObject *parent)
+    : QObject(parent)
+    , levels({1, 8, 32})
+    , jobsPerLevel(0)
+    , submitRate(0.0)
+    , fixtureSize(DEFAULT_FIXTURE_SIZE)
+    , fixtureCount(DEFAULT_FIXTURE_COUNT)
+    , algorithms({"md5", "sha1"})
+    , multiBufferHashing(false)
+    , levelIndex(0)
+    , levelJobs(0)
+    , submitted(0)
+    , finished(0)
+    , server(nullptr)
+    , client(nullptr)
+    , cpuAtStart(0)
+    , peakRss(0)
+    , laneBlocksAtStart(0)
+    , laneStepsAtStart(0)
+{
+    connect(&submitTimer, &QTimer::timeout, this, &LoadTester::onSubmitTimer);
+    connect(&resourceTimer, &QTimer::timeout, this, &LoadTester::onResourceTimer);
+}
+
+LoadTester::~LoadTester()
+{
+    // The server's destructor stops any job still running
+    delete client;
+    delete server;
+}
+
+void LoadTester::setConcurrencyLevels(const QList<int> &levels)
+{
+    this->levels.clear();
+    for (int level : levels) {
+        if (level > 0) {
+            this->levels.append(level);
+        }
+    }
+}
+
+void LoadTester::setJobsPerLevel(int count)
+{
+    jobsPerLevel = qMax(0, count);
+}
+
+void LoadTester::setSubmitRate(double jobsPerSecond)
+{
+    submitRate = qMax(0.0, jobsPerSecond);
+}
+
+void LoadTester::setFixtures(qint64 mediaSize, int count, const QString &fixtureDir)
+{
+    if (mediaSize > 0) {
+        fixtureSize = mediaSize;
+    }
+    if (count > 0) {
+        fixtureCount = count;
+    }
+    this->fixtureDir = fixtureDir;
+}
+
+void LoadTester::setAlgorithms(const QStringList &algorithms)
+{
+    if (!algorithms.isEmpty()) {
+        this->algorithms = algorithms;
+    }
+}
+
+void LoadTester::setReportPath(const QString &path)
+{
+    reportPath = path;
+}
+
+void LoadTester::setMultiBufferHashing(bool enable)
+{
+    multiBufferHashing = enable;
+}
+
+bool LoadTester::start()
+{
+    if (levels.isEmpty()) {
+        emit error("No concurrency levels to run");
+        return false;
+    }
+
+    if (!createFixtures()) {
+        return false;
+    }
+
+    results.clear();
+    levelIndex = 0;
+    QTimer::singleShot(0, this, &LoadTester::startLevel);
+    return true;
+}
+
+QList<LoadLevelResult> LoadTester::getResults() const
+{
+    return results;
+}
+
+double LoadTester::percentile(QList<double> values, double fraction)
+{
+    if (values.isEmpty()) {
+        return 0.0;
+    }
+
+    // Nearest rank: the smallest value with at least `fraction` of the set at or below it
+    std::sort(values.begin(), values.end());
+    int rank = static_cast<int>(std::ceil(fraction * values.size()));
+    return values.at(qBound(0, rank - 1, values.size() - 1));
+}
+
+// ===== Slot Implementations =====
+
+void LoadTester::onSubmitTimer()
+{
+    // A zero rate submits the whole level on the first tick
+    while (submitted < levelJobs) {
+        int requestId = submitted++;
+        submitTimes.insert(requestId, clock.elapsed());
+
+        QJsonObject request;
+        request.insert("cmd", "submit");
+        request.insert("id", requestId);
+        request.insert("image", fixtures.at(requestId % fixtures.size()));
+        request.insert("algorithms", QJsonArray::fromStringList(algorithms));
+        send(request);
+
+        if (submitRate > 0.0) {
+            break;
+        }
+    }
+
+    if (submitted >= levelJobs) {
+        submitTimer.stop();
+    }
+}
+
+void LoadTester::onResourceTimer()
+{
+    peakRss = qMax(peakRss, residentBytes());
+}
+
+void LoadTester::onReadyRead()
+{
+    buffer.append(client->readAll());
+
+    int newline;
+    while (client && (newline = buffer.indexOf('\n')) >= 0) {
+        QByteArray line = buffer.left(newline).trimmed();
+        buffer.remove(0, newline + 1);
+
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error == QJsonParseError::NoError && document.isObject()) {
+            handleMessage(document.object());
+        }
+    }
+}
+
+// ===== Private Helper Functions =====
+
+bool LoadTester::createFixtures()
+{
+    QString directory = fixtureDir;
+    if (directory.isEmpty()) {
+        temporaryDir.reset(new QTemporaryDir());
+        if (!temporaryDir->isValid()) {
+            emit error("Cannot create a temporary directory for the fixtures");
+            return false;
+        }
+        directory = temporaryDir->path();
+    } else if (!QDir().mkpath(directory)) {
+        emit error("Cannot create " + directory);
+        return false;
+    }
+
+    fixtures.clear();
+    for (int i = 0; i < fixtureCount; ++i) {
+        // Named by size and seed, so a kept fixture directory is reused
+        QString path = QDir(directory).filePath(QString("loadtest-%1MB-%2.E01")
+                                                    .arg(fixtureSize / (1024*1024))
+                                                    .arg(i + 1));
+        if (!QFileInfo::exists(path) && !createFixture(path, static_cast<quint32>(i + 1))) {
+            return false;
+        }
+        fixtures.append(path);
+        emit fixtureReady(path);
+    }
+    return true;
+}
+
+bool LoadTester::createFixture(const QString &path, quint32 seed)
+{
+    EWFWriter writer;
+    writer.setMediaSize(fixtureSize);
+    writer.setCompressionLevel(EWFWriter::COMPRESSION_FAST);
+    writer.setHeaderValue("case_number", "load-test");
+    writer.setHeaderValue("description", "Synthetic load-test fixture");
+    if (!writer.open(path)) {
+        emit error("Cannot create fixture " + path + ": " + writer.getLastError());
+        return false;
+    }
+
+    // Blocks cycle through random, random, repetitive and zero data, so
+    // reads include both real inflate work and cheap chunks
+    QCryptographicHash md5(QCryptographicHash::Md5);
+    QByteArray block(static_cast<int>(FIXTURE_BLOCK_SIZE), Qt::Uninitialized);
+    quint32 state = seed * 2654435761u + 1;
+    for (qint64 offset = 0, index = 0; offset < fixtureSize; offset += FIXTURE_BLOCK_SIZE, ++index) {
+        int size = static_cast<int>(qMin(FIXTURE_BLOCK_SIZE, fixtureSize - offset));
+        char *data = block.data();
+        switch (index % 4) {
+        case 0:
+        case 1:
+            for (int i = 0; i < size; ++i) {
+                // xorshift32
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                data[i] = static_cast<char>(state);
+            }
+            break;
+        case 2:
+            for (int i = 0; i < size; ++i) {
+                data[i] = static_cast<char>("load-test fixture "[i % 18]);
+            }
+            break;
+        default:
+            memset(data, 0, static_cast<size_t>(size));
+            break;
+        }
+
+        if (writer.write(data, size) != size) {
+            emit error("Cannot write fixture " + path + ": " + writer.getLastError());
+            return false;
+        }
+        md5.addData(data, size);
+    }
+
+    // Stored hash, so every job ends "verified"
+    writer.setHashValue("MD5", QString::fromLatin1(md5.result().toHex()));
+    if (!writer.finalize()) {
+        emit error("Cannot finalize fixture " + path + ": " + writer.getLastError());
+        return false;
+    }
+
+    qDebug() << "LoadTester: Created fixture" << path;
+    return true;
+}
+
+void LoadTester::startLevel()
+{
+    int concurrency = levels.at(levelIndex);
+    levelJobs = jobsPerLevel > 0 ? jobsPerLevel : qMax(concurrency * 2, MIN_JOBS_PER_LEVEL);
+    submitted = 0;
+    finished = 0;
+    jobTimes.clear();
+    submitTimes.clear();
+    buffer.clear();
+
+    // A fresh server per level; the previous one may still be shutting down
+    server = new JobServer(this);
+    server->setWorkerCount(concurrency);
+    server->setProgressInterval(PROGRESS_SAMPLE_MS);
+    server->setMultiBufferHashing(multiBufferHashing);
+    QString name = QString("e01hasher-loadtest-%1-%2").arg(QCoreApplication::applicationPid()).arg(levelIndex);
+    if (!server->listen(name)) {
+        emit error("Cannot start the job server on " + name);
+        return;
+    }
+
+    client = new QLocalSocket(this);
+    client->connectToServer(server->serverName());
+    if (!client->waitForConnected(CONNECT_TIMEOUT_MS)) {
+        emit error("Cannot connect to the job server: " + client->errorString());
+        return;
+    }
+    connect(client, &QLocalSocket::readyRead, this, &LoadTester::onReadyRead);
+
+    // Every job's events, before the first submit
+    send(QJsonObject{{"cmd", "subscribe"}});
+
+    emit levelStarted(concurrency, levelJobs);
+    qDebug() << "LoadTester: Level" << concurrency << "with" << levelJobs << "jobs";
+
+    peakRss = residentBytes();
+    cpuAtStart = processCpuMs();
+    laneBlocksAtStart = MultiBufferHasher::instance().getBlocksHashed();
+    laneStepsAtStart = MultiBufferHasher::instance().getBlockSteps();
+    clock.start();
+    resourceTimer.start(RESOURCE_SAMPLE_MS);
+    if (submitRate > 0.0) {
+        submitTimer.start(qMax(1, static_cast<int>(1000.0 / submitRate)));
+    }
+    onSubmitTimer();
+}
+
+void LoadTester::finishLevel()
+{
+    qint64 wallMs = qMax<qint64>(1, clock.elapsed());
+    submitTimer.stop();
+    resourceTimer.stop();
+    onResourceTimer();
+
+    LoadLevelResult result;
+    result.concurrency = levels.at(levelIndex);
+    result.jobs = levelJobs;
+    result.wallMs = wallMs;
+    result.peakRssBytes = peakRss;
+    result.cpuPercent = (processCpuMs() - cpuAtStart) * 100.0 / wallMs;
+    qint64 laneSteps = MultiBufferHasher::instance().getBlockSteps() - laneStepsAtStart;
+    if (laneSteps > 0) {
+        result.lanesFilled = static_cast<double>(MultiBufferHasher::instance().getBlocksHashed()
+                                                 - laneBlocksAtStart) / laneSteps;
+    }
+
+    QList<double> latencies;
+    QList<double> firstProgress;
+    QList<double> jobRates;
+    int verified = 0;
+    double megabytes = static_cast<double>(fixtureSize) / (1024 * 1024);
+    for (const JobTimes &times : jobTimes) {
+        if (times.submitted < 0 || times.finished < 0) {
+            continue;
+        }
+        latencies.append(times.finished - times.submitted);
+        if (times.firstProgress >= 0) {
+            firstProgress.append(times.firstProgress - times.submitted);
+        }
+        if (times.verified) {
+            verified++;
+            if (times.started >= 0 && times.finished > times.started) {
+                jobRates.append(megabytes * 1000.0 / (times.finished - times.started));
+            }
+        }
+    }
+
+    result.failed = levelJobs - verified;
+    result.latencyP50 = percentile(latencies, 0.50);
+    result.latencyP90 = percentile(latencies, 0.90);
+    result.latencyP99 = percentile(latencies, 0.99);
+    result.latencyMax = percentile(latencies, 1.0);
+    result.firstProgressP50 = percentile(firstProgress, 0.50);
+    result.firstProgressP90 = percentile(firstProgress, 0.90);
+    result.jobMBpsP10 = percentile(jobRates, 0.10);
+    result.jobMBpsP50 = percentile(jobRates, 0.50);
+    result.aggregateMBps = verified * megabytes * 1000.0 / wallMs;
+    results.append(result);
+
+    // Called from the client's own signal; both go once it returns
+    client->disconnect(this);
+    client->deleteLater();
+    client = nullptr;
+    server->deleteLater();
+    server = nullptr;
+
+    emit levelComplete(result);
+
+    if (++levelIndex < levels.size()) {
+        QTimer::singleShot(0, this, &LoadTester::startLevel);
+        return;
+    }
+
+    if (!reportPath.isEmpty()) {
+        QString errorMessage;
+        if (!writeReport(errorMessage)) {
+            emit error(errorMessage);
+            return;
+        }
+    }
+    emit loadTestComplete();
+}
+
+void LoadTester::handleMessage(const QJsonObject &message)
+{
+    qint64 now = clock.elapsed();
+    QString event = message.value("event").toString();
+
+    if (event.isEmpty()) {
+        // Reply to a submit: ties the request to its job
+        int requestId = message.value("id").toInt(-1);
+        if (!submitTimes.contains(requestId)) {
+            return;
+        }
+        qint64 submitTime = submitTimes.take(requestId);
+        if (!message.value("ok").toBool()) {
+            qDebug() << "LoadTester: Submit failed:" << message.value("error").toString();
+            finished++;
+        } else {
+            jobTimes[message.value("job").toInt()].submitted = submitTime;
+        }
+    } else {
+        JobTimes &times = jobTimes[message.value("job").toInt()];
+        if (event == "started") {
+            times.started = now;
+        } else if (event == "progress") {
+            if (times.firstProgress < 0 && message.value("bytes").toDouble() > 0) {
+                times.firstProgress = now;
+            }
+        } else if (event == "result") {
+            times.finished = now;
+            times.verified = message.value("state").toString() == "verified";
+            finished++;
+        }
+    }
+
+    if (finished >= levelJobs && submitted >= levelJobs) {
+        finishLevel();
+    }
+}
+
+void LoadTester::send(const QJsonObject &message)
+{
+    client->write(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    client->write("\n");
+}
+
+bool LoadTester::writeReport(QString &errorMessage) const
+{
+    QJsonObject host;
+    host.insert("name", QSysInfo::machineHostName());
+    host.insert("os", QSysInfo::prettyProductName());
+    host.insert("architecture", QSysInfo::currentCpuArchitecture());
+    host.insert("logicalCpus", QThread::idealThreadCount());
+
+    QJsonObject fixture;
+    fixture.insert("mediaSize", fixtureSize);
+    fixture.insert("count", fixtureCount);
+    fixture.insert("compression", "fast");
+
+    QJsonArray levelList;
+    for (const LoadLevelResult &result : results) {
+        levelList.append(levelToJson(result));
+    }
+
+    QJsonObject report;
+    report.insert("created", QDateTime::currentDateTime().toString(Qt::ISODate));
+    report.insert("version", QCoreApplication::applicationVersion());
+    report.insert("host", host);
+    report.insert("fixtures", fixture);
+    report.insert("algorithms", QJsonArray::fromStringList(algorithms));
+    report.insert("submitRate", submitRate);
+    report.insert("multiBuffer", multiBufferHashing);
+    report.insert("progressSampleMs", PROGRESS_SAMPLE_MS);
+    report.insert("levels", levelList);
+
+    QSaveFile file(reportPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorMessage = "Cannot write " + reportPath + ": " + file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        errorMessage = "Cannot write " + reportPath + ": " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QJsonObject LoadTester::levelToJson(const LoadLevelResult &result)
+{
+    QJsonObject object;
+    object.insert("concurrency", result.concurrency);
+    object.insert("jobs", result.jobs);
+    object.insert("failed", result.failed);
+    object.insert("wallMs", result.wallMs);
+    object.insert("latencyMs", QJsonObject{{"p50", result.latencyP50}, {"p90", result.latencyP90},
+                                           {"p99", result.latencyP99}, {"max", result.latencyMax}});
+    object.insert("firstProgressMs", QJsonObject{{"p50", result.firstProgressP50},
+                                                 {"p90", result.firstProgressP90}});
+    object.insert("jobMBps", QJsonObject{{"p10", result.jobMBpsP10}, {"p50", result.jobMBpsP50}});
+    object.insert("aggregateMBps", result.aggregateMBps);
+    object.insert("cpuPercent", result.cpuPercent);
+    object.insert("peakRssBytes", result.peakRssBytes);
+    object.insert("lanesFilled", result.lanesFilled);
+    return object;
+}
+
+qint64 LoadTester::processCpuMs()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    ULARGE_INTEGER kernelTime, userTime;
+    kernelTime.LowPart = kernel.dwLowDateTime;
+    kernelTime.HighPart = kernel.dwHighDateTime;
+    userTime.LowPart = user.dwLowDateTime;
+    userTime.HighPart = user.dwHighDateTime;
+    return static_cast<qint64>((kernelTime.QuadPart + userTime.QuadPart) / 10000);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000LL +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#endif
+}
+
+qint64 LoadTester::residentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return static_cast<qint64>(counters.WorkingSetSize);
+#else
+    // Current RSS where /proc exists, otherwise the peak so far
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#endif
+}
@@ -0,0 +1,169 @@
+/*
+ * E01 Hash Verification Tool
+ * LoadTester - Concurrent-job load generator for the job server
+ */
+
+#ifndef LOADTESTER_H
+#define LOADTESTER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMap>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QTemporaryDir>
+#include <QScopedPointer>
+#include <QMetaType>
+
+class JobServer;
+
+// Measurements of one concurrency level; times in milliseconds from submit
+struct LoadLevelResult
+{
+    int concurrency = 0;
+    int jobs = 0;
+    int failed = 0;               // Jobs that did not end "verified"
+    qint64 wallMs = 0;            // First submit to last result
+    double latencyP50 = 0.0;      // End-to-end: submit to result
+    double latencyP90 = 0.0;
+    double latencyP99 = 0.0;
+    double latencyMax = 0.0;
+    double firstProgressP50 = 0.0;
+    double firstProgressP90 = 0.0;
+    double jobMBpsP10 = 0.0;      // Per job: media size over start-to-result time
+    double jobMBpsP50 = 0.0;
+    double aggregateMBps = 0.0;   // All media over the wall time
+    double cpuPercent = 0.0;      // Process CPU time over wall time (100 = one core)
+    qint64 peakRssBytes = 0;
+    double lanesFilled = 0.0;     // Average busy multi-buffer SHA lanes (0 when not used)
+};
+
+Q_DECLARE_METATYPE(LoadLevelResult)
+
+// Runs the job server in-process at each requested concurrency (its worker
+// count) and drives it over its own local socket protocol, exactly as a
+// client would: jobs are submitted at a fixed rate against synthetic E01
+// fixtures and every job's started / progress / result events are
+// timestamped. CPU time and resident memory of the process are sampled
+// while a level runs. Fixtures are generated from a fixed seed, so runs on
+// different builds or hosts hash the same data and their reports compare.
+class LoadTester : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LoadTester(QObject *parent = nullptr);
+    ~LoadTester();
+
+    // Levels run in order (default 1, 8, 32)
+    void setConcurrencyLevels(const QList<int> &levels);
+
+    // Jobs per level (0 = twice the concurrency, at least MIN_JOBS_PER_LEVEL)
+    void setJobsPerLevel(int count);
+
+    // Submissions per second (0 = all at once)
+    void setSubmitRate(double jobsPerSecond);
+
+    // Synthetic images: media size and number of distinct fixtures; kept
+    // in fixtureDir if given, otherwise in a temporary directory
+    void setFixtures(qint64 mediaSize, int count, const QString &fixtureDir = QString());
+
+    void setAlgorithms(const QStringList &algorithms);
+
+    // Run the server with SHA-1 / SHA-256 in the shared multi-buffer lanes
+    void setMultiBufferHashing(bool enable);
+
+    // JSON report, written when the last level ends (optional)
+    void setReportPath(const QString &path);
+
+    // Create the fixtures, then run the levels from the event loop
+    bool start();
+
+    QList<LoadLevelResult> getResults() const;
+
+    static double percentile(QList<double> values, double fraction);
+
+signals:
+    void fixtureReady(const QString &path);
+    void levelStarted(int concurrency, int jobs);
+    void levelComplete(const LoadLevelResult &result);
+    void loadTestComplete();
+    void error(const QString &errorMessage);
+
+private slots:
+    void onSubmitTimer();
+    void onResourceTimer();
+    void onReadyRead();
+
+private:
+    // Timestamps of one job, -1 until the event arrives
+    struct JobTimes {
+        qint64 submitted = -1;
+        qint64 started = -1;
+        qint64 firstProgress = -1;
+        qint64 finished = -1;
+        bool verified = false;
+    };
+
+    bool createFixtures();
+    bool createFixture(const QString &path, quint32 seed);
+    void startLevel();
+    void finishLevel();
+    void handleMessage(const QJsonObject &message);
+    void send(const QJsonObject &message);
+    bool writeReport(QString &errorMessage) const;
+    static QJsonObject levelToJson(const LoadLevelResult &result);
+    static qint64 processCpuMs();
+    static qint64 residentBytes();
+
+    // Configuration
+    QList<int> levels;
+    int jobsPerLevel;
+    double submitRate;
+    qint64 fixtureSize;
+    int fixtureCount;
+    QString fixtureDir;
+    QStringList algorithms;
+    QString reportPath;
+    bool multiBufferHashing;
+
+    // Fixtures
+    QScopedPointer<QTemporaryDir> temporaryDir;
+    QStringList fixtures;
+
+    // Current level
+    int levelIndex;
+    int levelJobs;
+    int submitted;
+    int finished;
+    JobServer *server;
+    QLocalSocket *client;
+    QByteArray buffer;
+    QMap<int, JobTimes> jobTimes;     // By job id
+    QMap<int, qint64> submitTimes;    // By request id until the reply names the job
+    QElapsedTimer clock;
+    qint64 cpuAtStart;
+    qint64 peakRss;
+    qint64 laneBlocksAtStart;
+    qint64 laneStepsAtStart;
+    QTimer submitTimer;
+    QTimer resourceTimer;
+
+    QList<LoadLevelResult> results;
+
+    // Constants
+    static const int MIN_JOBS_PER_LEVEL = 8;
+    static const int PROGRESS_SAMPLE_MS = 20;      // Resolution of time-to-first-progress
+    static const int RESOURCE_SAMPLE_MS = 100;
+    static const int CONNECT_TIMEOUT_MS = 5000;
+    static const qint64 DEFAULT_FIXTURE_SIZE = 256LL * 1024 * 1024;
+    static const int DEFAULT_FIXTURE_COUNT = 4;
+    static const qint64 FIXTURE_BLOCK_SIZE = 1024 * 1024;
+};
+
+#endif // LOADTESTER_H
@@ -4,17 +4,51 @@
  */
 
 #include "mainwindow.h"
+#include "clirunner.h"
+#include "sparsemap.h"
+#include "quickverifier.h"
+#include "imagecomparator.h"
+#include "evidencecopier.h"
+#include "loadtester.h"
+#include "segmenthasher.h"
 #include <QApplication>
+#include <QCoreApplication>
 #include <QDebug>
 #include <QMessageBox>
 #include <QMap>
 #include <QString>
+#include <QStringList>
 #include <QMetaType>
 
 int main(int argc, char *argv[])
 {
     // Register custom types for cross-thread signal/slot communication
     qRegisterMetaType<QMap<QString,bool>>("QMap<QString,bool>");
+    qRegisterMetaType<SparseMap>("SparseMap");
+    qRegisterMetaType<QuickVerifyResult>("QuickVerifyResult");
+    qRegisterMetaType<ImageCompareResult>("ImageCompareResult");
+    qRegisterMetaType<CopiedSegmentList>("CopiedSegmentList");
+    qRegisterMetaType<LoadLevelResult>("LoadLevelResult");
+    qRegisterMetaType<SegmentHashList>("SegmentHashList");
+    qRegisterMetaType<BadRangeMap>("BadRangeMap");
+
+    // Command-line options select the headless mode; anything else (an
+    // image opened from the file manager, Qt's GUI flags) starts the GUI
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i) {
+        arguments.append(QString::fromLocal8Bit(argv[i]));
+    }
+
+    if (CliRunner::isCommandLine(arguments)) {
+        QCoreApplication app(argc, argv);
+
+        app.setApplicationName("E01 Hash Verification Tool");
+        app.setApplicationVersion("1.0.0");
+        app.setOrganizationName("Forensic Tools");
+
+        CliRunner runner;
+        return runner.run(app.arguments());
+    }
 
     QApplication app(argc, argv);
 
@@ -25,5 +59,11 @@ int main(int argc, char *argv[])
     MainWindow mainWindow;
     mainWindow.show();
 
+    // QApplication has already taken its own flags out of arguments()
+    const QStringList guiArguments = app.arguments();
+    if (guiArguments.size() > 1) {
+        mainWindow.openFile(guiArguments.at(1));
+    }
+
     return app.exec();
 }
@@ -4,6 +4,7 @@
  */
 
 #include "mainwindow.h"
+#include "prefetchreader.h"
 #include <QMenuBar>
 #include <QMenu>
 #include <QAction>
@@ -30,16 +31,26 @@ MainWindow::MainWindow(QWidget *parent)
     , md5CheckBox(nullptr)
     , sha1CheckBox(nullptr)
     , sha256CheckBox(nullptr)
+    , sparseMapCheckBox(nullptr)
+    , similarityCheckBox(nullptr)
+    , segmentHashCheckBox(nullptr)
+    , continueOnErrorCheckBox(nullptr)
+    , backgroundCheckBox(nullptr)
     , startButton(nullptr)
+    , quickCheckButton(nullptr)
     , progressGroup(nullptr)
     , progressBar(nullptr)
     , progressLabel(nullptr)
+    , pauseButton(nullptr)
     , cancelButton(nullptr)
+    , progressTimer(nullptr)
     , resultsGroup(nullptr)
     , resultsLabel(nullptr)
     , ewfHandler(nullptr)
     , hashEngine(nullptr)
+    , quickVerifier(nullptr)
     , currentState(STATE_READY)
+    , networkStorage(false)
 {
     // Initialize EWF handler
     ewfHandler = new EWFHandler();
@@ -61,6 +72,13 @@ MainWindow::~MainWindow()
         delete hashEngine;
     }
 
+    // Clean up quick verifier if running
+    if (quickVerifier) {
+        quickVerifier->cancel();
+        quickVerifier->wait();
+        delete quickVerifier;
+    }
+
     // Clean up EWF handler
     if (ewfHandler) {
         ewfHandler->close();
@@ -135,14 +153,36 @@ void MainWindow::setupUI()
     md5CheckBox = new QCheckBox("MD5", metadataGroup);
     sha1CheckBox = new QCheckBox("SHA1", metadataGroup);
     sha256CheckBox = new QCheckBox("SHA256", metadataGroup);
+    sparseMapCheckBox = new QCheckBox("Zero chunks", metadataGroup);
+    sparseMapCheckBox->setToolTip("Map the all-zero (unallocated) chunks of the media");
+    similarityCheckBox = new QCheckBox("Similarity (ssdeep)", metadataGroup);
+    similarityCheckBox->setToolTip("Fuzzy digest for spotting near-copies, e.g. a re-acquisition");
+    segmentHashCheckBox = new QCheckBox("Segment files", metadataGroup);
+    segmentHashCheckBox->setToolTip("Also hash each .E01 ... .Exx file as stored, for chain-of-custody records");
+    continueOnErrorCheckBox = new QCheckBox("Continue past errors", metadataGroup);
+    continueOnErrorCheckBox->setToolTip("Hash damaged chunks as zeros and map them instead of stopping "
+                                        "(the hashes are then marked as hashes with substitutions)");
+    backgroundCheckBox = new QCheckBox("Low priority", metadataGroup);
+    backgroundCheckBox->setToolTip("Read in the idle I/O class at the lowest CPU priority, so "
+                                   "acquisitions on the same disk are not slowed down");
 
     md5CheckBox->setChecked(true);
     sha1CheckBox->setChecked(true);
     sha256CheckBox->setChecked(false);  // SHA256 off by default
+    sparseMapCheckBox->setChecked(false);
+    similarityCheckBox->setChecked(false);
+    segmentHashCheckBox->setChecked(false);
+    continueOnErrorCheckBox->setChecked(false);
+    backgroundCheckBox->setChecked(false);
 
     checkboxLayout->addWidget(md5CheckBox);
     checkboxLayout->addWidget(sha1CheckBox);
     checkboxLayout->addWidget(sha256CheckBox);
+    checkboxLayout->addWidget(sparseMapCheckBox);
+    checkboxLayout->addWidget(similarityCheckBox);
+    checkboxLayout->addWidget(segmentHashCheckBox);
+    checkboxLayout->addWidget(continueOnErrorCheckBox);
+    checkboxLayout->addWidget(backgroundCheckBox);
     checkboxLayout->addStretch();
 
     metadataLayout->addLayout(checkboxLayout);
@@ -153,7 +193,18 @@ void MainWindow::setupUI()
     startButton->setStyleSheet("QPushButton { background-color: #4CAF50; color: white; font-weight: bold; }");
     connect(startButton, &QPushButton::clicked, this, &MainWindow::onStartVerification);
 
-    metadataLayout->addWidget(startButton);
+    // Quick check button (random chunk sample for intake triage)
+    quickCheckButton = new QPushButton("Quick Check", metadataGroup);
+    quickCheckButton->setMinimumHeight(35);
+    quickCheckButton->setMaximumWidth(150);
+    quickCheckButton->setToolTip("Read a random sample of chunks to check the image is plausibly intact");
+    connect(quickCheckButton, &QPushButton::clicked, this, &MainWindow::onStartQuickVerify);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    buttonLayout->addWidget(startButton);
+    buttonLayout->addWidget(quickCheckButton);
+
+    metadataLayout->addLayout(buttonLayout);
 
     mainLayout->addWidget(metadataGroup);
 
@@ -173,10 +224,25 @@ void MainWindow::setupUI()
     progressLabel = new QLabel("Starting verification...", progressGroup);
     progressLayout->addWidget(progressLabel);
 
+    // Pausing keeps the job's state; only full verifications can pause
+    pauseButton = new QPushButton("Pause", progressGroup);
+    pauseButton->setMaximumWidth(100);
+    connect(pauseButton, &QPushButton::clicked, this, &MainWindow::onPauseVerification);
+
     cancelButton = new QPushButton("Cancel", progressGroup);
     cancelButton->setMaximumWidth(100);
     connect(cancelButton, &QPushButton::clicked, this, &MainWindow::onCancelVerification);
-    progressLayout->addWidget(cancelButton, 0, Qt::AlignRight);
+
+    // The hash engine only publishes counters; the UI samples them at its own pace
+    progressTimer = new QTimer(this);
+    progressTimer->setInterval(PROGRESS_INTERVAL_MS);
+    connect(progressTimer, &QTimer::timeout, this, &MainWindow::onProgressTimer);
+
+    QHBoxLayout *controlLayout = new QHBoxLayout();
+    controlLayout->addStretch();
+    controlLayout->addWidget(pauseButton);
+    controlLayout->addWidget(cancelButton);
+    progressLayout->addLayout(controlLayout);
 
     mainLayout->addWidget(progressGroup);
 
@@ -243,6 +309,11 @@ void MainWindow::setState(ApplicationState newState)
 {
     currentState = newState;
 
+    // Telemetry is only sampled while a full verification runs
+    if (currentState != STATE_VERIFYING) {
+        progressTimer->stop();
+    }
+
     // Update UI based on state
     switch (currentState) {
         case STATE_READY:
@@ -258,6 +329,7 @@ void MainWindow::setState(ApplicationState newState)
             progressGroup->setVisible(false);
             resultsGroup->setVisible(false);
             startButton->setEnabled(true);
+            quickCheckButton->setEnabled(true);
             break;
 
         case STATE_VERIFYING:
@@ -266,6 +338,7 @@ void MainWindow::setState(ApplicationState newState)
             progressGroup->setVisible(true);
             resultsGroup->setVisible(false);
             startButton->setEnabled(false);
+            quickCheckButton->setEnabled(false);
             break;
 
         case STATE_COMPLETE:
@@ -275,10 +348,16 @@ void MainWindow::setState(ApplicationState newState)
             resultsGroup->setVisible(true);
             startButton->setEnabled(true);
             startButton->setText("Verify Another File");
+            quickCheckButton->setEnabled(false);
             break;
     }
 }
 
+void MainWindow::openFile(const QString &path)
+{
+    onFileSelected(path);
+}
+
 // ===== Slot Implementations =====
 
 void MainWindow::onFileSelected(const QString &path)
@@ -322,6 +401,12 @@ void MainWindow::onFileSelected(const QString &path)
 
     metadataText += "<br><b>Media Size:</b> " + QString::number(ewfHandler->getMediaSize() / (1024*1024)) + " MB<br>";
 
+    // Network shares are read with several outstanding requests
+    networkStorage = PrefetchReader::isNetworkPath(path);
+    if (networkStorage) {
+        metadataText += "<b>Storage:</b> network share (parallel reads enabled)<br>";
+    }
+
     // Check for stored hashes
     expectedMD5 = metadata.value("stored_md5");
     expectedSHA1 = metadata.value("stored_sha1");
@@ -367,11 +452,14 @@ void MainWindow::onStartVerification()
     hashEngine = new HashEngine(ewfHandler, this);
 
     // Connect signals
-    connect(hashEngine, &HashEngine::progressUpdate, this, &MainWindow::onProgressUpdate);
-    connect(hashEngine, &HashEngine::timeEstimate, this, &MainWindow::onTimeEstimate);
     connect(hashEngine, &HashEngine::md5Calculated, this, &MainWindow::onMD5Calculated);
     connect(hashEngine, &HashEngine::sha1Calculated, this, &MainWindow::onSHA1Calculated);
     connect(hashEngine, &HashEngine::sha256Calculated, this, &MainWindow::onSHA256Calculated);
+    connect(hashEngine, &HashEngine::sparseMapCalculated, this, &MainWindow::onSparseMapCalculated);
+    connect(hashEngine, &HashEngine::similarityDigestCalculated, this, &MainWindow::onSimilarityDigestCalculated);
+    connect(hashEngine, &HashEngine::similarityDigestSkipped, this, &MainWindow::onSimilarityDigestSkipped);
+    connect(hashEngine, &HashEngine::segmentHashesCalculated, this, &MainWindow::onSegmentHashesCalculated);
+    connect(hashEngine, &HashEngine::badRangesFound, this, &MainWindow::onBadRangesFound);
     connect(hashEngine, &HashEngine::verificationComplete, this, &MainWindow::onVerificationComplete);
     connect(hashEngine, &HashEngine::error, this, &MainWindow::onHashError);
 
@@ -379,6 +467,17 @@ void MainWindow::onStartVerification()
     hashEngine->enableMD5(md5CheckBox->isChecked());
     hashEngine->enableSHA1(sha1CheckBox->isChecked());
     hashEngine->enableSHA256(sha256CheckBox->isChecked());
+    hashEngine->enableSparseMap(sparseMapCheckBox->isChecked());
+    hashEngine->enableSimilarityDigest(similarityCheckBox->isChecked());
+    hashEngine->enableSegmentHashes(segmentHashCheckBox->isChecked());
+    hashEngine->enableContinueOnError(continueOnErrorCheckBox->isChecked());
+
+    // Readers and hash kernel are chosen per job (network shares get
+    // several outstanding reads)
+    hashEngine->enableAutoTune(true);
+    if (backgroundCheckBox->isChecked()) {
+        hashEngine->getControl().setPriority(JobControl::PRIORITY_BACKGROUND);
+    }
 
     // Set expected hashes
     if (!expectedMD5.isEmpty()) {
@@ -392,16 +491,49 @@ void MainWindow::onStartVerification()
     calculatedMD5.clear();
     calculatedSHA1.clear();
     calculatedSHA256.clear();
+    similarityDigest.clear();
+    similarityWarning.clear();
+    segmentHashes.clear();
+    sparseMap.clear();
+    badRangeMap.clear();
 
     // Reset progress
     progressBar->setValue(0);
     progressLabel->setText("Starting verification...");
+    pauseButton->setText("Pause");
+    pauseButton->setVisible(true);
 
     // Update state
     setState(STATE_VERIFYING);
 
     // Start hash calculation
     hashEngine->start();
+    progressTimer->start();
+}
+
+void MainWindow::onStartQuickVerify()
+{
+    // Clean up old quick verifier if exists
+    if (quickVerifier) {
+        quickVerifier->wait();
+        delete quickVerifier;
+    }
+
+    // The sampler opens its own handles so it can read segments in parallel
+    quickVerifier = new QuickVerifier(currentFilePath, this);
+
+    connect(quickVerifier, &QuickVerifier::progressUpdate, this, &MainWindow::onQuickProgressUpdate);
+    connect(quickVerifier, &QuickVerifier::quickVerifyComplete, this, &MainWindow::onQuickVerifyComplete);
+    connect(quickVerifier, &QuickVerifier::error, this, &MainWindow::onHashError);
+
+    // Reset progress
+    progressBar->setValue(0);
+    progressLabel->setText("Starting quick check...");
+    pauseButton->setVisible(false);
+
+    setState(STATE_VERIFYING);
+
+    quickVerifier->start();
 }
 
 void MainWindow::onCancelVerification()
@@ -410,31 +542,72 @@ void MainWindow::onCancelVerification()
         "Are you sure you want to cancel the verification?",
         QMessageBox::Yes | QMessageBox::No);
 
-    if (result == QMessageBox::Yes && hashEngine) {
+    if (result != QMessageBox::Yes) {
+        return;
+    }
+
+    if (hashEngine && hashEngine->isRunning()) {
         hashEngine->cancel();
         hashEngine->wait();
+    }
 
-        setState(STATE_FILE_LOADED);
-        QMessageBox::information(this, "Cancelled", "Verification cancelled by user.");
+    if (quickVerifier && quickVerifier->isRunning()) {
+        quickVerifier->cancel();
+        quickVerifier->wait();
     }
+
+    setState(STATE_FILE_LOADED);
+    QMessageBox::information(this, "Cancelled", "Verification cancelled by user.");
 }
 
-void MainWindow::onProgressUpdate(int percentage, qint64 bytesProcessed, qint64 totalBytes)
+void MainWindow::onPauseVerification()
 {
-    progressBar->setValue(percentage);
-
-    QString progressText = QString("Processing: %1 / %2 MB (%3%)")
-        .arg(bytesProcessed / (1024*1024))
-        .arg(totalBytes / (1024*1024))
-        .arg(percentage);
+    if (!hashEngine || !hashEngine->isRunning()) {
+        return;
+    }
 
-    progressLabel->setText(progressText);
+    JobControl &control = hashEngine->getControl();
+    if (control.isPaused()) {
+        control.resume();
+        pauseButton->setText("Pause");
+    } else {
+        control.pause();
+        pauseButton->setText("Resume");
+        progressLabel->setText("Paused");
+    }
 }
 
-void MainWindow::onTimeEstimate(const QString &remaining)
+void MainWindow::onProgressTimer()
 {
-    QString currentText = progressLabel->text();
-    progressLabel->setText(currentText + " - Time remaining: " + remaining);
+    if (!hashEngine) {
+        return;
+    }
+
+    // The button follows the control, including a pause pressed before the
+    // run started (kept by the engine)
+    bool paused = hashEngine->getControl().isPaused();
+    pauseButton->setText(paused ? "Resume" : "Pause");
+
+    // The rate would only show the pause draining the average
+    if (paused) {
+        return;
+    }
+
+    TelemetrySnapshot progress = hashEngine->getTelemetry().snapshot();
+    int percentage = progress.percentage();
+    progressBar->setValue(percentage);
+
+    QString progressText = QString("Processing: %1 / %2 MB (%3%) - %4 MB/s")
+        .arg(progress.bytesProcessed / (1024*1024))
+        .arg(progress.totalBytes / (1024*1024))
+        .arg(percentage)
+        .arg(progress.bytesPerSecond() / (1024*1024), 0, 'f', 1);
+
+    if (progress.remainingMs() >= 0) {
+        progressText += " - Time remaining: " + JobTelemetry::formatDuration(progress.remainingMs());
+    }
+
+    progressLabel->setText(progressText);
 }
 
 void MainWindow::onMD5Calculated(const QString &hash)
@@ -452,6 +625,31 @@ void MainWindow::onSHA256Calculated(const QString &hash)
     calculatedSHA256 = hash;
 }
 
+void MainWindow::onSparseMapCalculated(const SparseMap &map)
+{
+    sparseMap = map;
+}
+
+void MainWindow::onSimilarityDigestCalculated(const QString &digest)
+{
+    similarityDigest = digest;
+}
+
+void MainWindow::onSimilarityDigestSkipped(const QString &reason)
+{
+    similarityWarning = reason;
+}
+
+void MainWindow::onSegmentHashesCalculated(const SegmentHashList &hashes)
+{
+    segmentHashes = hashes;
+}
+
+void MainWindow::onBadRangesFound(const BadRangeMap &map)
+{
+    badRangeMap = map;
+}
+
 void MainWindow::onVerificationComplete(const QMap<QString, bool> &results)
 {
     setState(STATE_COMPLETE);
@@ -506,6 +704,59 @@ void MainWindow::onVerificationComplete(const QMap<QString, bool> &results)
         resultsText += "  (No stored hash to compare)<br><br>";
     }
 
+    if (!similarityDigest.isEmpty()) {
+        resultsText += "<b>Similarity (ssdeep):</b> " + similarityDigest + "<br><br>";
+    } else if (!similarityWarning.isEmpty()) {
+        resultsText += "<b>Similarity (ssdeep):</b> not computed (" + similarityWarning.toHtmlEscaped() + ")<br><br>";
+    }
+
+    // Container-file hashes of each segment
+    if (!segmentHashes.isEmpty()) {
+        resultsText += QString("<b>Segment files (%1):</b><br>").arg(segmentHashes.size());
+        for (const SegmentHash &segment : segmentHashes) {
+            // File names are user-controlled; keep them out of the markup
+            QString name = QFileInfo(segment.path).fileName().toHtmlEscaped();
+            if (!segment.error.isEmpty()) {
+                resultsText += "<span style='color: red;'>  " + name + ": unreadable - " + segment.error.toHtmlEscaped() + "</span><br>";
+                continue;
+            }
+            resultsText += "  " + name + "<br>";
+            resultsText += "    MD5:  " + segment.md5 + "<br>";
+            resultsText += "    SHA1: " + segment.sha1 + "<br>";
+        }
+        resultsText += "<br>";
+    }
+
+    // Damaged chunks were hashed as zeros: the hashes above are not the image's
+    if (!badRangeMap.isEmpty()) {
+        resultsText += QString("<span style='color: red;'><b>✗ Hashes with substitutions:</b> %1 damaged bytes "
+                               "in %2 ranges were hashed as zeros</span><br>")
+            .arg(badRangeMap.getBadBytes())
+            .arg(badRangeMap.getRanges().size());
+
+        const QList<BadRangeMap::Range> ranges = badRangeMap.getRanges();
+        for (int i = 0; i < ranges.size() && i < MAX_LISTED_BAD_RANGES; ++i) {
+            resultsText += QString("  %1 - %2 (%3)<br>")
+                .arg(ranges.at(i).offset)
+                .arg(ranges.at(i).offset + ranges.at(i).length - 1)
+                .arg(BadRangeMap::reasonName(ranges.at(i).reason));
+        }
+        if (ranges.size() > MAX_LISTED_BAD_RANGES) {
+            resultsText += QString("  ... and %1 more<br>").arg(ranges.size() - MAX_LISTED_BAD_RANGES);
+        }
+        resultsText += "<br>";
+        allPassed = false;
+    }
+
+    // Display unallocated (all-zero) regions
+    if (sparseMap.getTotalBytes() > 0) {
+        int zeroPercent = static_cast<int>((sparseMap.getZeroBytes() * 100) / sparseMap.getTotalBytes());
+        resultsText += QString("<b>Zero-filled regions:</b> %1 MB in %2 ranges (%3% of media)<br>")
+            .arg(sparseMap.getZeroBytes() / (1024*1024))
+            .arg(sparseMap.getRanges().size())
+            .arg(zeroPercent);
+    }
+
     resultsLabel->setText(resultsText);
 
     // Show completion message
@@ -518,6 +769,45 @@ void MainWindow::onVerificationComplete(const QMap<QString, bool> &results)
     }
 }
 
+void MainWindow::onQuickProgressUpdate(int percentage, int samplesChecked, int totalSamples)
+{
+    progressBar->setValue(percentage);
+
+    progressLabel->setText(QString("Sampling: %1 / %2 chunks (%3%)")
+        .arg(samplesChecked)
+        .arg(totalSamples)
+        .arg(percentage));
+}
+
+void MainWindow::onQuickVerifyComplete(const QuickVerifyResult &result)
+{
+    // Stay on the loaded file so a full verification can follow
+    setState(STATE_FILE_LOADED);
+    resultsGroup->setVisible(true);
+
+    QString resultsText = "<h3>Quick Check Complete</h3><br>";
+
+    if (result.failures == 0) {
+        resultsText += "<span style='color: green;'><b>✓ Image plausibly intact</b></span><br>";
+        resultsText += QString("  95% confidence that at most %1% of chunks are damaged<br><br>")
+            .arg(result.damageUpperBound * 100.0, 0, 'f', 3);
+    } else {
+        resultsText += QString("<span style='color: red;'><b>✗ %1 damaged chunk(s) found</b></span><br>")
+            .arg(result.failures);
+        resultsText += QString("  First damaged chunk at offset %1<br><br>")
+            .arg(result.failedOffsets.first());
+    }
+
+    resultsText += QString("<b>Sampled:</b> %1 of %2 chunks<br>")
+        .arg(result.samplesChecked)
+        .arg(result.totalChunks);
+    resultsText += QString("<b>Seed:</b> %1<br>").arg(result.seed);
+    resultsText += QString("<b>Elapsed:</b> %1 s<br>").arg(result.elapsedMs / 1000.0, 0, 'f', 1);
+    resultsText += "<br>Run a full verification to confirm the stored hashes.";
+
+    resultsLabel->setText(resultsText);
+}
+
 void MainWindow::onHashError(const QString &message)
 {
     onError("Hash calculation error: " + message);
@@ -15,11 +15,13 @@
 #include <QFrame>
 #include <QCheckBox>
 #include <QProgressBar>
+#include <QTimer>
 #include <QDragEnterEvent>
 #include <QDragMoveEvent>
 #include <QDropEvent>
 #include "ewfhandler.h"
 #include "hashengine.h"
+#include "quickverifier.h"
 
 // Forward declarations for future widgets
 // class DropZone;
@@ -35,6 +37,9 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Load an image as if it had been dropped on the window
+    void openFile(const QString &path);
+
     // Application states
     enum ApplicationState {
         STATE_READY,           // Waiting for file input
@@ -47,17 +52,29 @@ private slots:
     // File handling
     void onFileSelected(const QString &path);
     void onStartVerification();
+    void onStartQuickVerify();
     void onCancelVerification();
+    void onPauseVerification();
+
+    // Progress sampled from the hash engine's telemetry
+    void onProgressTimer();
 
     // Hash engine signals
-    void onProgressUpdate(int percentage, qint64 bytesProcessed, qint64 totalBytes);
-    void onTimeEstimate(const QString &remaining);
     void onMD5Calculated(const QString &hash);
     void onSHA1Calculated(const QString &hash);
     void onSHA256Calculated(const QString &hash);
+    void onSparseMapCalculated(const SparseMap &map);
+    void onSimilarityDigestCalculated(const QString &digest);
+    void onSimilarityDigestSkipped(const QString &reason);
+    void onSegmentHashesCalculated(const SegmentHashList &hashes);
+    void onBadRangesFound(const BadRangeMap &map);
     void onVerificationComplete(const QMap<QString, bool> &results);
     void onHashError(const QString &message);
 
+    // Quick verifier signals
+    void onQuickProgressUpdate(int percentage, int samplesChecked, int totalSamples);
+    void onQuickVerifyComplete(const QuickVerifyResult &result);
+
     // General error handling
     void onError(const QString &message);
 
@@ -87,12 +104,20 @@ private:
     QCheckBox *md5CheckBox;
     QCheckBox *sha1CheckBox;
     QCheckBox *sha256CheckBox;
+    QCheckBox *sparseMapCheckBox;
+    QCheckBox *similarityCheckBox;
+    QCheckBox *segmentHashCheckBox;
+    QCheckBox *continueOnErrorCheckBox;
+    QCheckBox *backgroundCheckBox;
     QPushButton *startButton;
+    QPushButton *quickCheckButton;
 
     QGroupBox *progressGroup;
     QProgressBar *progressBar;
     QLabel *progressLabel;
+    QPushButton *pauseButton;
     QPushButton *cancelButton;
+    QTimer *progressTimer;
 
     QGroupBox *resultsGroup;
     QLabel *resultsLabel;
@@ -100,10 +125,12 @@ private:
     // Core components
     EWFHandler *ewfHandler;
     HashEngine *hashEngine;
+    QuickVerifier *quickVerifier;
 
     // State management
     ApplicationState currentState;
     QString currentFilePath;
+    bool networkStorage;
 
     // Calculated and expected hashes
     QString calculatedMD5;
@@ -112,6 +139,19 @@ private:
     QString expectedMD5;
     QString expectedSHA1;
     QString expectedSHA256;
+    QString similarityDigest;
+    QString similarityWarning;
+    SegmentHashList segmentHashes;
+
+    // Unallocated (all-zero) regions from the last run
+    SparseMap sparseMap;
+
+    // Damaged ranges substituted in the last run (continue past errors)
+    BadRangeMap badRangeMap;
+
+    // Constants
+    static const int PROGRESS_INTERVAL_MS = 200;
+    static const int MAX_LISTED_BAD_RANGES = 20;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,320 @@
+/*
+ * E01 Hash Verification Tool
+ * MmapFileIO Implementation
+ */
+
+#include "mmapfileio.h"
+#include "hashdigest.h"
+#include <QDebug>
+#include <QFile>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MmapFileIO::MmapFileIO(libbfio_pool_t *pool, const QVector<Mapping*> &mappings)
+    : pool(pool)
+    , mappings(mappings)
+{
+}
+
+MmapFileIO::~MmapFileIO()
+{
+    freePool(&pool);
+}
+
+MmapFileIO *MmapFileIO::create(char * const filenames[], int fileCount, int maximumOpenHandles)
+{
+    libbfio_pool_t *pool = nullptr;
+    if (libbfio_pool_initialize(&pool, 0, qMax(0, maximumOpenHandles), nullptr) != 1) {
+        return nullptr;
+    }
+
+    // The pool owns every handle appended to it
+    QVector<Mapping*> mappings;
+    for (int i = 0; i < fileCount; ++i) {
+        Mapping *mapping = new Mapping();
+        mapping->path = QByteArray(filenames[i]);
+
+        libbfio_handle_t *handle = createHandle(mapping);
+        int entry = 0;
+        if (handle == nullptr ||
+            libbfio_pool_append_handle(pool, &entry, handle, LIBBFIO_OPEN_READ, nullptr) != 1) {
+            qDebug() << "MmapFileIO: Cannot add" << filenames[i] << "to the pool";
+            if (handle != nullptr) {
+                libbfio_handle_free(&handle, nullptr);
+            }
+            freePool(&pool);
+            return nullptr;
+        }
+        mappings.append(mapping);
+    }
+
+    return new MmapFileIO(pool, mappings);
+}
+
+libbfio_pool_t *MmapFileIO::getPool() const
+{
+    return pool;
+}
+
+void MmapFileIO::setSegmentHashes(bool enable)
+{
+    for (Mapping *mapping : mappings) {
+        delete mapping->digest;
+        mapping->digest = enable ? new HashDigest(true, true, false) : nullptr;
+        mapping->hashed = 0;
+    }
+}
+
+SegmentHashList MmapFileIO::finishSegmentHashes()
+{
+    SegmentHashList results;
+
+    for (Mapping *mapping : mappings) {
+        SegmentHash result;
+        result.path = QFile::decodeName(mapping->path);
+
+        if (mapping->digest == nullptr) {
+            result.error = "Segment hashing was not enabled";
+            results.append(result);
+            continue;
+        }
+
+        // The trailing sections, and anything else the media read did not
+        // reach, are hashed from a temporary mapping
+        intptr_t *ioHandle = reinterpret_cast<intptr_t*>(mapping);
+        bool wasOpen = mapping->opened;
+        if (!wasOpen && openMapping(ioHandle, LIBBFIO_ACCESS_FLAG_READ, nullptr) != 1) {
+            result.error = "Cannot map the segment file";
+        } else {
+            hashTo(mapping, mapping->size);
+            QMap<QString, QString> digests = mapping->digest->finish();
+            result.size = mapping->size;
+            result.md5 = digests.value("MD5");
+            result.sha1 = digests.value("SHA1");
+            if (!wasOpen) {
+                closeMapping(ioHandle, nullptr);
+            }
+        }
+
+        delete mapping->digest;
+        mapping->digest = nullptr;
+        mapping->hashed = 0;
+        results.append(result);
+    }
+
+    return results;
+}
+
+// ===== Private Helper Functions =====
+
+void MmapFileIO::freePool(libbfio_pool_t **pool)
+{
+    if (*pool != nullptr) {
+        libbfio_pool_free(pool, nullptr);
+        *pool = nullptr;
+    }
+}
+
+void MmapFileIO::hashTo(Mapping *mapping, qint64 end)
+{
+    end = qMin(end, mapping->size);
+    if (mapping->digest == nullptr || mapping->data == nullptr || end <= mapping->hashed) {
+        return;
+    }
+
+    mapping->digest->update(reinterpret_cast<const char*>(mapping->data + mapping->hashed),
+                            end - mapping->hashed);
+    mapping->hashed = end;
+}
+
+libbfio_handle_t *MmapFileIO::createHandle(Mapping *mapping)
+{
+    // Managed: libbfio frees the mapping with the handle
+    libbfio_handle_t *handle = nullptr;
+    if (libbfio_handle_initialize(&handle, reinterpret_cast<intptr_t*>(mapping),
+                                  &MmapFileIO::freeMapping, &MmapFileIO::cloneMapping,
+                                  &MmapFileIO::openMapping, &MmapFileIO::closeMapping,
+                                  &MmapFileIO::readMapping, &MmapFileIO::writeMapping,
+                                  &MmapFileIO::seekMapping, &MmapFileIO::mappingExists,
+                                  &MmapFileIO::mappingIsOpen, &MmapFileIO::mappingSize,
+                                  LIBBFIO_FLAG_IO_HANDLE_MANAGED | LIBBFIO_FLAG_IO_HANDLE_CLONE_BY_FUNCTION,
+                                  nullptr) != 1) {
+        delete mapping;
+        return nullptr;
+    }
+
+    return handle;
+}
+
+int MmapFileIO::freeMapping(intptr_t **ioHandle, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+    Mapping *mapping = reinterpret_cast<Mapping*>(*ioHandle);
+    if (mapping != nullptr) {
+        closeMapping(*ioHandle, nullptr);
+        delete mapping->digest;
+        delete mapping;
+        *ioHandle = nullptr;
+    }
+    return 1;
+}
+
+int MmapFileIO::cloneMapping(intptr_t **destination, intptr_t *source, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+
+    // A clone refers to the same file but has its own mapping and offset
+    Mapping *clone = new Mapping();
+    clone->path = reinterpret_cast<Mapping*>(source)->path;
+    *destination = reinterpret_cast<intptr_t*>(clone);
+    return 1;
+}
+
+int MmapFileIO::openMapping(intptr_t *ioHandle, int accessFlags, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+    Mapping *mapping = reinterpret_cast<Mapping*>(ioHandle);
+
+    if ((accessFlags & LIBBFIO_ACCESS_FLAG_WRITE) != 0) {
+        return -1;
+    }
+    if (mapping->opened) {
+        return 1;
+    }
+
+    int fd = ::open(mapping->path.constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return -1;
+    }
+
+    mapping->size = static_cast<qint64>(info.st_size);
+    mapping->offset = 0;
+    mapping->data = nullptr;
+
+    // An empty file cannot be mapped, and needs no mapping
+    if (mapping->size > 0) {
+        void *address = mmap(nullptr, static_cast<size_t>(mapping->size), PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            return -1;
+        }
+        madvise(address, static_cast<size_t>(mapping->size), MADV_SEQUENTIAL);
+        mapping->data = static_cast<const uint8_t*>(address);
+    }
+
+    // The mapping keeps the file referenced
+    ::close(fd);
+    mapping->opened = true;
+    return 1;
+}
+
+int MmapFileIO::closeMapping(intptr_t *ioHandle, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+    Mapping *mapping = reinterpret_cast<Mapping*>(ioHandle);
+
+    if (mapping->data != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping->data), static_cast<size_t>(mapping->size));
+        mapping->data = nullptr;
+    }
+    mapping->opened = false;
+    mapping->offset = 0;
+    return 0;
+}
+
+ssize_t MmapFileIO::readMapping(intptr_t *ioHandle, uint8_t *buffer, size_t size, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+    Mapping *mapping = reinterpret_cast<Mapping*>(ioHandle);
+
+    if (!mapping->opened) {
+        return -1;
+    }
+    if (mapping->offset >= mapping->size) {
+        return 0;
+    }
+
+    qint64 start = mapping->offset;
+    size_t available = static_cast<size_t>(mapping->size - mapping->offset);
+    size_t count = qMin(size, available);
+    memcpy(buffer, mapping->data + mapping->offset, count);
+    mapping->offset += static_cast<qint64>(count);
+
+    // Extend the segment hash over this read; a long jump ahead (the
+    // section scan at open) is left for a later read or for the finish
+    if (mapping->digest != nullptr && start - mapping->hashed <= HASH_GAP_LIMIT) {
+        hashTo(mapping, mapping->offset);
+    }
+    return static_cast<ssize_t>(count);
+}
+
+ssize_t MmapFileIO::writeMapping(intptr_t *ioHandle, const uint8_t *buffer, size_t size, libbfio_error_t **error)
+{
+    Q_UNUSED(ioHandle);
+    Q_UNUSED(buffer);
+    Q_UNUSED(size);
+    Q_UNUSED(error);
+
+    // Read-only
+    return -1;
+}
+
+off64_t MmapFileIO::seekMapping(intptr_t *ioHandle, off64_t offset, int whence, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+    Mapping *mapping = reinterpret_cast<Mapping*>(ioHandle);
+
+    qint64 target;
+    switch (whence) {
+    case SEEK_SET: target = offset; break;
+    case SEEK_CUR: target = mapping->offset + offset; break;
+    case SEEK_END: target = mapping->size + offset; break;
+    default:       return -1;
+    }
+
+    if (target < 0) {
+        return -1;
+    }
+    mapping->offset = target;
+    return static_cast<off64_t>(target);
+}
+
+int MmapFileIO::mappingExists(intptr_t *ioHandle, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+    Mapping *mapping = reinterpret_cast<Mapping*>(ioHandle);
+    return access(mapping->path.constData(), F_OK) == 0 ? 1 : 0;
+}
+
+int MmapFileIO::mappingIsOpen(intptr_t *ioHandle, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+    return reinterpret_cast<Mapping*>(ioHandle)->opened ? 1 : 0;
+}
+
+int MmapFileIO::mappingSize(intptr_t *ioHandle, size64_t *size, libbfio_error_t **error)
+{
+    Q_UNUSED(error);
+    Mapping *mapping = reinterpret_cast<Mapping*>(ioHandle);
+
+    if (mapping->opened) {
+        *size = static_cast<size64_t>(mapping->size);
+        return 1;
+    }
+
+    struct stat info;
+    if (stat(mapping->path.constData(), &info) != 0) {
+        return -1;
+    }
+    *size = static_cast<size64_t>(info.st_size);
+    return 1;
+}
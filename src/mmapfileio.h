@@ -0,0 +1,96 @@
+/*
+ * E01 Hash Verification Tool
+ * MmapFileIO - Memory-mapped libbfio handles for segment files (POSIX)
+ */
+
+#ifndef MMAPFILEIO_H
+#define MMAPFILEIO_H
+
+#include <QByteArray>
+#include <QVector>
+#include <libbfio.h>
+#include "segmenthasher.h"
+
+class HashDigest;
+
+// Custom libbfio file-IO handles backed by read-only memory maps, handed to
+// libewf as a file-IO pool. libewf's reads of segment data become a copy
+// out of the mapping instead of a seek and read() system call each, and
+// MADV_SEQUENTIAL lets the kernel read ahead aggressively. A descriptor is
+// only held while a segment is being mapped, so a pooled segment costs an
+// address-space mapping rather than an open file.
+//
+// A mapped file that is truncated underneath raises SIGBUS, so this is only
+// for finished images on local storage; EWFHandler never uses it for
+// network filesystems.
+//
+// The handles can also hash each segment file (MD5 + SHA1) as libewf reads
+// it: a read extends a per-segment hashed prefix, short gaps (sections
+// libewf read at open) are filled from the mapping, and whatever the media
+// read never reached is hashed in finishSegmentHashes(). The segment files
+// are then read from the disk once, for the media hash and their own.
+//
+// Only built with "qmake CONFIG+=mmap_io" (E01HASHER_MMAP_IO), which also
+// links libbfio; EWFHandler holds it through a forward declaration.
+class MmapFileIO
+{
+public:
+    // One handle per segment; libbfio keeps at most maximumOpenHandles of
+    // them mapped (0 = all). Returns nullptr on failure.
+    static MmapFileIO *create(char * const filenames[], int fileCount, int maximumOpenHandles);
+    ~MmapFileIO();
+
+    // The pool to hand to libewf (owned; free it only after the libewf
+    // handle using it is closed)
+    libbfio_pool_t *getPool() const;
+
+    // Hash every segment file from here on (restarting any hash in
+    // progress), or stop hashing
+    void setSegmentHashes(bool enable);
+
+    // Hash the rest of each segment and return the results in segment
+    // order; hashing stops until setSegmentHashes() is called again
+    SegmentHashList finishSegmentHashes();
+
+private:
+    // libbfio io_handle
+    struct Mapping {
+        QByteArray path;
+        const uint8_t *data = nullptr;
+        qint64 size = 0;
+        qint64 offset = 0;
+        bool opened = false;
+        HashDigest *digest = nullptr;    // Segment hash, while enabled
+        qint64 hashed = 0;               // Length of the hashed prefix
+    };
+
+    MmapFileIO(libbfio_pool_t *pool, const QVector<Mapping*> &mappings);
+    MmapFileIO(const MmapFileIO &) = delete;
+    MmapFileIO &operator=(const MmapFileIO &) = delete;
+
+    // libbfio callbacks
+    static int freeMapping(intptr_t **ioHandle, libbfio_error_t **error);
+    static int cloneMapping(intptr_t **destination, intptr_t *source, libbfio_error_t **error);
+    static int openMapping(intptr_t *ioHandle, int accessFlags, libbfio_error_t **error);
+    static int closeMapping(intptr_t *ioHandle, libbfio_error_t **error);
+    static ssize_t readMapping(intptr_t *ioHandle, uint8_t *buffer, size_t size, libbfio_error_t **error);
+    static ssize_t writeMapping(intptr_t *ioHandle, const uint8_t *buffer, size_t size, libbfio_error_t **error);
+    static off64_t seekMapping(intptr_t *ioHandle, off64_t offset, int whence, libbfio_error_t **error);
+    static int mappingExists(intptr_t *ioHandle, libbfio_error_t **error);
+    static int mappingIsOpen(intptr_t *ioHandle, libbfio_error_t **error);
+    static int mappingSize(intptr_t *ioHandle, size64_t *size, libbfio_error_t **error);
+
+    static libbfio_handle_t *createHandle(Mapping *mapping);
+    static void freePool(libbfio_pool_t **pool);
+    static void hashTo(Mapping *mapping, qint64 end);
+
+    libbfio_pool_t *pool;
+
+    // The pool's own handles, in segment order (owned by the pool)
+    QVector<Mapping*> mappings;
+
+    // Constants
+    static const qint64 HASH_GAP_LIMIT = 16 * 1024 * 1024;  // Larger jumps are not filled in
+};
+
+#endif // MMAPFILEIO_H
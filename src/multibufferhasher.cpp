@@ -0,0 +1,951 @@
+/*
+ * E01 Hash Verification Tool
+ * MultiBufferHasher Implementation
+ */
+
+#include "multibufferhasher.h"
+#include "hashdigest.h"
+#include "hashkernel.h"
+#include <QDebug>
+#include <QThread>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <cstring>
+
+#ifndef _WIN32
+#include <openssl/sha.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define MULTIBUFFER_AVX2 1
+    #include <immintrin.h>
+    #include <cpuid.h>
+    #define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+const quint32 SHA1_INITIAL[5] = {
+    0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+const quint32 SHA1_K[4] = {
+    0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6
+};
+
+const quint32 SHA256_INITIAL[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const quint32 SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline quint32 rotl(quint32 x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+inline quint32 rotr(quint32 x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+inline quint32 loadBigEndian(const unsigned char *p)
+{
+    return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | quint32(p[3]);
+}
+
+// ----- Scalar compression (one stream where OpenSSL is not available) -----
+
+#ifdef _WIN32
+
+void sha1Blocks(quint32 *state, const unsigned char *data, qint64 blocks)
+{
+    quint32 w[16];
+    for (qint64 block = 0; block < blocks; ++block, data += 64) {
+        quint32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int t = 0; t < 80; ++t) {
+            if (t < 16) {
+                w[t] = loadBigEndian(data + t * 4);
+            } else {
+                w[t & 15] = rotl(w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15], 1);
+            }
+
+            quint32 f;
+            if (t < 20) {
+                f = (b & c) | (~b & d);
+            } else if (t < 40 || t >= 60) {
+                f = b ^ c ^ d;
+            } else {
+                f = (b & c) | (b & d) | (c & d);
+            }
+
+            quint32 temp = rotl(a, 5) + f + e + SHA1_K[t / 20] + w[t & 15];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = temp;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+
+void sha256Blocks(quint32 *state, const unsigned char *data, qint64 blocks)
+{
+    quint32 w[16];
+    for (qint64 block = 0; block < blocks; ++block, data += 64) {
+        quint32 a = state[0], b = state[1], c = state[2], d = state[3];
+        quint32 e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            if (t < 16) {
+                w[t] = loadBigEndian(data + t * 4);
+            } else {
+                quint32 w15 = w[(t - 15) & 15];
+                quint32 w2 = w[(t - 2) & 15];
+                quint32 s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+                quint32 s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+                w[t & 15] += s0 + w[(t - 7) & 15] + s1;
+            }
+
+            quint32 t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g))
+                         + SHA256_K[t] + w[t & 15];
+            quint32 t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#endif // _WIN32
+
+// One stream: OpenSSL's block function (SHA extensions / AVX2 where the
+// CPU has them), resumed from the stream's state and left in it. The
+// CryptoAPI cannot be resumed from a raw state, so Windows builds use the
+// scalar functions above.
+void compressBlocks(MultiBufferHasher::Algorithm algorithm, quint32 *state,
+                    const unsigned char *data, qint64 blocks)
+{
+#ifndef _WIN32
+    if (algorithm == MultiBufferHasher::SHA256) {
+        SHA256_CTX context;
+        memcpy(context.h, state, 8 * sizeof(quint32));
+        for (qint64 block = 0; block < blocks; ++block) {
+            SHA256_Transform(&context, data + block * 64);
+        }
+        memcpy(state, context.h, 8 * sizeof(quint32));
+    } else {
+        SHA_CTX context;
+        context.h0 = state[0];
+        context.h1 = state[1];
+        context.h2 = state[2];
+        context.h3 = state[3];
+        context.h4 = state[4];
+        for (qint64 block = 0; block < blocks; ++block) {
+            SHA1_Transform(&context, data + block * 64);
+        }
+        state[0] = context.h0;
+        state[1] = context.h1;
+        state[2] = context.h2;
+        state[3] = context.h3;
+        state[4] = context.h4;
+    }
+#else
+    if (algorithm == MultiBufferHasher::SHA256) {
+        sha256Blocks(state, data, blocks);
+    } else {
+        sha1Blocks(state, data, blocks);
+    }
+#endif
+}
+
+// ----- AVX2 compression (LANE_COUNT streams, one per 32-bit element) -----
+
+#ifdef MULTIBUFFER_AVX2
+
+template<int N>
+AVX2_TARGET inline __m256i rotlLanes(__m256i x)
+{
+    return _mm256_or_si256(_mm256_slli_epi32(x, N), _mm256_srli_epi32(x, 32 - N));
+}
+
+template<int N>
+AVX2_TARGET inline __m256i rotrLanes(__m256i x)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+}
+
+AVX2_TARGET inline __m256i add3(__m256i a, __m256i b, __m256i c)
+{
+    return _mm256_add_epi32(_mm256_add_epi32(a, b), c);
+}
+
+// Word `offset` of every lane's current block
+AVX2_TARGET inline __m256i loadLaneWords(const unsigned char *const *data, int offset)
+{
+    return _mm256_setr_epi32(static_cast<int>(loadBigEndian(data[0] + offset)),
+                             static_cast<int>(loadBigEndian(data[1] + offset)),
+                             static_cast<int>(loadBigEndian(data[2] + offset)),
+                             static_cast<int>(loadBigEndian(data[3] + offset)),
+                             static_cast<int>(loadBigEndian(data[4] + offset)),
+                             static_cast<int>(loadBigEndian(data[5] + offset)),
+                             static_cast<int>(loadBigEndian(data[6] + offset)),
+                             static_cast<int>(loadBigEndian(data[7] + offset)));
+}
+
+// State word `index` of every lane, and back
+AVX2_TARGET inline __m256i loadLaneState(quint32 *const *states, int index)
+{
+    return _mm256_setr_epi32(static_cast<int>(states[0][index]), static_cast<int>(states[1][index]),
+                             static_cast<int>(states[2][index]), static_cast<int>(states[3][index]),
+                             static_cast<int>(states[4][index]), static_cast<int>(states[5][index]),
+                             static_cast<int>(states[6][index]), static_cast<int>(states[7][index]));
+}
+
+AVX2_TARGET inline void storeLaneState(quint32 *const *states, int index, __m256i value)
+{
+    alignas(32) quint32 words[MultiBufferHasher::LANE_COUNT];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words), value);
+    for (int lane = 0; lane < MultiBufferHasher::LANE_COUNT; ++lane) {
+        states[lane][index] = words[lane];
+    }
+}
+
+AVX2_TARGET void sha1LaneBlocks(quint32 *const *states, const unsigned char **data, qint64 blocks)
+{
+    __m256i state[5];
+    for (int i = 0; i < 5; ++i) {
+        state[i] = loadLaneState(states, i);
+    }
+
+    __m256i w[16];
+    for (qint64 block = 0; block < blocks; ++block) {
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int t = 0; t < 80; ++t) {
+            if (t < 16) {
+                w[t] = loadLaneWords(data, t * 4);
+            } else {
+                w[t & 15] = rotlLanes<1>(_mm256_xor_si256(_mm256_xor_si256(w[(t - 3) & 15], w[(t - 8) & 15]),
+                                                          _mm256_xor_si256(w[(t - 14) & 15], w[t & 15])));
+            }
+
+            __m256i f;
+            if (t < 20) {
+                f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_andnot_si256(b, d));
+            } else if (t < 40 || t >= 60) {
+                f = _mm256_xor_si256(_mm256_xor_si256(b, c), d);
+            } else {
+                f = _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+            }
+
+            __m256i temp = add3(rotlLanes<5>(a), f, e);
+            temp = add3(temp, _mm256_set1_epi32(static_cast<int>(SHA1_K[t / 20])), w[t & 15]);
+            e = d;
+            d = c;
+            c = rotlLanes<30>(b);
+            b = a;
+            a = temp;
+        }
+        state[0] = _mm256_add_epi32(state[0], a);
+        state[1] = _mm256_add_epi32(state[1], b);
+        state[2] = _mm256_add_epi32(state[2], c);
+        state[3] = _mm256_add_epi32(state[3], d);
+        state[4] = _mm256_add_epi32(state[4], e);
+
+        for (int lane = 0; lane < MultiBufferHasher::LANE_COUNT; ++lane) {
+            data[lane] += 64;
+        }
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        storeLaneState(states, i, state[i]);
+    }
+}
+
+AVX2_TARGET void sha256LaneBlocks(quint32 *const *states, const unsigned char **data, qint64 blocks)
+{
+    __m256i state[8];
+    for (int i = 0; i < 8; ++i) {
+        state[i] = loadLaneState(states, i);
+    }
+
+    __m256i w[16];
+    for (qint64 block = 0; block < blocks; ++block) {
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; ++t) {
+            if (t < 16) {
+                w[t] = loadLaneWords(data, t * 4);
+            } else {
+                __m256i w15 = w[(t - 15) & 15];
+                __m256i w2 = w[(t - 2) & 15];
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotrLanes<7>(w15), rotrLanes<18>(w15)),
+                                              _mm256_srli_epi32(w15, 3));
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotrLanes<17>(w2), rotrLanes<19>(w2)),
+                                              _mm256_srli_epi32(w2, 10));
+                w[t & 15] = _mm256_add_epi32(add3(w[t & 15], s0, w[(t - 7) & 15]), s1);
+            }
+
+            __m256i bigSigma1 = _mm256_xor_si256(_mm256_xor_si256(rotrLanes<6>(e), rotrLanes<11>(e)),
+                                                 rotrLanes<25>(e));
+            __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            __m256i t1 = add3(h, bigSigma1, choose);
+            t1 = add3(t1, _mm256_set1_epi32(static_cast<int>(SHA256_K[t])), w[t & 15]);
+
+            __m256i bigSigma0 = _mm256_xor_si256(_mm256_xor_si256(rotrLanes<2>(a), rotrLanes<13>(a)),
+                                                 rotrLanes<22>(a));
+            __m256i majority = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+            __m256i t2 = _mm256_add_epi32(bigSigma0, majority);
+
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = _mm256_add_epi32(t1, t2);
+        }
+        state[0] = _mm256_add_epi32(state[0], a);
+        state[1] = _mm256_add_epi32(state[1], b);
+        state[2] = _mm256_add_epi32(state[2], c);
+        state[3] = _mm256_add_epi32(state[3], d);
+        state[4] = _mm256_add_epi32(state[4], e);
+        state[5] = _mm256_add_epi32(state[5], f);
+        state[6] = _mm256_add_epi32(state[6], g);
+        state[7] = _mm256_add_epi32(state[7], h);
+
+        for (int lane = 0; lane < MultiBufferHasher::LANE_COUNT; ++lane) {
+            data[lane] += 64;
+        }
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        storeLaneState(states, i, state[i]);
+    }
+}
+
+#endif // MULTIBUFFER_AVX2
+
+}
+
+// ===== Stream =====
+
+MultiBufferHasher::Stream::Stream(Algorithm algorithm)
+    : Stream(algorithm, nullptr)
+{
+}
+
+MultiBufferHasher::Stream::Stream(Algorithm algorithm, LaneSet *set)
+    : algorithm(algorithm)
+    , laneSet(MultiBufferHasher::instance().attach(algorithm, set))
+    , partialSize(0)
+    , totalBytes(0)
+    , queued(false)
+{
+    if (algorithm == SHA256) {
+        memcpy(state, SHA256_INITIAL, sizeof(SHA256_INITIAL));
+    } else {
+        memset(state, 0, sizeof(state));
+        memcpy(state, SHA1_INITIAL, sizeof(SHA1_INITIAL));
+    }
+}
+
+MultiBufferHasher::Stream::~Stream()
+{
+    // Another caller may still be hashing from this stream's buffer
+    wait();
+    MultiBufferHasher::instance().detach(laneSet);
+}
+
+void MultiBufferHasher::Stream::submit(const char *data, qint64 size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char*>(data);
+    request = Request();
+    totalBytes += static_cast<quint64>(size);
+
+    // Top up the partial block left by the previous buffer; once full it
+    // is hashed from its own copy, ahead of this buffer's blocks
+    if (partialSize > 0) {
+        qint64 take = qMin<qint64>(64 - partialSize, size);
+        memcpy(partial + partialSize, bytes, static_cast<size_t>(take));
+        partialSize += static_cast<int>(take);
+        bytes += take;
+        size -= take;
+        if (partialSize == 64) {
+            memcpy(head, partial, 64);
+            request.data[0] = head;
+            request.blocks[0] = 1;
+            partialSize = 0;
+        }
+    }
+
+    qint64 wholeBlocks = size / 64;
+    if (wholeBlocks > 0) {
+        request.data[1] = bytes;
+        request.blocks[1] = wholeBlocks;
+    }
+
+    qint64 tail = size - wholeBlocks * 64;
+    if (tail > 0) {
+        memcpy(partial + partialSize, bytes + wholeBlocks * 64, static_cast<size_t>(tail));
+        partialSize += static_cast<int>(tail);
+    }
+
+    if (request.blocks[0] + request.blocks[1] > 0) {
+        request.done = false;
+        queued = true;
+        MultiBufferHasher::instance().enqueue(this);
+    }
+}
+
+void MultiBufferHasher::Stream::wait()
+{
+    if (queued) {
+        MultiBufferHasher::instance().drive(this);
+        queued = false;
+    }
+}
+
+QByteArray MultiBufferHasher::Stream::finish()
+{
+    wait();
+
+    // 0x80, zeros, then the message length in bits (big-endian), filling
+    // one block or two when the length no longer fits after the data
+    unsigned char padding[128];
+    memset(padding, 0, sizeof(padding));
+    memcpy(padding, partial, static_cast<size_t>(partialSize));
+    padding[partialSize] = 0x80;
+    int paddedSize = partialSize < 56 ? 64 : 128;
+    quint64 bits = totalBytes * 8;
+    for (int i = 0; i < 8; ++i) {
+        padding[paddedSize - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    compressBlocks(algorithm, state, padding, paddedSize / 64);
+    partialSize = 0;
+
+    int words = algorithm == SHA256 ? 8 : 5;
+    QByteArray digest(words * 4, Qt::Uninitialized);
+    for (int i = 0; i < words; ++i) {
+        digest[i * 4] = static_cast<char>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<char>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<char>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<char>(state[i]);
+    }
+    return digest;
+}
+
+// ===== Lane Sets =====
+
+MultiBufferHasher &MultiBufferHasher::instance()
+{
+    static MultiBufferHasher hasher;
+    return hasher;
+}
+
+MultiBufferHasher::MultiBufferHasher()
+    : laneSetLimit(qMax(1, QThread::idealThreadCount()))
+    , blocksHashed(0)
+    , blockSteps(0)
+{
+}
+
+MultiBufferHasher::~MultiBufferHasher()
+{
+    qDeleteAll(sha1Sets);
+    qDeleteAll(sha256Sets);
+}
+
+bool MultiBufferHasher::isSupported()
+{
+    // Lanes that have not reproduced the reference digests in this
+    // process are never given evidence to hash
+    static const bool supported = []() {
+        if (!hasAvx2()) {
+            return false;
+        }
+        QString failure;
+        if (!selfTest(&failure)) {
+            qDebug() << "MultiBufferHasher: Self-test failed, lanes disabled:" << failure;
+            return false;
+        }
+        return true;
+    }();
+    return supported;
+}
+
+bool MultiBufferHasher::selfTest(QString *failure)
+{
+    // Each stream gets its message in pieces of its own size; every stream
+    // is submitted before any is waited on, so the lanes run together
+    auto hashTogether = [](const QList<Stream*> &streams, const QList<QByteArray> &messages,
+                           const QList<qint64> &pieceSizes) {
+        QList<qint64> offsets;
+        for (int i = 0; i < streams.size(); ++i) {
+            offsets.append(0);
+        }
+
+        bool pending = true;
+        while (pending) {
+            pending = false;
+            for (int i = 0; i < streams.size(); ++i) {
+                qint64 size = qMin(pieceSizes[i], messages[i].size() - offsets[i]);
+                if (size > 0) {
+                    streams[i]->submit(messages[i].constData() + offsets[i], size);
+                    offsets[i] += size;
+                    pending = true;
+                }
+            }
+            for (Stream *stream : streams) {
+                stream->wait();
+            }
+        }
+
+        QStringList digests;
+        for (Stream *stream : streams) {
+            digests.append(QString::fromLatin1(stream->finish().toHex()));
+        }
+        return digests;
+    };
+
+    // More streams than lanes, so lanes are retired and refilled mid-run
+    const int sharedCount = LANE_COUNT + 3;
+    const Algorithm algorithms[] = { SHA1, SHA256 };
+
+    // FIPS 180 examples: empty, one block, padding spilling into a second
+    // block, and a long message
+    struct Vector {
+        const char *label;
+        QByteArray message;
+        const char *sha1;
+        const char *sha256;
+    };
+    const Vector vectors[] = {
+        { "empty message", QByteArray(),
+          "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+          "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "\"abc\"", QByteArray("abc"),
+          "a9993e364706816aba3e25717850c26c9cd0d89d",
+          "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "448-bit message", QByteArray("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+          "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { "one million \"a\"", QByteArray(1000000, 'a'),
+          "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+          "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" }
+    };
+
+    for (Algorithm algorithm : algorithms) {
+        const QString name = algorithm == SHA256 ? "SHA256" : "SHA1";
+        LaneSet *loneSet = MultiBufferHasher::instance().reserveLaneSet(algorithm);
+        LaneSet *sharedSet = MultiBufferHasher::instance().reserveLaneSet(algorithm);
+
+        for (const Vector &vector : vectors) {
+            const QString expected = QString::fromLatin1(algorithm == SHA256 ? vector.sha256 : vector.sha1);
+
+            // Alone in its set (OpenSSL's block function), in one piece
+            Stream lone(algorithm, loneSet);
+            lone.submit(vector.message.constData(), vector.message.size());
+            if (QString::fromLatin1(lone.finish().toHex()) != expected) {
+                if (failure) {
+                    *failure = QString("%1 of the %2, one stream").arg(name, vector.label);
+                }
+                return false;
+            }
+
+            // Sharing a set, in pieces of 1, 8, 15, ... bytes (fewer, larger
+            // pieces for the long message)
+            QList<Stream*> streams;
+            QList<QByteArray> messages;
+            QList<qint64> pieceSizes;
+            for (int i = 0; i < sharedCount; ++i) {
+                streams.append(new Stream(algorithm, sharedSet));
+                messages.append(vector.message);
+                pieceSizes.append(qMax<qint64>(1 + i * 7, vector.message.size() / 64 + i * 13));
+            }
+            const QStringList digests = hashTogether(streams, messages, pieceSizes);
+            qDeleteAll(streams);
+            for (int i = 0; i < digests.size(); ++i) {
+                if (digests[i] != expected) {
+                    if (failure) {
+                        *failure = QString("%1 of the %2, stream %3 of %4 sharing lanes")
+                            .arg(name, vector.label).arg(i + 1).arg(sharedCount);
+                    }
+                    return false;
+                }
+            }
+        }
+
+        // Uneven lengths and unaligned buffers, against the platform's
+        // own implementation
+        const QByteArray pool = HashKernel::makeBenchPool(4 * 1024 * 1024);
+        QList<Stream*> streams;
+        QList<QByteArray> messages;
+        QList<qint64> pieceSizes;
+        for (int i = 0; i < sharedCount; ++i) {
+            streams.append(new Stream(algorithm, sharedSet));
+            messages.append(pool.mid(i * 4099 + i % 3, 256 * 1024 * (1 + i % 4) + i * 977));
+            pieceSizes.append(i % 3 == 0 ? 63 + i : 64 * 1024 + i * 4099);
+        }
+        const QStringList digests = hashTogether(streams, messages, pieceSizes);
+        qDeleteAll(streams);
+        for (int i = 0; i < digests.size(); ++i) {
+            HashDigest reference(false, algorithm == SHA1, algorithm == SHA256);
+            if (!reference.isValid()) {
+                if (failure) {
+                    *failure = "the platform crypto provider could not be opened";
+                }
+                return false;
+            }
+            reference.update(messages[i]);
+            if (digests[i] != reference.finish().value(name)) {
+                if (failure) {
+                    *failure = QString("%1 of a %2-byte message, stream %3 of %4 sharing lanes, "
+                                       "against the platform implementation")
+                        .arg(name).arg(messages[i].size()).arg(i + 1).arg(sharedCount);
+                }
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool MultiBufferHasher::hasShaExtensions()
+{
+#ifdef MULTIBUFFER_AVX2
+    // CPUID leaf 7, EBX bit 29
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29)) != 0;
+#else
+    return false;
+#endif
+}
+
+QList<MultiBufferBenchResult> MultiBufferHasher::benchmark(qint64 bytesPerStream)
+{
+    const QByteArray pool = HashKernel::makeBenchPool(bytesPerStream);
+    const Algorithm algorithms[] = { SHA1, SHA256 };
+    const int streamCounts[] = { 1, 2, 4, 8, 16 };
+
+    QList<MultiBufferBenchResult> results;
+    for (Algorithm algorithm : algorithms) {
+        for (int streams : streamCounts) {
+            results.append(benchmarkStreams(algorithm, streams, pool, bytesPerStream));
+        }
+    }
+    return results;
+}
+
+qint64 MultiBufferHasher::getBlocksHashed() const
+{
+    QMutexLocker locker(&mutex);
+    return blocksHashed;
+}
+
+qint64 MultiBufferHasher::getBlockSteps() const
+{
+    QMutexLocker locker(&mutex);
+    return blockSteps;
+}
+
+// ===== Private Helper Functions =====
+
+MultiBufferHasher::LaneSet *MultiBufferHasher::attach(Algorithm algorithm, LaneSet *set)
+{
+    QMutexLocker locker(&mutex);
+
+    // Only one caller drives a set at a time: spread streams over up to
+    // one set per core, and share a set only once they outnumber the cores
+    if (!set) {
+        LaneSet *idle = nullptr;
+        LaneSet *leastLoaded = nullptr;
+        int inUse = 0;
+        for (LaneSet *candidate : algorithm == SHA256 ? sha256Sets : sha1Sets) {
+            if (candidate->streams == 0) {
+                idle = idle ? idle : candidate;
+            } else {
+                ++inUse;
+                if (!leastLoaded || candidate->streams < leastLoaded->streams) {
+                    leastLoaded = candidate;
+                }
+            }
+        }
+
+        if (leastLoaded && inUse >= laneSetLimit && leastLoaded->streams < LANE_COUNT) {
+            set = leastLoaded;
+        } else {
+            set = idle ? idle : createLaneSet(algorithm);
+        }
+    }
+
+    ++set->streams;
+    return set;
+}
+
+MultiBufferHasher::LaneSet *MultiBufferHasher::reserveLaneSet(Algorithm algorithm)
+{
+    QMutexLocker locker(&mutex);
+    return createLaneSet(algorithm);
+}
+
+MultiBufferHasher::LaneSet *MultiBufferHasher::createLaneSet(Algorithm algorithm)
+{
+    // Called with mutex held; sets live as long as the hasher and are
+    // reused once their streams are gone
+    LaneSet *set = new LaneSet;
+    set->algorithm = algorithm;
+    for (int lane = 0; lane < LANE_COUNT; ++lane) {
+        set->lanes[lane] = nullptr;
+        set->segment[lane] = 0;
+    }
+    set->streams = 0;
+    set->driving = false;
+
+    (algorithm == SHA256 ? sha256Sets : sha1Sets).append(set);
+    return set;
+}
+
+void MultiBufferHasher::detach(LaneSet *set)
+{
+    QMutexLocker locker(&mutex);
+    --set->streams;
+}
+
+void MultiBufferHasher::enqueue(Stream *stream)
+{
+    QMutexLocker locker(&mutex);
+    stream->laneSet->queue.enqueue(stream);
+}
+
+void MultiBufferHasher::drive(const Stream *stream)
+{
+    QMutexLocker locker(&mutex);
+    LaneSet &set = *stream->laneSet;
+
+    while (!stream->request.done) {
+        // Another caller's pass may finish this request too
+        if (set.driving) {
+            set.passDone.wait(&mutex);
+            continue;
+        }
+
+        // Run passes on this thread, taking in whatever the other streams
+        // of the set have queued, until this stream's buffer is consumed
+        set.driving = true;
+        fillLanes(set);
+
+        // The lanes belong to the driving caller; only the queue needs the lock
+        locker.unlock();
+        qint64 steps = 0;
+        qint64 blocks = runLanes(set, steps);
+        locker.relock();
+
+        blocksHashed += blocks;
+        blockSteps += steps;
+
+        retireLanes(set);
+        set.driving = false;
+        set.passDone.wakeAll();
+    }
+}
+
+void MultiBufferHasher::fillLanes(LaneSet &set)
+{
+    for (int lane = 0; lane < LANE_COUNT && !set.queue.isEmpty(); ++lane) {
+        if (!set.lanes[lane]) {
+            Stream *stream = set.queue.dequeue();
+            set.lanes[lane] = stream;
+            set.segment[lane] = stream->request.blocks[0] > 0 ? 0 : 1;
+        }
+    }
+}
+
+qint64 MultiBufferHasher::runLanes(LaneSet &set, qint64 &steps)
+{
+    // Every lane advances by the same number of blocks: up to the end of
+    // the shortest run, so that lane can be handed back right after
+    int active = 0;
+    int firstLane = -1;
+    qint64 passBlocks = MAX_BLOCKS_PER_PASS;
+    for (int lane = 0; lane < LANE_COUNT; ++lane) {
+        if (set.lanes[lane]) {
+            passBlocks = qMin(passBlocks, set.lanes[lane]->request.blocks[set.segment[lane]]);
+            if (firstLane < 0) {
+                firstLane = lane;
+            }
+            ++active;
+        }
+    }
+
+    if (active == 0) {
+        return 0;
+    }
+
+    const bool shared = active > 1 && hasAvx2();
+#ifdef MULTIBUFFER_AVX2
+    if (shared) {
+        // Empty lanes hash a copy of a busy lane's data into scratch state
+        quint32 scratch[LANE_COUNT][8];
+        quint32 *states[LANE_COUNT];
+        const unsigned char *data[LANE_COUNT];
+        const Stream::Request &first = set.lanes[firstLane]->request;
+        for (int lane = 0; lane < LANE_COUNT; ++lane) {
+            if (set.lanes[lane]) {
+                states[lane] = set.lanes[lane]->state;
+                data[lane] = set.lanes[lane]->request.data[set.segment[lane]];
+            } else {
+                memset(scratch[lane], 0, sizeof(scratch[lane]));
+                states[lane] = scratch[lane];
+                data[lane] = first.data[set.segment[firstLane]];
+            }
+        }
+
+        if (set.algorithm == SHA256) {
+            sha256LaneBlocks(states, data, passBlocks);
+        } else {
+            sha1LaneBlocks(states, data, passBlocks);
+        }
+    } else
+#endif
+    {
+        for (int lane = 0; lane < LANE_COUNT; ++lane) {
+            if (set.lanes[lane]) {
+                Stream *stream = set.lanes[lane];
+                compressBlocks(set.algorithm, stream->state,
+                               stream->request.data[set.segment[lane]], passBlocks);
+            }
+        }
+    }
+
+    for (int lane = 0; lane < LANE_COUNT; ++lane) {
+        if (set.lanes[lane]) {
+            Stream::Request &request = set.lanes[lane]->request;
+            request.data[set.segment[lane]] += passBlocks * 64;
+            request.blocks[set.segment[lane]] -= passBlocks;
+        }
+    }
+
+    // One-stream passes run one lane per step
+    steps += shared ? passBlocks : passBlocks * active;
+    return passBlocks * active;
+}
+
+void MultiBufferHasher::retireLanes(LaneSet &set)
+{
+    for (int lane = 0; lane < LANE_COUNT; ++lane) {
+        Stream *stream = set.lanes[lane];
+        if (!stream) {
+            continue;
+        }
+
+        while (set.segment[lane] < 2 && stream->request.blocks[set.segment[lane]] == 0) {
+            ++set.segment[lane];
+        }
+        if (set.segment[lane] == 2) {
+            stream->request.done = true;
+            set.lanes[lane] = nullptr;
+        }
+    }
+}
+
+int MultiBufferHasher::laneSetsFor(int streams) const
+{
+    // What attach() opens for this many streams arriving together
+    return qMax(qMin(streams, laneSetLimit), (streams + LANE_COUNT - 1) / LANE_COUNT);
+}
+
+bool MultiBufferHasher::hasAvx2()
+{
+#ifdef MULTIBUFFER_AVX2
+    static const bool available = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+    return available;
+#else
+    return false;
+#endif
+}
+
+MultiBufferBenchResult MultiBufferHasher::benchmarkStreams(Algorithm algorithm, int streams,
+                                                           const QByteArray &pool, qint64 bytesPerStream)
+{
+    // Every thread hashes bytesPerStream in 1MB reads, starting its own
+    // number of reads into the pool and wrapping, so the lanes of a set
+    // do not all read the same cache lines
+    const qint64 poolChunks = qMax<qint64>(1, pool.size() / BENCH_CHUNK_SIZE);
+    auto hashAll = [&](bool lanes) {
+        QList<QThread*> threads;
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int i = 0; i < streams; ++i) {
+            threads.append(QThread::create([&, i]() {
+                Stream *stream = lanes ? new Stream(algorithm) : nullptr;
+                HashDigest *digest = lanes ? nullptr : new HashDigest(false, algorithm == SHA1, algorithm == SHA256);
+                for (qint64 done = 0, chunk = i; done < bytesPerStream; done += BENCH_CHUNK_SIZE, ++chunk) {
+                    const char *data = pool.constData() + (chunk % poolChunks) * BENCH_CHUNK_SIZE;
+                    qint64 size = qMin(BENCH_CHUNK_SIZE, bytesPerStream - done);
+                    if (stream) {
+                        stream->submit(data, size);
+                        stream->wait();
+                    } else {
+                        digest->update(data, size);
+                    }
+                }
+                if (stream) {
+                    stream->finish();
+                } else {
+                    digest->finish();
+                }
+                delete stream;
+                delete digest;
+            }));
+            threads.last()->start();
+        }
+
+        for (QThread *thread : threads) {
+            thread->wait();
+        }
+        qDeleteAll(threads);
+
+        double seconds = qMax(timer.nsecsElapsed(), Q_INT64_C(1)) / 1e9;
+        return (static_cast<double>(bytesPerStream) * streams / (1024.0 * 1024.0)) / seconds;
+    };
+
+    MultiBufferBenchResult result;
+    result.algorithm = algorithm == SHA256 ? "SHA256" : "SHA1";
+    result.streams = streams;
+    result.laneSets = MultiBufferHasher::instance().laneSetsFor(streams);
+    result.lanesMBps = hashAll(true);
+    result.perJobMBps = hashAll(false);
+    return result;
+}
@@ -0,0 +1,169 @@
+/*
+ * E01 Hash Verification Tool
+ * MultiBufferHasher - Shared SHA-1 / SHA-256 lanes for concurrent jobs
+ */
+
+#ifndef MULTIBUFFERHASHER_H
+#define MULTIBUFFERHASHER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QList>
+#include <QString>
+#include <QByteArray>
+
+// Throughput of one algorithm at one stream count: every stream through
+// the shared lanes, and every stream on its own platform context
+struct MultiBufferBenchResult
+{
+    QString algorithm;
+    int streams;
+    int laneSets;
+    double lanesMBps;
+    double perJobMBps;
+};
+
+// SHA-1 and SHA-256 are serial within one stream: every 64-byte block
+// depends on the state left by the one before, so a single stream cannot
+// use wide vector registers. Independent streams can. A lane set holds
+// LANE_COUNT lanes of one algorithm and advances them together with one
+// AVX2 instruction stream, each 32-bit element of a register belonging to
+// a different job. There is no service thread: a job submits its buffer
+// and, when it waits, drives its lane set itself until its own buffer is
+// consumed, hashing whatever the other jobs of the set have queued along
+// the way (the submit / flush scheme of multi-buffer crypto libraries).
+// Only one caller drives a set at a time, so streams are spread over up
+// to one set per core and share a set only once the jobs outnumber the
+// cores. A set with one busy stream hands its blocks to OpenSSL's block
+// function, so a lone job hashes as fast as it would on its own.
+//
+// The lanes are only used where isSupported() is true: AVX2 present and
+// selfTest() passed in this process.
+class MultiBufferHasher
+{
+    struct LaneSet;
+
+public:
+    enum Algorithm {
+        SHA1,
+        SHA256
+    };
+
+    // One job's running digest; its thread submits data and waits for it
+    // to be consumed (submit() / wait() may bracket other work)
+    class Stream
+    {
+    public:
+        explicit Stream(Algorithm algorithm);
+        ~Stream();
+
+        // Queue every whole block of data (the buffer must stay valid
+        // until wait() returns); a trailing partial block is kept here
+        void submit(const char *data, qint64 size);
+        void wait();
+
+        // Pad, hash the final blocks and return the digest (the stream
+        // cannot be updated afterwards)
+        QByteArray finish();
+
+    private:
+        friend class MultiBufferHasher;
+
+        // Joins set instead of the least loaded one (self-test)
+        Stream(Algorithm algorithm, LaneSet *set);
+        Stream(const Stream &) = delete;
+        Stream &operator=(const Stream &) = delete;
+
+        // Up to two runs of blocks: a completed partial block, then the
+        // whole blocks of the submitted buffer
+        struct Request {
+            const unsigned char *data[2] = { nullptr, nullptr };
+            qint64 blocks[2] = { 0, 0 };
+            bool done = true;
+        };
+
+        Algorithm algorithm;
+        LaneSet *laneSet;
+        quint32 state[8];
+        unsigned char partial[64];
+        unsigned char head[64];
+        int partialSize;
+        quint64 totalBytes;
+        bool queued;
+        Request request;
+    };
+
+    static MultiBufferHasher &instance();
+
+    // AVX2 kernels compiled in, the CPU has AVX2 and selfTest() passed
+    // (run once, on first call)
+    static bool isSupported();
+
+    // Known-answer vectors through lone and shared lanes, then uneven
+    // concurrent streams cross-checked against HashDigest (OpenSSL /
+    // CryptoAPI); the failing case is described in failure
+    static bool selfTest(QString *failure = nullptr);
+
+    // The CPU has the SHA instruction extensions, which OpenSSL uses for
+    // one stream at a time; those usually outrun the shared lanes
+    static bool hasShaExtensions();
+
+    // Aggregate MB/s of 1, 2, 4, 8 and 16 threads each hashing the same
+    // fixed-seed pool from a different offset, through Streams and then
+    // through HashDigest, for SHA-1 and SHA-256
+    static QList<MultiBufferBenchResult> benchmark(qint64 bytesPerStream = DEFAULT_BENCH_STREAM_SIZE);
+
+    // 64-byte blocks hashed, and lockstep block steps taken; their ratio
+    // is the average number of lanes busy (1 when streams ran alone)
+    qint64 getBlocksHashed() const;
+    qint64 getBlockSteps() const;
+
+    // Constants
+    static const int LANE_COUNT = 8;    // 32-bit words per AVX2 register
+    static const qint64 DEFAULT_BENCH_STREAM_SIZE = 32 * 1024 * 1024;
+
+private:
+    MultiBufferHasher();
+    ~MultiBufferHasher();
+
+    // A free lane has no stream; streams counts the Streams attached
+    struct LaneSet {
+        Algorithm algorithm;
+        Stream *lanes[LANE_COUNT];
+        int segment[LANE_COUNT];
+        QQueue<Stream*> queue;
+        int streams;
+        bool driving;
+        QWaitCondition passDone;
+    };
+
+    LaneSet *attach(Algorithm algorithm, LaneSet *set);
+    LaneSet *reserveLaneSet(Algorithm algorithm);
+    LaneSet *createLaneSet(Algorithm algorithm);
+    void detach(LaneSet *set);
+    void enqueue(Stream *stream);
+    void drive(const Stream *stream);
+    void fillLanes(LaneSet &set);
+    qint64 runLanes(LaneSet &set, qint64 &steps);
+    void retireLanes(LaneSet &set);
+    int laneSetsFor(int streams) const;
+    static bool hasAvx2();
+    static MultiBufferBenchResult benchmarkStreams(Algorithm algorithm, int streams, const QByteArray &pool,
+                                                   qint64 bytesPerStream);
+
+    mutable QMutex mutex;
+    QList<LaneSet*> sha1Sets;
+    QList<LaneSet*> sha256Sets;
+    int laneSetLimit;
+
+    // Statistics (updated by the driving callers under mutex)
+    qint64 blocksHashed;
+    qint64 blockSteps;
+
+    // Constants
+    static const qint64 MAX_BLOCKS_PER_PASS = 256;  // 16KB per lane before new streams are taken in
+    static const qint64 BENCH_CHUNK_SIZE = 1024 * 1024; // Matches HashEngine::CHUNK_SIZE
+};
+
+#endif // MULTIBUFFERHASHER_H
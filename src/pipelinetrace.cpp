@@ -0,0 +1,187 @@
+/*
+ * E01 Hash Verification Tool
+ * PipelineTrace Implementation
+ */
+
+#include "pipelinetrace.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+namespace {
+
+// Trace-event name and category of each PipelineTrace::EventKind. libewf
+// inflates chunks inside its read call, so decompression is part of a read.
+struct KindInfo {
+    const char *name;
+    const char *category;
+};
+
+const KindInfo KIND_INFO[PipelineTrace::EVENT_KIND_COUNT] = {
+    { "read+inflate",      "io"    },
+    { "hash",              "hash"  },
+    { "stage block",       "stage" },
+    { "segment read",      "io"    },
+    { "segment hash",      "hash"  },
+    { "wait next block",   "wait"  },
+    { "wait window",       "wait"  },
+    { "wait stage full",   "wait"  },
+    { "wait stage empty",  "wait"  },
+    { "throttle",          "wait"  },
+    { "paused",            "wait"  }
+};
+
+// Chrome trace timestamps are microseconds
+QByteArray microseconds(qint64 ns)
+{
+    return QByteArray::number(ns / 1000.0, 'f', 3);
+}
+
+}
+
+thread_local PipelineTrace::Ring *PipelineTrace::currentRing = nullptr;
+
+PipelineTrace::PipelineTrace(const QString &outputPath, int eventsPerThread)
+    : outputPath(outputPath)
+    , eventsPerThread(qMax(1, eventsPerThread))
+    , originNs(now())
+{
+}
+
+PipelineTrace::~PipelineTrace()
+{
+    write();
+    qDeleteAll(rings);
+}
+
+QString PipelineTrace::getOutputPath() const
+{
+    return outputPath;
+}
+
+// ===== ThreadScope =====
+
+PipelineTrace::ThreadScope::ThreadScope(PipelineTrace *trace, const char *threadName)
+    : previous(currentRing)
+{
+    if (trace) {
+        currentRing = trace->attach(threadName);
+    }
+}
+
+PipelineTrace::ThreadScope::~ThreadScope()
+{
+    currentRing = previous;
+}
+
+// ===== Private Helper Functions =====
+
+PipelineTrace::Ring *PipelineTrace::attach(const char *threadName)
+{
+    QMutexLocker locker(&mutex);
+
+    Qt::HANDLE thread = QThread::currentThreadId();
+    Ring *ring = ringsByThread.value(thread, nullptr);
+    if (ring) {
+        return ring;
+    }
+
+    // Allocated up front: recording never allocates
+    ring = new Ring();
+    ring->tid = rings.size() + 1;
+    ring->name = QByteArray(threadName);
+    ring->events.resize(static_cast<size_t>(eventsPerThread));
+    ring->recorded = 0;
+
+    rings.append(ring);
+    ringsByThread.insert(thread, ring);
+    return ring;
+}
+
+bool PipelineTrace::write() const
+{
+    QMutexLocker locker(&mutex);
+
+    QSaveFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "PipelineTrace: Cannot write" << outputPath;
+        return false;
+    }
+
+    qint64 written = 0;
+    qint64 dropped = 0;
+    QByteArray line;
+
+    file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    file.write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+               "\"args\":{\"name\":\"e01hasher\"}}");
+
+    for (const Ring *ring : rings) {
+        line = ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" +
+               QByteArray::number(ring->tid) + ",\"args\":{\"name\":\"" + ring->name + "\"}}";
+        file.write(line);
+
+        // Oldest surviving event first
+        qint64 capacity = static_cast<qint64>(ring->events.size());
+        qint64 first = qMax<qint64>(0, ring->recorded - capacity);
+        dropped += first;
+
+        for (qint64 i = first; i < ring->recorded; ++i) {
+            const Event &event = ring->events[static_cast<size_t>(i % capacity)];
+            const KindInfo &info = KIND_INFO[event.kind];
+
+            line = ",\n{\"name\":\"" + QByteArray(info.name) + "\",\"cat\":\"" + info.category +
+                   "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + QByteArray::number(ring->tid) +
+                   ",\"ts\":" + microseconds(event.startNs - originNs) +
+                   ",\"dur\":" + microseconds(event.endNs - event.startNs);
+            if (event.offset >= 0 || event.size >= 0) {
+                line += ",\"args\":{";
+                if (event.offset >= 0) {
+                    line += "\"offset\":" + QByteArray::number(event.offset);
+                }
+                if (event.size >= 0) {
+                    line += QByteArray(event.offset >= 0 ? "," : "") +
+                            "\"bytes\":" + QByteArray::number(event.size);
+                }
+                line += "}";
+            }
+            line += "}";
+            file.write(line);
+            ++written;
+        }
+    }
+
+    file.write("\n],\"otherData\":{\"droppedEvents\":" + QByteArray::number(dropped) + "}}\n");
+
+    if (!file.commit()) {
+        qDebug() << "PipelineTrace: Cannot write" << outputPath;
+        return false;
+    }
+
+    qDebug() << "PipelineTrace: Wrote" << written << "events from" << rings.size()
+             << "threads to" << outputPath << "(" << dropped << "overwritten)";
+    return true;
+}
+
+qint64 PipelineTrace::now()
+{
+    // One clock for every trace, so threads share a time base
+    static QElapsedTimer clock = []() {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return clock.nsecsElapsed();
+}
+
+void PipelineTrace::record(Ring *ring, EventKind kind, qint64 startNs, qint64 endNs,
+                           qint64 offset, qint64 size)
+{
+    Event &event = ring->events[static_cast<size_t>(ring->recorded % static_cast<qint64>(ring->events.size()))];
+    event.startNs = startNs;
+    event.endNs = endNs;
+    event.offset = offset;
+    event.size = size;
+    event.kind = kind;
+    ++ring->recorded;
+}
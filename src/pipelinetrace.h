@@ -0,0 +1,139 @@
+/*
+ * E01 Hash Verification Tool
+ * PipelineTrace - Per-thread timeline of pipeline events (Chrome trace JSON)
+ */
+
+#ifndef PIPELINETRACE_H
+#define PIPELINETRACE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QThread>
+#include <vector>
+
+// Opt-in timeline of one job: every read, hash update, stage block and
+// queue wait on every thread of the pipeline, written as Chrome trace-event
+// JSON (chrome://tracing, ui.perfetto.dev) when the trace is destroyed.
+// Counters show how fast a job ran; the timeline shows when the reader
+// stalled and which worker starved.
+//
+// Each thread that takes part attaches with a ThreadScope and records into
+// its own fixed-size ring, so recording is a clock read and a store with no
+// lock and no allocation. A full ring overwrites its oldest events. With
+// no trace attached, a Span costs a single thread-local pointer test.
+//
+// The trace must outlive every thread recording into it; it is written by
+// the destructor, once those threads have stopped.
+class PipelineTrace
+{
+    struct Ring;
+
+public:
+    enum EventKind {
+        EVENT_READ,            // libewf read (including chunk decompression)
+        EVENT_HASH,            // Hash update of one block
+        EVENT_STAGE_BLOCK,     // Analysis stage processing one block
+        EVENT_SEGMENT_READ,    // Segment-file read
+        EVENT_SEGMENT_HASH,    // Segment-file hash update
+        EVENT_WAIT_BLOCK,      // Hash loop waiting for the next prefetched block
+        EVENT_WAIT_WINDOW,     // Prefetch reader waiting for the window to open
+        EVENT_WAIT_STAGE_FULL, // Hash loop blocked on a full stage queue
+        EVENT_WAIT_STAGE_EMPTY,// Stage waiting for a block
+        EVENT_WAIT_THROTTLE,   // Rate limit
+        EVENT_WAIT_PAUSED,     // Job paused
+        EVENT_KIND_COUNT
+    };
+
+    explicit PipelineTrace(const QString &outputPath, int eventsPerThread = DEFAULT_EVENTS_PER_THREAD);
+    ~PipelineTrace();
+
+    QString getOutputPath() const;
+
+    // Attaches the calling thread for the lifetime of the scope (a thread
+    // attached twice, e.g. a pool thread running several tasks, keeps one
+    // timeline row)
+    class ThreadScope
+    {
+    public:
+        ThreadScope(PipelineTrace *trace, const char *threadName);
+        ~ThreadScope();
+
+    private:
+        Ring *previous;
+    };
+
+    // One event on the calling thread's timeline, from construction to
+    // destruction; offset and size are shown as arguments when set
+    class Span
+    {
+    public:
+        explicit Span(EventKind kind, qint64 offset = -1, qint64 size = -1)
+            : ring(currentRing)
+            , kind(kind)
+            , offset(offset)
+            , size(size)
+            , startNs(ring ? now() : 0)
+        {
+        }
+
+        ~Span()
+        {
+            if (ring) {
+                record(ring, kind, startNs, now(), offset, size);
+            }
+        }
+
+        void setSize(qint64 size) { this->size = size; }
+
+    private:
+        Ring *ring;
+        EventKind kind;
+        qint64 offset;
+        qint64 size;
+        qint64 startNs;
+    };
+
+private:
+    struct Event {
+        qint64 startNs;
+        qint64 endNs;
+        qint64 offset;
+        qint64 size;
+        int kind;
+    };
+
+    // A thread's events: written only by that thread, read once it has stopped
+    struct Ring {
+        int tid;
+        QByteArray name;
+        std::vector<Event> events;
+        qint64 recorded;
+    };
+
+    Ring *attach(const char *threadName);
+    bool write() const;
+
+    static qint64 now();
+    static void record(Ring *ring, EventKind kind, qint64 startNs, qint64 endNs,
+                       qint64 offset, qint64 size);
+
+    static thread_local Ring *currentRing;
+
+    QString outputPath;
+    int eventsPerThread;
+    qint64 originNs;
+
+    // Rings in attach order; a ring's tid is its index + 1
+    mutable QMutex mutex;
+    QList<Ring*> rings;
+    QMap<Qt::HANDLE, Ring*> ringsByThread;
+
+    // Constants
+    static const int DEFAULT_EVENTS_PER_THREAD = 128 * 1024;   // 5MB per thread
+};
+
+#endif // PIPELINETRACE_H
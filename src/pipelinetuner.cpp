@@ -0,0 +1,211 @@
+/*
+ * E01 Hash Verification Tool
+ * PipelineTuner Implementation
+ */
+
+#include "pipelinetuner.h"
+#include "prefetchreader.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QSysInfo>
+#include <QThread>
+#include <cmath>
+
+#ifndef _WIN32
+    #include <sys/stat.h>
+    #include <sys/sysmacros.h>
+#endif
+
+PipelineTuner::PipelineTuner(EWFHandler *ewfHandler)
+    : ewfHandler(ewfHandler)
+{
+}
+
+PipelineConfig PipelineTuner::calibrate(bool md5, bool sha1, bool sha256)
+{
+    PipelineConfig config;
+    QString path = ewfHandler->getFilePath();
+
+    // Hash side: the faster kernel for this algorithm set
+    KernelBenchResult kernel = kernelSpeed(md5, sha1, sha256);
+    config.blockedKernel = kernel.blockedMBps >= kernel.sequentialMBps;
+    double hashMBps = qMax(kernel.blockedMBps, kernel.sequentialMBps);
+    config.reasons << QString("%1 hash: %2 kernel, %3 MB/s")
+        .arg(kernel.algorithms)
+        .arg(config.blockedKernel ? "cache-blocked" : "one pass per algorithm")
+        .arg(hashMBps, 0, 'f', 0);
+
+    // Read side
+    int compressionLevel = ewfHandler->getCompressionLevel();
+    static const char *compressionNames[] = {"none", "fast", "best"};
+    QString compression = (compressionLevel >= 0 && compressionLevel <= 2)
+        ? compressionNames[compressionLevel] : "unknown";
+
+    if (PrefetchReader::isNetworkPath(path)) {
+        // Latency, not bandwidth or CPU, limits a share
+        config.parallelReads = NETWORK_PARALLEL_READS;
+        config.readSize = NETWORK_READ_SIZE;
+        config.reasons << QString("network share: %1 outstanding %2MB reads to hide round trips")
+            .arg(config.parallelReads).arg(config.readSize / (1024 * 1024));
+        return config;
+    }
+
+    int cpus = qMax(1, QThread::idealThreadCount());
+
+    if (isRotational(path) == 1) {
+        if (compressionLevel <= 0 || cpus < 2) {
+            config.reasons << QString("rotational disk (compression: %1): one sequential reader, "
+                                      "more would only add seeks").arg(compression);
+            return config;
+        }
+
+        // A compressed image can be limited by inflate rather than by the
+        // disk: probe once from the disk, then again from the page cache.
+        // If the cached pass is not much faster, the disk is idle for most
+        // of each read, and a few readers on adjacent extents inflate in
+        // parallel without turning the access pattern random.
+        double diskMBps = probeReadSpeed();
+        double inflateMBps = probeReadSpeed();
+        if (diskMBps <= 0.0 || inflateMBps <= 0.0 || inflateMBps >= diskMBps * INFLATE_BOUND_FACTOR
+            || inflateMBps >= hashMBps) {
+            config.reasons << QString("rotational disk (read %1 MB/s, cached %2 MB/s, compression: %3): "
+                                      "one sequential reader, more would only add seeks")
+                .arg(diskMBps, 0, 'f', 0).arg(inflateMBps, 0, 'f', 0).arg(compression);
+            return config;
+        }
+
+        int wanted = static_cast<int>(std::ceil(hashMBps / inflateMBps));
+        config.parallelReads = qBound(2, wanted, qMin(ROTATIONAL_MAX_PARALLEL_READS, cpus));
+        config.readSize = ROTATIONAL_READ_SIZE;
+        config.reasons << QString("rotational disk, inflate-bound (read %1 MB/s, cached %2 MB/s, "
+                                  "compression: %3): %4 readers of %5MB")
+            .arg(diskMBps, 0, 'f', 0).arg(inflateMBps, 0, 'f', 0).arg(compression)
+            .arg(config.parallelReads).arg(config.readSize / (1024 * 1024));
+        return config;
+    }
+
+    double readMBps = probeReadSpeed();
+
+    if (readMBps <= 0.0) {
+        config.reasons << "read probe failed: one reader";
+        return config;
+    }
+    if (cpus < 2) {
+        config.reasons << QString("one CPU (read %1 MB/s, compression: %2): reading and hashing "
+                                  "share it, no reader threads")
+            .arg(readMBps, 0, 'f', 0).arg(compression);
+        return config;
+    }
+
+    // Reader threads take reading (and inflating) off the hash thread; each
+    // has its own handle, so they scale the read side until it matches the
+    // hash. Two are needed to overlap at all.
+    int wanted = static_cast<int>(std::ceil(hashMBps / readMBps));
+    config.parallelReads = qBound(2, wanted, qMin(MAX_PARALLEL_READS, cpus));
+    config.readSize = compressionLevel > 0 ? COMPRESSED_READ_SIZE : UNCOMPRESSED_READ_SIZE;
+
+    if (readMBps >= hashMBps) {
+        config.reasons << QString("hash-bound (read %1 MB/s, compression: %2): %3 readers of %4MB "
+                                  "only to overlap reading with hashing")
+            .arg(readMBps, 0, 'f', 0).arg(compression)
+            .arg(config.parallelReads).arg(config.readSize / (1024 * 1024));
+    } else {
+        config.reasons << QString("read-bound (read %1 MB/s, compression: %2): %3 readers of %4MB "
+                                  "to approach the hash rate")
+            .arg(readMBps, 0, 'f', 0).arg(compression)
+            .arg(config.parallelReads).arg(config.readSize / (1024 * 1024));
+    }
+    return config;
+}
+
+int PipelineTuner::isRotational(const QString &path)
+{
+#ifdef _WIN32
+    Q_UNUSED(path);
+    return -1;
+#else
+    struct stat info;
+    if (stat(QFile::encodeName(path).constData(), &info) != 0) {
+        return -1;
+    }
+
+    // /sys/dev/block/<major>:<minor> links to the device; a partition's
+    // queue settings live on its parent disk
+    QString device = QFileInfo(QString("/sys/dev/block/%1:%2")
+                                   .arg(major(info.st_dev)).arg(minor(info.st_dev))).canonicalFilePath();
+    if (device.isEmpty()) {
+        return -1;
+    }
+
+    const QStringList candidates = {device + "/queue/rotational", device + "/../queue/rotational"};
+    for (const QString &candidate : candidates) {
+        QFile file(candidate);
+        if (file.open(QIODevice::ReadOnly)) {
+            return file.readAll().trimmed() == "1" ? 1 : 0;
+        }
+    }
+
+    return -1;
+#endif
+}
+
+// ===== Private Helper Functions =====
+
+double PipelineTuner::probeReadSpeed()
+{
+    qint64 mediaSize = ewfHandler->getMediaSize();
+    if (mediaSize <= 0) {
+        return 0.0;
+    }
+
+    // A few points spread over the media, away from the (often sparse) start
+    QByteArray buffer(static_cast<int>(PROBE_READ_SIZE), Qt::Uninitialized);
+    qint64 bytesRead = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 1; i <= PROBE_POINTS; ++i) {
+        qint64 offset = (mediaSize / (PROBE_POINTS + 1)) * i;
+        qint64 length = qMin(PROBE_READ_SIZE, mediaSize - offset);
+        if (length <= 0) {
+            continue;
+        }
+
+        qint64 result = ewfHandler->readAt(buffer.data(), length, offset);
+        if (result <= 0) {
+            break;
+        }
+        bytesRead += result;
+    }
+
+    qint64 elapsedNs = qMax<qint64>(1, timer.nsecsElapsed());
+    return (static_cast<double>(bytesRead) / (1024.0 * 1024.0)) / (elapsedNs / 1e9);
+}
+
+KernelBenchResult PipelineTuner::kernelSpeed(bool md5, bool sha1, bool sha256)
+{
+    // Keyed by host as well, for settings on a shared home directory
+    QString key = QString("HashKernel/%1/%2%3%4")
+        .arg(QSysInfo::machineHostName())
+        .arg(md5 ? "md5" : "").arg(sha1 ? "sha1" : "").arg(sha256 ? "sha256" : "");
+
+    QSettings settings;
+    KernelBenchResult result;
+    if (settings.contains(key + "/blocked")) {
+        result.algorithms = settings.value(key + "/algorithms").toString();
+        result.sequentialMBps = settings.value(key + "/sequential").toDouble();
+        result.blockedMBps = settings.value(key + "/blocked").toDouble();
+        return result;
+    }
+
+    result = HashKernel::benchmarkSet(md5, sha1, sha256, KERNEL_BENCH_POOL_SIZE);
+    settings.setValue(key + "/algorithms", result.algorithms);
+    settings.setValue(key + "/sequential", result.sequentialMBps);
+    settings.setValue(key + "/blocked", result.blockedMBps);
+
+    return result;
+}
@@ -0,0 +1,65 @@
+/*
+ * E01 Hash Verification Tool
+ * PipelineTuner - Per-job calibration of the read and hash pipeline
+ */
+
+#ifndef PIPELINETUNER_H
+#define PIPELINETUNER_H
+
+#include <QString>
+#include <QStringList>
+#include "ewfhandler.h"
+#include "hashkernel.h"
+
+// Configuration chosen for one job, with the reason for each choice
+struct PipelineConfig
+{
+    int parallelReads = 1;       // Readers, each decompressing on its own handle
+    qint64 readSize = 0;         // Per outstanding request (parallel reads only)
+    bool blockedKernel = true;   // Cache-blocked vs one pass per algorithm
+    QStringList reasons;
+};
+
+// Probes the image and host before a job and picks the reader count, read
+// size and hash kernel:
+//  - compression level (libewf) and storage type (network share, or
+//    /sys/block/<dev>/queue/rotational on Linux)
+//  - single-reader throughput, including decompression, over a few MB
+//  - hash kernel throughput for the job's algorithm set, measured once per
+//    host and cached in QSettings
+// Reader threads are sized so the read side matches the hash rate; none are
+// used on a single CPU, where there is nothing to overlap with. On a
+// rotational disk they are only used (2-4) for a compressed image whose
+// reads are bound by inflate rather than by the disk, judged by re-reading
+// the probe points from the page cache.
+class PipelineTuner
+{
+public:
+    explicit PipelineTuner(EWFHandler *ewfHandler);
+
+    PipelineConfig calibrate(bool md5, bool sha1, bool sha256);
+
+    // 1 rotational, 0 solid state, -1 unknown (not Linux, or no sysfs entry)
+    static int isRotational(const QString &path);
+
+private:
+    double probeReadSpeed();
+    KernelBenchResult kernelSpeed(bool md5, bool sha1, bool sha256);
+
+    EWFHandler *ewfHandler;
+
+    // Constants
+    static const qint64 PROBE_READ_SIZE = 4 * 1024 * 1024;        // Per probe point
+    static const int PROBE_POINTS = 3;
+    static const qint64 KERNEL_BENCH_POOL_SIZE = 32 * 1024 * 1024;
+    static const int NETWORK_PARALLEL_READS = 8;
+    static const int MAX_PARALLEL_READS = 8;
+    static const qint64 COMPRESSED_READ_SIZE = 4 * 1024 * 1024;   // Spreads inflate work evenly
+    static const qint64 UNCOMPRESSED_READ_SIZE = 16 * 1024 * 1024; // Fewer, larger device requests
+    static const qint64 NETWORK_READ_SIZE = 8 * 1024 * 1024;
+    static const int ROTATIONAL_MAX_PARALLEL_READS = 4;
+    static const qint64 ROTATIONAL_READ_SIZE = 16 * 1024 * 1024;  // Long extents amortize seeks
+    static const int INFLATE_BOUND_FACTOR = 2;  // Cached probe under 2x the disk probe: inflate-bound
+};
+
+#endif // PIPELINETUNER_H
@@ -0,0 +1,234 @@
+/*
+ * E01 Hash Verification Tool
+ * PrefetchReader Implementation
+ */
+
+#include "prefetchreader.h"
+#include "ewfhandler.h"
+#include "jobcontrol.h"
+#include "pipelinetrace.h"
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+#include <QStorageInfo>
+#include <QStringList>
+
+PrefetchReader::PrefetchReader(const QString &filePath, qint64 mediaSize, int workers, qint64 blockSize)
+    : filePath(filePath)
+    , mediaSize(mediaSize)
+    , workers(qMax(1, workers))
+    , blockSize(qMax<qint64>(1, blockSize))
+    , blockCount((mediaSize + this->blockSize - 1) / this->blockSize)
+    , windowSize(this->workers * 2)
+    , control(nullptr)
+    , trace(nullptr)
+    , rawInput(false)
+    , nextToClaim(0)
+    , nextToDeliver(0)
+    , stopping(false)
+    , failed(false)
+{
+}
+
+PrefetchReader::~PrefetchReader()
+{
+    stop();
+}
+
+void PrefetchReader::setJobControl(JobControl *control)
+{
+    this->control = control;
+}
+
+void PrefetchReader::setTrace(PipelineTrace *trace)
+{
+    this->trace = trace;
+}
+
+void PrefetchReader::setRawInput(bool raw)
+{
+    rawInput = raw;
+}
+
+bool PrefetchReader::start()
+{
+    stopping = false;
+    failed = false;
+    nextToClaim = 0;
+    nextToDeliver = 0;
+    readyBlocks.clear();
+
+    pool.setMaxThreadCount(workers);
+    for (int i = 0; i < workers; ++i) {
+        pool.start([this]() {
+            readerLoop();
+        });
+    }
+
+    qDebug() << "PrefetchReader: Started" << workers << "readers with"
+             << blockSize / (1024*1024) << "MB blocks";
+    return true;
+}
+
+void PrefetchReader::stop()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        windowOpen.wakeAll();
+        blockReady.wakeAll();
+    }
+
+    pool.waitForDone();
+}
+
+bool PrefetchReader::takeNext(QByteArray &block)
+{
+    QMutexLocker locker(&mutex);
+
+    if (nextToDeliver >= blockCount) {
+        return false;
+    }
+
+    if (!readyBlocks.contains(nextToDeliver) && !failed && !stopping) {
+        PipelineTrace::Span span(PipelineTrace::EVENT_WAIT_BLOCK, nextToDeliver * blockSize);
+        while (!readyBlocks.contains(nextToDeliver) && !failed && !stopping) {
+            blockReady.wait(&mutex);
+        }
+    }
+
+    if (failed || stopping) {
+        return false;
+    }
+
+    block = readyBlocks.take(nextToDeliver);
+    ++nextToDeliver;
+
+    // Let readers claim the block that just entered the window
+    windowOpen.wakeAll();
+    return true;
+}
+
+bool PrefetchReader::hasError() const
+{
+    QMutexLocker locker(&mutex);
+    return failed;
+}
+
+QString PrefetchReader::getLastError() const
+{
+    QMutexLocker locker(&mutex);
+    return lastError;
+}
+
+bool PrefetchReader::isNetworkPath(const QString &path)
+{
+    QStorageInfo storage(path);
+    if (!storage.isValid()) {
+        return false;
+    }
+
+    QString type = QString::fromLatin1(storage.fileSystemType()).toLower();
+    static const QStringList networkTypes = {
+        "nfs", "nfs4", "cifs", "smb", "smb2", "smb3", "smbfs", "9p",
+        "fuse.sshfs", "fuse.rclone", "afpfs", "webdav", "davfs"
+    };
+
+    return networkTypes.contains(type);
+}
+
+// ===== Private Helper Functions =====
+
+void PrefetchReader::readerLoop()
+{
+    PipelineTrace::ThreadScope traceScope(trace, "prefetch reader");
+
+    if (control) {
+        control->applyPriority();
+    }
+
+    // Every reader has its own handle, so requests really overlap
+    EWFHandler handler;
+    QFile rawFile(filePath);
+    bool opened = rawInput ? rawFile.open(QIODevice::ReadOnly) : handler.open(filePath);
+    if (!opened) {
+        QMutexLocker locker(&mutex);
+        failed = true;
+        lastError = "Failed to open reader handle: " +
+                    (rawInput ? rawFile.errorString() : handler.getLastError());
+        blockReady.wakeAll();
+        return;
+    }
+
+    while (true) {
+        // Paused readers hold their handle and claim nothing
+        if (control && !control->checkpoint()) {
+            stopForJob();
+            return;
+        }
+
+        qint64 index;
+        {
+            QMutexLocker locker(&mutex);
+
+            // Bound memory: never run more than windowSize blocks ahead
+            if (!stopping && !failed && nextToClaim < blockCount &&
+                nextToClaim >= nextToDeliver + windowSize) {
+                PipelineTrace::Span span(PipelineTrace::EVENT_WAIT_WINDOW);
+                while (!stopping && !failed && nextToClaim < blockCount &&
+                       nextToClaim >= nextToDeliver + windowSize) {
+                    windowOpen.wait(&mutex);
+                }
+            }
+
+            if (stopping || failed || nextToClaim >= blockCount) {
+                return;
+            }
+
+            index = nextToClaim++;
+        }
+
+        qint64 offset = index * blockSize;
+        qint64 size = qMin(blockSize, mediaSize - offset);
+        QByteArray block(static_cast<int>(size), Qt::Uninitialized);
+
+        qint64 bytesRead;
+        {
+            PipelineTrace::Span span(PipelineTrace::EVENT_READ, offset, size);
+            if (rawInput) {
+                bytesRead = rawFile.seek(offset) ? rawFile.read(block.data(), size) : -1;
+            } else {
+                bytesRead = handler.readAt(block.data(), size, offset);
+            }
+        }
+
+        // Bandwidth limit; the block is dropped if the job is cancelled meanwhile
+        if (control && bytesRead == size && !control->throttle(bytesRead)) {
+            stopForJob();
+            return;
+        }
+
+        QMutexLocker locker(&mutex);
+        if (bytesRead != size) {
+            failed = true;
+            lastError = QString("Failed to read %1 bytes at offset %2: %3")
+                .arg(size)
+                .arg(offset)
+                .arg(rawInput ? rawFile.errorString() : handler.getLastError());
+            blockReady.wakeAll();
+            return;
+        }
+
+        readyBlocks.insert(index, block);
+        blockReady.wakeAll();
+    }
+}
+
+void PrefetchReader::stopForJob()
+{
+    // Not an error: takeNext() returns false and the caller sees the cancel
+    QMutexLocker locker(&mutex);
+    stopping = true;
+    windowOpen.wakeAll();
+    blockReady.wakeAll();
+}
@@ -0,0 +1,79 @@
+/*
+ * E01 Hash Verification Tool
+ * PrefetchReader - Parallel read-ahead for high-latency storage
+ */
+
+#ifndef PREFETCHREADER_H
+#define PREFETCHREADER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+class JobControl;
+class PipelineTrace;
+
+// Keeps several large reads in flight, each on its own libewf handle, and
+// hands the blocks back strictly in media order. On SMB/NFS this turns one
+// synchronous round trip per request into `workers` overlapping streams.
+class PrefetchReader
+{
+public:
+    PrefetchReader(const QString &filePath, qint64 mediaSize, int workers, qint64 blockSize);
+    ~PrefetchReader();
+
+    // Readers pause, throttle and stop with the job (optional)
+    void setJobControl(JobControl *control);
+
+    // Record reads and waits on the job's timeline (optional)
+    void setTrace(PipelineTrace *trace);
+
+    // Read the file as a raw image instead of through libewf
+    void setRawInput(bool raw);
+
+    // Start / stop the reader threads
+    bool start();
+    void stop();
+
+    // Next block in media order; returns false at end of media or on error
+    bool takeNext(QByteArray &block);
+
+    // Error handling
+    bool hasError() const;
+    QString getLastError() const;
+
+    // True for SMB/CIFS/NFS and FUSE network mounts
+    static bool isNetworkPath(const QString &path);
+
+private:
+    void readerLoop();
+    void stopForJob();
+
+    QString filePath;
+    qint64 mediaSize;
+    int workers;
+    qint64 blockSize;
+    qint64 blockCount;
+    int windowSize;
+    JobControl *control;
+    PipelineTrace *trace;
+    bool rawInput;
+
+    // Shared state (guarded by mutex)
+    mutable QMutex mutex;
+    QWaitCondition blockReady;
+    QWaitCondition windowOpen;
+    QMap<qint64, QByteArray> readyBlocks;
+    qint64 nextToClaim;
+    qint64 nextToDeliver;
+    bool stopping;
+    bool failed;
+    QString lastError;
+
+    QThreadPool pool;
+};
+
+#endif // PREFETCHREADER_H
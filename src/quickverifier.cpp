@@ -0,0 +1,236 @@
+/*
+ * E01 Hash Verification Tool
+ * QuickVerifier Implementation
+ */
+
+#include "quickverifier.h"
+#include "ewfhandler.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QThreadPool>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+QuickVerifier::QuickVerifier(const QString &filePath, QObject *parent)
+    : QThread(parent)
+    , filePath(filePath)
+    , sampleCount(DEFAULT_SAMPLE_COUNT)
+    , seed(static_cast<quint32>(QDateTime::currentMSecsSinceEpoch()))
+    , threadCount(qMin(QThread::idealThreadCount(), MAX_THREADS))
+    , totalSamples(0)
+    , cancelled(0)
+{
+}
+
+QuickVerifier::~QuickVerifier()
+{
+    // Wait for thread to finish
+    if (isRunning()) {
+        cancel();
+        wait();
+    }
+}
+
+void QuickVerifier::setSampleCount(int count)
+{
+    sampleCount = qMax(1, count);
+}
+
+void QuickVerifier::setSeed(quint32 seed)
+{
+    this->seed = seed;
+}
+
+void QuickVerifier::setThreadCount(int count)
+{
+    threadCount = qBound(1, count, MAX_THREADS);
+}
+
+void QuickVerifier::cancel()
+{
+    cancelled.storeRelease(1);
+}
+
+void QuickVerifier::run()
+{
+    qDebug() << "QuickVerifier: Starting quick verification with seed" << seed;
+
+    samplesChecked = 0;
+    workerErrors = 0;
+    failedOffsets.clear();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Probe the image geometry with a short-lived handle
+    EWFHandler probe;
+    if (!probe.open(filePath)) {
+        emit error("Failed to open file: " + probe.getLastError());
+        return;
+    }
+
+    qint64 mediaSize = probe.getMediaSize();
+    qint64 chunkSize = probe.getChunkSize();
+    probe.close();
+
+    if (mediaSize <= 0 || chunkSize <= 0) {
+        emit error("Image reports no media data");
+        return;
+    }
+
+    qint64 totalChunks = (mediaSize + chunkSize - 1) / chunkSize;
+    QList<qint64> sample = drawSample(totalChunks, sampleCount);
+    totalSamples = sample.size();
+
+    // Deal chunks round-robin so every worker covers the whole media range;
+    // each worker opens its own libewf handle so reads proceed in parallel
+    int workers = qMin(threadCount, totalSamples);
+    QList<QList<qint64>> assignments;
+    for (int i = 0; i < workers; ++i) {
+        assignments.append(QList<qint64>());
+    }
+    for (int i = 0; i < sample.size(); ++i) {
+        assignments[i % workers].append(sample.at(i));
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (const QList<qint64> &chunks : assignments) {
+        pool.start([this, chunks, chunkSize, mediaSize]() {
+            verifyChunks(chunks, chunkSize, mediaSize);
+        });
+    }
+    pool.waitForDone();
+
+    if (cancelled.loadAcquire()) {
+        qDebug() << "QuickVerifier: Cancelled by user";
+        return;
+    }
+
+    // A worker that could not open the image read none of its share; the
+    // bound below would then claim more coverage than the sample has
+    int failedWorkers = workerErrors.loadAcquire();
+    if (failedWorkers > 0) {
+        emit error(QString("%1 of %2 sampling workers could not open the image; "
+                           "%3 of %4 samples were read")
+                   .arg(failedWorkers).arg(workers)
+                   .arg(samplesChecked.loadAcquire()).arg(totalSamples));
+        return;
+    }
+
+    QuickVerifyResult result;
+    result.seed = seed;
+    result.totalChunks = totalChunks;
+    result.chunkSize = chunkSize;
+    result.samplesChecked = samplesChecked.loadAcquire();
+    result.failedOffsets = failedOffsets;
+    result.failures = failedOffsets.size();
+    std::sort(result.failedOffsets.begin(), result.failedOffsets.end());
+
+    // One-sided 95% upper bound on the damaged fraction. With no failures it
+    // is exact: the largest p for which seeing none still has at least 5%
+    // probability, 1 - 0.05^(1/n), roughly 3/n ("rule of three"). With
+    // failures it is the normal (Wald) approximation p + 1.645 * SE, which
+    // is not exact and runs low when failures are few.
+    int n = result.samplesChecked;
+    if (n > 0) {
+        if (result.failures == 0) {
+            result.damageUpperBound = 1.0 - std::pow(0.05, 1.0 / n);
+        } else {
+            double p = static_cast<double>(result.failures) / n;
+            result.damageUpperBound = qMin(1.0, p + 1.645 * std::sqrt(p * (1.0 - p) / n));
+        }
+    } else {
+        result.damageUpperBound = 1.0;
+    }
+
+    result.elapsedMs = timer.elapsed();
+
+    emit progressUpdate(100, result.samplesChecked, totalSamples);
+    emit quickVerifyComplete(result);
+
+    qDebug() << "QuickVerifier: Checked" << result.samplesChecked << "chunks,"
+             << result.failures << "failures in" << result.elapsedMs << "ms";
+}
+
+QList<qint64> QuickVerifier::drawSample(qint64 totalChunks, int count)
+{
+    QList<qint64> chunks;
+
+    // Small images: check every chunk
+    if (totalChunks <= count) {
+        for (qint64 i = 0; i < totalChunks; ++i) {
+            chunks.append(i);
+        }
+        return chunks;
+    }
+
+    // Stratified sampling: one random chunk from each of `count` equal strata.
+    // Segment files hold consecutive media ranges, so this spreads the sample
+    // across every segment while staying reproducible from the seed.
+    QRandomGenerator generator(seed);
+    for (int i = 0; i < count; ++i) {
+        qint64 first = (totalChunks * i) / count;
+        qint64 last = (totalChunks * (i + 1)) / count;
+        qint64 span = qMax<qint64>(1, last - first);
+        chunks.append(first + static_cast<qint64>(generator.generate64() % static_cast<quint64>(span)));
+    }
+
+    return chunks;
+}
+
+void QuickVerifier::verifyChunks(const QList<qint64> &chunks, qint64 chunkSize, qint64 mediaSize)
+{
+    EWFHandler handler;
+    if (!handler.open(filePath)) {
+        workerErrors.fetchAndAddOrdered(1);
+        return;
+    }
+
+    QByteArray buffer(static_cast<int>(chunkSize), Qt::Uninitialized);
+    int reportEvery = qMax(1, totalSamples / 100);
+
+    for (qint64 chunk : chunks) {
+        if (cancelled.loadAcquire()) {
+            return;
+        }
+
+        qint64 offset = chunk * chunkSize;
+        qint64 expected = qMin(chunkSize, mediaSize - offset);
+
+        // libewf inflates the chunk and checks its Adler-32 on every read;
+        // decompression failures fail the read, checksum failures are logged
+        qint64 bytesRead = handler.readAt(buffer.data(), expected, offset);
+        if (bytesRead != expected) {
+            recordFailure(offset);
+        }
+
+        int checked = samplesChecked.fetchAndAddOrdered(1) + 1;
+        if (checked % reportEvery == 0) {
+            emit progressUpdate((checked * 100) / totalSamples, checked, totalSamples);
+        }
+    }
+
+    // Chunks whose stored checksum did not match the inflated data
+    const QList<QPair<qint64, qint64>> checksumErrors = handler.getChecksumErrors();
+    for (const QPair<qint64, qint64> &range : checksumErrors) {
+        for (qint64 chunk : chunks) {
+            qint64 offset = chunk * chunkSize;
+            if (offset < range.first + range.second && offset + chunkSize > range.first) {
+                recordFailure(offset);
+            }
+        }
+    }
+}
+
+void QuickVerifier::recordFailure(qint64 offset)
+{
+    QMutexLocker locker(&failureMutex);
+
+    if (!failedOffsets.contains(offset)) {
+        failedOffsets.append(offset);
+    }
+}
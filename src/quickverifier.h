@@ -0,0 +1,83 @@
+/*
+ * E01 Hash Verification Tool
+ * QuickVerifier - Random chunk sampling for fast integrity triage
+ */
+
+#ifndef QUICKVERIFIER_H
+#define QUICKVERIFIER_H
+
+#include <QThread>
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QMetaType>
+
+// Outcome of a quick verification run
+struct QuickVerifyResult
+{
+    quint32 seed = 0;              // Seed used to draw the sample (re-run with it to reproduce)
+    qint64 totalChunks = 0;        // Chunks in the media
+    qint64 chunkSize = 0;          // Bytes per chunk
+    int samplesChecked = 0;        // Chunks actually read
+    int failures = 0;              // Chunks that failed to read, inflate or checksum
+    QList<qint64> failedOffsets;   // Media offsets of the failed chunks
+    double damageUpperBound = 0.0; // 95% upper bound of the damaged chunk fraction
+    qint64 elapsedMs = 0;
+};
+
+Q_DECLARE_METATYPE(QuickVerifyResult)
+
+class QuickVerifier : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit QuickVerifier(const QString &filePath, QObject *parent = nullptr);
+    ~QuickVerifier();
+
+    // Sampling configuration
+    void setSampleCount(int count);
+    void setSeed(quint32 seed);
+    void setThreadCount(int count);
+
+    // Control
+    void cancel();
+
+signals:
+    void progressUpdate(int percentage, int samplesChecked, int totalSamples);
+    void quickVerifyComplete(const QuickVerifyResult &result);
+    void error(const QString &errorMessage);
+
+protected:
+    void run() override;
+
+private:
+    QList<qint64> drawSample(qint64 totalChunks, int count);
+    void verifyChunks(const QList<qint64> &chunks, qint64 chunkSize, qint64 mediaSize);
+    void recordFailure(qint64 offset);
+
+    QString filePath;
+
+    // Sampling configuration
+    int sampleCount;
+    quint32 seed;
+    int threadCount;
+
+    // Shared worker state
+    QAtomicInt samplesChecked;
+    QAtomicInt workerErrors;
+    QMutex failureMutex;
+    QList<qint64> failedOffsets;
+    int totalSamples;
+
+    // Control flags (set by cancel(), read by the sampling workers; a
+    // cancel before run() starts is kept)
+    QAtomicInt cancelled;
+
+    // Constants
+    static const int DEFAULT_SAMPLE_COUNT = 4096;
+    static const int MAX_THREADS = 8;
+};
+
+#endif // QUICKVERIFIER_H
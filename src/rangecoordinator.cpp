@@ -0,0 +1,531 @@
+/*
+ * E01 Hash Verification Tool
+ * RangeCoordinator Implementation
+ */
+
+#include "rangecoordinator.h"
+#include <QDebug>
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <algorithm>
+
+RangeCoordinator::RangeCoordinator(QObject *parent)
+    : QObject(parent)
+    , mediaSize(0)
+    , rangeSize(DEFAULT_RANGE_SIZE)
+    , pieceSize(0)
+    , fillByte(0)
+    , taskTimeoutMs(DEFAULT_TASK_TIMEOUT_S * 1000LL)
+    , rangesDone(0)
+    , started(false)
+    , finished(false)
+    , workersSeen(0)
+    , blocksChecked(0)
+    , knownGood(0)
+    , knownBad(0)
+{
+    connect(&localServer, &QLocalServer::newConnection, this, &RangeCoordinator::onNewLocalConnection);
+    connect(&tcpServer, &QTcpServer::newConnection, this, &RangeCoordinator::onNewTcpConnection);
+    connect(&taskTimer, &QTimer::timeout, this, &RangeCoordinator::onTaskTimer);
+}
+
+RangeCoordinator::~RangeCoordinator()
+{
+    // Workers still connected are told to stop rather than left waiting
+    for (auto it = peers.begin(); it != peers.end(); ++it) {
+        send(it.key(), QJsonObject{{"cmd", "done"}});
+    }
+}
+
+void RangeCoordinator::setImage(const QString &imagePath, qint64 mediaSize)
+{
+    this->imagePath = imagePath;
+    this->mediaSize = mediaSize;
+}
+
+void RangeCoordinator::setRangeSize(qint64 bytes)
+{
+    if (bytes > 0) {
+        rangeSize = bytes;
+    }
+}
+
+void RangeCoordinator::setPieceSize(qint64 bytes)
+{
+    pieceSize = qMax<qint64>(0, bytes);
+}
+
+void RangeCoordinator::setKnownBlockIndex(const QString &indexPath, const QString &reportPath)
+{
+    knownBlockIndexPath = indexPath;
+    knownBlockReportPath = reportPath;
+}
+
+void RangeCoordinator::setFillByte(quint8 fillByte)
+{
+    this->fillByte = fillByte;
+}
+
+void RangeCoordinator::setTaskTimeout(int seconds)
+{
+    taskTimeoutMs = qMax(0, seconds) * 1000LL;
+}
+
+void RangeCoordinator::setToken(const QString &token)
+{
+    this->token = token;
+}
+
+QString RangeCoordinator::getToken() const
+{
+    return token;
+}
+
+bool RangeCoordinator::listen(const QString &address)
+{
+    if (address.startsWith("tcp:")) {
+        QString host;
+        quint16 port = 0;
+        if (!parseTcpAddress(address, host, port)) {
+            emit error("Malformed address " + address + " (expected tcp:HOST:PORT)");
+            return false;
+        }
+
+        QHostAddress hostAddress = host == "*" ? QHostAddress(QHostAddress::Any) : QHostAddress(host);
+        if (!tcpServer.listen(hostAddress, port)) {
+            emit error("Cannot listen on " + address + ": " + tcpServer.errorString());
+            return false;
+        }
+        this->address = QString("tcp:%1:%2").arg(host).arg(tcpServer.serverPort());
+
+        // Anyone who can reach the port could otherwise take ranges and
+        // report forged hashes
+        if (token.isEmpty()) {
+            QByteArray random(TOKEN_BYTES, '\0');
+            for (int i = 0; i < TOKEN_BYTES; ++i) {
+                random[i] = static_cast<char>(QRandomGenerator::system()->bounded(256));
+            }
+            token = QString::fromLatin1(random.toHex());
+        }
+    } else {
+        // A coordinator that died without cleaning up leaves its socket file behind
+        QLocalServer::removeServer(address);
+
+        localServer.setSocketOptions(QLocalServer::UserAccessOption);
+        if (!localServer.listen(address)) {
+            emit error("Cannot listen on " + address + ": " + localServer.errorString());
+            return false;
+        }
+        this->address = localServer.fullServerName();
+    }
+
+    qDebug() << "RangeCoordinator: Listening on" << this->address;
+    return true;
+}
+
+QString RangeCoordinator::serverAddress() const
+{
+    return address;
+}
+
+void RangeCoordinator::start()
+{
+    // Whole pieces per range, whole megabytes per piece (block and chunk
+    // boundaries then never straddle two ranges)
+    qint64 piece = pieceSize > 0 ? pieceSize : rangeSize;
+    piece = qMax(PIECE_ALIGNMENT, (piece + PIECE_ALIGNMENT - 1) / PIECE_ALIGNMENT * PIECE_ALIGNMENT);
+    qint64 range = qMax(piece, (rangeSize + piece - 1) / piece * piece);
+
+    tasks.clear();
+    attempts.clear();
+    pending.clear();
+    pieces.clear();
+    badRanges.clear();
+    rangesDone = 0;
+    blocksChecked = 0;
+    knownGood = 0;
+    knownBad = 0;
+
+    for (qint64 offset = 0; offset < mediaSize; offset += range) {
+        RangeTask task;
+        task.id = tasks.size();
+        task.imagePath = imagePath;
+        task.offset = offset;
+        task.length = qMin(range, mediaSize - offset);
+        task.pieceSize = piece;
+        task.fillByte = fillByte;
+        if (!knownBlockIndexPath.isEmpty()) {
+            task.knownBlockIndexPath = knownBlockIndexPath;
+            task.knownBlockReportPath = reportPartPath(task.id);
+        }
+
+        pending.enqueue(task.id);
+        tasks.append(task);
+        attempts.append(0);
+    }
+
+    started = true;
+    finished = false;
+
+    qDebug() << "RangeCoordinator:" << tasks.size() << "ranges of" << range / (1024*1024) << "MB,"
+             << piece / (1024*1024) << "MB pieces";
+
+    if (tasks.isEmpty()) {
+        finishDistribution(QString());
+        return;
+    }
+    if (taskTimeoutMs > 0) {
+        taskTimer.start(TASK_CHECK_MS);
+    }
+    dispatch();
+}
+
+PieceHashList RangeCoordinator::getPieces() const
+{
+    return pieces;
+}
+
+BadRangeMap RangeCoordinator::getBadRanges() const
+{
+    return badRanges;
+}
+
+qint64 RangeCoordinator::getBlocksChecked() const
+{
+    return blocksChecked;
+}
+
+qint64 RangeCoordinator::getKnownGood() const
+{
+    return knownGood;
+}
+
+qint64 RangeCoordinator::getKnownBad() const
+{
+    return knownBad;
+}
+
+int RangeCoordinator::getRangeCount() const
+{
+    return tasks.size();
+}
+
+int RangeCoordinator::getWorkersSeen() const
+{
+    return workersSeen;
+}
+
+int RangeCoordinator::getConnectedWorkers() const
+{
+    int connected = 0;
+    for (const Peer &peer : peers) {
+        if (peer.ready) {
+            connected++;
+        }
+    }
+    return connected;
+}
+
+bool RangeCoordinator::parseTcpAddress(const QString &address, QString &host, quint16 &port)
+{
+    if (!address.startsWith("tcp:")) {
+        return false;
+    }
+
+    QString hostAndPort = address.mid(4);
+    int colon = hostAndPort.lastIndexOf(':');
+    if (colon <= 0) {
+        return false;
+    }
+
+    bool ok = false;
+    port = hostAndPort.mid(colon + 1).toUShort(&ok);
+    host = hostAndPort.left(colon);
+    return ok;
+}
+
+// ===== Slot Implementations =====
+
+void RangeCoordinator::onNewLocalConnection()
+{
+    while (localServer.hasPendingConnections()) {
+        QLocalSocket *socket = localServer.nextPendingConnection();
+        addPeer(socket);
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { dropPeer(socket); });
+    }
+}
+
+void RangeCoordinator::onNewTcpConnection()
+{
+    while (tcpServer.hasPendingConnections()) {
+        QTcpSocket *socket = tcpServer.nextPendingConnection();
+        addPeer(socket);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { dropPeer(socket); });
+    }
+}
+
+void RangeCoordinator::onTaskTimer()
+{
+    QList<QIODevice*> expired;
+    for (auto it = peers.constBegin(); it != peers.constEnd(); ++it) {
+        if (it.value().task >= 0 && it.value().assigned.elapsed() > taskTimeoutMs) {
+            expired.append(it.key());
+        }
+    }
+
+    // A hung or wedged worker: its range counts as a failed attempt and is
+    // handed out again, and any late result from it is never read
+    for (QIODevice *socket : expired) {
+        qDebug() << "RangeCoordinator: Dropping" << peers[socket].name << "(range"
+                 << peers[socket].task << "timed out)";
+        dropPeer(socket);
+        socket->close();
+    }
+}
+
+// ===== Private Helper Functions =====
+
+void RangeCoordinator::addPeer(QIODevice *socket)
+{
+    peers.insert(socket, Peer());
+    connect(socket, &QIODevice::readyRead, this, [this, socket]() { readPeer(socket); });
+}
+
+void RangeCoordinator::readPeer(QIODevice *socket)
+{
+    if (!peers.contains(socket)) {
+        return;
+    }
+
+    peers[socket].buffer.append(socket->readAll());
+
+    int newline;
+    while (peers.contains(socket) && (newline = peers[socket].buffer.indexOf('\n')) >= 0) {
+        QByteArray line = peers[socket].buffer.left(newline).trimmed();
+        peers[socket].buffer.remove(0, newline + 1);
+        if (!line.isEmpty()) {
+            handleMessage(socket, line);
+        }
+    }
+
+    // A peer that never sends a newline does not get to grow the buffer
+    if (peers.contains(socket) && peers[socket].buffer.size() > MAX_MESSAGE_SIZE) {
+        qDebug() << "RangeCoordinator: Dropping" << peers[socket].name << "(message too large)";
+        socket->close();
+    }
+}
+
+void RangeCoordinator::dropPeer(QIODevice *socket)
+{
+    if (!peers.contains(socket)) {
+        return;
+    }
+
+    // The range it was working on goes to the next idle worker
+    Peer peer = peers.take(socket);
+    if (peer.ready) {
+        qDebug() << "RangeCoordinator: Lost worker" << peer.name;
+        emit workerLost(peer.name);
+    }
+    socket->deleteLater();
+
+    if (peer.task >= 0 && !finished &&
+        !retryRange(peer.task, QString("its worker (%1) was lost").arg(peer.name))) {
+        return;
+    }
+    dispatch();
+}
+
+void RangeCoordinator::handleMessage(QIODevice *socket, const QByteArray &line)
+{
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        qDebug() << "RangeCoordinator: Ignoring malformed message";
+        return;
+    }
+
+    QJsonObject message = document.object();
+    QString command = message.value("cmd").toString();
+
+    if (command == "hello") {
+        // Compared in full whatever the first difference, so response
+        // times do not reveal the token
+        QByteArray expected = token.toUtf8();
+        QByteArray presented = message.value("token").toString().toUtf8();
+        bool accepted = expected.size() == presented.size();
+        for (int i = 0; i < expected.size(); ++i) {
+            if (i >= presented.size() || expected.at(i) != presented.at(i)) {
+                accepted = false;
+            }
+        }
+        if (!accepted) {
+            qDebug() << "RangeCoordinator: Rejecting worker" << message.value("worker").toString() << "(bad token)";
+            send(socket, QJsonObject{{"cmd", "rejected"}, {"error", "Wrong or missing worker token"}});
+            socket->close();
+            return;
+        }
+
+        Peer &peer = peers[socket];
+        peer.name = message.value("worker").toString();
+        peer.ready = true;
+        ++workersSeen;
+        emit workerJoined(peer.name);
+
+        if (finished) {
+            send(socket, QJsonObject{{"cmd", "done"}});
+        } else {
+            dispatch();
+        }
+    } else if (command == "result" && peers.value(socket).ready) {
+        handleResult(socket, message);
+    } else {
+        qDebug() << "RangeCoordinator: Ignoring unknown command" << command;
+    }
+}
+
+void RangeCoordinator::handleResult(QIODevice *socket, const QJsonObject &message)
+{
+    RangeResult result = RangeVerifier::resultFromJson(message);
+    Peer &peer = peers[socket];
+
+    // Results of ranges this worker was not given (or of a finished run) are stale
+    if (finished || result.id != peer.task || result.id < 0 || result.id >= tasks.size()) {
+        return;
+    }
+    peer.task = -1;
+
+    if (!result.error.isEmpty()) {
+        const RangeTask &task = tasks.at(result.id);
+        qDebug() << "RangeCoordinator: Range" << task.id << "failed on" << peer.name << "-" << result.error;
+
+        if (retryRange(result.id, result.error)) {
+            dispatch();
+        }
+        return;
+    }
+
+    pieces.append(result.pieces);
+    for (const BadRangeMap::Range &range : result.badRanges.getRanges()) {
+        badRanges.addRange(range.offset, range.length, range.reason);
+    }
+    blocksChecked += result.blocksChecked;
+    knownGood += result.knownGood;
+    knownBad += result.knownBad;
+    ++rangesDone;
+    emit rangeVerified(rangesDone, tasks.size());
+
+    if (rangesDone == tasks.size()) {
+        finishDistribution(QString());
+    } else {
+        dispatch();
+    }
+}
+
+bool RangeCoordinator::retryRange(int id, const QString &reason)
+{
+    // Disconnects and timeouts count too, so a range that kills or hangs
+    // every worker it reaches cannot cycle forever
+    if (++attempts[id] >= MAX_RANGE_ATTEMPTS) {
+        finishDistribution(QString("Range at offset %1 failed %2 times, last: %3")
+                           .arg(tasks.at(id).offset).arg(MAX_RANGE_ATTEMPTS).arg(reason));
+        return false;
+    }
+
+    pending.prepend(id);
+    return true;
+}
+
+void RangeCoordinator::dispatch()
+{
+    if (!started || finished) {
+        return;
+    }
+
+    for (auto it = peers.begin(); it != peers.end() && !pending.isEmpty(); ++it) {
+        Peer &peer = it.value();
+        if (!peer.ready || peer.task >= 0) {
+            continue;
+        }
+
+        int id = pending.dequeue();
+        peer.task = id;
+        peer.assigned.start();
+        send(it.key(), RangeVerifier::taskToJson(tasks.at(id)));
+    }
+}
+
+void RangeCoordinator::finishDistribution(const QString &failure)
+{
+    finished = true;
+    taskTimer.stop();
+    for (auto it = peers.begin(); it != peers.end(); ++it) {
+        send(it.key(), QJsonObject{{"cmd", "done"}});
+    }
+
+    QString errorMessage = failure;
+    if (errorMessage.isEmpty()) {
+        std::sort(pieces.begin(), pieces.end(), [](const PieceHash &a, const PieceHash &b) {
+            return a.offset < b.offset;
+        });
+        if (!knownBlockIndexPath.isEmpty()) {
+            mergeReports(errorMessage);
+        }
+    }
+
+    if (!errorMessage.isEmpty()) {
+        emit error(errorMessage);
+        return;
+    }
+
+    qDebug() << "RangeCoordinator: Verified" << tasks.size() << "ranges with" << workersSeen << "workers";
+    emit distributionComplete();
+}
+
+bool RangeCoordinator::mergeReports(QString &errorMessage)
+{
+    QFile report(knownBlockReportPath);
+    if (!report.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errorMessage = "Failed to create hit report: " + report.errorString();
+        return false;
+    }
+
+    for (const RangeTask &task : tasks) {
+        QFile part(task.knownBlockReportPath);
+        if (!part.open(QIODevice::ReadOnly)) {
+            errorMessage = "Missing hit report part " + part.fileName();
+            return false;
+        }
+
+        // Every part starts with the CSV header; keep the first one only
+        if (task.id > 0) {
+            part.readLine();
+        }
+        report.write(part.readAll());
+        part.close();
+        part.remove();
+    }
+
+    report.close();
+    if (report.error() != QFileDevice::NoError) {
+        errorMessage = "Failed to write hit report: " + report.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString RangeCoordinator::reportPartPath(int task) const
+{
+    return QString("%1.part%2").arg(knownBlockReportPath).arg(task, 5, 10, QChar('0'));
+}
+
+void RangeCoordinator::send(QIODevice *socket, const QJsonObject &message)
+{
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    socket->write("\n");
+}
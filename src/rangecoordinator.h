@@ -0,0 +1,174 @@
+/*
+ * E01 Hash Verification Tool
+ * RangeCoordinator - Hands media ranges to worker processes and merges their results
+ */
+
+#ifndef RANGECOORDINATOR_H
+#define RANGECOORDINATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QMap>
+#include <QList>
+#include <QQueue>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QLocalServer>
+#include <QTcpServer>
+#include "rangeverifier.h"
+
+// Splits an image into ranges and hands them to RangeWorker processes,
+// possibly on other hosts that see the image at the same path. Workers
+// connect over a local socket or TCP ("tcp:HOST:PORT") and exchange one
+// JSON object per line:
+//
+//   worker -> {"cmd":"hello","worker":"host/pid","token":"..."}
+//          <- {"cmd":"range","task":3,"image":...,"offset":...,"length":...,...}
+//   worker -> {"cmd":"result","task":3,"pieces":[...],"badRanges":[...],...}
+//          <- next range, and so on
+//          <- {"cmd":"done"} when every range is verified
+//          <- {"cmd":"rejected","error":...} to a hello with the wrong token
+//
+// A TCP listener accepts workers from other hosts, so it requires a shared
+// token (generated if none is set); workers that do not present it are
+// never given ranges and their results are ignored. A local socket is
+// limited to the user and needs a token only if one is set.
+//
+// A worker takes one range at a time. The range of a worker that
+// disconnects, or that has not reported within the task timeout, is handed
+// to the next idle worker; either counts as a failed attempt, and a range
+// that fails MAX_RANGE_ATTEMPTS times fails the distribution. The image
+// MD5/SHA is not split: it needs one sequential stream and stays with the
+// caller.
+class RangeCoordinator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RangeCoordinator(QObject *parent = nullptr);
+    ~RangeCoordinator();
+
+    // Work to split (before start()); the range size is rounded to whole
+    // pieces, pieces to whole megabytes
+    void setImage(const QString &imagePath, qint64 mediaSize);
+    void setRangeSize(qint64 bytes);
+    void setPieceSize(qint64 bytes);
+
+    // Look every block up in a known-block index; workers write one part of
+    // the hit report per range, merged in media order at the end
+    void setKnownBlockIndex(const QString &indexPath, const QString &reportPath);
+
+    // Byte hashed in place of damaged chunks (default 0)
+    void setFillByte(quint8 fillByte);
+
+    // Seconds a worker may spend on one range before it is dropped and the
+    // range handed out again (0 = no limit)
+    void setTaskTimeout(int seconds);
+
+    // Token workers must present (before listen()); a TCP listener without
+    // one generates a random token, readable with getToken()
+    void setToken(const QString &token);
+    QString getToken() const;
+
+    // "tcp:HOST:PORT" (port 0 picks a free one) or a local socket name
+    bool listen(const QString &address);
+    QString serverAddress() const;
+
+    // Queue the ranges and hand them to connected (and later) workers
+    void start();
+
+    // Results (valid after distributionComplete)
+    PieceHashList getPieces() const;
+    BadRangeMap getBadRanges() const;
+    qint64 getBlocksChecked() const;
+    qint64 getKnownGood() const;
+    qint64 getKnownBad() const;
+    int getRangeCount() const;
+    int getWorkersSeen() const;
+
+    // Workers connected and accepted right now
+    int getConnectedWorkers() const;
+
+    // Splits "tcp:HOST:PORT"; false for a local socket name
+    static bool parseTcpAddress(const QString &address, QString &host, quint16 &port);
+
+signals:
+    void workerJoined(const QString &name);
+    void workerLost(const QString &name);
+    void rangeVerified(int rangesDone, int rangeCount);
+    void distributionComplete();
+    void error(const QString &errorMessage);
+
+private slots:
+    void onNewLocalConnection();
+    void onNewTcpConnection();
+    void onTaskTimer();
+
+private:
+    // Per-connection state; task is -1 while the worker is idle
+    struct Peer {
+        QByteArray buffer;
+        QString name;
+        bool ready = false;
+        int task = -1;
+        QElapsedTimer assigned;    // Since the current task was sent
+    };
+
+    void addPeer(QIODevice *socket);
+    void readPeer(QIODevice *socket);
+    void dropPeer(QIODevice *socket);
+    void handleMessage(QIODevice *socket, const QByteArray &line);
+    void handleResult(QIODevice *socket, const QJsonObject &message);
+    bool retryRange(int id, const QString &reason);
+    void dispatch();
+    void finishDistribution(const QString &failure);
+    bool mergeReports(QString &errorMessage);
+    QString reportPartPath(int task) const;
+    void send(QIODevice *socket, const QJsonObject &message);
+
+    QLocalServer localServer;
+    QTcpServer tcpServer;
+    QString address;
+    QString token;
+    QTimer taskTimer;
+
+    // Work
+    QString imagePath;
+    qint64 mediaSize;
+    qint64 rangeSize;
+    qint64 pieceSize;
+    QString knownBlockIndexPath;
+    QString knownBlockReportPath;
+    quint8 fillByte;
+    qint64 taskTimeoutMs;
+    QList<RangeTask> tasks;
+    QList<int> attempts;
+    QQueue<int> pending;
+    int rangesDone;
+    bool started;
+    bool finished;
+
+    // Workers
+    QMap<QIODevice*, Peer> peers;
+    int workersSeen;
+
+    // Merged results
+    PieceHashList pieces;
+    BadRangeMap badRanges;
+    qint64 blocksChecked;
+    qint64 knownGood;
+    qint64 knownBad;
+
+    // Constants
+    static const qint64 DEFAULT_RANGE_SIZE = 1024LL * 1024 * 1024;   // 1GB per range
+    static const qint64 PIECE_ALIGNMENT = 1024 * 1024;
+    static const int MAX_RANGE_ATTEMPTS = 3;
+    static const int DEFAULT_TASK_TIMEOUT_S = 1800;    // A 1GB range with lookups on a slow share
+    static const int TASK_CHECK_MS = 5000;
+    static const int TOKEN_BYTES = 16;
+    static const int MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+};
+
+#endif // RANGECOORDINATOR_H
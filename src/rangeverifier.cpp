@@ -0,0 +1,219 @@
+/*
+ * E01 Hash Verification Tool
+ * RangeVerifier Implementation
+ */
+
+#include "rangeverifier.h"
+#include "knownblockstage.h"
+#include "hashdigest.h"
+#include <QDebug>
+#include <QByteArray>
+#include <QJsonArray>
+#include <QScopedPointer>
+#include <cstring>
+
+namespace {
+
+// Offsets travel as JSON numbers, exact up to 2^53 bytes
+qint64 toInt64(const QJsonValue &value)
+{
+    return static_cast<qint64>(value.toDouble());
+}
+
+}
+
+RangeVerifier::RangeVerifier()
+{
+}
+
+RangeVerifier::~RangeVerifier()
+{
+    ewfHandler.close();
+}
+
+RangeResult RangeVerifier::verify(const RangeTask &task)
+{
+    RangeResult result;
+    result.id = task.id;
+
+    if (!openImage(task.imagePath, result.error)) {
+        return result;
+    }
+
+    qint64 end = qMin(task.offset + task.length, ewfHandler.getMediaSize());
+    qint64 pieceSize = task.pieceSize > 0 ? task.pieceSize : task.length;
+
+    // Block lookups run on the stage's own thread while this one reads
+    QScopedPointer<KnownBlockStage> knownBlockStage;
+    if (!task.knownBlockIndexPath.isEmpty()) {
+        knownBlockStage.reset(new KnownBlockStage(task.knownBlockIndexPath, task.knownBlockReportPath));
+        if (!knownBlockStage->startStage()) {
+            result.error = knownBlockStage->getLastError();
+            return result;
+        }
+    }
+
+    for (qint64 pieceStart = task.offset; pieceStart < end; pieceStart += pieceSize) {
+        PieceHash piece;
+        piece.offset = pieceStart;
+        piece.length = qMin(pieceSize, end - pieceStart);
+
+        HashDigest digest(true, true, false);
+        if (!digest.isValid()) {
+            result.error = "Failed to initialize piece hash";
+            return result;
+        }
+
+        qint64 badBytesBefore = result.badRanges.getBadBytes();
+        for (qint64 pos = 0; pos < piece.length; pos += READ_SIZE) {
+            qint64 size = qMin(READ_SIZE, piece.length - pos);
+
+            // The stage keeps a reference to each block, so each read needs its own
+            QByteArray block(static_cast<int>(size), Qt::Uninitialized);
+            ewfHandler.readWithSubstitution(block.data(), size, pieceStart + pos,
+                                            static_cast<char>(task.fillByte), result.badRanges);
+
+            if (knownBlockStage) {
+                knownBlockStage->submit(block, pieceStart + pos);
+            }
+            digest.update(block.constData(), size);
+        }
+
+        QMap<QString, QString> hashes = digest.finish();
+        piece.md5 = hashes.value("MD5");
+        piece.sha1 = hashes.value("SHA1");
+        piece.damaged = result.badRanges.getBadBytes() > badBytesBefore;
+        result.pieces.append(piece);
+    }
+
+    if (knownBlockStage) {
+        if (!knownBlockStage->finish()) {
+            result.error = knownBlockStage->getLastError();
+            return result;
+        }
+        result.blocksChecked = knownBlockStage->getBlocksChecked();
+        result.knownGood = knownBlockStage->getKnownGood();
+        result.knownBad = knownBlockStage->getKnownBad();
+    }
+
+    qDebug() << "RangeVerifier: Range" << task.id << "at" << task.offset << "-"
+             << result.pieces.size() << "pieces," << result.badRanges.getBadBytes() << "damaged bytes";
+    return result;
+}
+
+QJsonObject RangeVerifier::taskToJson(const RangeTask &task)
+{
+    QJsonObject object;
+    object.insert("cmd", "range");
+    object.insert("task", task.id);
+    object.insert("image", task.imagePath);
+    object.insert("offset", task.offset);
+    object.insert("length", task.length);
+    object.insert("pieceSize", task.pieceSize);
+    object.insert("fillByte", task.fillByte);
+    if (!task.knownBlockIndexPath.isEmpty()) {
+        object.insert("knownBlocks", task.knownBlockIndexPath);
+        object.insert("knownBlocksReport", task.knownBlockReportPath);
+    }
+    return object;
+}
+
+RangeTask RangeVerifier::taskFromJson(const QJsonObject &object)
+{
+    RangeTask task;
+    task.id = object.value("task").toInt();
+    task.imagePath = object.value("image").toString();
+    task.offset = toInt64(object.value("offset"));
+    task.length = toInt64(object.value("length"));
+    task.pieceSize = toInt64(object.value("pieceSize"));
+    task.fillByte = static_cast<quint8>(object.value("fillByte").toInt());
+    task.knownBlockIndexPath = object.value("knownBlocks").toString();
+    task.knownBlockReportPath = object.value("knownBlocksReport").toString();
+    return task;
+}
+
+QJsonObject RangeVerifier::resultToJson(const RangeResult &result)
+{
+    QJsonArray pieces;
+    for (const PieceHash &piece : result.pieces) {
+        QJsonObject entry;
+        entry.insert("offset", piece.offset);
+        entry.insert("length", piece.length);
+        entry.insert("md5", piece.md5);
+        entry.insert("sha1", piece.sha1);
+        entry.insert("damaged", piece.damaged);
+        pieces.append(entry);
+    }
+
+    QJsonArray badRanges;
+    for (const BadRangeMap::Range &range : result.badRanges.getRanges()) {
+        QJsonObject entry;
+        entry.insert("offset", range.offset);
+        entry.insert("length", range.length);
+        entry.insert("checksum", range.reason == BadRangeMap::CHECKSUM_ERROR);
+        badRanges.append(entry);
+    }
+
+    QJsonObject object;
+    object.insert("cmd", "result");
+    object.insert("task", result.id);
+    object.insert("pieces", pieces);
+    object.insert("badRanges", badRanges);
+    object.insert("blocksChecked", result.blocksChecked);
+    object.insert("knownGood", result.knownGood);
+    object.insert("knownBad", result.knownBad);
+    if (!result.error.isEmpty()) {
+        object.insert("error", result.error);
+    }
+    return object;
+}
+
+RangeResult RangeVerifier::resultFromJson(const QJsonObject &object)
+{
+    RangeResult result;
+    result.id = object.value("task").toInt();
+
+    for (const QJsonValue &value : object.value("pieces").toArray()) {
+        QJsonObject entry = value.toObject();
+        PieceHash piece;
+        piece.offset = toInt64(entry.value("offset"));
+        piece.length = toInt64(entry.value("length"));
+        piece.md5 = entry.value("md5").toString();
+        piece.sha1 = entry.value("sha1").toString();
+        piece.damaged = entry.value("damaged").toBool();
+        result.pieces.append(piece);
+    }
+
+    for (const QJsonValue &value : object.value("badRanges").toArray()) {
+        QJsonObject entry = value.toObject();
+        result.badRanges.addRange(toInt64(entry.value("offset")), toInt64(entry.value("length")),
+                                  entry.value("checksum").toBool() ? BadRangeMap::CHECKSUM_ERROR
+                                                                   : BadRangeMap::READ_ERROR);
+    }
+
+    result.blocksChecked = toInt64(object.value("blocksChecked"));
+    result.knownGood = toInt64(object.value("knownGood"));
+    result.knownBad = toInt64(object.value("knownBad"));
+    result.error = object.value("error").toString();
+    return result;
+}
+
+// ===== Private Helper Functions =====
+
+bool RangeVerifier::openImage(const QString &path, QString &errorMessage)
+{
+    if (ewfHandler.isOpen() && openPath == path) {
+        return true;
+    }
+
+    ewfHandler.close();
+    openPath.clear();
+
+    if (!ewfHandler.open(path)) {
+        errorMessage = "Cannot open " + path + ": " + ewfHandler.getLastError();
+        return false;
+    }
+
+    openPath = path;
+    return true;
+}
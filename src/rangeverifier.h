@@ -0,0 +1,84 @@
+/*
+ * E01 Hash Verification Tool
+ * RangeVerifier - Chunk validation, piecewise hashes and block lookups for one media range
+ */
+
+#ifndef RANGEVERIFIER_H
+#define RANGEVERIFIER_H
+
+#include <QString>
+#include <QList>
+#include <QJsonObject>
+#include "ewfhandler.h"
+#include "badrangemap.h"
+
+// One range of the media, handed by a RangeCoordinator to a worker
+struct RangeTask
+{
+    int id = 0;
+    QString imagePath;
+    qint64 offset = 0;
+    qint64 length = 0;
+    qint64 pieceSize = 0;            // Pieces are hashed separately (0 = the whole range)
+    quint8 fillByte = 0;             // Hashed in place of damaged chunks
+    QString knownBlockIndexPath;     // Empty: no block lookup
+    QString knownBlockReportPath;    // This range's part of the hit report
+};
+
+// MD5 and SHA1 of one piece of the media; damaged chunks are hashed as the
+// task's fill byte
+struct PieceHash
+{
+    qint64 offset = 0;
+    qint64 length = 0;
+    QString md5;
+    QString sha1;
+    bool damaged = false;
+};
+
+typedef QList<PieceHash> PieceHashList;
+
+// Everything a worker found in one range
+struct RangeResult
+{
+    int id = 0;
+    PieceHashList pieces;
+    BadRangeMap badRanges;
+    qint64 blocksChecked = 0;
+    qint64 knownGood = 0;
+    qint64 knownBad = 0;
+    QString error;                   // Empty unless the range could not be processed
+};
+
+// The range-parallel part of a verification: every chunk of the range is
+// read (libewf inflates it and checks its stored checksum), each piece is
+// hashed, and every block is looked up in a known-block index. Unlike the
+// image MD5/SHA, none of this depends on the bytes before the range, so a
+// coordinator can spread the ranges of one image over many processes.
+//
+// The image handle is kept open between ranges of the same image.
+class RangeVerifier
+{
+public:
+    RangeVerifier();
+    ~RangeVerifier();
+
+    RangeResult verify(const RangeTask &task);
+
+    // Wire format (one JSON object per line between coordinator and worker)
+    static QJsonObject taskToJson(const RangeTask &task);
+    static RangeTask taskFromJson(const QJsonObject &object);
+    static QJsonObject resultToJson(const RangeResult &result);
+    static RangeResult resultFromJson(const QJsonObject &object);
+
+private:
+    bool openImage(const QString &path, QString &errorMessage);
+
+    EWFHandler ewfHandler;
+    QString openPath;
+
+    // Constants
+    static const qint64 READ_SIZE = 1024 * 1024;  // 1MB reads
+};
+
+#endif // RANGEVERIFIER_H
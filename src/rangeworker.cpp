@@ -0,0 +1,126 @@
+/*
+ * E01 Hash Verification Tool
+ * RangeWorker Implementation
+ */
+
+#include "rangeworker.h"
+#include "rangecoordinator.h"
+#include <QDebug>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QSysInfo>
+
+RangeWorker::RangeWorker(QObject *parent)
+    : QObject(parent)
+    , socket(nullptr)
+    , rangesVerified(0)
+    , done(false)
+{
+}
+
+bool RangeWorker::connectTo(const QString &address, const QString &token)
+{
+    QString host;
+    quint16 port = 0;
+
+    if (RangeCoordinator::parseTcpAddress(address, host, port)) {
+        QTcpSocket *tcpSocket = new QTcpSocket(this);
+        tcpSocket->connectToHost(host, port);
+        if (!tcpSocket->waitForConnected(CONNECT_TIMEOUT_MS)) {
+            emit error("Cannot connect to " + address + ": " + tcpSocket->errorString());
+            delete tcpSocket;
+            return false;
+        }
+        connect(tcpSocket, &QTcpSocket::disconnected, this, &RangeWorker::onDisconnected);
+        socket = tcpSocket;
+    } else {
+        QLocalSocket *localSocket = new QLocalSocket(this);
+        localSocket->connectToServer(address);
+        if (!localSocket->waitForConnected(CONNECT_TIMEOUT_MS)) {
+            emit error("Cannot connect to " + address + ": " + localSocket->errorString());
+            delete localSocket;
+            return false;
+        }
+        connect(localSocket, &QLocalSocket::disconnected, this, &RangeWorker::onDisconnected);
+        socket = localSocket;
+    }
+
+    connect(socket, &QIODevice::readyRead, this, &RangeWorker::onReadyRead);
+
+    QString name = QString("%1/%2").arg(QSysInfo::machineHostName()).arg(QCoreApplication::applicationPid());
+    send(QJsonObject{{"cmd", "hello"}, {"worker", name}, {"token", token}});
+
+    qDebug() << "RangeWorker: Connected to" << address << "as" << name;
+    return true;
+}
+
+int RangeWorker::getRangesVerified() const
+{
+    return rangesVerified;
+}
+
+// ===== Slot Implementations =====
+
+void RangeWorker::onReadyRead()
+{
+    buffer.append(socket->readAll());
+
+    int newline;
+    while (!done && (newline = buffer.indexOf('\n')) >= 0) {
+        QByteArray line = buffer.left(newline).trimmed();
+        buffer.remove(0, newline + 1);
+        if (!line.isEmpty()) {
+            handleMessage(line);
+        }
+    }
+}
+
+void RangeWorker::onDisconnected()
+{
+    if (!done) {
+        done = true;
+        emit error("Coordinator closed the connection");
+    }
+}
+
+// ===== Private Helper Functions =====
+
+void RangeWorker::handleMessage(const QByteArray &line)
+{
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        qDebug() << "RangeWorker: Ignoring malformed message";
+        return;
+    }
+
+    QJsonObject message = document.object();
+    QString command = message.value("cmd").toString();
+
+    if (command == "range") {
+        RangeTask task = RangeVerifier::taskFromJson(message);
+        RangeResult result = verifier.verify(task);
+        if (result.error.isEmpty()) {
+            ++rangesVerified;
+        }
+        send(RangeVerifier::resultToJson(result));
+    } else if (command == "rejected") {
+        done = true;
+        emit error("Coordinator rejected this worker: " + message.value("error").toString());
+    } else if (command == "done") {
+        done = true;
+        qDebug() << "RangeWorker: Done after" << rangesVerified << "ranges";
+        emit finished(rangesVerified);
+    } else {
+        qDebug() << "RangeWorker: Ignoring unknown command" << command;
+    }
+}
+
+void RangeWorker::send(const QJsonObject &message)
+{
+    socket->write(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    socket->write("\n");
+}
@@ -0,0 +1,57 @@
+/*
+ * E01 Hash Verification Tool
+ * RangeWorker - Worker process side of range-parallel verification
+ */
+
+#ifndef RANGEWORKER_H
+#define RANGEWORKER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QIODevice>
+#include "rangeverifier.h"
+
+// Connects to a RangeCoordinator, verifies the ranges it is handed one at a
+// time and reports each result, until the coordinator says it is done.
+// Ranges are verified on the worker's own thread: the process does nothing
+// else, and the coordinator's messages simply wait in the socket meanwhile.
+class RangeWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RangeWorker(QObject *parent = nullptr);
+
+    // "tcp:HOST:PORT" or a local socket name, as given by the coordinator,
+    // and the coordinator's worker token (required over TCP)
+    bool connectTo(const QString &address, const QString &token = QString());
+
+    int getRangesVerified() const;
+
+signals:
+    // The coordinator has no more ranges
+    void finished(int rangesVerified);
+
+    void error(const QString &errorMessage);
+
+private slots:
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    void handleMessage(const QByteArray &line);
+    void send(const QJsonObject &message);
+
+    QIODevice *socket;
+    QByteArray buffer;
+    RangeVerifier verifier;
+    int rangesVerified;
+    bool done;
+
+    // Constants
+    static const int CONNECT_TIMEOUT_MS = 10000;
+};
+
+#endif // RANGEWORKER_H
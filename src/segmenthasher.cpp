@@ -0,0 +1,210 @@
+/*
+ * E01 Hash Verification Tool
+ * SegmentHasher Implementation
+ */
+
+#include "segmenthasher.h"
+#include "jobtelemetry.h"
+#include "jobcontrol.h"
+#include "pipelinetrace.h"
+#include "hashdigest.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QStorageInfo>
+#include <QThreadPool>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+#endif
+
+SegmentHasher::SegmentHasher(const QStringList &segmentFiles, QObject *parent)
+    : QThread(parent)
+    , segmentFiles(segmentFiles)
+    , perDeviceLimit(DEFAULT_PER_DEVICE_LIMIT)
+    , telemetry(nullptr)
+    , control(nullptr)
+    , trace(nullptr)
+    , bytesHashed(0)
+    , cancelled(0)
+{
+}
+
+SegmentHasher::~SegmentHasher()
+{
+    // Wait for thread to finish
+    if (isRunning()) {
+        cancel();
+        wait();
+    }
+}
+
+void SegmentHasher::setPerDeviceLimit(int limit)
+{
+    perDeviceLimit = qMax(1, limit);
+}
+
+void SegmentHasher::setTelemetry(JobTelemetry *telemetry)
+{
+    this->telemetry = telemetry;
+}
+
+void SegmentHasher::setJobControl(JobControl *control)
+{
+    this->control = control;
+}
+
+void SegmentHasher::setTrace(PipelineTrace *trace)
+{
+    this->trace = trace;
+}
+
+SegmentHashList SegmentHasher::getResults() const
+{
+    return results;
+}
+
+qint64 SegmentHasher::getBytesHashed() const
+{
+    return bytesHashed.loadAcquire();
+}
+
+void SegmentHasher::cancel()
+{
+    cancelled.storeRelease(1);
+}
+
+void SegmentHasher::run()
+{
+    qDebug() << "SegmentHasher: Hashing" << segmentFiles.size() << "segment files";
+
+    bytesHashed = 0;
+    results.clear();
+    for (const QString &path : segmentFiles) {
+        SegmentHash hash;
+        hash.path = path;
+        results.append(hash);
+    }
+
+    // One pool per device: every segment gets its own task, and the pool's
+    // thread limit caps how many of them read from that device at once.
+    // Tasks are queued in segment order so each device is read front to back.
+    QMap<QString, QThreadPool*> pools;
+    for (int i = 0; i < segmentFiles.size(); ++i) {
+        QString device = deviceKey(segmentFiles.at(i));
+        QThreadPool *pool = pools.value(device, nullptr);
+        if (pool == nullptr) {
+            pool = new QThreadPool();
+            pool->setMaxThreadCount(perDeviceLimit);
+            pools.insert(device, pool);
+        }
+        pool->start([this, i]() {
+            hashSegment(i);
+        });
+    }
+
+    for (QThreadPool *pool : pools) {
+        pool->waitForDone();
+    }
+    int deviceCount = pools.size();
+    qDeleteAll(pools);
+
+    if (cancelled.loadAcquire()) {
+        qDebug() << "SegmentHasher: Cancelled";
+        return;
+    }
+
+    emit segmentHashesCalculated(results);
+
+    qDebug() << "SegmentHasher: Hashed" << getBytesHashed() << "bytes across"
+             << deviceCount << "device(s)";
+}
+
+// ===== Private Helper Functions =====
+
+void SegmentHasher::hashSegment(int index)
+{
+    if (cancelled.loadAcquire()) {
+        return;
+    }
+
+    if (control) {
+        control->applyPriority();
+    }
+    PipelineTrace::ThreadScope traceScope(trace, "segment hasher");
+
+    SegmentHash &result = results[index];
+
+    QFile file(result.path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        result.error = file.errorString();
+        return;
+    }
+
+#ifndef _WIN32
+    // The whole file is read once, front to back
+    posix_fadvise(file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    HashDigest digest(true, true, false);
+    if (!digest.isValid()) {
+        result.error = "Failed to initialize segment hash";
+        return;
+    }
+
+    QByteArray buffer(static_cast<int>(READ_SIZE), Qt::Uninitialized);
+    qint64 total = 0;
+
+    while (!cancelled.loadAcquire()) {
+        qint64 bytesRead;
+        {
+            PipelineTrace::Span span(PipelineTrace::EVENT_SEGMENT_READ, total, READ_SIZE);
+            bytesRead = file.read(buffer.data(), READ_SIZE);
+        }
+        if (bytesRead < 0) {
+            result.error = file.errorString();
+            break;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+
+        {
+            PipelineTrace::Span span(PipelineTrace::EVENT_SEGMENT_HASH, total, bytesRead);
+            digest.update(buffer.constData(), bytesRead);
+        }
+        total += bytesRead;
+        bytesHashed.fetchAndAddOrdered(bytesRead);
+        if (telemetry) {
+            telemetry->addToCounter(JobTelemetry::COUNTER_SEGMENT_BYTES, bytesRead);
+        }
+
+        // Shares the job's bandwidth limit, and holds while it is paused
+        if (control && !control->throttle(bytesRead)) {
+            cancelled.storeRelease(1);
+        }
+    }
+
+    if (cancelled.loadAcquire() || !result.error.isEmpty()) {
+        return;
+    }
+
+    QMap<QString, QString> digests = digest.finish();
+    result.size = total;
+    result.md5 = digests.value("MD5");
+    result.sha1 = digests.value("SHA1");
+
+    qDebug() << "SegmentHasher:" << QFileInfo(result.path).fileName() << result.md5;
+}
+
+QString SegmentHasher::deviceKey(const QString &path)
+{
+    // Device node on Unix, volume root on Windows
+    QStorageInfo storage(path);
+    if (!storage.isValid()) {
+        return QString();
+    }
+    QByteArray device = storage.device();
+    return device.isEmpty() ? storage.rootPath() : QString::fromLocal8Bit(device);
+}
@@ -0,0 +1,95 @@
+/*
+ * E01 Hash Verification Tool
+ * SegmentHasher - Container-file hashes of every segment (.E01 ... .Exx)
+ */
+
+#ifndef SEGMENTHASHER_H
+#define SEGMENTHASHER_H
+
+#include <QThread>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QAtomicInt>
+#include <QMetaType>
+
+class JobTelemetry;
+class JobControl;
+class PipelineTrace;
+
+// Hashes of one segment file as stored on disk
+struct SegmentHash
+{
+    QString path;
+    qint64 size = 0;
+    QString md5;
+    QString sha1;
+    QString error;    // Empty unless the file could not be read
+};
+
+typedef QList<SegmentHash> SegmentHashList;
+
+Q_DECLARE_METATYPE(SegmentHashList)
+
+// Hashes each segment file in its own worker. Workers on the same device are
+// limited so a single disk is not thrashed by competing sequential reads;
+// segments on different devices proceed fully in parallel. HashEngine only
+// starts it once the media read is done, so it never competes with libewf
+// for the disk; an image opened through memory maps needs no SegmentHasher
+// (MmapFileIO hashes the segments as libewf reads them).
+class SegmentHasher : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit SegmentHasher(const QStringList &segmentFiles, QObject *parent = nullptr);
+    ~SegmentHasher();
+
+    // Concurrent readers per device (1 suits spinning disks)
+    void setPerDeviceLimit(int limit);
+
+    // Publish bytes read in the job's telemetry (optional)
+    void setTelemetry(JobTelemetry *telemetry);
+
+    // Pause, throttle and priority of the job this belongs to (optional)
+    void setJobControl(JobControl *control);
+
+    // Record reads and hash updates on the job's timeline (optional)
+    void setTrace(PipelineTrace *trace);
+
+    // Results, in segment order (valid once the thread has finished)
+    SegmentHashList getResults() const;
+    qint64 getBytesHashed() const;
+
+    // Control
+    void cancel();
+
+signals:
+    void segmentHashesCalculated(const SegmentHashList &hashes);
+
+protected:
+    void run() override;
+
+private:
+    void hashSegment(int index);
+    static QString deviceKey(const QString &path);
+
+    QStringList segmentFiles;
+    SegmentHashList results;
+    int perDeviceLimit;
+    JobTelemetry *telemetry;
+    JobControl *control;
+    PipelineTrace *trace;
+
+    // Shared worker state
+    QAtomicInteger<qint64> bytesHashed;
+
+    // Control flags (set by cancel() and by any worker whose job is cancelled)
+    QAtomicInt cancelled;
+
+    // Constants
+    static const int DEFAULT_PER_DEVICE_LIMIT = 2;
+    static const qint64 READ_SIZE = 1024 * 1024;  // 1MB reads
+};
+
+#endif // SEGMENTHASHER_H
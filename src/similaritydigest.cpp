@@ -0,0 +1,356 @@
+/*
+ * E01 Hash Verification Tool
+ * SimilarityDigest Implementation
+ */
+
+#include "similaritydigest.h"
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+#include <cstring>
+
+namespace {
+
+const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Runs of more than three identical characters carry little information
+// and are collapsed before comparison (as ssdeep does)
+QByteArray eliminateSequences(const QByteArray &input)
+{
+    QByteArray output;
+    output.reserve(input.size());
+
+    for (int i = 0; i < input.size(); ++i) {
+        if (i >= 3 && input[i] == input[i - 1] && input[i] == input[i - 2] && input[i] == input[i - 3]) {
+            continue;
+        }
+        output.append(input[i]);
+    }
+
+    return output;
+}
+
+// Two signatures only score if they share a run of ROLLING_WINDOW characters
+bool hasCommonSubstring(const QByteArray &s1, const QByteArray &s2, int length)
+{
+    if (s1.size() < length || s2.size() < length) {
+        return false;
+    }
+
+    for (int i = 0; i + length <= s1.size(); ++i) {
+        for (int j = 0; j + length <= s2.size(); ++j) {
+            if (memcmp(s1.constData() + i, s2.constData() + j, length) == 0) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Weighted edit distance: insert / delete cost 1, substitution cost 2
+quint32 editDistance(const QByteArray &s1, const QByteArray &s2)
+{
+    QVector<quint32> previous(s2.size() + 1);
+    QVector<quint32> current(s2.size() + 1);
+
+    for (int j = 0; j <= s2.size(); ++j) {
+        previous[j] = j;
+    }
+
+    for (int i = 0; i < s1.size(); ++i) {
+        current[0] = i + 1;
+        for (int j = 0; j < s2.size(); ++j) {
+            quint32 cost = (s1[i] == s2[j]) ? 0 : 2;
+            current[j + 1] = qMin(qMin(previous[j + 1] + 1, current[j] + 1), previous[j] + cost);
+        }
+        previous.swap(current);
+    }
+
+    return previous[s2.size()];
+}
+
+} // namespace
+
+SimilarityDigest::SimilarityDigest()
+    : fixedSize(0)
+{
+    reset();
+}
+
+void SimilarityDigest::setTotalSize(quint64 size)
+{
+    fixedSize = size;
+}
+
+void SimilarityDigest::reset()
+{
+    memset(window, 0, sizeof(window));
+    h1 = 0;
+    h2 = 0;
+    h3 = 0;
+    windowPos = 0;
+
+    bhStart = 0;
+    bhEnd = 1;
+    blockHashes[0].h = HASH_INIT;
+    blockHashes[0].halfh = HASH_INIT;
+    blockHashes[0].digest[0] = '\0';
+    blockHashes[0].halfdigest = '\0';
+    blockHashes[0].dlen = 0;
+
+    lastHash = 0;
+    needLastHash = false;
+    totalSize = 0;
+}
+
+void SimilarityDigest::update(const char *data, qint64 size)
+{
+    const quint8 *bytes = reinterpret_cast<const quint8*>(data);
+
+    for (qint64 i = 0; i < size; ++i) {
+        step(bytes[i]);
+    }
+
+    totalSize += static_cast<quint64>(size);
+}
+
+QString SimilarityDigest::digest() const
+{
+    quint32 bi = bhStart;
+    quint32 h = h1 + h2 + h3;
+
+    // Initial block size guess from the input length
+    while (blockSizeAt(bi) * SPAMSUM_LENGTH < totalSize) {
+        ++bi;
+        if (bi >= NUM_BLOCKHASHES) {
+            return QString();
+        }
+    }
+
+    // Halve it while the signature would be too short
+    while (bi >= bhEnd) {
+        --bi;
+    }
+    while (bi > bhStart && blockHashes[bi].dlen < SPAMSUM_LENGTH / 2) {
+        --bi;
+    }
+
+    QByteArray result = QByteArray::number(blockSizeAt(bi));
+    result.append(':');
+
+    // First signature: block size bi
+    const BlockHash &first = blockHashes[bi];
+    result.append(first.digest, static_cast<int>(first.dlen));
+    if (h != 0) {
+        result.append(BASE64[first.h % 64]);
+    } else if (first.digest[first.dlen] != '\0') {
+        result.append(first.digest[first.dlen]);
+    }
+
+    result.append(':');
+
+    // Second signature: block size 2 * bi, truncated to half length
+    if (bi < bhEnd - 1) {
+        const BlockHash &second = blockHashes[bi + 1];
+        quint32 length = qMin(second.dlen, SPAMSUM_LENGTH / 2 - 1);
+        result.append(second.digest, static_cast<int>(length));
+        if (h != 0) {
+            result.append(BASE64[second.halfh % 64]);
+        } else if (second.halfdigest != '\0') {
+            result.append(second.halfdigest);
+        }
+    } else if (h != 0) {
+        result.append(BASE64[(bi == 0 ? first.h : lastHash) % 64]);
+    }
+
+    return QString::fromLatin1(result);
+}
+
+int SimilarityDigest::compare(const QString &digest1, const QString &digest2)
+{
+    QStringList regions1 = digest1.split(QLatin1Char(REGION_SEPARATOR));
+    QStringList regions2 = digest2.split(QLatin1Char(REGION_SEPARATOR));
+    if (regions1.size() == 1 && regions2.size() == 1) {
+        return compareSingle(digest1, digest2);
+    }
+
+    // Regions are fixed-size, so region i covers the same media range on
+    // both sides; a region only one side has scores 0
+    int common = qMin(regions1.size(), regions2.size());
+    int total = 0;
+    for (int i = 0; i < common; ++i) {
+        total += compareSingle(regions1[i], regions2[i]);
+    }
+
+    return total / qMax(regions1.size(), regions2.size());
+}
+
+// ===== Private Helper Functions =====
+
+int SimilarityDigest::compareSingle(const QString &digest1, const QString &digest2)
+{
+    QList<QByteArray> parts1 = digest1.toLatin1().split(':');
+    QList<QByteArray> parts2 = digest2.toLatin1().split(':');
+    if (parts1.size() < 3 || parts2.size() < 3) {
+        return 0;
+    }
+
+    bool ok1 = false;
+    bool ok2 = false;
+    quint64 blockSize1 = parts1[0].toULongLong(&ok1);
+    quint64 blockSize2 = parts2[0].toULongLong(&ok2);
+    if (!ok1 || !ok2) {
+        return 0;
+    }
+
+    // Only digests at the same or adjacent block sizes are comparable
+    if (blockSize1 != blockSize2 && blockSize1 * 2 != blockSize2 && blockSize2 * 2 != blockSize1) {
+        return 0;
+    }
+
+    // ssdeep appends ',"filename"' to the second signature
+    QByteArray s1b1 = eliminateSequences(parts1[1]);
+    QByteArray s1b2 = eliminateSequences(parts1[2].split(',').first());
+    QByteArray s2b1 = eliminateSequences(parts2[1]);
+    QByteArray s2b2 = eliminateSequences(parts2[2].split(',').first());
+
+    if (blockSize1 == blockSize2 && s1b1 == s2b1 && s1b2 == s2b2) {
+        return 100;
+    }
+
+    auto scoreStrings = [](const QByteArray &s1, const QByteArray &s2, quint64 blockSize) -> quint32 {
+        if (s1.size() > static_cast<int>(SPAMSUM_LENGTH) || s2.size() > static_cast<int>(SPAMSUM_LENGTH)) {
+            return 0;
+        }
+        if (!hasCommonSubstring(s1, s2, ROLLING_WINDOW)) {
+            return 0;
+        }
+
+        quint32 score = editDistance(s1, s2);
+        score = (score * SPAMSUM_LENGTH) / (s1.size() + s2.size());
+        score = (100 * score) / SPAMSUM_LENGTH;
+        if (score >= 100) {
+            return 0;
+        }
+        score = 100 - score;
+
+        // Small block sizes cannot support a high score on short signatures
+        if (blockSize >= (99 + ROLLING_WINDOW) / ROLLING_WINDOW * MIN_BLOCKSIZE) {
+            return score;
+        }
+        quint64 cap = blockSize / MIN_BLOCKSIZE * static_cast<quint64>(qMin(s1.size(), s2.size()));
+        return static_cast<quint32>(qMin<quint64>(score, cap));
+    };
+
+    quint32 score;
+    if (blockSize1 == blockSize2) {
+        score = qMax(scoreStrings(s1b1, s2b1, blockSize1), scoreStrings(s1b2, s2b2, blockSize1 * 2));
+    } else if (blockSize1 * 2 == blockSize2) {
+        score = scoreStrings(s2b1, s1b2, blockSize2);
+    } else {
+        score = scoreStrings(s1b1, s2b2, blockSize1);
+    }
+
+    return static_cast<int>(score);
+}
+
+void SimilarityDigest::step(quint8 c)
+{
+    // Rolling hash
+    h2 -= h1;
+    h2 += ROLLING_WINDOW * static_cast<quint32>(c);
+    h1 += c;
+    h1 -= window[windowPos];
+    window[windowPos] = c;
+    if (++windowPos == ROLLING_WINDOW) {
+        windowPos = 0;
+    }
+    h3 <<= 5;
+    h3 ^= c;
+
+    quint32 h = h1 + h2 + h3;
+
+    // Piece hashes for every active block size
+    for (quint32 i = bhStart; i < bhEnd; ++i) {
+        blockHashes[i].h = (blockHashes[i].h * HASH_PRIME) ^ c;
+        blockHashes[i].halfh = (blockHashes[i].halfh * HASH_PRIME) ^ c;
+    }
+    if (needLastHash) {
+        lastHash = (lastHash * HASH_PRIME) ^ c;
+    }
+
+    // Trigger points: a trigger for block size 2b is also one for b, so
+    // the first block size that does not trigger ends the scan
+    for (quint32 i = bhStart; i < bhEnd; ++i) {
+        quint64 blockSize = blockSizeAt(i);
+        if (h % blockSize != blockSize - 1) {
+            break;
+        }
+
+        BlockHash &bh = blockHashes[i];
+        if (bh.dlen == 0) {
+            tryForkBlockHash();
+        }
+
+        bh.digest[bh.dlen] = BASE64[bh.h % 64];
+        bh.halfdigest = BASE64[bh.halfh % 64];
+
+        if (bh.dlen < SPAMSUM_LENGTH - 1) {
+            bh.digest[++bh.dlen] = '\0';
+            bh.h = HASH_INIT;
+            if (bh.dlen < SPAMSUM_LENGTH / 2) {
+                bh.halfh = HASH_INIT;
+            }
+        } else {
+            tryReduceBlockHash();
+        }
+    }
+}
+
+void SimilarityDigest::tryForkBlockHash()
+{
+    if (bhEnd < NUM_BLOCKHASHES) {
+        const BlockHash &previous = blockHashes[bhEnd - 1];
+        BlockHash &next = blockHashes[bhEnd];
+        next.h = previous.h;
+        next.halfh = previous.halfh;
+        next.digest[0] = '\0';
+        next.halfdigest = '\0';
+        next.dlen = 0;
+        ++bhEnd;
+    } else if (!needLastHash) {
+        needLastHash = true;
+        lastHash = blockHashes[bhEnd - 1].h;
+    }
+}
+
+void SimilarityDigest::tryReduceBlockHash()
+{
+    if (bhEnd - bhStart < 2) {
+        return;
+    }
+
+    // The smallest block size is still a candidate for the final digest
+    quint64 expectedSize = fixedSize > 0 ? fixedSize : totalSize;
+    if (blockSizeAt(bhStart) * SPAMSUM_LENGTH >= expectedSize) {
+        return;
+    }
+
+    // ...or the next one up might still end up too short
+    if (blockHashes[bhStart + 1].dlen < SPAMSUM_LENGTH / 2) {
+        return;
+    }
+
+    ++bhStart;
+}
+
+quint64 SimilarityDigest::maximumInputSize()
+{
+    return blockSizeAt(NUM_BLOCKHASHES - 1) * SPAMSUM_LENGTH;
+}
+
+quint64 SimilarityDigest::blockSizeAt(quint32 index)
+{
+    return static_cast<quint64>(MIN_BLOCKSIZE) << index;
+}
@@ -0,0 +1,81 @@
+/*
+ * E01 Hash Verification Tool
+ * SimilarityDigest - Context-triggered piecewise hash (ssdeep compatible)
+ */
+
+#ifndef SIMILARITYDIGEST_H
+#define SIMILARITYDIGEST_H
+
+#include <QString>
+
+// Streaming implementation of the ssdeep / libfuzzy CTPH algorithm. All
+// candidate block sizes are tracked at once, so the digest is produced in a
+// single pass with no re-read of the media when the initial block size
+// guess is too large. Output is byte-for-byte what `ssdeep` prints for the
+// same data, so digests can be compared with either tool.
+class SimilarityDigest
+{
+public:
+    SimilarityDigest();
+
+    // Known total length lets unused block sizes be dropped early
+    void setTotalSize(quint64 size);
+    void reset();
+
+    // Feed data; call digest() once all data has been added
+    void update(const char *data, qint64 size);
+    QString digest() const;
+
+    // Longest input a digest can describe (64 pieces of the largest block
+    // size, about 192 GiB); digest() is empty beyond it
+    static quint64 maximumInputSize();
+
+    // Match score 0-100 between two digests (0 = no similarity). Either may
+    // be a list of per-region digests (see SimilarityStage); lists are
+    // compared region by region and the scores averaged
+    static int compare(const QString &digest1, const QString &digest2);
+
+    // Joins the per-region digests of media over maximumInputSize()
+    static const char REGION_SEPARATOR = ';';
+
+private:
+    struct BlockHash {
+        quint32 h;
+        quint32 halfh;
+        char digest[64];
+        char halfdigest;
+        quint32 dlen;
+    };
+
+    void step(quint8 c);
+    void tryForkBlockHash();
+    void tryReduceBlockHash();
+
+    static quint64 blockSizeAt(quint32 index);
+    static int compareSingle(const QString &digest1, const QString &digest2);
+
+    // Rolling hash over the last ROLLING_WINDOW bytes
+    quint8 window[7];
+    quint32 h1;
+    quint32 h2;
+    quint32 h3;
+    quint32 windowPos;
+
+    BlockHash blockHashes[31];
+    quint32 bhStart;
+    quint32 bhEnd;
+    quint32 lastHash;
+    bool needLastHash;
+    quint64 totalSize;
+    quint64 fixedSize;
+
+    // Constants
+    static const quint32 ROLLING_WINDOW = 7;
+    static const quint32 MIN_BLOCKSIZE = 3;
+    static const quint32 SPAMSUM_LENGTH = 64;
+    static const quint32 NUM_BLOCKHASHES = 31;
+    static const quint32 HASH_PRIME = 0x01000193;
+    static const quint32 HASH_INIT = 0x28021967;
+};
+
+#endif // SIMILARITYDIGEST_H
@@ -0,0 +1,69 @@
+/*
+ * E01 Hash Verification Tool
+ * SimilarityStage Implementation
+ */
+
+#include "similaritystage.h"
+#include <QDebug>
+
+SimilarityStage::SimilarityStage(qint64 mediaSize, QObject *parent)
+    : BlockStage(parent)
+    , mediaSize(mediaSize)
+    , regionSize(static_cast<qint64>(SimilarityDigest::maximumInputSize()))
+    , regionFilled(0)
+{
+}
+
+QString SimilarityStage::getDigest() const
+{
+    return result;
+}
+
+bool SimilarityStage::prepare()
+{
+    result.clear();
+    regionDigests.clear();
+    startRegion(0);
+    return true;
+}
+
+void SimilarityStage::processBlock(const char *data, qint64 size, qint64 offset)
+{
+    // Buffers arrive in media order; one may straddle a region boundary
+    while (size > 0) {
+        qint64 length = qMin(size, regionSize - regionFilled);
+        digest.update(data, length);
+        regionFilled += length;
+        data += length;
+        size -= length;
+        offset += length;
+
+        if (regionFilled == regionSize) {
+            regionDigests << digest.digest();
+            startRegion(offset);
+        }
+    }
+}
+
+bool SimilarityStage::complete()
+{
+    // Empty media still gets a (plain ssdeep) digest of no data
+    if (regionFilled > 0 || regionDigests.isEmpty()) {
+        regionDigests << digest.digest();
+    }
+
+    result = regionDigests.join(QLatin1Char(SimilarityDigest::REGION_SEPARATOR));
+    qDebug() << "SimilarityStage:" << regionDigests.size() << "region(s)," << result.left(120);
+    return true;
+}
+
+// ===== Private Helper Functions =====
+
+void SimilarityStage::startRegion(qint64 regionStart)
+{
+    digest.reset();
+    regionFilled = 0;
+
+    // A stream's size is not known; the digest then tracks its own length
+    digest.setTotalSize(mediaSize > 0 ? static_cast<quint64>(qMin(regionSize, mediaSize - regionStart)) : 0);
+}
@@ -0,0 +1,46 @@
+/*
+ * E01 Hash Verification Tool
+ * SimilarityStage - Similarity digest of the full media
+ */
+
+#ifndef SIMILARITYSTAGE_H
+#define SIMILARITYSTAGE_H
+
+#include "blockstage.h"
+#include "similaritydigest.h"
+#include <QStringList>
+
+// The CTPH digest is inherently sequential, so it gets one worker of its
+// own and never holds up MD5 / SHA1 / SHA256 in the hash loop.
+//
+// One ssdeep digest only describes about 192 GiB, so the media is digested
+// in regions of SimilarityDigest::maximumInputSize() bytes. Media that fits
+// in one region gets a plain ssdeep digest; larger media gets one digest
+// per region, joined with SimilarityDigest::REGION_SEPARATOR.
+class SimilarityStage : public BlockStage
+{
+    Q_OBJECT
+
+public:
+    explicit SimilarityStage(qint64 mediaSize, QObject *parent = nullptr);
+
+    // Result (valid after finish())
+    QString getDigest() const;
+
+protected:
+    bool prepare() override;
+    void processBlock(const char *data, qint64 size, qint64 offset) override;
+    bool complete() override;
+
+private:
+    void startRegion(qint64 regionStart);
+
+    qint64 mediaSize;
+    qint64 regionSize;
+    qint64 regionFilled;
+    SimilarityDigest digest;
+    QStringList regionDigests;
+    QString result;
+};
+
+#endif // SIMILARITYSTAGE_H
@@ -0,0 +1,77 @@
+/*
+ * E01 Hash Verification Tool
+ * SparseMap Implementation
+ */
+
+#include "sparsemap.h"
+#include <cstring>
+
+SparseMap::SparseMap()
+    : zeroBytes(0)
+    , totalBytes(0)
+{
+}
+
+void SparseMap::addChunk(qint64 offset, qint64 length, bool isZero)
+{
+    totalBytes += length;
+
+    if (!isZero) {
+        return;
+    }
+
+    zeroBytes += length;
+
+    // Extend the previous range if this chunk directly follows it
+    if (!ranges.isEmpty()) {
+        Range &last = ranges.last();
+        if (last.offset + last.length == offset) {
+            last.length += length;
+            return;
+        }
+    }
+
+    ranges.append(Range{offset, length});
+}
+
+void SparseMap::clear()
+{
+    ranges.clear();
+    zeroBytes = 0;
+    totalBytes = 0;
+}
+
+QList<SparseMap::Range> SparseMap::getRanges() const
+{
+    return ranges;
+}
+
+qint64 SparseMap::getZeroBytes() const
+{
+    return zeroBytes;
+}
+
+qint64 SparseMap::getTotalBytes() const
+{
+    return totalBytes;
+}
+
+bool SparseMap::isEmpty() const
+{
+    return ranges.isEmpty();
+}
+
+bool SparseMap::isAllZero(const char *data, qint64 size)
+{
+    if (size <= 0) {
+        return true;
+    }
+
+    // Allocated data almost always fails on the first byte; for zero
+    // chunks memcmp against itself shifted by one runs at memory bandwidth
+    if (data[0] != 0) {
+        return false;
+    }
+
+    return memcmp(data, data + 1, static_cast<size_t>(size - 1)) == 0;
+}
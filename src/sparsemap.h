@@ -0,0 +1,44 @@
+/*
+ * E01 Hash Verification Tool
+ * SparseMap - Map of all-zero (unallocated) regions in the media
+ */
+
+#ifndef SPARSEMAP_H
+#define SPARSEMAP_H
+
+#include <QList>
+#include <QMetaType>
+
+class SparseMap
+{
+public:
+    // A contiguous run of all-zero chunks
+    struct Range {
+        qint64 offset;
+        qint64 length;
+    };
+
+    SparseMap();
+
+    // Record one chunk; adjacent zero chunks are coalesced into one range
+    void addChunk(qint64 offset, qint64 length, bool isZero);
+    void clear();
+
+    // Results
+    QList<Range> getRanges() const;
+    qint64 getZeroBytes() const;
+    qint64 getTotalBytes() const;
+    bool isEmpty() const;
+
+    // Zero detection (early exit on the first non-zero byte)
+    static bool isAllZero(const char *data, qint64 size);
+
+private:
+    QList<Range> ranges;
+    qint64 zeroBytes;
+    qint64 totalBytes;
+};
+
+Q_DECLARE_METATYPE(SparseMap)
+
+#endif // SPARSEMAP_H
@@ -0,0 +1,220 @@
+/*
+ * E01 Hash Verification Tool
+ * StreamReader Implementation
+ */
+
+#include "streamreader.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <fcntl.h>
+    #include <cstdio>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+StreamReader::StreamReader()
+    : inputFd(-1)
+    , outputFd(-1)
+    , ownsInput(false)
+    , passThrough(false)
+    , kernelTee(false)
+{
+}
+
+StreamReader::~StreamReader()
+{
+    close();
+}
+
+bool StreamReader::open(const QString &path)
+{
+    close();
+
+#ifdef _WIN32
+    if (isStdin(path)) {
+        inputFd = _fileno(stdin);
+        _setmode(inputFd, _O_BINARY);
+    } else {
+        inputFd = _wopen(reinterpret_cast<const wchar_t*>(path.utf16()), _O_RDONLY | _O_BINARY);
+        ownsInput = true;
+    }
+    outputFd = _fileno(stdout);
+    _setmode(outputFd, _O_BINARY);
+#else
+    if (isStdin(path)) {
+        inputFd = STDIN_FILENO;
+    } else {
+        inputFd = ::open(path.toLocal8Bit().constData(), O_RDONLY);
+        ownsInput = true;
+    }
+    outputFd = STDOUT_FILENO;
+#endif
+
+    if (inputFd < 0) {
+        setError(QString("Failed to open input stream: %1").arg(strerror(errno)));
+        ownsInput = false;
+        return false;
+    }
+
+    kernelTee = false;
+#ifdef __linux__
+    // tee(2) only works pipe-to-pipe
+    struct stat inputStat;
+    struct stat outputStat;
+    kernelTee = fstat(inputFd, &inputStat) == 0 && S_ISFIFO(inputStat.st_mode) &&
+                fstat(outputFd, &outputStat) == 0 && S_ISFIFO(outputStat.st_mode);
+#endif
+
+    qDebug() << "StreamReader: Reading" << (isStdin(path) ? QString("stdin") : path);
+    return true;
+}
+
+void StreamReader::close()
+{
+    if (ownsInput && inputFd >= 0) {
+#ifdef _WIN32
+        _close(inputFd);
+#else
+        ::close(inputFd);
+#endif
+    }
+
+    inputFd = -1;
+    outputFd = -1;
+    ownsInput = false;
+}
+
+bool StreamReader::isOpen() const
+{
+    return inputFd >= 0;
+}
+
+void StreamReader::setPassThrough(bool enable)
+{
+    passThrough = enable;
+}
+
+qint64 StreamReader::read(char *buffer, qint64 maxSize)
+{
+    if (inputFd < 0) {
+        setError("Stream not open");
+        return -1;
+    }
+
+    // Pipes return whatever is buffered; keep reading so the hash loop
+    // still works on full-size blocks
+    qint64 filled = 0;
+    while (filled < maxSize) {
+        qint64 available = maxSize - filled;
+
+        if (passThrough && kernelTee) {
+            // Duplicate into stdout first, then consume the same bytes
+            available = teeOnce(available);
+            if (available <= 0) {
+                if (available < 0) {
+                    return -1;
+                }
+                break;
+            }
+        }
+
+        qint64 bytesRead = readOnce(buffer + filled, available);
+        if (bytesRead < 0) {
+            return -1;
+        }
+        if (bytesRead == 0) {
+            break;
+        }
+
+        if (passThrough && !kernelTee && !writeOutput(buffer + filled, bytesRead)) {
+            return -1;
+        }
+
+        filled += bytesRead;
+    }
+
+    return filled;
+}
+
+QString StreamReader::getLastError() const
+{
+    return lastError;
+}
+
+bool StreamReader::isStdin(const QString &path)
+{
+    return path == "-";
+}
+
+// ===== Private Helper Functions =====
+
+qint64 StreamReader::readOnce(char *buffer, qint64 maxSize)
+{
+    while (true) {
+#ifdef _WIN32
+        int bytesRead = _read(inputFd, buffer, static_cast<unsigned int>(qMin<qint64>(maxSize, 1 << 30)));
+#else
+        ssize_t bytesRead = ::read(inputFd, buffer, static_cast<size_t>(maxSize));
+#endif
+        if (bytesRead >= 0) {
+            return bytesRead;
+        }
+        if (errno != EINTR) {
+            setError(QString("Failed to read input stream: %1").arg(strerror(errno)));
+            return -1;
+        }
+    }
+}
+
+qint64 StreamReader::teeOnce(qint64 maxSize)
+{
+#ifdef __linux__
+    while (true) {
+        ssize_t duplicated = ::tee(inputFd, outputFd, static_cast<size_t>(maxSize), 0);
+        if (duplicated >= 0) {
+            return duplicated;
+        }
+        if (errno != EINTR) {
+            setError(QString("Failed to pass stream through: %1").arg(strerror(errno)));
+            return -1;
+        }
+    }
+#else
+    Q_UNUSED(maxSize);
+    return -1;
+#endif
+}
+
+bool StreamReader::writeOutput(const char *data, qint64 size)
+{
+    qint64 written = 0;
+    while (written < size) {
+#ifdef _WIN32
+        int result = _write(outputFd, data + written, static_cast<unsigned int>(qMin<qint64>(size - written, 1 << 30)));
+#else
+        ssize_t result = ::write(outputFd, data + written, static_cast<size_t>(size - written));
+#endif
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            setError(QString("Failed to pass stream through: %1").arg(strerror(errno)));
+            return false;
+        }
+        written += result;
+    }
+
+    return true;
+}
+
+void StreamReader::setError(const QString &errorMsg)
+{
+    lastError = errorMsg;
+    qDebug() << "StreamReader Error:" << errorMsg;
+}
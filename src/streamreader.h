@@ -0,0 +1,53 @@
+/*
+ * E01 Hash Verification Tool
+ * StreamReader - Sequential input from stdin or a named pipe
+ */
+
+#ifndef STREAMREADER_H
+#define STREAMREADER_H
+
+#include <QString>
+
+// Reads a raw byte stream (e.g. `ewfexport -t -` or `dd` output) for
+// in-line hashing. With pass-through enabled every byte read is also
+// written to stdout, so the tool can sit in the middle of a pipeline. On
+// Linux, when stdin and stdout are both pipes, tee(2) duplicates the data
+// into the output pipe inside the kernel; the only copy made is the one
+// the hashes need.
+class StreamReader
+{
+public:
+    StreamReader();
+    ~StreamReader();
+
+    // "-" opens stdin
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+
+    // Copy everything read to stdout
+    void setPassThrough(bool enable);
+
+    // Fill the buffer (short only at end of stream); 0 at end, -1 on error
+    qint64 read(char *buffer, qint64 maxSize);
+
+    // Error handling
+    QString getLastError() const;
+
+    static bool isStdin(const QString &path);
+
+private:
+    qint64 readOnce(char *buffer, qint64 maxSize);
+    qint64 teeOnce(qint64 maxSize);
+    bool writeOutput(const char *data, qint64 size);
+    void setError(const QString &errorMsg);
+
+    int inputFd;
+    int outputFd;
+    bool ownsInput;
+    bool passThrough;
+    bool kernelTee;
+    QString lastError;
+};
+
+#endif // STREAMREADER_H
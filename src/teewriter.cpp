@@ -0,0 +1,246 @@
+/*
+ * E01 Hash Verification Tool
+ * TeeWriter Implementation
+ */
+
+#include "teewriter.h"
+#include "ewfhandler.h"
+#include "hashdigest.h"
+#include <QDebug>
+#include <QByteArray>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+TeeWriter::TeeWriter(const QString &outputPath, qint64 mediaSize, QObject *parent)
+    : BlockStage(parent)
+    , outputPath(outputPath)
+    , mediaSize(mediaSize)
+    , format(formatForPath(outputPath))
+    , segmentSize(0)
+    , verifyOutput(false)
+    , sourceBytesPerSector(0)
+    , bytesWritten(0)
+{
+    setQueueDepth(WRITER_QUEUE_DEPTH);
+}
+
+void TeeWriter::setFormat(Format format)
+{
+    this->format = format;
+}
+
+void TeeWriter::setSegmentSize(qint64 size)
+{
+    segmentSize = size;
+}
+
+void TeeWriter::setVerifyOutput(bool verify)
+{
+    verifyOutput = verify;
+}
+
+void TeeWriter::setSourceHeader(const QMap<QString, QString> &values, qint64 bytesPerSector)
+{
+    sourceHeaderValues = values;
+    sourceBytesPerSector = bytesPerSector;
+}
+
+void TeeWriter::setSourceHashes(const QString &md5, const QString &sha1)
+{
+    sourceMD5 = md5;
+    sourceSHA1 = sha1;
+}
+
+QString TeeWriter::getOutputPath() const
+{
+    return outputPath;
+}
+
+qint64 TeeWriter::getBytesWritten() const
+{
+    return bytesWritten;
+}
+
+QString TeeWriter::getOutputMD5() const
+{
+    return outputMD5;
+}
+
+TeeWriter::Format TeeWriter::formatForPath(const QString &path)
+{
+    return EWFWriter::segmentBasePath(path) != path ? FormatEWF : FormatRaw;
+}
+
+bool TeeWriter::prepare()
+{
+    bytesWritten = 0;
+    outputMD5.clear();
+
+    if (format == FormatEWF) {
+        ewfWriter.reset(new EWFWriter());
+        ewfWriter->setMediaSize(mediaSize);
+        ewfWriter->setSegmentSize(segmentSize);
+        ewfWriter->setBytesPerSector(sourceBytesPerSector);
+
+        // Case metadata only; libewf writes its own dates and tool fields
+        static const char *const copiedValues[] = {
+            "case_number", "description", "examiner_name", "evidence_number", "notes"
+        };
+        for (const char *identifier : copiedValues) {
+            QString value = sourceHeaderValues.value(QString::fromLatin1(identifier));
+            if (!value.isEmpty()) {
+                ewfWriter->setHeaderValue(QString::fromLatin1(identifier), value);
+            }
+        }
+
+        if (!ewfWriter->open(outputPath)) {
+            setError(ewfWriter->getLastError());
+            return false;
+        }
+    } else {
+        // Writes are large and sequential; skip QFile's own buffering
+        rawFile.setFileName(outputPath);
+        if (!rawFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+            setError(QString("Failed to create output file: %1").arg(rawFile.errorString()));
+            return false;
+        }
+    }
+
+    qDebug() << "TeeWriter: Writing" << (format == FormatEWF ? "E01" : "raw") << "output to" << outputPath;
+    return true;
+}
+
+void TeeWriter::processBlock(const char *data, qint64 size, qint64 offset)
+{
+    if (offset != bytesWritten) {
+        setError(QString("Output out of sequence at offset %1").arg(offset));
+        return;
+    }
+
+    qint64 written = (format == FormatEWF) ? ewfWriter->write(data, size) : rawFile.write(data, size);
+    if (written != size) {
+        setError(format == FormatEWF ? ewfWriter->getLastError()
+                                     : QString("Failed to write output: %1").arg(rawFile.errorString()));
+        return;
+    }
+
+    bytesWritten += written;
+}
+
+bool TeeWriter::complete()
+{
+    if (format == FormatEWF) {
+        // Store the source hashes so the new image verifies on its own
+        if (!sourceMD5.isEmpty()) {
+            ewfWriter->setHashValue("MD5", sourceMD5);
+        }
+        if (!sourceSHA1.isEmpty()) {
+            ewfWriter->setHashValue("SHA1", sourceSHA1);
+        }
+
+        if (!ewfWriter->finalize()) {
+            setError(ewfWriter->getLastError());
+            return false;
+        }
+        ewfWriter.reset();
+    } else {
+        if (!rawFile.flush()) {
+            setError(QString("Failed to write output: %1").arg(rawFile.errorString()));
+            return false;
+        }
+        rawFile.close();
+    }
+
+    qDebug() << "TeeWriter: Wrote" << bytesWritten << "bytes to" << outputPath;
+
+    if (verifyOutput) {
+        return readBackOutput();
+    }
+
+    return true;
+}
+
+// ===== Private Helper Functions =====
+
+bool TeeWriter::readBackOutput()
+{
+    // Read what actually reached the disk, not what was handed to the
+    // writer: the output is synced and its cached pages dropped first, so
+    // the reads below go to the device (on Windows they may still be
+    // served from the file cache)
+    QFile rawInput;
+    EWFHandler ewfInput;
+    qint64 inputSize;
+
+    if (format == FormatEWF) {
+        QString firstSegment = EWFWriter::segmentBasePath(outputPath) + ".E01";
+        if (!ewfInput.open(firstSegment)) {
+            setError("Failed to reopen output for verification: " + ewfInput.getLastError());
+            return false;
+        }
+        inputSize = ewfInput.getMediaSize();
+        for (const QString &segment : ewfInput.getSegmentFiles()) {
+            dropCachedPages(segment);
+        }
+    } else {
+        dropCachedPages(outputPath);
+        rawInput.setFileName(outputPath);
+        if (!rawInput.open(QIODevice::ReadOnly)) {
+            setError(QString("Failed to reopen output for verification: %1").arg(rawInput.errorString()));
+            return false;
+        }
+        inputSize = rawInput.size();
+    }
+
+    HashDigest digest(true, false, false);
+    if (!digest.isValid()) {
+        setError("Failed to initialize output hash");
+        return false;
+    }
+
+    QByteArray buffer(static_cast<int>(READBACK_SIZE), Qt::Uninitialized);
+    qint64 position = 0;
+    bool ok = true;
+
+    while (position < inputSize) {
+        qint64 length = qMin(READBACK_SIZE, inputSize - position);
+        qint64 bytesRead = (format == FormatEWF) ? ewfInput.readAt(buffer.data(), length, position)
+                                                 : rawInput.read(buffer.data(), length);
+        if (bytesRead != length) {
+            ok = false;
+            break;
+        }
+
+        digest.update(buffer.constData(), length);
+        position += length;
+    }
+
+    if (!ok) {
+        setError(QString("Failed to read back output at offset %1").arg(position));
+        return false;
+    }
+
+    outputMD5 = digest.finish().value("MD5");
+    qDebug() << "TeeWriter: Output MD5" << outputMD5;
+    return true;
+}
+
+void TeeWriter::dropCachedPages(const QString &path)
+{
+#ifndef _WIN32
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    // Dirty pages cannot be dropped; write them out first
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#else
+    Q_UNUSED(path);
+#endif
+}
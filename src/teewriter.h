@@ -0,0 +1,82 @@
+/*
+ * E01 Hash Verification Tool
+ * TeeWriter - Writes the decompressed stream to a raw or E01 output
+ */
+
+#ifndef TEEWRITER_H
+#define TEEWRITER_H
+
+#include "blockstage.h"
+#include "ewfwriter.h"
+#include <QFile>
+#include <QMap>
+#include <QScopedPointer>
+
+// Converts an image in the same pass that verifies it. The writer runs on
+// its own thread with a deeper queue than the analysis stages, so short
+// stalls on the output disk do not hold up hashing.
+class TeeWriter : public BlockStage
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        FormatRaw,
+        FormatEWF
+    };
+
+    TeeWriter(const QString &outputPath, qint64 mediaSize, QObject *parent = nullptr);
+
+    // Output settings (before start)
+    void setFormat(Format format);
+    void setSegmentSize(qint64 size);
+    void setVerifyOutput(bool verify);
+
+    // Source case metadata and sector size to carry into an E01 output
+    // (before start); values the source does not have are left unset
+    void setSourceHeader(const QMap<QString, QString> &values, qint64 bytesPerSector);
+
+    // Source hashes to store in an E01 output; call before finish()
+    void setSourceHashes(const QString &md5, const QString &sha1);
+
+    // Results (valid after finish())
+    QString getOutputPath() const;
+    qint64 getBytesWritten() const;
+    QString getOutputMD5() const;
+
+    // .E01 / .Ex01 names select EWF (an .Ex01 target is rejected on open),
+    // anything else raw
+    static Format formatForPath(const QString &path);
+
+protected:
+    bool prepare() override;
+    void processBlock(const char *data, qint64 size, qint64 offset) override;
+    bool complete() override;
+
+private:
+    bool readBackOutput();
+    static void dropCachedPages(const QString &path);
+
+    QString outputPath;
+    qint64 mediaSize;
+    Format format;
+    qint64 segmentSize;
+    bool verifyOutput;
+
+    QFile rawFile;
+    QScopedPointer<EWFWriter> ewfWriter;
+
+    QMap<QString, QString> sourceHeaderValues;
+    qint64 sourceBytesPerSector;
+    QString sourceMD5;
+    QString sourceSHA1;
+
+    qint64 bytesWritten;
+    QString outputMD5;
+
+    // Constants
+    static const int WRITER_QUEUE_DEPTH = 32;
+    static const qint64 READBACK_SIZE = 8 * 1024 * 1024;
+};
+
+#endif // TEEWRITER_H
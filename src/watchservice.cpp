@@ -0,0 +1,419 @@
+/*
+ * E01 Hash Verification Tool
+ * WatchService Implementation
+ */
+
+#include "watchservice.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QRegularExpression>
+
+WatchService::WatchService(QObject *parent)
+    : QObject(parent)
+    , stableSeconds(DEFAULT_STABLE_SECONDS)
+    , calculateMD5(true)
+    , calculateSHA1(true)
+    , calculateSHA256(false)
+    , rateLimit(0.0)
+    , background(false)
+    , ewfHandler(nullptr)
+    , hashEngine(nullptr)
+{
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &WatchService::onDirectoryChanged);
+    connect(&stabilityTimer, &QTimer::timeout, this, &WatchService::onStabilityCheck);
+}
+
+WatchService::~WatchService()
+{
+    // Stop the running job before tearing down the handler it reads from
+    if (hashEngine) {
+        hashEngine->cancel();
+        hashEngine->wait();
+        delete hashEngine;
+    }
+
+    delete ewfHandler;
+}
+
+bool WatchService::addDirectory(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.isDir()) {
+        return false;
+    }
+
+    directories.append(info.absoluteFilePath());
+    return true;
+}
+
+void WatchService::setReportDirectory(const QString &path)
+{
+    reportDirectory = QFileInfo(path).absoluteFilePath();
+}
+
+void WatchService::setStableSeconds(int seconds)
+{
+    stableSeconds = qMax(1, seconds);
+}
+
+void WatchService::setAlgorithms(bool md5, bool sha1, bool sha256)
+{
+    calculateMD5 = md5;
+    calculateSHA1 = sha1;
+    calculateSHA256 = sha256;
+}
+
+void WatchService::setRateLimit(double megabytesPerSecond)
+{
+    rateLimit = qMax(0.0, megabytesPerSecond);
+}
+
+void WatchService::setBackground(bool background)
+{
+    this->background = background;
+}
+
+bool WatchService::start()
+{
+    if (directories.isEmpty()) {
+        emit error("No directories to watch");
+        return false;
+    }
+
+    if (!QDir().mkpath(reportDirectory)) {
+        emit error("Cannot create report directory: " + reportDirectory);
+        return false;
+    }
+
+    watcher.addPaths(directories);
+
+    // Acquisitions that landed while the service was down
+    for (const QString &directory : directories) {
+        scanDirectory(directory);
+    }
+
+    // Change events only say "something happened"; stability is judged by
+    // re-reading the candidates' sizes on a timer
+    stabilityTimer.start(STABILITY_CHECK_MS);
+
+    qDebug() << "WatchService: Watching" << directories << "reports to" << reportDirectory;
+    return true;
+}
+
+QString WatchService::reportPathFor(const QString &imagePath) const
+{
+    QFileInfo image(imagePath);
+    QByteArray directoryHash = QCryptographicHash::hash(image.absolutePath().toUtf8(),
+                                                        QCryptographicHash::Md5).toHex().left(8);
+    return QDir(reportDirectory).filePath(image.completeBaseName() + "." + QString::fromLatin1(directoryHash) +
+                                          ".verification.txt");
+}
+
+// ===== Slot Implementations =====
+
+void WatchService::onDirectoryChanged(const QString &path)
+{
+    scanDirectory(path);
+}
+
+void WatchService::onStabilityCheck()
+{
+    QDateTime now = QDateTime::currentDateTime();
+
+    const QStringList images = candidates.keys();
+    for (const QString &image : images) {
+        Candidate current = describeSegments(image);
+        Candidate &previous = candidates[image];
+
+        // First segment removed or renamed away
+        if (current.segmentCount == 0) {
+            candidates.remove(image);
+            openFailures.remove(image);
+            continue;
+        }
+
+        if (current.segmentCount != previous.segmentCount || current.totalSize != previous.totalSize ||
+            current.lastModified != previous.lastModified) {
+            current.unchangedSince = now;
+            previous = current;
+            continue;
+        }
+
+        if (previous.unchangedSince.secsTo(now) < stableSeconds) {
+            continue;
+        }
+
+        // Quiet for long enough; make sure libewf agrees the set is whole
+        // (an imager that pauses mid-acquisition leaves the last segment
+        // open). A set that already failed to open goes straight back to
+        // the job queue, where the next failure counts as another attempt.
+        EWFHandler probe;
+        if (!openFailures.contains(image) && (!probe.open(image) || probe.segmentFilesCorrupted())) {
+            qDebug() << "WatchService: Segment set not complete yet:" << image;
+            previous.unchangedSince = now;
+            continue;
+        }
+        probe.close();
+
+        candidates.remove(image);
+        queued.insert(image);
+        pending.enqueue(image);
+        emit acquisitionQueued(image);
+    }
+
+    startNextJob();
+}
+
+void WatchService::onMD5Calculated(const QString &hash)
+{
+    calculated["MD5"] = hash;
+}
+
+void WatchService::onSHA1Calculated(const QString &hash)
+{
+    calculated["SHA1"] = hash;
+}
+
+void WatchService::onSHA256Calculated(const QString &hash)
+{
+    calculated["SHA256"] = hash;
+}
+
+void WatchService::onVerificationComplete(const QMap<QString, bool> &results)
+{
+    // Only hashes with a stored value were verified; the engine counts the
+    // others as passed
+    bool compared = false;
+    Verdict verdict = VERDICT_VERIFIED;
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        if (expected.value(it.key()).isEmpty()) {
+            continue;
+        }
+        compared = true;
+        if (!it.value()) {
+            verdict = VERDICT_MISMATCH;
+        }
+    }
+    if (!compared) {
+        verdict = VERDICT_COMPUTED;
+    }
+
+    finishJob(verdict, results, QString());
+}
+
+void WatchService::onHashError(const QString &message)
+{
+    finishJob(VERDICT_FAILED, QMap<QString, bool>(), message);
+}
+
+// ===== Private Helper Functions =====
+
+void WatchService::scanDirectory(const QString &path)
+{
+    QDir dir(path);
+    const QStringList files = dir.entryList(QDir::Files, QDir::Name);
+
+    for (const QString &fileName : files) {
+        if (!isFirstSegment(fileName)) {
+            continue;
+        }
+
+        QString image = dir.absoluteFilePath(fileName);
+        if (queued.contains(image) || candidates.contains(image)) {
+            continue;
+        }
+
+        // Already verified in an earlier run
+        if (QFileInfo::exists(reportPathFor(image))) {
+            queued.insert(image);
+            continue;
+        }
+
+        Candidate candidate = describeSegments(image);
+        candidate.unchangedSince = QDateTime::currentDateTime();
+        candidates.insert(image, candidate);
+
+        qDebug() << "WatchService: New acquisition" << image;
+    }
+}
+
+WatchService::Candidate WatchService::describeSegments(const QString &firstSegment) const
+{
+    // After .E99 libewf continues .EAA ... .EZZ, .FAA ... .ZZZ (.Ex99 goes
+    // on to .ExAA, .FxAA, ...) in the case of the first segment; matching
+    // that case keeps side files such as .log or .txt out of the set
+    static const QRegularExpression upperSuffix("^\\.(E[0-9]{2}|[E-Z][A-Z]{2}|Ex[0-9]{2}|[E-Z]x[A-Z]{2})$");
+    static const QRegularExpression lowerSuffix("^\\.(e[0-9]{2}|[e-z][a-z]{2}|ex[0-9]{2}|[e-z]x[a-z]{2})$");
+
+    Candidate candidate;
+    QFileInfo first(firstSegment);
+    QString baseName = first.completeBaseName();
+    const QRegularExpression &segmentSuffix = first.suffix().startsWith("E") ? upperSuffix : lowerSuffix;
+
+    const QFileInfoList entries = first.dir().entryInfoList(QDir::Files);
+    for (const QFileInfo &entry : entries) {
+        QString name = entry.fileName();
+        if (!name.startsWith(baseName + ".") || !segmentSuffix.match(name.mid(baseName.length())).hasMatch()) {
+            continue;
+        }
+
+        candidate.segmentCount++;
+        candidate.totalSize += entry.size();
+        if (!candidate.lastModified.isValid() || entry.lastModified() > candidate.lastModified) {
+            candidate.lastModified = entry.lastModified();
+        }
+    }
+
+    return candidate;
+}
+
+bool WatchService::isFirstSegment(const QString &fileName) const
+{
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "e01" || suffix == "ex01";
+}
+
+void WatchService::startNextJob()
+{
+    while (!hashEngine && !pending.isEmpty()) {
+        currentImage = pending.dequeue();
+        jobStarted = QDateTime::currentDateTime();
+        calculated.clear();
+        expected.clear();
+
+        ewfHandler = new EWFHandler();
+        if (!ewfHandler->open(currentImage)) {
+            QString failure = "Failed to open image: " + ewfHandler->getLastError();
+            int attempts = ++openFailures[currentImage];
+            if (attempts >= MAX_OPEN_ATTEMPTS) {
+                openFailures.remove(currentImage);
+                finishJob(VERDICT_FAILED, QMap<QString, bool>(), failure);
+                continue;
+            }
+
+            // Often transient (share dropped, file locked by the imager):
+            // watch the set again instead of writing a permanent report
+            emit error(QString("%1 (%2); retrying after %3 s").arg(failure, currentImage).arg(stableSeconds));
+            Candidate candidate = describeSegments(currentImage);
+            candidate.unchangedSince = QDateTime::currentDateTime();
+            candidates.insert(currentImage, candidate);
+            queued.remove(currentImage);
+
+            delete ewfHandler;
+            ewfHandler = nullptr;
+            currentImage.clear();
+            continue;
+        }
+        openFailures.remove(currentImage);
+
+        expected["MD5"] = ewfHandler->getStoredMD5();
+        expected["SHA1"] = ewfHandler->getStoredSHA1();
+        segmentFiles = ewfHandler->getSegmentFiles();
+
+        hashEngine = new HashEngine(ewfHandler);
+        connect(hashEngine, &HashEngine::md5Calculated, this, &WatchService::onMD5Calculated);
+        connect(hashEngine, &HashEngine::sha1Calculated, this, &WatchService::onSHA1Calculated);
+        connect(hashEngine, &HashEngine::sha256Calculated, this, &WatchService::onSHA256Calculated);
+        connect(hashEngine, &HashEngine::verificationComplete, this, &WatchService::onVerificationComplete);
+        connect(hashEngine, &HashEngine::error, this, &WatchService::onHashError);
+
+        hashEngine->enableMD5(calculateMD5);
+        hashEngine->enableSHA1(calculateSHA1);
+        hashEngine->enableSHA256(calculateSHA256);
+        hashEngine->enableSparseMap(false);
+        hashEngine->enableAutoTune(true);
+        hashEngine->getControl().setRateLimit(rateLimit);
+        hashEngine->getControl().setPriority(background ? JobControl::PRIORITY_BACKGROUND
+                                                        : JobControl::PRIORITY_NORMAL);
+        if (!expected.value("MD5").isEmpty()) {
+            hashEngine->setExpectedMD5(expected.value("MD5"));
+        }
+        if (!expected.value("SHA1").isEmpty()) {
+            hashEngine->setExpectedSHA1(expected.value("SHA1"));
+        }
+
+        qDebug() << "WatchService: Verifying" << currentImage;
+        emit verificationStarted(currentImage);
+        hashEngine->start();
+    }
+}
+
+void WatchService::finishJob(Verdict verdict, const QMap<QString, bool> &results, const QString &failure)
+{
+    QString reportPath = reportPathFor(currentImage);
+    if (!writeReport(reportPath, verdict, results, failure)) {
+        emit error("Failed to write report: " + reportPath);
+    }
+
+    emit verificationFinished(currentImage, verdict, reportPath);
+
+    if (hashEngine) {
+        hashEngine->wait();
+        delete hashEngine;
+        hashEngine = nullptr;
+    }
+    delete ewfHandler;
+    ewfHandler = nullptr;
+    currentImage.clear();
+    segmentFiles.clear();
+
+    // Called from the engine's completion signal; the next job is started
+    // from the event loop rather than from inside this slot
+    QTimer::singleShot(0, this, &WatchService::startNextJob);
+}
+
+bool WatchService::writeReport(const QString &reportPath, Verdict verdict, const QMap<QString, bool> &results,
+                               const QString &failure)
+{
+    // Written whole or not at all: an existing report marks the image done
+    QSaveFile file(reportPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream report(&file);
+    report << "E01 Hash Verification Report\n";
+    report << "============================\n\n";
+    report << "Image:      " << currentImage << "\n";
+    report << "Segments:   " << segmentFiles.size() << "\n";
+    if (ewfHandler && ewfHandler->isOpen()) {
+        report << "Media size: " << ewfHandler->getMediaSize() << " bytes\n";
+    }
+    report << "Started:    " << jobStarted.toString(Qt::ISODate) << "\n";
+    report << "Finished:   " << QDateTime::currentDateTime().toString(Qt::ISODate) << "\n\n";
+
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        QString storedHash = expected.value(it.key());
+        report << it.key() << ":\n";
+        report << "  Calculated: " << calculated.value(it.key()) << "\n";
+        if (storedHash.isEmpty()) {
+            report << "  Stored:     (none)\n";
+            report << "  Result:     NO STORED HASH\n\n";
+        } else {
+            report << "  Stored:     " << storedHash << "\n";
+            report << "  Result:     " << (it.value() ? "VERIFIED" : "MISMATCH") << "\n\n";
+        }
+    }
+
+    switch (verdict) {
+    case VERDICT_VERIFIED:
+        report << "Result:     VERIFIED\n";
+        break;
+    case VERDICT_MISMATCH:
+        report << "Result:     NOT VERIFIED\n";
+        break;
+    case VERDICT_COMPUTED:
+        report << "Result:     COMPUTED - no stored hash\n";
+        break;
+    case VERDICT_FAILED:
+        report << "Result:     FAILED - " << failure << "\n";
+        break;
+    }
+    report.flush();
+
+    return file.commit();
+}
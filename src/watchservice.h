@@ -0,0 +1,132 @@
+/*
+ * E01 Hash Verification Tool
+ * WatchService - Watch drop directories and verify new acquisitions
+ */
+
+#ifndef WATCHSERVICE_H
+#define WATCHSERVICE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QSet>
+#include <QQueue>
+#include <QDateTime>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include "ewfhandler.h"
+#include "hashengine.h"
+
+// Watches directories (QFileSystemWatcher, which is inotify on Linux) for
+// new EWF acquisitions. A segment set is queued once its file list, sizes
+// and timestamps have not changed for the stable period and libewf reports
+// the set complete. Jobs run one at a time and each writes a text report to
+// the report directory; an image whose report already exists is skipped,
+// so restarting the service does not repeat finished work. An image that
+// cannot be opened is retried after another stable period before it gets
+// a FAILED report.
+class WatchService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WatchService(QObject *parent = nullptr);
+    ~WatchService();
+
+    // Overall result of one acquisition; VERIFIED needs at least one
+    // stored hash that matched
+    enum Verdict {
+        VERDICT_VERIFIED,      // Every stored hash matched
+        VERDICT_MISMATCH,      // A stored hash did not match
+        VERDICT_COMPUTED,      // No stored hash for any algorithm hashed
+        VERDICT_FAILED         // Could not be opened or hashed
+    };
+
+    // Configuration (before start())
+    bool addDirectory(const QString &path);
+    void setReportDirectory(const QString &path);
+    void setStableSeconds(int seconds);
+    void setAlgorithms(bool md5, bool sha1, bool sha256);
+
+    // Keep verifications from starving acquisitions on the same storage:
+    // per-job limit in MB/s (0 = unlimited), idle I/O class and low CPU priority
+    void setRateLimit(double megabytesPerSecond);
+    void setBackground(bool background);
+
+    bool start();
+
+    // Report written for an image (whether or not it exists yet); named
+    // after the image and a hash of its directory, so same-named images in
+    // different watched directories get separate reports
+    QString reportPathFor(const QString &imagePath) const;
+
+signals:
+    void acquisitionQueued(const QString &imagePath);
+    void verificationStarted(const QString &imagePath);
+    void verificationFinished(const QString &imagePath, WatchService::Verdict verdict, const QString &reportPath);
+    void error(const QString &errorMessage);
+
+private slots:
+    void onDirectoryChanged(const QString &path);
+    void onStabilityCheck();
+
+    // Hash engine signals for the running job
+    void onMD5Calculated(const QString &hash);
+    void onSHA1Calculated(const QString &hash);
+    void onSHA256Calculated(const QString &hash);
+    void onVerificationComplete(const QMap<QString, bool> &results);
+    void onHashError(const QString &message);
+
+private:
+    // What a segment set looked like at the last scan
+    struct Candidate {
+        int segmentCount = 0;
+        qint64 totalSize = 0;
+        QDateTime lastModified;
+        QDateTime unchangedSince;
+    };
+
+    void scanDirectory(const QString &path);
+    Candidate describeSegments(const QString &firstSegment) const;
+    bool isFirstSegment(const QString &fileName) const;
+    void startNextJob();
+    void finishJob(Verdict verdict, const QMap<QString, bool> &results, const QString &failure);
+    bool writeReport(const QString &reportPath, Verdict verdict, const QMap<QString, bool> &results,
+                     const QString &failure);
+
+    // Configuration
+    QStringList directories;
+    QString reportDirectory;
+    int stableSeconds;
+    bool calculateMD5;
+    bool calculateSHA1;
+    bool calculateSHA256;
+    double rateLimit;
+    bool background;
+
+    QFileSystemWatcher watcher;
+    QTimer stabilityTimer;
+
+    // Segment sets seen but not yet stable, and sets already handed on
+    QMap<QString, Candidate> candidates;
+    QSet<QString> queued;
+    QQueue<QString> pending;
+    QMap<QString, int> openFailures;
+
+    // Running job
+    EWFHandler *ewfHandler;
+    HashEngine *hashEngine;
+    QString currentImage;
+    QDateTime jobStarted;
+    QMap<QString, QString> calculated;
+    QMap<QString, QString> expected;
+    QStringList segmentFiles;
+
+    // Constants
+    static const int DEFAULT_STABLE_SECONDS = 120;
+    static const int STABILITY_CHECK_MS = 5000;
+    static const int MAX_OPEN_ATTEMPTS = 3;
+};
+
+#endif // WATCHSERVICE_H
@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+#
+# E01 Hash Verification Tool
+# mmapbench - Memory-mapped vs read() segment I/O (Linux only)
+#
+# Verifies one image with the default libewf file I/O and with --mmap,
+# alternating, and reports for each run the wall time, user and system CPU
+# seconds and, if strace is installed, the number of read/seek system calls.
+# Tuning is disabled so both paths use the same single reader.
+#
+# Usage: mmapbench.sh [path/to/e01hasher] image.E01 [runs]
+#
+# Cold-cache numbers need the page cache dropped before each run; set
+# MMAPBENCH_DROP_CACHES=1 when running as root to do that here.
+
+set -u
+
+HASHER=${1:-e01hasher}
+IMAGE=${2:?usage: mmapbench.sh [e01hasher] image.E01 [runs]}
+RUNS=${3:-3}
+DROP=${MMAPBENCH_DROP_CACHES:-0}
+
+TIMING=$(mktemp)
+trap 'rm -f "$TIMING"' EXIT
+
+drop_caches() {
+    if [ "$DROP" = "1" ]; then
+        sync
+        echo 3 > /proc/sys/vm/drop_caches
+    fi
+}
+
+# read/pread/lseek calls made by one run (empty without strace)
+count_syscalls() {
+    command -v strace > /dev/null || return
+    drop_caches
+    strace -f -c -e trace=read,pread64,readv,preadv,lseek -o "$TIMING" \
+        "$HASHER" --md5 --no-tune "$@" "$IMAGE" > /dev/null 2>&1
+    awk '$NF == "total" { print $4 }' "$TIMING"
+}
+
+printf "%-8s %4s %9s %9s %9s %12s\n" "mode" "run" "wall s" "user s" "sys s" "read calls"
+for run in $(seq "$RUNS"); do
+    for mode in read mmap; do
+        args=()
+        [ "$mode" = "mmap" ] && args=(--mmap)
+
+        drop_caches
+        /usr/bin/time -f "%e %U %S" -o "$TIMING" \
+            "$HASHER" --md5 --no-tune ${args[@]+"${args[@]}"} "$IMAGE" > /dev/null 2>&1
+        read -r wall user sys < "$TIMING"
+
+        calls=$(count_syscalls ${args[@]+"${args[@]}"})
+        printf "%-8s %4s %9s %9s %9s %12s\n" "$mode" "$run" "$wall" "$user" "$sys" "${calls:--}"
+    done
+done
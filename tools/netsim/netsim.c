@@ -0,0 +1,283 @@
+/*
+ * E01 Hash Verification Tool
+ * netsim - LD_PRELOAD shim that makes local files behave like a network share
+ *
+ * Every read from a file under NETSIM_PATH is delayed by a fixed round-trip
+ * latency and throttled to a shared bandwidth cap, so read strategies can be
+ * benchmarked without a real SMB/NFS server.
+ *
+ * Environment:
+ *   NETSIM_PATH            Path prefix to throttle (required; other files are untouched)
+ *   NETSIM_LATENCY_MS      Added latency per read request (default 2)
+ *   NETSIM_BANDWIDTH_MBPS  Aggregate bandwidth cap in MB/s, 0 = unlimited (default 0)
+ *
+ * Build: see tools/netsim/Makefile
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#define NETSIM_MAX_FDS 65536
+
+static char netsim_path[4096];
+static size_t netsim_path_length = 0;
+static long netsim_latency_ns = 2000000L;
+static double netsim_bytes_per_ns = 0.0;
+
+/* Which descriptors refer to throttled files */
+static unsigned char netsim_tracked[NETSIM_MAX_FDS];
+
+/* Shared link: the time at which the simulated wire becomes free */
+static pthread_mutex_t netsim_link_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int64_t netsim_link_free_ns = 0;
+
+static int (*real_open)(const char *, int, ...);
+static int (*real_open64)(const char *, int, ...);
+static int (*real_openat)(int, const char *, int, ...);
+static int (*real_openat64)(int, const char *, int, ...);
+static int (*real_dup)(int);
+static int (*real_dup2)(int, int);
+static int (*real_dup3)(int, int, int);
+static int (*real_close)(int);
+static ssize_t (*real_read)(int, void *, size_t);
+static ssize_t (*real_pread)(int, void *, size_t, off_t);
+static ssize_t (*real_pread64)(int, void *, size_t, off64_t);
+static ssize_t (*real_readv)(int, const struct iovec *, int);
+
+__attribute__((constructor))
+static void netsim_init(void)
+{
+    const char *value;
+
+    real_open = dlsym(RTLD_NEXT, "open");
+    real_open64 = dlsym(RTLD_NEXT, "open64");
+    real_openat = dlsym(RTLD_NEXT, "openat");
+    real_openat64 = dlsym(RTLD_NEXT, "openat64");
+    real_dup = dlsym(RTLD_NEXT, "dup");
+    real_dup2 = dlsym(RTLD_NEXT, "dup2");
+    real_dup3 = dlsym(RTLD_NEXT, "dup3");
+    real_close = dlsym(RTLD_NEXT, "close");
+    real_read = dlsym(RTLD_NEXT, "read");
+    real_pread = dlsym(RTLD_NEXT, "pread");
+    real_pread64 = dlsym(RTLD_NEXT, "pread64");
+    real_readv = dlsym(RTLD_NEXT, "readv");
+
+    value = getenv("NETSIM_PATH");
+    if (value != NULL && value[0] != '\0') {
+        strncpy(netsim_path, value, sizeof(netsim_path) - 1);
+        netsim_path_length = strlen(netsim_path);
+    }
+
+    value = getenv("NETSIM_LATENCY_MS");
+    if (value != NULL) {
+        netsim_latency_ns = (long)(atof(value) * 1000000.0);
+    }
+
+    value = getenv("NETSIM_BANDWIDTH_MBPS");
+    if (value != NULL && atof(value) > 0.0) {
+        netsim_bytes_per_ns = atof(value) * 1024.0 * 1024.0 / 1e9;
+    }
+}
+
+static int64_t netsim_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void netsim_sleep_until(int64_t deadline_ns)
+{
+    struct timespec deadline;
+    deadline.tv_sec = deadline_ns / 1000000000LL;
+    deadline.tv_nsec = deadline_ns % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) != 0) {
+    }
+}
+
+static void netsim_track(int fd, const char *path)
+{
+    if (fd < 0 || fd >= NETSIM_MAX_FDS) {
+        return;
+    }
+    netsim_tracked[fd] = (netsim_path_length > 0 && path != NULL &&
+                          strncmp(path, netsim_path, netsim_path_length) == 0);
+}
+
+static void netsim_copy(int from_fd, int to_fd)
+{
+    if (to_fd < 0 || to_fd >= NETSIM_MAX_FDS) {
+        return;
+    }
+    netsim_tracked[to_fd] = (from_fd >= 0 && from_fd < NETSIM_MAX_FDS) ? netsim_tracked[from_fd] : 0;
+}
+
+/*
+ * Requests overlap in latency (like outstanding SMB/NFS requests) but
+ * share the wire, so transfer time is serialized across all threads.
+ */
+static void netsim_delay(int fd, ssize_t bytes)
+{
+    int64_t start_ns;
+    int64_t transfer_ns = 0;
+    int64_t done_ns;
+
+    if (fd < 0 || fd >= NETSIM_MAX_FDS || !netsim_tracked[fd] || bytes < 0) {
+        return;
+    }
+
+    start_ns = netsim_now_ns();
+    done_ns = start_ns + netsim_latency_ns;
+
+    if (netsim_bytes_per_ns > 0.0) {
+        transfer_ns = (int64_t)((double)bytes / netsim_bytes_per_ns);
+
+        pthread_mutex_lock(&netsim_link_mutex);
+        if (netsim_link_free_ns < start_ns) {
+            netsim_link_free_ns = start_ns;
+        }
+        netsim_link_free_ns += transfer_ns;
+        if (netsim_link_free_ns > done_ns) {
+            done_ns = netsim_link_free_ns;
+        }
+        pthread_mutex_unlock(&netsim_link_mutex);
+    }
+
+    netsim_sleep_until(done_ns);
+}
+
+static mode_t netsim_mode(int flags, va_list args)
+{
+    if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE) {
+        return (mode_t)va_arg(args, int);
+    }
+    return 0;
+}
+
+int open(const char *path, int flags, ...)
+{
+    va_list args;
+    mode_t mode;
+    int fd;
+
+    va_start(args, flags);
+    mode = netsim_mode(flags, args);
+    va_end(args);
+
+    fd = real_open(path, flags, mode);
+    netsim_track(fd, path);
+    return fd;
+}
+
+int open64(const char *path, int flags, ...)
+{
+    va_list args;
+    mode_t mode;
+    int fd;
+
+    va_start(args, flags);
+    mode = netsim_mode(flags, args);
+    va_end(args);
+
+    fd = real_open64(path, flags, mode);
+    netsim_track(fd, path);
+    return fd;
+}
+
+int openat(int dirfd, const char *path, int flags, ...)
+{
+    va_list args;
+    mode_t mode;
+    int fd;
+
+    va_start(args, flags);
+    mode = netsim_mode(flags, args);
+    va_end(args);
+
+    fd = real_openat(dirfd, path, flags, mode);
+    netsim_track(fd, path);
+    return fd;
+}
+
+int openat64(int dirfd, const char *path, int flags, ...)
+{
+    va_list args;
+    mode_t mode;
+    int fd;
+
+    va_start(args, flags);
+    mode = netsim_mode(flags, args);
+    va_end(args);
+
+    fd = real_openat64(dirfd, path, flags, mode);
+    netsim_track(fd, path);
+    return fd;
+}
+
+/* Tools such as dd move the opened file onto stdin with dup2 */
+int dup(int old_fd)
+{
+    int fd = real_dup(old_fd);
+    netsim_copy(old_fd, fd);
+    return fd;
+}
+
+int dup2(int old_fd, int new_fd)
+{
+    int fd = real_dup2(old_fd, new_fd);
+    netsim_copy(old_fd, fd);
+    return fd;
+}
+
+int dup3(int old_fd, int new_fd, int flags)
+{
+    int fd = real_dup3(old_fd, new_fd, flags);
+    netsim_copy(old_fd, fd);
+    return fd;
+}
+
+int close(int fd)
+{
+    if (fd >= 0 && fd < NETSIM_MAX_FDS) {
+        netsim_tracked[fd] = 0;
+    }
+    return real_close(fd);
+}
+
+ssize_t read(int fd, void *buffer, size_t count)
+{
+    ssize_t result = real_read(fd, buffer, count);
+    netsim_delay(fd, result);
+    return result;
+}
+
+ssize_t pread(int fd, void *buffer, size_t count, off_t offset)
+{
+    ssize_t result = real_pread(fd, buffer, count, offset);
+    netsim_delay(fd, result);
+    return result;
+}
+
+ssize_t pread64(int fd, void *buffer, size_t count, off64_t offset)
+{
+    ssize_t result = real_pread64(fd, buffer, count, offset);
+    netsim_delay(fd, result);
+    return result;
+}
+
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    ssize_t result = real_readv(fd, iov, iovcnt);
+    netsim_delay(fd, result);
+    return result;
+}
@@ -0,0 +1,124 @@
+#!/usr/bin/env bash
+#
+# E01 Hash Verification Tool
+# segbench - Many-segment fixture and segment-handle benchmark (Linux only)
+#
+# Writes a synthetic image split into thousands of small segments (with
+# e01hasher's own E01 writer), then, for each --segment-handles setting:
+#   - verifies it once, reporting wall time and the peak number of open
+#     descriptors
+#   - runs SEGBENCH_JOBS verifications of it at once in one job server,
+#     under a SEGBENCH_NOFILE descriptor limit, reporting how many failed
+#
+# Usage: segbench.sh [path/to/e01hasher] [work directory]
+#
+# Environment:
+#   SEGBENCH_SIZE_MB     Media size in MB (default 2048)
+#   SEGBENCH_SEGMENT_MB  Segment size in MB (default 1, about 2000 segments)
+#   SEGBENCH_JOBS        Concurrent server jobs (default 4)
+#   SEGBENCH_NOFILE      Descriptor limit for the server runs (default 1024)
+#   SEGBENCH_HANDLES     Settings to compare (default "-1 0 4 64"; -1 is
+#                        libewf's own unlimited behaviour)
+#
+# The fixture is kept in the work directory and reused. Drop the page cache
+# (echo 3 > /proc/sys/vm/drop_caches) before each run for cold-cache numbers.
+
+set -u
+
+HASHER=${1:-e01hasher}
+WORKDIR=${2:-/tmp/segbench}
+SIZE_MB=${SEGBENCH_SIZE_MB:-2048}
+SEGMENT_MB=${SEGBENCH_SEGMENT_MB:-1}
+JOBS=${SEGBENCH_JOBS:-4}
+NOFILE=${SEGBENCH_NOFILE:-1024}
+HANDLES=${SEGBENCH_HANDLES:-"-1 0 4 64"}
+
+FIXTURE="$WORKDIR/fixture.E01"
+
+mkdir -p "$WORKDIR" || exit 2
+
+if [ ! -f "$FIXTURE" ]; then
+    echo "Writing ${SIZE_MB}MB fixture in ${SEGMENT_MB}MB segments to $WORKDIR"
+    head -c "${SIZE_MB}M" /dev/urandom |
+        "$HASHER" --md5 --tee "$FIXTURE" --tee-segment-size "$SEGMENT_MB" - > /dev/null || exit 2
+fi
+SEGMENTS=$(ls "$WORKDIR"/fixture.* | wc -l)
+echo "Fixture:  $FIXTURE ($SEGMENTS segments)"
+echo
+
+# Highest descriptor count of a process, sampled until it exits
+peak_fds() {
+    local pid=$1 peak=0 count
+    while kill -0 "$pid" 2> /dev/null; do
+        count=$(ls "/proc/$pid/fd" 2> /dev/null | wc -l)
+        [ "$count" -gt "$peak" ] && peak=$count
+        sleep 0.05
+    done
+    echo "$peak"
+}
+
+# Submit the fixture JOBS times to a server and count the results
+server_run() {
+    local handles=$1 name="segbench-$$" log="$WORKDIR/server.log"
+    (
+        ulimit -n "$NOFILE"
+        exec "$HASHER" --serve "$name" --workers "$JOBS" --segment-handles "$handles"
+    ) > "$log" 2>&1 &
+    local server=$!
+
+    local socket=""
+    for _ in $(seq 50); do
+        socket=$(sed -n 's/^Serving: *//p' "$log")
+        [ -n "$socket" ] && break
+        sleep 0.1
+    done
+    if [ -z "$socket" ]; then
+        kill "$server" 2> /dev/null
+        echo "server did not start"
+        return
+    fi
+
+    python3 - "$socket" "$FIXTURE" "$JOBS" << 'EOF'
+import json, socket, sys
+path, image, jobs = sys.argv[1], sys.argv[2], int(sys.argv[3])
+client = socket.socket(socket.AF_UNIX)
+client.connect(path)
+stream = client.makefile("rw")
+def send(message):
+    stream.write(json.dumps(message) + "\n")
+    stream.flush()
+send({"cmd": "subscribe"})
+for _ in range(jobs):
+    send({"cmd": "submit", "image": image, "algorithms": ["md5"]})
+states = {}
+for line in stream:
+    message = json.loads(line)
+    if message.get("event") == "result":
+        states[message["job"]] = message["state"]
+        if len(states) == jobs:
+            break
+counts = {}
+for state in states.values():
+    counts[state] = counts.get(state, 0) + 1
+print(", ".join("%d %s" % (n, s) for s, n in sorted(counts.items())))
+EOF
+
+    kill "$server" 2> /dev/null
+    wait "$server" 2> /dev/null
+}
+
+printf "%-10s %10s %10s   %s\n" "handles" "seconds" "peak fds" "$JOBS jobs at nofile=$NOFILE"
+for handles in $HANDLES; do
+    start=$(date +%s.%N)
+    "$HASHER" --md5 --no-tune --segment-handles "$handles" "$FIXTURE" > /dev/null 2>&1 &
+    pid=$!
+    peak=$(peak_fds "$pid")
+    wait "$pid"
+    status=$?
+    end=$(date +%s.%N)
+
+    seconds=$(awk -v a="$start" -v b="$end" 'BEGIN { printf "%.1f", b - a }')
+    [ "$status" -eq 0 ] || seconds="failed"
+
+    printf "%-10s %10s %10s   %s\n" "$handles" "$seconds" "$peak" "$(server_run "$handles")"
+done